@@ -1,6 +1,7 @@
-#include <iostream>
 #include <pthread.h>
+#include <stdexcept>
 #include "thread.h"
+#include "fast_logger.h"
 
 using namespace std;
 
@@ -11,14 +12,14 @@ Thread::Thread(Runnable* pRunnable): _thread(0), _runnable(pRunnable) {
 }
 
 void Thread::start() {
-  cout << "Thread::Start() called" << endl;
+  MMFastLogDebug("Thread::Start() called");
   //remove warning
   //int nr = pthread_create(&_thread, NULL, &Thread::Main, this);
   pthread_create(&_thread, NULL, &Thread::Main, this);
 }
 
 void Thread::wait() {
-  cout << "Thread::Wait() called" << endl;
+  MMFastLogDebug("Thread::Wait() called");
   void* pData;
   //remove warning
   //int nr = pthread_join(_thread, &pData);
@@ -27,20 +28,20 @@ void Thread::wait() {
 
 void Thread::run() {
   if (_runnable != 0) {
-    cout << "Thread::Run(): calling runnable" << endl;
+    MMFastLogDebug("Thread::Run(): calling runnable");
     _runnable->run();
   }
 }
 
 void* Thread::Main(void* pInst) {
-  cout << "Thread::Main() called" << endl;
+  MMFastLogDebug("Thread::Main() called");
   Thread* pt = nullptr;
 
   try{
       pt = static_cast<Thread*>(pInst);
       pt->run();
   }catch(std::runtime_error& exception) {
-      cout << "Thread::Main() Failed to create thread" << endl;
+      MMFastLogError("Thread::Main() Failed to create thread");
   }
 
   return pt;
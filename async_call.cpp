@@ -0,0 +1,56 @@
+#include "async_call.h"
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+
+std::shared_ptr<AsyncCall> AsyncCall::Create(Waker waker) {
+    std::shared_ptr<AsyncCall> call(new AsyncCall(waker));
+    call->self_ = call;
+    return call;
+}
+
+AsyncCall::AsyncCall(Waker waker)
+  : self_(),
+    waker_(waker),
+    cancellable_(g_cancellable_new()),
+    result_(nullptr),
+    waiting_(true) {}
+
+AsyncCall::~AsyncCall() {
+    if (result_)
+        g_object_unref(result_);
+    g_object_unref(cancellable_);
+}
+
+gpointer AsyncCall::UserData() {
+    return new std::shared_ptr<AsyncCall>(self_.lock());
+}
+
+void AsyncCall::Callback(GObject* source_object, GAsyncResult* res, gpointer user_data) {
+    auto ref = static_cast<std::shared_ptr<AsyncCall>*>(user_data);
+    std::shared_ptr<AsyncCall> call = *ref;
+    delete ref;
+
+    if (!call->waiting_) {
+        MMLogWarn("late reply of abandoned call is dropped");
+        return;
+    }
+
+    call->result_ = G_ASYNC_RESULT(g_object_ref(res));
+    call->waiting_ = false;
+    if (call->waker_)
+        call->waker_();
+}
+
+void AsyncCall::Abandon() {
+    if (!waiting_)
+        return;
+
+    waiting_ = false;
+    g_cancellable_cancel(cancellable_);
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,93 @@
+/**
+* @file async_call.h
+* @version 1.0
+* Header for the state of an asynchronous gdbus call to PlayerEngine, lge::mm::AsyncCall
+*/
+
+#ifndef ASYNC_CALL_H_
+#define ASYNC_CALL_H_
+
+#include <functional>
+#include <memory>
+
+#include <gio/gio.h>
+
+namespace lge {
+namespace mm {
+
+/**
+* @class lge::mm::AsyncCall
+* @brief State shared by a command waiting for a gdbus reply and the reply callback.
+* @details The command passes Cancellable() and UserData() to com_lge_player_engine_call_xxx()<BR>
+*          with AsyncCall::Callback, then waits until Waiting() is false. The callback holds<BR>
+*          its own reference, so the state outlives the command if the wait times out.<BR>
+*          After Abandon() the call is cancelled and a late reply only drops its result,<BR>
+*          the waker is not called, so it can not satisfy a later wait of the lane.
+*/
+class AsyncCall {
+public:
+    typedef std::function<void()> Waker;
+
+    /**
+    * @fn Create
+    * @param[in] waker : called on the thread of the reply, only while the command waits
+    * @return std::shared_ptr<AsyncCall>
+    */
+    static std::shared_ptr<AsyncCall> Create(Waker waker);
+
+    ~AsyncCall();
+
+    GCancellable* Cancellable() const {
+        return cancellable_;
+    }
+
+    /**
+    * @fn UserData
+    * @brief Reference for one gdbus call, released by Callback().
+    * @return gpointer
+    */
+    gpointer UserData();
+
+    /**
+    * @fn Callback
+    * @brief GAsyncReadyCallback of the call.
+    * @return : None
+    */
+    static void Callback(GObject* source_object, GAsyncResult* res, gpointer user_data);
+
+    bool Waiting() const {
+        return waiting_;
+    }
+
+    /**
+    * @fn Result
+    * @brief Result to pass to com_lge_player_engine_call_xxx_finish(), owned by AsyncCall.
+    * @return GAsyncResult* (nullptr - no reply)
+    */
+    GAsyncResult* Result() const {
+        return result_;
+    }
+
+    /**
+    * @fn Abandon
+    * @brief Stops waiting and cancels the call, e.g. when the wait timed out.
+    * @return : None
+    */
+    void Abandon();
+
+private:
+    explicit AsyncCall(Waker waker);
+    AsyncCall(const AsyncCall&) = delete;
+    AsyncCall& operator=(const AsyncCall&) = delete;
+
+    std::weak_ptr<AsyncCall> self_;
+    Waker waker_;
+    GCancellable* cancellable_;
+    GAsyncResult* result_;
+    bool waiting_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // ASYNC_CALL_H_
@@ -0,0 +1,120 @@
+/**
+* @file async_call_test.cpp
+* @version 1.0
+* Test of AsyncCall, the state of an asynchronous gdbus call to PlayerEngine.
+*
+* A GTask stands for the gdbus call. The engine either answers, answers after the wait
+* gave up, or never answers. The waker stands for SetEvent(CallAsync) of the lane.
+*
+* build : g++ -std=c++11 -I. async_call_test.cpp async_call.cpp $(pkg-config --cflags --libs gio-2.0) -o async_call_test
+* usage : async_call_test
+*/
+
+#include <stdio.h>
+
+#include "async_call.h"
+#include "test_check.h"
+
+using lge::mm::AsyncCall;
+
+static void RunPending() {
+    while (g_main_context_iteration(NULL, FALSE)) {
+    }
+}
+
+// the engine side of a call, answers only when the test says so
+static GTask* StartCall(std::shared_ptr<AsyncCall>& call) {
+    return g_task_new(NULL, call->Cancellable(), (GAsyncReadyCallback)AsyncCall::Callback, call->UserData());
+}
+
+static void TestReply() {
+    int woken = 0;
+    auto call = AsyncCall::Create([&woken]() { woken++; });
+    GTask* task = StartCall(call);
+
+    CHECK(call->Waiting());
+    g_task_return_boolean(task, TRUE);
+    g_object_unref(task);
+    RunPending();
+
+    CHECK(woken == 1);
+    CHECK(!call->Waiting());
+    CHECK(call->Result() != nullptr);
+    CHECK(g_task_propagate_boolean(G_TASK(call->Result()), NULL) == TRUE);
+}
+
+static void TestNeverAnswers() {
+    int woken = 0;
+    auto call = AsyncCall::Create([&woken]() { woken++; });
+    GTask* task = StartCall(call);
+
+    // the wait timed out
+    RunPending();
+    CHECK(woken == 0);
+    call->Abandon();
+    CHECK(!call->Waiting());
+    CHECK(call->Result() == nullptr);
+    CHECK(g_cancellable_is_cancelled(call->Cancellable()));
+
+    // the command is gone, the call is still referenced by the pending task
+    std::weak_ptr<AsyncCall> weak = call;
+    call.reset();
+    CHECK(!weak.expired());
+
+    // gdbus completes a cancelled call with G_IO_ERROR_CANCELLED
+    CHECK(g_task_return_error_if_cancelled(task));
+    g_object_unref(task);
+    RunPending();
+    CHECK(woken == 0);
+    CHECK(weak.expired());
+}
+
+static void TestLateReply() {
+    int woken_first = 0;
+    int woken_next = 0;
+    auto first = AsyncCall::Create([&woken_first]() { woken_first++; });
+    GTask* late = StartCall(first);
+    first->Abandon();
+    first.reset();
+
+    // the next command of the lane waits for its own call
+    auto next = AsyncCall::Create([&woken_next]() { woken_next++; });
+    GTask* task = StartCall(next);
+
+    g_task_return_boolean(late, TRUE);
+    g_object_unref(late);
+    RunPending();
+    CHECK(woken_first == 0);
+    CHECK(woken_next == 0);
+    CHECK(next->Waiting());
+
+    g_task_return_boolean(task, TRUE);
+    g_object_unref(task);
+    RunPending();
+    CHECK(woken_next == 1);
+    CHECK(next->Result() != nullptr);
+}
+
+static void TestAbandonAfterReply() {
+    int woken = 0;
+    auto call = AsyncCall::Create([&woken]() { woken++; });
+    GTask* task = StartCall(call);
+
+    g_task_return_boolean(task, TRUE);
+    g_object_unref(task);
+    RunPending();
+    call->Abandon();
+
+    CHECK(woken == 1);
+    CHECK(call->Result() != nullptr);
+    CHECK(!g_cancellable_is_cancelled(call->Cancellable()));
+}
+
+int main() {
+    TestReply();
+    TestNeverAnswers();
+    TestLateReply();
+    TestAbandonAfterReply();
+
+    return TestResult("async_call_test");
+}
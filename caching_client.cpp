@@ -0,0 +1,197 @@
+#include "caching_client.h"
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+namespace player {
+
+namespace {
+
+const char* BusAddress() {
+    const char* address = g_getenv("MM_CACHING_BUS_ADDRESS");
+    return (address && *address) ? address : nullptr;
+}
+
+} // namespace
+
+CachingClient::CachingClient()
+  : connection_(nullptr),
+    closed_handler_(0),
+    connecting_(nullptr),
+    pending_() {}
+
+CachingClient::~CachingClient() {
+    if (connecting_) {
+        g_cancellable_cancel(connecting_);
+        g_object_unref(connecting_);
+    }
+    for (auto call : pending_) {
+        // done may refer to the owner which goes away, a GAsyncReadyCallback still owns its user data
+        if (call->callback)
+            fail(call);
+        else
+            release(call);
+    }
+    if (connection_) {
+        g_signal_handler_disconnect(connection_, closed_handler_);
+        g_object_unref(connection_);
+    }
+}
+
+void CachingClient::Call(const gchar* method, GVariant* params, ReplyCallback done) {
+    PendingCall* call = new PendingCall();
+    call->method = method;
+    call->params = g_variant_ref_sink(params);
+    call->done = std::move(done);
+    call->cancellable = nullptr;
+    call->callback = nullptr;
+    call->user_data = nullptr;
+    queue(call);
+}
+
+void CachingClient::Call(const gchar* method, GVariant* params, GCancellable* cancellable,
+                         GAsyncReadyCallback callback, gpointer user_data) {
+    PendingCall* call = new PendingCall();
+    call->method = method;
+    call->params = g_variant_ref_sink(params);
+    call->cancellable = cancellable ? G_CANCELLABLE(g_object_ref(cancellable)) : nullptr;
+    call->callback = callback;
+    call->user_data = user_data;
+    queue(call);
+}
+
+GVariant* CachingClient::Finish(GAsyncResult* res, GError** error) {
+    // a call which failed before it was sent
+    if (G_IS_TASK(res))
+        return static_cast<GVariant*>(g_task_propagate_pointer(G_TASK(res), error));
+
+    GObject* connection = g_async_result_get_source_object(res);
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(connection), res, error);
+    g_object_unref(connection);
+    return reply;
+}
+
+void CachingClient::queue(PendingCall* call) {
+    if (connection_) {
+        send(call);
+        return;
+    }
+
+    pending_.push_back(call);
+    if (!connecting_)
+        connect();
+}
+
+void CachingClient::connect() {
+    connecting_ = g_cancellable_new();
+
+    const char* address = BusAddress();
+    if (address) {
+        MMLogInfo("connect to caching service bus [%s]", address);
+        g_dbus_connection_new_for_address(address,
+            (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                   G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+            NULL, connecting_, &CachingClient::onConnected, this);
+    } else {
+        g_bus_get(G_BUS_TYPE_SYSTEM, connecting_, &CachingClient::onConnected, this);
+    }
+}
+
+void CachingClient::onConnected(GObject* source_object, GAsyncResult* res, gpointer user_data) {
+    GError* error = NULL;
+    GDBusConnection* connection = BusAddress() ? g_dbus_connection_new_for_address_finish(res, &error)
+                                               : g_bus_get_finish(res, &error);
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        // the client is gone already
+        g_error_free(error);
+        return;
+    }
+
+    CachingClient* self = static_cast<CachingClient*>(user_data);
+    g_object_unref(self->connecting_);
+    self->connecting_ = nullptr;
+
+    std::vector<PendingCall*> calls;
+    calls.swap(self->pending_);
+
+    if (connection == NULL) {
+        MMLogError("get dbus connection fail : %s", error ? error->message : "");
+        if (error)
+            g_error_free(error);
+        for (auto call : calls)
+            fail(call);
+        return;
+    }
+
+    self->connection_ = connection;
+    if (BusAddress())
+        g_dbus_connection_set_exit_on_close(connection, FALSE);
+    self->closed_handler_ = g_signal_connect(connection, "closed", G_CALLBACK(&CachingClient::onClosed), self);
+
+    for (auto call : calls)
+        self->send(call);
+}
+
+void CachingClient::onClosed(GDBusConnection* connection, gboolean remote_peer_vanished,
+                             GError* error, gpointer user_data) {
+    CachingClient* self = static_cast<CachingClient*>(user_data);
+    MMLogWarn("caching service bus is closed, reconnect on next call");
+
+    g_signal_handler_disconnect(self->connection_, self->closed_handler_);
+    self->closed_handler_ = 0;
+    g_object_unref(self->connection_);
+    self->connection_ = nullptr;
+}
+
+void CachingClient::send(PendingCall* call) {
+    if (call->callback) {
+        g_dbus_connection_call(connection_, CACHE_SERVICE_NAME, CACHE_OBJECT_PATH, CACHE_INTERFACE_NAME,
+                               call->method.c_str(), call->params, NULL, G_DBUS_CALL_FLAGS_NONE,
+                               CACHE_CALL_TIMEOUT_MS, call->cancellable, call->callback, call->user_data);
+        release(call);
+        return;
+    }
+    g_dbus_connection_call(connection_, CACHE_SERVICE_NAME, CACHE_OBJECT_PATH, CACHE_INTERFACE_NAME,
+                           call->method.c_str(), call->params, NULL, G_DBUS_CALL_FLAGS_NONE,
+                           CACHE_CALL_TIMEOUT_MS, NULL, &CachingClient::onReply, call);
+}
+
+void CachingClient::onReply(GObject* source_object, GAsyncResult* res, gpointer user_data) {
+    PendingCall* call = static_cast<PendingCall*>(user_data);
+    GError* error = NULL;
+
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source_object), res, &error);
+    if (error) {
+        MMLogError("caching gdbus call [%s] fail : %s", call->method.c_str(), error->message);
+        g_error_free(error);
+    }
+
+    if (call->done)
+        call->done(reply);
+    if (reply)
+        g_variant_unref(reply);
+    release(call);
+}
+
+void CachingClient::fail(PendingCall* call) {
+    if (call->callback) {
+        GTask* task = g_task_new(NULL, call->cancellable, call->callback, call->user_data);
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED, "no caching service bus");
+        g_object_unref(task);
+    } else if (call->done) {
+        call->done(nullptr);
+    }
+    release(call);
+}
+
+void CachingClient::release(PendingCall* call) {
+    g_variant_unref(call->params);
+    if (call->cancellable)
+        g_object_unref(call->cancellable);
+    delete call;
+}
+
+} // namespace player
+} // namespace mm
+} // namespace lge
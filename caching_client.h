@@ -0,0 +1,121 @@
+/**
+* @file caching_client.h
+* @version 1.0
+* Header for asynchronous client of the stream caching service
+*/
+
+#ifndef CACHING_CLIENT_H_
+#define CACHING_CLIENT_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <gio/gio.h>
+
+#define CACHE_SERVICE_NAME   "com.lge.stream-caching-service"
+#define CACHE_OBJECT_PATH    "/com/lge/caching"
+#define CACHE_INTERFACE_NAME "com.lge.StreamCaching"
+
+#define CACHE_SETCACHEDMUSIC  "SetCachedMusic"
+#define CACHE_GETCACHEDMOVIE  "GetCachedMovie"
+#define CACHE_SETCACHEDMOVIE  "SetCachedMovie"
+
+#ifndef CACHE_CALL_TIMEOUT_MS
+#define CACHE_CALL_TIMEOUT_MS 3000 // gdbus timeout of a caching service call
+#endif
+
+namespace lge {
+namespace mm {
+namespace player {
+
+/**
+* @class lge::mm::player::CachingClient
+* @brief Calls the stream caching service without blocking the caller.
+* @details The bus connection is opened on the first call and kept, calls made while it is
+*          being opened are queued. It is opened again after the bus closes it.<BR>
+*          The system bus is used, MM_CACHING_BUS_ADDRESS selects another bus, e.g. a private
+*          one with a stand-in service.<BR>
+*          Replies are dispatched in the thread default main context of the caller, so call it
+*          from the command handling thread only.
+*/
+class CachingClient {
+public:
+    /**
+    * @param reply : out values of the method, nullptr on error or timeout. Owned by CachingClient.
+    */
+    typedef std::function<void(GVariant* reply)> ReplyCallback;
+
+    CachingClient();
+    ~CachingClient();
+
+    CachingClient(const CachingClient&) = delete;
+    CachingClient& operator=(const CachingClient&) = delete;
+
+    /**
+    * @fn Call
+    * @brief Calls method of the caching service, done is always called later from the main loop.
+    * @param[in] method : method name
+    * @param[in] params : floating or owned parameters, consumed
+    * @param[in] done : reply callback, may be empty
+    * @return : None
+    */
+    void Call(const gchar* method, GVariant* params, ReplyCallback done);
+
+    /**
+    * @fn Call
+    * @brief Calls method of the caching service as g_dbus_connection_call() does, e.g. with
+    *        AsyncCall::Callback for a command which waits for the reply.
+    * @param[in] method : method name
+    * @param[in] params : floating or owned parameters, consumed
+    * @param[in] cancellable : cancels the call, may be nullptr
+    * @param[in] callback : always called later from the main loop, the reply is got by Finish()
+    * @param[in] user_data : user data of callback
+    * @return : None
+    */
+    void Call(const gchar* method, GVariant* params, GCancellable* cancellable,
+              GAsyncReadyCallback callback, gpointer user_data);
+
+    /**
+    * @fn Finish
+    * @brief Gets the reply of a call made with a GAsyncReadyCallback.
+    * @param[in] res : result passed to the callback
+    * @param[out] error : error of the call, may be nullptr
+    * @return GVariant* : out values owned by the caller, nullptr on error or timeout
+    */
+    static GVariant* Finish(GAsyncResult* res, GError** error);
+
+private:
+    struct PendingCall {
+        std::string method;
+        GVariant* params;
+        ReplyCallback done;
+        // set by a caller which finishes the call itself
+        GCancellable* cancellable;
+        GAsyncReadyCallback callback;
+        gpointer user_data;
+    };
+
+    void queue(PendingCall* call);
+    static void release(PendingCall* call);
+
+    void connect();
+    void send(PendingCall* call);
+    static void fail(PendingCall* call);
+
+    static void onConnected(GObject* source_object, GAsyncResult* res, gpointer user_data);
+    static void onReply(GObject* source_object, GAsyncResult* res, gpointer user_data);
+    static void onClosed(GDBusConnection* connection, gboolean remote_peer_vanished,
+                         GError* error, gpointer user_data);
+
+    GDBusConnection* connection_;
+    gulong closed_handler_;
+    GCancellable* connecting_;
+    std::vector<PendingCall*> pending_;
+};
+
+} // namespace player
+} // namespace mm
+} // namespace lge
+
+#endif  // CACHING_CLIENT_H_
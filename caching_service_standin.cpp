@@ -0,0 +1,244 @@
+/**
+* @file caching_service_standin.cpp
+* @version 1.0
+* Stand-in of the stream caching service, and timing of CachingClient against blocking calls.
+*
+* A private bus is started with GTestDBus, and com.lge.stream-caching-service is owned on it
+* by a thread which answers every com.lge.StreamCaching method after a delay:
+*   SetCachedMusic(ss) -> (ss), SetCachedMovie(sss) -> (sss), GetCachedMovie(s) -> (sss)
+* GetCachedMovie answers "OK" with a path, the others answer "OK" and the url.
+*
+*   sync  : a new connection and a synchronous call per request, as sendDbusCaching did
+*   async : CachingClient with MM_CACHING_BUS_ADDRESS set to the private bus
+* Reported are the time per call and the longest stall of the caller's main loop, which is
+* what the command queue sees.
+*
+* build : g++ -O2 -std=c++11 -I. caching_service_standin.cpp caching_client.cpp
+*         $(pkg-config --cflags --libs gio-2.0) -o mm_caching_standin
+* usage : mm_caching_standin [serve|sync|async|all] [delay_ms=50] [calls=100]
+*         serve keeps the stand-in running and prints the bus address
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+
+#include <gio/gio.h>
+
+#include "caching_client.h"
+
+using lge::mm::player::CachingClient;
+
+static const gchar kIntrospection[] =
+    "<node>"
+    "  <interface name='" CACHE_INTERFACE_NAME "'>"
+    "    <method name='" CACHE_SETCACHEDMUSIC "'>"
+    "      <arg type='s' direction='in'/><arg type='s' direction='in'/>"
+    "      <arg type='s' direction='out'/><arg type='s' direction='out'/>"
+    "    </method>"
+    "    <method name='" CACHE_SETCACHEDMOVIE "'>"
+    "      <arg type='s' direction='in'/><arg type='s' direction='in'/><arg type='s' direction='in'/>"
+    "      <arg type='s' direction='out'/><arg type='s' direction='out'/><arg type='s' direction='out'/>"
+    "    </method>"
+    "    <method name='" CACHE_GETCACHEDMOVIE "'>"
+    "      <arg type='s' direction='in'/>"
+    "      <arg type='s' direction='out'/><arg type='s' direction='out'/><arg type='s' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+static guint reply_delay_ms = 50;
+static GMainContext* service_context = nullptr;
+static GMainLoop* service_loop = nullptr;
+
+static gboolean ReplyLater(gpointer user_data) {
+    GDBusMethodInvocation* invocation = static_cast<GDBusMethodInvocation*>(user_data);
+    const gchar* method = g_dbus_method_invocation_get_method_name(invocation);
+    GVariant* params = g_dbus_method_invocation_get_parameters(invocation);
+
+    const gchar* url = NULL;
+    g_variant_get_child(params, 0, "&s", &url);
+    if (g_strcmp0(method, CACHE_GETCACHEDMOVIE) == 0) {
+        std::string path = std::string("/tmp/cache/") + (strrchr(url, '/') ? strrchr(url, '/') + 1 : url);
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(sss)", "OK", path.c_str(), ""));
+    } else if (g_strcmp0(method, CACHE_SETCACHEDMOVIE) == 0) {
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(sss)", "OK", url, ""));
+    } else {
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(ss)", "OK", url));
+    }
+    return FALSE;
+}
+
+static void HandleMethod(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                         const gchar* interface_name, const gchar* method_name, GVariant* parameters,
+                         GDBusMethodInvocation* invocation, gpointer user_data) {
+    GSource* source = g_timeout_source_new(reply_delay_ms);
+    g_source_set_callback(source, ReplyLater, invocation, nullptr);
+    g_source_attach(source, service_context);
+    g_source_unref(source);
+}
+
+static void RunService(const std::string& address, std::promise<void>* ready) {
+    g_main_context_push_thread_default(service_context);
+
+    GError* error = NULL;
+    GDBusConnection* connection = g_dbus_connection_new_for_address_sync(address.c_str(),
+        (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                               G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+        NULL, NULL, &error);
+    if (connection == NULL) {
+        fprintf(stderr, "stand-in connection fail : %s\n", error->message);
+        exit(1);
+    }
+
+    static const GDBusInterfaceVTable vtable = { HandleMethod, NULL, NULL, { 0 } };
+    GDBusNodeInfo* node = g_dbus_node_info_new_for_xml(kIntrospection, NULL);
+    g_dbus_connection_register_object(connection, CACHE_OBJECT_PATH, node->interfaces[0], &vtable,
+                                      NULL, NULL, NULL);
+
+    GVariant* owned = g_dbus_connection_call_sync(connection, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                                  "org.freedesktop.DBus", "RequestName",
+                                                  g_variant_new("(su)", CACHE_SERVICE_NAME, 0u),
+                                                  G_VARIANT_TYPE("(u)"), G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (owned)
+        g_variant_unref(owned);
+    ready->set_value();
+
+    g_main_loop_run(service_loop);
+
+    g_dbus_node_info_unref(node);
+    g_object_unref(connection);
+    g_main_context_pop_thread_default(service_context);
+}
+
+// longest gap between 1 ms ticks of the caller's main loop
+struct StallMeter {
+    gint64 last_us = 0;
+    gint64 max_gap_us = 0;
+
+    static gboolean Tick(gpointer user_data) {
+        StallMeter* self = static_cast<StallMeter*>(user_data);
+        gint64 now = g_get_monotonic_time();
+        if (self->last_us > 0)
+            self->max_gap_us = std::max(self->max_gap_us, now - self->last_us);
+        self->last_us = now;
+        return TRUE;
+    }
+};
+
+static void RunSync(const std::string& address, int calls) {
+    StallMeter meter;
+    guint tick = g_timeout_add(1, StallMeter::Tick, &meter);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    int remaining = calls;
+    gint64 begin = g_get_monotonic_time();
+
+    // one blocking call per idle, the tick can only run in between
+    struct Context { std::string address; int* remaining; GMainLoop* loop; } ctx = { address, &remaining, loop };
+    g_idle_add([](gpointer user_data) -> gboolean {
+        Context* c = static_cast<Context*>(user_data);
+        GDBusConnection* conn = g_dbus_connection_new_for_address_sync(c->address.c_str(),
+            (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                   G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+            NULL, NULL, NULL);
+        GVariant* ret = g_dbus_connection_call_sync(conn, CACHE_SERVICE_NAME, CACHE_OBJECT_PATH, CACHE_INTERFACE_NAME,
+                                                    CACHE_GETCACHEDMOVIE, g_variant_new("(s)", "http://cdn/golf/1.mp4"),
+                                                    NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+        if (ret)
+            g_variant_unref(ret);
+        g_object_unref(conn);
+        if (--(*c->remaining) == 0) {
+            g_main_loop_quit(c->loop);
+            return FALSE;
+        }
+        return TRUE;
+    }, &ctx);
+
+    g_main_loop_run(loop);
+    double total_ms = (g_get_monotonic_time() - begin) / 1000.0;
+    printf("%6s %8d %12.2f %14.2f\n", "sync", calls, total_ms / calls, meter.max_gap_us / 1000.0);
+
+    g_source_remove(tick);
+    g_main_loop_unref(loop);
+}
+
+static void RunAsync(const std::string& address, int calls) {
+    g_setenv("MM_CACHING_BUS_ADDRESS", address.c_str(), TRUE);
+
+    StallMeter meter;
+    guint tick = g_timeout_add(1, StallMeter::Tick, &meter);
+    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    int replied = 0;
+    int failed = 0;
+    gint64 begin = g_get_monotonic_time();
+
+    {
+        CachingClient client;
+        // sequential like commands of one PlayerEngine, each waits for its reply
+        std::function<void()> next = [&]() {
+            client.Call(CACHE_GETCACHEDMOVIE, g_variant_new("(s)", "http://cdn/golf/1.mp4"), [&](GVariant* reply) {
+                if (reply == nullptr)
+                    failed++;
+                if (++replied == calls)
+                    g_main_loop_quit(loop);
+                else
+                    next();
+            });
+        };
+        next();
+        g_main_loop_run(loop);
+    }
+
+    double total_ms = (g_get_monotonic_time() - begin) / 1000.0;
+    printf("%6s %8d %12.2f %14.2f   failed=%d\n", "async", calls, total_ms / calls, meter.max_gap_us / 1000.0, failed);
+
+    g_source_remove(tick);
+    g_main_loop_unref(loop);
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = (argc > 1) ? argv[1] : "all";
+    reply_delay_ms = (argc > 2) ? (guint)atoi(argv[2]) : 50;
+    int calls = (argc > 3) ? atoi(argv[3]) : 100;
+
+    if (mode != "serve" && mode != "sync" && mode != "async" && mode != "all") {
+        fprintf(stderr, "usage: %s [serve|sync|async|all] [delay_ms] [calls]\n", argv[0]);
+        return 1;
+    }
+
+    GTestDBus* bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    std::string address = g_test_dbus_get_bus_address(bus);
+
+    service_context = g_main_context_new();
+    service_loop = g_main_loop_new(service_context, FALSE);
+    std::promise<void> ready;
+    std::thread service(RunService, address, &ready);
+    ready.get_future().wait();
+
+    if (mode == "serve") {
+        printf("MM_CACHING_BUS_ADDRESS=%s\n", address.c_str());
+        fflush(stdout);
+        service.join();
+    } else {
+        printf("delay=%ums\n", reply_delay_ms);
+        printf("%6s %8s %12s %14s\n", "mode", "calls", "ms/call", "max stall(ms)");
+        if (mode == "sync" || mode == "all")
+            RunSync(address, calls);
+        if (mode == "async" || mode == "all")
+            RunAsync(address, calls);
+        g_main_loop_quit(service_loop);
+        service.join();
+    }
+
+    g_main_loop_unref(service_loop);
+    g_main_context_unref(service_context);
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return 0;
+}
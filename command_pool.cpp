@@ -0,0 +1,210 @@
+#include "command_pool.h"
+
+#include <stdlib.h>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+namespace command {
+
+// block size of each class, including the header
+static const size_t kClassSize[COMMAND_POOL_CLASS_COUNT] = { 64, 128, 192, 256, 384, 512, 768, 1024 };
+
+// header keeps max_align_t alignment of the object
+static const size_t kHeaderSize = 16;
+static const uint32_t kOversize = 0xff;
+
+struct BlockHeader {
+    uint32_t idx;
+};
+
+CommandPool::ThreadCache::ThreadCache() {
+    for (int i = 0; i < COMMAND_POOL_CLASS_COUNT; i++) {
+        free[i] = nullptr;
+        count[i] = 0;
+    }
+}
+
+CommandPool::ThreadCache::~ThreadCache() {
+    for (int i = 0; i < COMMAND_POOL_CLASS_COUNT; i++)
+        CommandPool::Instance().Flush(i, *this, 0);
+}
+
+CommandPool& CommandPool::Instance() {
+    // never destroyed, commands may be deleted by static destructors
+    static CommandPool* pool = new CommandPool();
+    return *pool;
+}
+
+CommandPool::CommandPool()
+  : chunk_mutex_(),
+    chunks_(),
+    allocated_(0),
+    released_(0),
+    cache_hits_(0),
+    oversize_(0) {
+    for (auto& c : classes_) {
+        c.free = nullptr;
+        c.count = 0;
+    }
+}
+
+CommandPool::ThreadCache& CommandPool::Cache() {
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+int CommandPool::ClassOf(size_t size) {
+    size += kHeaderSize;
+    for (int i = 0; i < COMMAND_POOL_CLASS_COUNT; i++) {
+        if (size <= kClassSize[i])
+            return i;
+    }
+    return -1;
+}
+
+bool CommandPool::Refill(int idx, ThreadCache& cache) {
+    SizeClass& sc = classes_[idx];
+    {
+        std::lock_guard<std::mutex> locker(sc.mutex);
+        while (sc.free && cache.count[idx] < COMMAND_POOL_THREAD_CACHE / 2) {
+            FreeBlock* block = sc.free;
+            sc.free = block->next;
+            sc.count--;
+            block->next = cache.free[idx];
+            cache.free[idx] = block;
+            cache.count[idx]++;
+        }
+    }
+    if (cache.free[idx])
+        return true;
+
+    char* chunk = static_cast<char*>(malloc(COMMAND_POOL_CHUNK_SIZE));
+    if (chunk == nullptr) {
+        MMLogError("failed to allocate command chunk");
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> locker(chunk_mutex_);
+        chunks_.push_back(chunk);
+    }
+
+    size_t n = COMMAND_POOL_CHUNK_SIZE / kClassSize[idx];
+    std::vector<FreeBlock*> blocks;
+    for (size_t i = 0; i < n; i++) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * kClassSize[idx]);
+        if (cache.count[idx] < COMMAND_POOL_THREAD_CACHE) {
+            block->next = cache.free[idx];
+            cache.free[idx] = block;
+            cache.count[idx]++;
+        } else {
+            blocks.push_back(block);
+        }
+    }
+
+    std::lock_guard<std::mutex> locker(sc.mutex);
+    for (auto block : blocks) {
+        block->next = sc.free;
+        sc.free = block;
+        sc.count++;
+    }
+    return true;
+}
+
+void CommandPool::Flush(int idx, ThreadCache& cache, size_t keep) {
+    if (cache.count[idx] <= keep)
+        return;
+
+    SizeClass& sc = classes_[idx];
+    std::lock_guard<std::mutex> locker(sc.mutex);
+    while (cache.count[idx] > keep) {
+        FreeBlock* block = cache.free[idx];
+        cache.free[idx] = block->next;
+        cache.count[idx]--;
+        block->next = sc.free;
+        sc.free = block;
+        sc.count++;
+    }
+}
+
+void* CommandPool::Allocate(size_t size) noexcept {
+    allocated_.fetch_add(1, std::memory_order_relaxed);
+
+    int idx = ClassOf(size);
+    char* block = nullptr;
+    if (idx < 0) {
+        oversize_.fetch_add(1, std::memory_order_relaxed);
+        block = static_cast<char*>(malloc(size + kHeaderSize));
+        if (block == nullptr)
+            return nullptr;
+        reinterpret_cast<BlockHeader*>(block)->idx = kOversize;
+        return block + kHeaderSize;
+    }
+
+    ThreadCache& cache = Cache();
+    if (cache.free[idx]) {
+        cache_hits_.fetch_add(1, std::memory_order_relaxed);
+    } else if (!Refill(idx, cache)) {
+        return nullptr;
+    }
+
+    FreeBlock* fb = cache.free[idx];
+    cache.free[idx] = fb->next;
+    cache.count[idx]--;
+
+    block = reinterpret_cast<char*>(fb);
+    reinterpret_cast<BlockHeader*>(block)->idx = idx;
+    return block + kHeaderSize;
+}
+
+void CommandPool::Release(void* ptr) noexcept {
+    if (ptr == nullptr)
+        return;
+    released_.fetch_add(1, std::memory_order_relaxed);
+
+    char* block = static_cast<char*>(ptr) - kHeaderSize;
+    uint32_t idx = reinterpret_cast<BlockHeader*>(block)->idx;
+    if (idx == kOversize) {
+        free(block);
+        return;
+    }
+
+    ThreadCache& cache = Cache();
+    FreeBlock* fb = reinterpret_cast<FreeBlock*>(block);
+    fb->next = cache.free[idx];
+    cache.free[idx] = fb;
+    cache.count[idx]++;
+
+    // the consumer thread only releases, give the half back for producers
+    if (cache.count[idx] > COMMAND_POOL_THREAD_CACHE)
+        Flush(idx, cache, COMMAND_POOL_THREAD_CACHE / 2);
+}
+
+CommandPool::Stats CommandPool::GetStats() const {
+    Stats stats;
+    stats.allocated = allocated_.load(std::memory_order_relaxed);
+    stats.released = released_.load(std::memory_order_relaxed);
+    stats.cache_hits = cache_hits_.load(std::memory_order_relaxed);
+    stats.oversize = oversize_.load(std::memory_order_relaxed);
+    stats.in_use = stats.allocated - stats.released;
+    {
+        std::lock_guard<std::mutex> locker(chunk_mutex_);
+        stats.chunks = chunks_.size();
+    }
+    return stats;
+}
+
+void CommandPool::LogStats() const {
+    Stats stats = GetStats();
+    MMLogInfo("command pool: alloc=[%llu], free=[%llu], in_use=[%llu], cache_hit=[%llu], chunks=[%llu](%lluKB), oversize=[%llu]",
+              (unsigned long long)stats.allocated, (unsigned long long)stats.released,
+              (unsigned long long)stats.in_use, (unsigned long long)stats.cache_hits,
+              (unsigned long long)stats.chunks, (unsigned long long)(stats.chunks * COMMAND_POOL_CHUNK_SIZE / 1024),
+              (unsigned long long)stats.oversize);
+    (void)stats; // MMLogInfo may be compiled out
+}
+
+} // namespace command
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,132 @@
+/**
+* @file command_pool.h
+* @version 1.0
+* Header for recycling allocator of command objects
+*/
+
+#ifndef COMMAND_POOL_H_
+#define COMMAND_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace lge {
+namespace mm {
+namespace command {
+
+#define COMMAND_POOL_CHUNK_SIZE   (64 * 1024) // bytes taken from the heap when a size class runs out
+#define COMMAND_POOL_THREAD_CACHE 32          // blocks kept by each thread per size class
+#define COMMAND_POOL_CLASS_COUNT  8
+
+/**
+* @class lge::mm::command::CommandPool
+* @brief Size-class free-list allocator for BaseCommand objects.
+* @details Blocks are carved from chunks and never given back to the heap, they are recycled.<BR>
+*          Each thread keeps a small cache per size class, so CommonAPI threads allocating and<BR>
+*          EventSystem thread releasing take the shared lock only once per batch.<BR>
+*          Objects bigger than the largest class fall back to malloc.
+*/
+class CommandPool {
+public:
+    struct Stats {
+        uint64_t allocated;    // Allocate() calls
+        uint64_t released;     // Release() calls
+        uint64_t cache_hits;   // served from thread cache without lock
+        uint64_t chunks;       // chunks taken from heap
+        uint64_t oversize;     // served by malloc
+        uint64_t in_use;       // live blocks
+    };
+
+    static CommandPool& Instance();
+
+    /**
+    * @fn Allocate
+    * @brief Returns a block which can hold size bytes.
+    * @param[in] size : object size
+    * @return void* (nullptr - out of memory)
+    */
+    void* Allocate(size_t size) noexcept;
+
+    /**
+    * @fn Release
+    * @brief Returns the block to the free list of its size class.
+    * @param[in] ptr : block returned by Allocate()
+    * @return : None
+    */
+    void Release(void* ptr) noexcept;
+
+    Stats GetStats() const;
+    void LogStats() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SizeClass {
+        std::mutex mutex;
+        FreeBlock* free;
+        size_t count;
+    };
+
+    struct ThreadCache {
+        FreeBlock* free[COMMAND_POOL_CLASS_COUNT];
+        size_t count[COMMAND_POOL_CLASS_COUNT];
+        ThreadCache();
+        ~ThreadCache();
+    };
+
+    CommandPool();
+    CommandPool(const CommandPool&) = delete;
+    CommandPool& operator=(const CommandPool&) = delete;
+
+    static int ClassOf(size_t size);
+    static ThreadCache& Cache();
+    bool Refill(int idx, ThreadCache& cache);
+    void Flush(int idx, ThreadCache& cache, size_t keep);
+
+    SizeClass classes_[COMMAND_POOL_CLASS_COUNT];
+    mutable std::mutex chunk_mutex_;
+    std::vector<void*> chunks_;
+
+    std::atomic<uint64_t> allocated_;
+    std::atomic<uint64_t> released_;
+    std::atomic<uint64_t> cache_hits_;
+    std::atomic<uint64_t> oversize_;
+};
+
+/**
+* @class lge::mm::command::PooledObject
+* @brief Base of BaseCommand, routes new/delete of every command to CommandPool.
+*/
+class PooledObject {
+public:
+    static void* operator new(size_t size) {
+        void* ptr = CommandPool::Instance().Allocate(size);
+        if (ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    static void* operator new(size_t size, const std::nothrow_t&) noexcept {
+        return CommandPool::Instance().Allocate(size);
+    }
+
+    static void operator delete(void* ptr) noexcept {
+        CommandPool::Instance().Release(ptr);
+    }
+
+    static void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+        CommandPool::Instance().Release(ptr);
+    }
+};
+
+} // namespace command
+} // namespace mm
+} // namespace lge
+
+#endif  // COMMAND_POOL_H_
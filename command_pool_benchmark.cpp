@@ -0,0 +1,148 @@
+/**
+* @file command_pool_benchmark.cpp
+* @version 1.0
+* Benchmark of command allocation with the heap against CommandPool.
+*
+* Producer threads allocate mixed size commands like CommonAPI threads do and post them
+* to a MPSC queue, one consumer thread deletes them like EventSystem does.
+* Run each mode in its own process, so RSS of one mode does not hide the other.
+*
+* build : g++ -O2 -std=c++11 -pthread -I. command_pool_benchmark.cpp command_pool.cpp -o cmd_pool_bench
+* usage : cmd_pool_bench [heap|pool] [commands=4000000] [producers=4] [rounds=5]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_pool.h"
+#include "mpsc_queue.h"
+
+using lge::mm::BoundedMpscQueue;
+using lge::mm::command::CommandPool;
+using lge::mm::command::PooledObject;
+
+struct HeapBase {
+    virtual ~HeapBase() {}
+};
+
+template<typename Base>
+struct Command : public Base {
+    Command(int type, const std::string& name) : type(type), connectionName(name) {}
+    int type;
+    std::string connectionName;
+};
+
+// sizes of real commands vary from a few members to OpenUri with uri and channel map
+template<typename Base, size_t N>
+struct SizedCommand : public Command<Base> {
+    SizedCommand(int type, const std::string& name) : Command<Base>(type, name) {
+        memset(payload, type, sizeof(payload));
+    }
+    char payload[N];
+};
+
+template<typename Base>
+static Command<Base>* MakeCommand(unsigned seed, const std::string& name) {
+    switch (seed % 6) {
+    case 0: return new (std::nothrow) SizedCommand<Base, 8>(0, name);      // Play, Pause
+    case 1: return new (std::nothrow) SizedCommand<Base, 24>(1, name);     // Seek, SetPosition
+    case 2: return new (std::nothrow) SizedCommand<Base, 40>(2, name);     // SetRate, SetVolume
+    case 3: return new (std::nothrow) SizedCommand<Base, 120>(3, name);    // OpenTrack
+    case 4: return new (std::nothrow) SizedCommand<Base, 300>(4, name);    // OpenUri
+    default: return new (std::nothrow) SizedCommand<Base, 16>(5, name);    // Stop
+    }
+}
+
+static long CurrentRssKb() {
+    long rss = 0;
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        long size = 0;
+        if (fscanf(fp, "%ld %ld", &size, &rss) != 2)
+            rss = 0;
+        fclose(fp);
+    }
+    return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+template<typename Base>
+static double Run(size_t commands, int producers) {
+    BoundedMpscQueue<Command<Base>*> queue(4096);
+    std::atomic<int> running(producers);
+    std::vector<std::thread> threads;
+    const std::string name(":1.123");
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            size_t n = commands / producers;
+            for (size_t i = 0; i < n; i++) {
+                Command<Base>* cmd = MakeCommand<Base>((unsigned)(i * 7 + p), name);
+                while (!queue.TryPush(cmd))
+                    std::this_thread::yield();
+            }
+            running--;
+        });
+    }
+
+    std::thread consumer([&]() {
+        Command<Base>* cmd = nullptr;
+        while (1) {
+            if (queue.TryPop(cmd)) {
+                delete cmd;
+            } else if (running == 0) {
+                if (!queue.TryPop(cmd))
+                    break;
+                delete cmd;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (auto& t : threads)
+        t.join();
+    consumer.join();
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+int main(int argc, char *argv[]) {
+    std::string mode = (argc > 1) ? argv[1] : "pool";
+    size_t commands = (argc > 2) ? strtoul(argv[2], NULL, 10) : 4000000;
+    int producers = (argc > 3) ? atoi(argv[3]) : 4;
+    int rounds = (argc > 4) ? atoi(argv[4]) : 5;
+
+    if (mode != "heap" && mode != "pool") {
+        fprintf(stderr, "usage: %s [heap|pool] [commands] [producers] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    printf("mode=%s commands=%zu producers=%d\n", mode.c_str(), commands, producers);
+    printf("%6s %12s %14s %10s\n", "round", "time(ms)", "ns/command", "rss(KB)");
+
+    for (int r = 0; r < rounds; r++) {
+        double ms = (mode == "heap") ? Run<HeapBase>(commands, producers)
+                                     : Run<PooledObject>(commands, producers);
+        printf("%6d %12.1f %14.1f %10ld\n", r, ms, ms * 1e6 / commands, CurrentRssKb());
+        fflush(stdout);
+    }
+
+    if (mode == "pool") {
+        CommandPool::Stats stats = CommandPool::Instance().GetStats();
+        printf("alloc=%llu free=%llu cache_hit=%.1f%% chunks=%llu oversize=%llu\n",
+               (unsigned long long)stats.allocated, (unsigned long long)stats.released,
+               stats.allocated ? 100.0 * stats.cache_hits / stats.allocated : 0.0,
+               (unsigned long long)stats.chunks, (unsigned long long)stats.oversize);
+    }
+    return 0;
+}
@@ -1,120 +1,313 @@
 #include "command_queue.h"
 
+#include <algorithm>
+#include <set>
+
+#include "command_recorder.h"
+#include "fast_logger.h"
 #include "player_logger.h"
 
+#ifndef COMMAND_QUEUE_CAPACITY
+#define COMMAND_QUEUE_CAPACITY 1024 // posts not drained yet, more are rejected
+#endif
+
+#ifndef COMMAND_QUEUE_FRONT_CAPACITY
+#define COMMAND_QUEUE_FRONT_CAPACITY 64 // PostFront() not drained yet, more are rejected
+#endif
+
 namespace lge {
 namespace mm {
 namespace command {
 
 Queue::Queue()
-  : queue_(),
-    mutex_(),
+  : ring_(COMMAND_QUEUE_CAPACITY),
+    front_(COMMAND_QUEUE_FRONT_CAPACITY),
+    draining_(false),
+    pending_(),
+    slots_(),
+    notified_(false),
     callback_(nullptr) {}
 
 void Queue::RegisterCallback(CommandArrivedCallback cb) {
     callback_ = cb;
 }
 
+void Queue::Notify() {
+    // only the first producer after the consumer re-armed wakes it up
+    if (!notified_.exchange(true, std::memory_order_acq_rel) && callback_)
+        callback_();
+}
+
+void Queue::Rearm() {
+    notified_.store(false, std::memory_order_seq_cst);
+
+    if (HasIncoming())
+        Notify();
+}
+
+// commands which are posted but not drained yet. pending_ is moved by the consumer by itself
+bool Queue::HasIncoming() {
+    return front_.SizeApprox() != 0 || ring_.SizeApprox() != 0;
+}
+
+// Seek and SetPosition replace each other, as both decide the position of the media
+bool Queue::CoalesceGroup(CommandType type, CommandType& group) {
+    switch (type) {
+    case CommandType::Seek:
+    case CommandType::SetPosition:
+        group = CommandType::Seek;
+        return true;
+    case CommandType::SetRate:
+    case CommandType::SetVolume:
+        group = type;
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t Queue::SlotKeyHash::operator()(const SlotKey& key) const {
+    return std::hash<std::string>()(key.second) ^ ((size_t)key.first << 1);
+}
+
+// a coalescable command replaces the pending one of its slot, so a slot has one queue entry
+void Queue::Enqueue(BaseCommand* bc, bool to_front) {
+    CommandType group;
+    if (!CoalesceGroup(bc->type, group)) {
+        to_front ? pending_.push_front(bc) : pending_.push_back(bc);
+        return;
+    }
+
+    BaseCommand*& latest = slots_[SlotKey(group, bc->connectionName)];
+    BaseCommand* superseded = latest;
+    latest = bc;
+    if (superseded == nullptr) {
+        to_front ? pending_.push_front(bc) : pending_.push_back(bc);
+        return;
+    }
+
+    auto it = std::find(pending_.begin(), pending_.end(), superseded);
+    if (!to_front && it != pending_.end() && !QueuedAfter(it, bc->connectionName)) {
+        *it = bc;
+    } else {
+        // keeps its own place against a command to the same engine queued in between
+        if (it != pending_.end())
+            pending_.erase(it);
+        to_front ? pending_.push_front(bc) : pending_.push_back(bc);
+    }
+    Supersede(superseded);
+}
+
+bool Queue::QueuedAfter(std::deque<BaseCommand*>::iterator it, const std::string& connection_name) {
+    for (it++; it != pending_.end(); it++) {
+        if ((*it)->connectionName.empty() || (*it)->connectionName == connection_name)
+            return true;
+    }
+    return false;
+}
+
+void Queue::Supersede(BaseCommand* bc) {
+    MMLogDebug("command(%d) to [%s] is superseded", (int)bc->type, bc->connectionName.c_str());
+
+    // the caller gets NO_ERROR, the same as a command skipped when it runs
+    Recorder::Instance().OnDone(bc);
+    bc->Complete();
+    delete bc;
+}
+
+void Queue::Unindex(BaseCommand* bc) {
+    CommandType group;
+    if (!CoalesceGroup(bc->type, group))
+        return;
+
+    auto it = slots_.find(SlotKey(group, bc->connectionName));
+    if (it != slots_.end() && it->second == bc)
+        slots_.erase(it);
+}
+
+void Queue::Drain() {
+    // a condition of PostIf() may look at the queue, it sees what was posted before its command
+    if (draining_)
+        return;
+    draining_ = true;
+
+    // commands posted to front are taken oldest first, each goes before the one before it
+    BaseCommand* bc = nullptr;
+    while (front_.TryPop(bc))
+        Enqueue(bc, true);
+
+    Posted posted;
+    while (ring_.TryPop(posted)) {
+        if (posted.condition && !Admit(posted))
+            continue;
+        Enqueue(posted.bc, false);
+    }
+    draining_ = false;
+}
+
+// the condition runs on the thread which pops commands, so no Pop() comes between it and the post
+bool Queue::Admit(const Posted& posted) {
+    bool admitted = (*posted.condition)();
+    delete posted.condition;
+    if (admitted)
+        return true;
+
+    MMLogDebug("command(%d) to [%s] is not posted by its condition", (int)posted.bc->type,
+               posted.bc->connectionName.c_str());
+    Recorder::Instance().OnDone(posted.bc);
+    posted.bc->Complete();
+    delete posted.bc;
+    return false;
+}
+
+// a producer may be the thread which pops commands, so a full queue never blocks
+void Queue::Reject(BaseCommand* bc, std::function<bool(void)>* condition) {
+    MMLogError("command queue is full, command(%d) to [%s] is rejected", (int)bc->type, bc->connectionName.c_str());
+    delete condition;
+    Recorder::Instance().OnDone(bc);
+    bc->e = ::v1::org::genivi::mediamanager::PlayerTypes::PlayerError::MEDIA_MANAGER_INTERNAL_ERROR;
+    bc->Complete();
+    delete bc;
+}
+
 BaseCommand* Queue::Pop() {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
     BaseCommand* bc = nullptr;
 
-    if (queue_.empty())
+    Drain();
+    if (pending_.empty()) {
+        Rearm();
         return bc;
+    }
 
-    bc = queue_.front();
-    queue_.pop_front();
+    bc = pending_.front();
+    pending_.pop_front();
+    Unindex(bc);
 
     return bc;
 }
 
-void Queue::PostNoGurad(BaseCommand* bc, bool to_front) {
-    if (to_front == true)
-        queue_.push_front(bc);
-    else
-        queue_.push_back(bc);
+BaseCommand* Queue::Pop(const std::function<bool(const BaseCommand*)>& runnable) {
+    std::set<std::string> blocked;
 
-    if (callback_ && queue_.size() == 1)
-        callback_();
-}
+    Drain();
+    for (auto it = pending_.begin(); it != pending_.end(); it++) {
+        BaseCommand* bc = *it;
+        bool cross_engine = bc->connectionName.empty();
 
-void Queue::PostFront(BaseCommand* bc) {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
+        // keeps order of commands to the same PlayerEngine
+        if (!cross_engine && blocked.count(bc->connectionName))
+            continue;
 
-    PostNoGurad(bc, true);
-}
+        if (runnable(bc)) {
+            pending_.erase(it);
+            Unindex(bc);
+            return bc;
+        }
 
-void Queue::Post(BaseCommand* bc) {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
+        // commands behind a cross-engine command wait until it is done
+        if (cross_engine)
+            break;
+        blocked.insert(bc->connectionName);
+    }
 
-    PostNoGurad(bc, false);
+    return nullptr;
 }
 
-void Queue::PostIf(BaseCommand* bc, const std::function<bool(void)>& fn) {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
+void Queue::PostNoGurad(BaseCommand* bc, bool to_front, std::function<bool(void)>* condition) {
+    // before publishing, consumer may delete bc as soon as it is posted
+    Recorder::Instance().OnPost(bc, to_front);
 
-    if (!fn())
+    bool posted = to_front ? front_.TryPush(bc) : ring_.TryPush(Posted{bc, condition});
+    if (!posted) {
+        Reject(bc, condition);
         return;
+    }
+    Notify();
+}
+
+void Queue::PostFront(BaseCommand* bc) {
+    PostNoGurad(bc, true, nullptr);
+}
+
+void Queue::Post(BaseCommand* bc) {
+    PostNoGurad(bc, false, nullptr);
+}
 
-    PostNoGurad(bc, false);
+void Queue::PostIf(BaseCommand* bc, const std::function<bool(void)>& fn) {
+    PostNoGurad(bc, false, new std::function<bool(void)>(fn));
 }
 
+// Pop, Exist, Size and Clear are called only from the EventSystem thread which runs commands
+// and PlayerEngine signal handlers, so pending_ and slots_ need no lock.
 bool Queue::Exist(const std::vector<CommandType>& compare_list, std::string connection_name) {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
-    std::string name = "";
+    bool need_scan = false;
 
-    if (queue_.empty())
+    Drain();
+    if (pending_.empty())
         return false;
 
-    for (auto& cmd : queue_) {
-        name = cmd->connectionName;
-
-        if (cmd->type == CommandType::OpenUri){
-            MMLogInfo("Item in queue : [OpenUri] [%s]", name.c_str());
-        } else if (cmd->type == CommandType::Pause) {
-            MMLogInfo("Item in queue : [Pause] [%s]", name.c_str() );
-        } else if (cmd->type == CommandType::Play) {
-            MMLogInfo("Item in queue : [Play] [%s]", name.c_str() );
-        } else if (cmd->type == CommandType::Seek) {
-            MMLogInfo("Item in queue : [Seek] [%s]", name.c_str() );
-        } else if (cmd->type == CommandType::SetPosition) {
-            MMLogInfo("Item in queue : [SetPosition] [%s]", name.c_str() );
-        } else if (cmd->type == CommandType::Stop) {
-            MMLogInfo("Item in queue : [Stop] [%s]", name.c_str() );
-        } else {
-            //MMLogInfo("We do not check this command type");
+    // coalescable commands are found from the slot index without walking the queue
+    for (auto& v : compare_list) {
+        CommandType group;
+        if (!CoalesceGroup(v, group)) {
+            need_scan = true;
+            continue;
         }
+        auto it = slots_.find(SlotKey(group, connection_name));
+        if (it != slots_.end() && it->second->type == v) {
+            MMFastLogInfo("Find a duplicated command(%d) [%s]", (int)v, connection_name.c_str());
+            return true;
+        }
+    }
+
+    if (!need_scan)
+        return false;
+
+    for (auto& cmd : pending_) {
+        if (connection_name.compare(cmd->connectionName) != 0)
+            continue;
 
         for (auto& v : compare_list) {
-            if ((cmd->type == v) && (connection_name.compare(cmd->connectionName) == 0)) {
-                MMLogInfo("Find a duplicated command [%s]", connection_name.c_str() );
+            CommandType group;
+            if (cmd->type == v && !CoalesceGroup(v, group)) {
+                MMFastLogInfo("Find a duplicated command(%d) [%s]", (int)v, connection_name.c_str());
                 return true;
             }
         }
-
-        MMLogInfo("There is no command to [%s]", connection_name.c_str() );
     }
 
+    MMFastLogInfo("There is no command to [%s]", connection_name.c_str());
     return false;
 }
 
+bool Queue::Superseded(const BaseCommand* bc) {
+    CommandType group;
+    if (!CoalesceGroup(bc->type, group))
+        return false;
+
+    Drain();
+    auto it = slots_.find(SlotKey(group, bc->connectionName));
+    return (it != slots_.end() && it->second != bc);
+}
+
 uint64_t Queue::Size() {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
-    return queue_.size();
+    Drain();
+    return pending_.size();
 }
 
 void Queue::Clear() {
-    std::lock_guard<std::recursive_mutex> locker(mutex_);
     BaseCommand *command = nullptr;
 
-    while(queue_.size()){
-        command = queue_.front();
+    Drain();
+    while(pending_.size()){
+        command = pending_.front();
+        Recorder::Instance().OnDone(command);
         delete command;
-        queue_.pop_front();
+        pending_.pop_front();
     }
+    slots_.clear();
 }
 
 } // namespace command
 } // namespace mm
 } // namespace lge
-
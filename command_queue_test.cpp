@@ -0,0 +1,203 @@
+/**
+* @file command_queue_test.cpp
+* @version 1.0
+* Test of coalescing, conditional and rejected posts in command::Queue.
+*
+* A flood of Seek to one PlayerEngine keeps a single queue entry which runs once with the
+* latest position, and every superseded caller gets its reply. The replaced command keeps
+* the order against other commands to the same PlayerEngine. Every command recorded as
+* posted is recorded as done, also when it is superseded or cleared. The condition of
+* PostIf() sees the commands posted before it, and a post beyond the capacity is rejected
+* with a reply instead of blocking.
+*
+* build : g++ -std=c++11 -pthread -I. command_queue_test.cpp command_queue.cpp command_recorder.cpp fast_logger.cpp -o command_queue_test
+* usage : command_queue_test
+*/
+
+#include <stdio.h>
+#include <set>
+#include <vector>
+
+#include "command_queue.h"
+#include "command_recorder.h"
+#include "test_check.h"
+
+using namespace lge::mm::command;
+using PlayerError = ::v1::org::genivi::mediamanager::PlayerTypes::PlayerError;
+
+static int64_t PositionOf(BaseCommand* bc) {
+    if (bc->type == CommandType::SetPosition)
+        return static_cast<SetPositionCommand*>(bc)->pos_us;
+    return static_cast<SeekCommand*>(bc)->pos_us;
+}
+
+static void TestFlood() {
+    const int requests = 1000;
+    Queue queue;
+    int replied = 0;
+
+    for (int i = 0; i < requests; i++) {
+        queue.Post(new SeekCommand(nullptr, i, "A", [&replied](PlayerError e) {
+            if (e == PlayerError::NO_ERROR)
+                replied++;
+        }));
+    }
+
+    CHECK(queue.Size() == 1);
+    CHECK(replied == requests - 1);
+
+    BaseCommand* bc = queue.Pop();
+    CHECK(bc != nullptr);
+    if (bc) {
+        CHECK(bc->type == CommandType::Seek);
+        CHECK(PositionOf(bc) == requests - 1);
+        delete bc;
+    }
+    CHECK(queue.Pop() == nullptr);
+}
+
+static void TestOrderOnSameEngine() {
+    Queue queue;
+
+    // the second Seek must not run before Play which was requested in between
+    queue.Post(new SeekCommand(nullptr, 1, "A", nullptr));
+    queue.Post(new PlayCommand(nullptr, "A", nullptr));
+    queue.Post(new SeekCommand(nullptr, 2, "A", nullptr));
+    CHECK(queue.Size() == 2);
+
+    BaseCommand* bc = queue.Pop();
+    CHECK(bc && bc->type == CommandType::Play);
+    delete bc;
+    bc = queue.Pop();
+    CHECK(bc && bc->type == CommandType::Seek && PositionOf(bc) == 2);
+    delete bc;
+    CHECK(queue.Pop() == nullptr);
+}
+
+static void TestInPlaceAcrossEngines() {
+    Queue queue;
+
+    // a command to another engine does not move the Seek of A back
+    queue.Post(new SeekCommand(nullptr, 1, "A", nullptr));
+    queue.Post(new SeekCommand(nullptr, 5, "B", nullptr));
+    queue.Post(new SeekCommand(nullptr, 2, "A", nullptr));
+    CHECK(queue.Size() == 2);
+
+    BaseCommand* bc = queue.Pop();
+    CHECK(bc && bc->connectionName == "A" && PositionOf(bc) == 2);
+    delete bc;
+    bc = queue.Pop();
+    CHECK(bc && bc->connectionName == "B" && PositionOf(bc) == 5);
+    delete bc;
+}
+
+static void TestSetPositionSupersedesSeek() {
+    Queue queue;
+    bool seek_replied = false;
+
+    queue.Post(new SeekCommand(nullptr, 1, "A", [&seek_replied](PlayerError) { seek_replied = true; }));
+    queue.Post(new SetPositionCommand(nullptr, false, 7, "A", nullptr));
+    CHECK(queue.Size() == 1);
+    CHECK(seek_replied);
+    CHECK(!queue.Exist({CommandType::Seek}, "A"));
+    CHECK(queue.Exist({CommandType::SetPosition}, "A"));
+
+    BaseCommand* bc = queue.Pop();
+    CHECK(bc && bc->type == CommandType::SetPosition && PositionOf(bc) == 7);
+    delete bc;
+}
+
+static void TestRecordedDone() {
+    std::set<uint64_t> open_seqs;
+    Recorder::Instance().SetObserver([&open_seqs](const Record& record) {
+        if (record.kind == RecordKind::Post)
+            open_seqs.insert(record.seq);
+        else if (record.kind == RecordKind::Done)
+            open_seqs.erase(record.seq);
+    });
+
+    {
+        Queue queue;
+        for (int i = 0; i < 100; i++)
+            queue.Post(new SeekCommand(nullptr, i, "A", nullptr));
+        queue.Post(new PlayCommand(nullptr, "A", nullptr));
+        queue.Post(new SetRateCommand(nullptr, 2.0, "B"));
+        CHECK(queue.Size() == 3);
+        CHECK(open_seqs.size() == 3);
+
+        // the Seek runs, the others are flushed
+        BaseCommand* bc = queue.Pop();
+        CHECK(bc && bc->type == CommandType::Seek);
+        Recorder::Instance().OnStart(bc);
+        Recorder::Instance().OnDone(bc);
+        delete bc;
+        queue.Clear();
+        CHECK(queue.Size() == 0);
+    }
+
+    Recorder::Instance().SetObserver(nullptr);
+    CHECK(open_seqs.empty());
+}
+
+static void TestPostIf() {
+    Queue queue;
+    std::vector<bool> seen;
+    PlayerError reply = PlayerError::BACKEND_UNREACHABLE;
+
+    queue.Post(new PlayCommand(nullptr, "A", nullptr));
+    // evaluated when drained, no Pop() in between
+    queue.PostIf(new PlayCommand(nullptr, "A", [&reply](PlayerError e) { reply = e; }), [&queue, &seen]() {
+        seen.push_back(queue.Exist({CommandType::Play}, "A"));
+        return false;
+    });
+    queue.PostIf(new PlayCommand(nullptr, "B", nullptr), [&queue, &seen]() {
+        seen.push_back(queue.Exist({CommandType::Play}, "B"));
+        return true;
+    });
+    CHECK(seen.empty());
+    CHECK(queue.Size() == 2);
+    CHECK(seen.size() == 2 && seen[0] && !seen[1]);
+    CHECK(reply == PlayerError::NO_ERROR);
+    queue.Clear();
+}
+
+static void TestFullRejects() {
+    Queue queue;
+    int rejected = 0;
+
+    for (int i = 0; i < 1024; i++)
+        queue.Post(new PlayCommand(nullptr, "A", nullptr));
+    queue.Post(new PlayCommand(nullptr, "A", [&rejected](PlayerError e) {
+        if (e == PlayerError::MEDIA_MANAGER_INTERNAL_ERROR)
+            rejected++;
+    }));
+    CHECK(rejected == 1);
+    CHECK(queue.Size() == 1024);
+
+    // drained, room again
+    queue.Post(new PlayCommand(nullptr, "B", nullptr));
+    CHECK(queue.Size() == 1025);
+
+    // commands posted to front are taken latest first
+    queue.PostFront(new PlayCommand(nullptr, "C", nullptr));
+    queue.PostFront(new PlayCommand(nullptr, "D", nullptr));
+    BaseCommand* bc = queue.Pop();
+    CHECK(bc && bc->connectionName == "D");
+    delete bc;
+    bc = queue.Pop();
+    CHECK(bc && bc->connectionName == "C");
+    delete bc;
+    queue.Clear();
+}
+
+int main() {
+    TestFlood();
+    TestOrderOnSameEngine();
+    TestInPlaceAcrossEngines();
+    TestSetPositionSupersedesSeek();
+    TestRecordedDone();
+    TestPostIf();
+    TestFullRejects();
+
+    return TestResult("command_queue_test");
+}
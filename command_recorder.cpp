@@ -0,0 +1,320 @@
+#include "command_recorder.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sstream>
+
+#include "commands.h"
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+namespace command {
+
+static uint64_t MonotonicUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t WallClockUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+Recorder& Recorder::Instance() {
+    static Recorder recorder;
+    return recorder;
+}
+
+Recorder::Recorder()
+  : enabled_(false),
+    mutex_(),
+    fp_(nullptr),
+    begin_us_(0),
+    last_us_(0),
+    next_seq_(1),
+    seq_(),
+    observer_(nullptr) {
+    const char* path = getenv(COMMAND_RECORD_FILE_ENV);
+    if (path && *path)
+        Open(path);
+}
+
+Recorder::~Recorder() {
+    Close();
+}
+
+bool Recorder::Open(const std::string& path) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (fp_)
+        fclose(fp_);
+    fp_ = fopen(path.c_str(), "wb");
+    if (fp_ == nullptr) {
+        MMLogError("failed to open record file [%s]", path.c_str());
+        return false;
+    }
+
+    uint64_t wall = WallClockUs();
+    fwrite(COMMAND_RECORD_MAGIC, 1, 8, fp_);
+    fwrite(&wall, sizeof(wall), 1, fp_);
+
+    begin_us_ = last_us_ = MonotonicUs();
+    enabled_ = true;
+    MMLogInfo("recording commands to [%s]", path.c_str());
+    return true;
+}
+
+void Recorder::Close() {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (fp_) {
+        fclose(fp_);
+        fp_ = nullptr;
+    }
+    seq_.clear();
+    enabled_ = (observer_ != nullptr);
+}
+
+void Recorder::SetObserver(Observer observer) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    observer_ = observer;
+    if (observer_ && begin_us_ == 0)
+        begin_us_ = last_us_ = MonotonicUs();
+    enabled_ = (fp_ != nullptr || observer_ != nullptr);
+}
+
+void Recorder::PutVarint(uint64_t v) {
+    uint8_t buf[10];
+    size_t n = 0;
+    do {
+        buf[n] = v & 0x7f;
+        v >>= 7;
+        if (v)
+            buf[n] |= 0x80;
+        n++;
+    } while (v);
+    fwrite(buf, 1, n, fp_);
+}
+
+void Recorder::PutString(const std::string& s) {
+    PutVarint(s.size());
+    fwrite(s.data(), 1, s.size(), fp_);
+}
+
+void Recorder::Write(Record& record) {
+    uint64_t now = MonotonicUs();
+    record.time_us = now - begin_us_;
+
+    if (observer_)
+        observer_(record);
+    if (fp_ == nullptr)
+        return;
+
+    uint8_t kind = (uint8_t)record.kind;
+    fwrite(&kind, 1, 1, fp_);
+    PutVarint(now - last_us_);
+    PutVarint(record.seq);
+    last_us_ = now;
+
+    switch (record.kind) {
+    case RecordKind::Post:
+        PutVarint(record.type);
+        fwrite(&record.flags, 1, 1, fp_);
+        PutString(record.name);
+        PutString(record.payload);
+        break;
+    case RecordKind::Signal:
+        PutString(record.name);
+        PutString(record.payload);
+        break;
+    default:
+        break;
+    }
+}
+
+void Recorder::OnPost(const BaseCommand* bc, bool to_front) {
+    if (!Enabled() || bc == nullptr)
+        return;
+
+    Record record;
+    record.kind = RecordKind::Post;
+    record.type = (uint32_t)bc->type;
+    record.flags = (bc->from_hmi ? 0x1 : 0) | (to_front ? 0x2 : 0);
+    record.name = bc->connectionName;
+    record.payload = EncodeParams(bc);
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    record.seq = next_seq_++;
+    seq_[bc] = record.seq;
+    Write(record);
+}
+
+void Recorder::OnStart(const BaseCommand* bc) {
+    if (!Enabled())
+        return;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto it = seq_.find(bc);
+    if (it == seq_.end())
+        return;
+
+    Record record;
+    record.kind = RecordKind::Start;
+    record.seq = it->second;
+    record.type = (uint32_t)bc->type;
+    Write(record);
+}
+
+void Recorder::OnDone(const BaseCommand* bc) {
+    if (!Enabled())
+        return;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto it = seq_.find(bc);
+    if (it == seq_.end())
+        return;
+
+    Record record;
+    record.kind = RecordKind::Done;
+    record.seq = it->second;
+    record.type = (uint32_t)bc->type;
+    seq_.erase(it);
+    Write(record);
+}
+
+void Recorder::OnSignal(const char* sender, const char* json) {
+    if (!Enabled())
+        return;
+
+    Record record;
+    record.kind = RecordKind::Signal;
+    record.type = 0;
+    record.flags = 0;
+    record.name = sender ? sender : "";
+    record.payload = json ? json : "";
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    record.seq = 0;
+    Write(record);
+}
+
+std::string Recorder::EncodeParams(const BaseCommand* bc) {
+    std::ostringstream os;
+
+    switch (bc->type) {
+    case CommandType::Seek:
+        os << "pos_us=" << static_cast<const SeekCommand*>(bc)->pos_us;
+        break;
+    case CommandType::SetPosition: {
+        auto cmd = static_cast<const SetPositionCommand*>(bc);
+        os << "pos_us=" << cmd->pos_us << ";is_streaming=" << cmd->is_streaming;
+        break;
+    }
+    case CommandType::SetRate:
+        os << "rate=" << static_cast<const SetRateCommand*>(bc)->rate;
+        break;
+    case CommandType::SetVolume:
+        os << "volume=" << static_cast<const SetVolumeCommand*>(bc)->volume;
+        break;
+    case CommandType::OpenUri: {
+        auto cmd = static_cast<const OpenUriCommand*>(bc);
+        os << "media_id=" << cmd->media_id << ";channel_num=" << cmd->channel_num << ";uri=" << cmd->uri;
+        break;
+    }
+    case CommandType::SetMute:
+        os << "mute=" << (int)static_cast<const SetMuteCommand*>(bc)->mute;
+        break;
+    default:
+        break;
+    }
+
+    return os.str();
+}
+
+RecordReader::RecordReader()
+  : fp_(nullptr),
+    time_us_(0) {}
+
+RecordReader::~RecordReader() {
+    if (fp_)
+        fclose(fp_);
+}
+
+bool RecordReader::Open(const std::string& path) {
+    char magic[8];
+    uint64_t wall;
+
+    fp_ = fopen(path.c_str(), "rb");
+    if (fp_ == nullptr)
+        return false;
+    if (fread(magic, 1, 8, fp_) != 8 || memcmp(magic, COMMAND_RECORD_MAGIC, 8) != 0)
+        return false;
+    if (fread(&wall, sizeof(wall), 1, fp_) != 1)
+        return false;
+    return true;
+}
+
+bool RecordReader::GetVarint(uint64_t& v) {
+    int c, shift = 0;
+    v = 0;
+    while ((c = fgetc(fp_)) != EOF) {
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return true;
+        shift += 7;
+        if (shift > 63)
+            return false;
+    }
+    return false;
+}
+
+bool RecordReader::GetString(std::string& s) {
+    uint64_t len;
+    if (!GetVarint(len) || len > (16 << 20))
+        return false;
+    s.resize(len);
+    return (len == 0) || (fread(&s[0], 1, len, fp_) == len);
+}
+
+bool RecordReader::Next(Record& record) {
+    uint8_t kind;
+    uint64_t delta, v;
+
+    if (fp_ == nullptr || fread(&kind, 1, 1, fp_) != 1)
+        return false;
+    if (!GetVarint(delta) || !GetVarint(record.seq))
+        return false;
+
+    time_us_ += delta;
+    record.kind = (RecordKind)kind;
+    record.time_us = time_us_;
+    record.type = 0;
+    record.flags = 0;
+    record.name.clear();
+    record.payload.clear();
+
+    switch (record.kind) {
+    case RecordKind::Post:
+        if (!GetVarint(v) || fread(&record.flags, 1, 1, fp_) != 1)
+            return false;
+        record.type = (uint32_t)v;
+        return GetString(record.name) && GetString(record.payload);
+    case RecordKind::Signal:
+        return GetString(record.name) && GetString(record.payload);
+    case RecordKind::Start:
+    case RecordKind::Done:
+        return true;
+    default:
+        MMLogError("unknown record kind %u", kind);
+        return false;
+    }
+}
+
+} // namespace command
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,133 @@
+/**
+* @file command_recorder.h
+* @version 1.0
+* Header for recording command stream and PlayerEngine signals of media manager
+*/
+
+#ifndef COMMAND_RECORDER_H_
+#define COMMAND_RECORDER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace lge {
+namespace mm {
+namespace command {
+
+class BaseCommand;
+
+#define COMMAND_RECORD_FILE_ENV "MM_RECORD_FILE"
+#define COMMAND_RECORD_MAGIC    "MMREC1\n"   // 8 bytes with terminating null
+
+/**
+* Record file layout (host byte order, varint is LEB128)
+*   header : magic[8], u64 wall clock of first record (us)
+*   record : u8 kind, varint delta from previous record (us), varint seq, body
+*     Post   : varint command type, u8 flags(bit0 from_hmi, bit1 front), str connection, str params
+*     Start  : -
+*     Done   : -
+*     Signal : str sender, str json
+*   str    : varint length, bytes
+*/
+enum class RecordKind : uint8_t {
+    Post = 1,
+    Start = 2,
+    Done = 3,
+    Signal = 4,
+};
+
+struct Record {
+    RecordKind kind;
+    uint64_t time_us;      // from the beginning of the record
+    uint64_t seq;
+    uint32_t type;
+    uint8_t flags;
+    std::string name;      // connection of command, sender of signal
+    std::string payload;   // params of command, json of signal
+};
+
+/**
+* @class lge::mm::command::Recorder
+* @brief Writes every command entering command::Queue and every StateChange signal to a file.
+* @details Enabled when MM_RECORD_FILE is set, otherwise each hook costs one atomic load.<BR>
+*          mm_replay reads the file back with RecordReader.
+*/
+class Recorder {
+public:
+    typedef std::function<void(const Record&)> Observer;
+
+    static Recorder& Instance();
+
+    bool Open(const std::string& path);
+    void Close();
+    bool Enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * @fn SetObserver
+    * @brief Gets every record in process as well. Used by replay to measure latency.
+    * @param[in] observer : called with recorder lock held
+    * @return : None
+    */
+    void SetObserver(Observer observer);
+
+    void OnPost(const BaseCommand* bc, bool to_front);
+    void OnStart(const BaseCommand* bc);
+    // called on every path which deletes a posted command: run, superseded, cleared or dropped
+    void OnDone(const BaseCommand* bc);
+    void OnSignal(const char* sender, const char* json);
+
+    // parameters of commands which replay can construct again, "key=value;..."
+    static std::string EncodeParams(const BaseCommand* bc);
+
+private:
+    Recorder();
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    void Write(Record& record);
+    void PutVarint(uint64_t v);
+    void PutString(const std::string& s);
+
+    std::atomic<bool> enabled_;
+    std::mutex mutex_;
+    FILE* fp_;
+    uint64_t begin_us_;
+    uint64_t last_us_;
+    uint64_t next_seq_;
+    std::map<const BaseCommand*, uint64_t> seq_;
+    Observer observer_;
+};
+
+/**
+* @class lge::mm::command::RecordReader
+* @brief Reads a file written by Recorder.
+*/
+class RecordReader {
+public:
+    RecordReader();
+    ~RecordReader();
+
+    bool Open(const std::string& path);
+    bool Next(Record& record);
+
+private:
+    bool GetVarint(uint64_t& v);
+    bool GetString(std::string& s);
+
+    FILE* fp_;
+    uint64_t time_us_;
+};
+
+} // namespace command
+} // namespace mm
+} // namespace lge
+
+#endif  // COMMAND_RECORDER_H_
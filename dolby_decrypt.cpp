@@ -0,0 +1,230 @@
+#include "dolby_decrypt.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+
+CryptoServiceWatch::CryptoServiceWatch()
+  : context_(g_main_context_new()),
+    connection_(nullptr),
+    subscription_(0),
+    appeared_(false) {
+    const char* name = DOLBY_CRYPTO_SERVICE_NAME;
+    if (name[0] == '\0') {
+        MMLogWarn("no cryptoservice name is set, retry by timer only");
+        return;
+    }
+
+    GError* error = nullptr;
+    GBusType bus = DOLBY_CRYPTO_SERVICE_BUS;
+    connection_ = g_bus_get_sync(bus, nullptr, &error);
+    if (connection_ == nullptr) {
+        MMLogWarn("bus of %s is not reachable, retry by timer only: %s", name, error ? error->message : "");
+        if (error)
+            g_error_free(error);
+        return;
+    }
+
+    // FileDecryptor decides the bus, a key source found only on the other bus would never wake us
+    if (!hasOwner(connection_, name)) {
+        GBusType other = (bus == G_BUS_TYPE_SYSTEM) ? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM;
+        GDBusConnection* other_connection = g_bus_get_sync(other, nullptr, nullptr);
+        if (other_connection && hasOwner(other_connection, name)) {
+            MMLogError("%s is on the %s bus, not on the %s bus, check DOLBY_CRYPTO_SERVICE_BUS", name,
+                       other == G_BUS_TYPE_SYSTEM ? "system" : "session",
+                       bus == G_BUS_TYPE_SYSTEM ? "system" : "session");
+            g_object_unref(connection_);
+            connection_ = other_connection;
+            other_connection = nullptr;
+        }
+        if (other_connection)
+            g_object_unref(other_connection);
+    }
+
+    // the signal is delivered to the thread default context at the subscription
+    g_main_context_push_thread_default(context_);
+    subscription_ = g_dbus_connection_signal_subscribe(connection_,
+                                                       "org.freedesktop.DBus",
+                                                       "org.freedesktop.DBus",
+                                                       "NameOwnerChanged",
+                                                       "/org/freedesktop/DBus",
+                                                       name,
+                                                       G_DBUS_SIGNAL_FLAGS_NONE,
+                                                       &CryptoServiceWatch::onNameOwnerChanged,
+                                                       this, nullptr);
+    g_main_context_pop_thread_default(context_);
+}
+
+CryptoServiceWatch::~CryptoServiceWatch() {
+    if (subscription_ > 0)
+        g_dbus_connection_signal_unsubscribe(connection_, subscription_);
+    if (connection_)
+        g_object_unref(connection_);
+    g_main_context_unref(context_);
+}
+
+bool CryptoServiceWatch::Wait(uint32_t timeout_ms) {
+    if (subscription_ == 0) {
+        usleep(timeout_ms * 1000);
+        return false;
+    }
+
+    // a signal received since the last Wait() is already queued and ends the wait at once
+    appeared_ = false;
+    bool timed_out = false;
+    GSource* timer = g_timeout_source_new(timeout_ms);
+    g_source_set_callback(timer, &CryptoServiceWatch::onTimeout, &timed_out, nullptr);
+    g_source_attach(timer, context_);
+
+    while (!appeared_ && !timed_out)
+        g_main_context_iteration(context_, TRUE);
+
+    g_source_destroy(timer);
+    g_source_unref(timer);
+    return appeared_;
+}
+
+void CryptoServiceWatch::onNameOwnerChanged(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                            const gchar* interface, const gchar* signal, GVariant* parameters,
+                                            gpointer user_data) {
+    auto self = static_cast<CryptoServiceWatch*>(user_data);
+    const gchar* name = nullptr;
+    const gchar* old_owner = nullptr;
+    const gchar* new_owner = nullptr;
+    g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+
+    // arg0 is matched by the bus, a unique name or another name is not the key source anyway
+    if (name == nullptr || name[0] == ':' || g_strcmp0(name, DOLBY_CRYPTO_SERVICE_NAME) != 0)
+        return;
+
+    if (new_owner && new_owner[0] != '\0') {
+        MMLogDebug("%s appeared on the bus", name);
+        self->appeared_ = true;
+    }
+}
+
+bool CryptoServiceWatch::hasOwner(GDBusConnection* connection, const char* name) {
+    GVariant* reply = g_dbus_connection_call_sync(connection,
+                                                  "org.freedesktop.DBus",
+                                                  "/org/freedesktop/DBus",
+                                                  "org.freedesktop.DBus",
+                                                  "NameHasOwner",
+                                                  g_variant_new("(s)", name),
+                                                  G_VARIANT_TYPE("(b)"),
+                                                  G_DBUS_CALL_FLAGS_NONE,
+                                                  -1, nullptr, nullptr);
+    if (reply == nullptr)
+        return false;
+
+    gboolean owned = FALSE;
+    g_variant_get(reply, "(b)", &owned);
+    g_variant_unref(reply);
+    return owned;
+}
+
+gboolean CryptoServiceWatch::onTimeout(gpointer user_data) {
+    *static_cast<bool*>(user_data) = true;
+    return G_SOURCE_REMOVE;
+}
+
+bool RetryWithBackoff(const std::string& what, std::function<bool()> attempt, uint32_t timeout_ms) {
+    auto begin = std::chrono::steady_clock::now();
+    auto deadline = begin + std::chrono::milliseconds(timeout_ms);
+    uint32_t backoff_ms = DOLBY_DECRYPT_BACKOFF_MIN_MS;
+    std::unique_ptr<CryptoServiceWatch> watch;
+
+    for (uint32_t retry = 0; ; retry++) {
+        if (attempt()) {
+            if (retry > 0) {
+                MMLogInfo("%s is done after %u retries, %lld ms", what.c_str(), retry,
+                          (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - begin).count());
+            }
+            return true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            MMLogError("%s gives up after %u retries", what.c_str(), retry);
+            return false;
+        }
+
+        // subscribed only when the key source is late, which is not the usual case
+        if (!watch)
+            watch.reset(new CryptoServiceWatch());
+
+        uint32_t left_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+        uint32_t wait_ms = std::min(std::max(backoff_ms, 1u), left_ms);
+        MMLogInfo("Wait for cryptoservice ready... %s retry[%u] in %u ms", what.c_str(), retry, wait_ms);
+
+        // the key source which appeared gets an immediate retry, the backoff grows anyway
+        watch->Wait(wait_ms);
+        backoff_ms = std::min(backoff_ms * 2, (uint32_t)DOLBY_DECRYPT_BACKOFF_MAX_MS);
+    }
+}
+
+namespace {
+
+std::mutex readiness_mutex;
+std::condition_variable readiness_cv;
+bool readiness_settled = false;
+bool readiness_available = false;
+std::vector<DolbyLibraryReadiness::Listener> readiness_listeners;
+
+} // namespace
+
+void DolbyLibraryReadiness::Settle(bool available) {
+    std::vector<Listener> listeners;
+    {
+        std::lock_guard<std::mutex> locker(readiness_mutex);
+        if (readiness_settled)
+            return;
+        readiness_settled = true;
+        readiness_available = available;
+        listeners.swap(readiness_listeners);
+    }
+    MMLogInfo("Dolby libraries are %s", available ? "ready" : "not available");
+    readiness_cv.notify_all();
+
+    for (auto& listener : listeners)
+        listener(available);
+}
+
+bool DolbyLibraryReadiness::Wait(uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> locker(readiness_mutex);
+    return readiness_cv.wait_for(locker, std::chrono::milliseconds(timeout_ms),
+                                 []() { return readiness_settled; });
+}
+
+bool DolbyLibraryReadiness::IsSettled() {
+    std::lock_guard<std::mutex> locker(readiness_mutex);
+    return readiness_settled;
+}
+
+bool DolbyLibraryReadiness::IsAvailable() {
+    std::lock_guard<std::mutex> locker(readiness_mutex);
+    return readiness_settled && readiness_available;
+}
+
+void DolbyLibraryReadiness::AddListener(Listener listener) {
+    std::unique_lock<std::mutex> locker(readiness_mutex);
+    if (!readiness_settled) {
+        readiness_listeners.push_back(listener);
+        return;
+    }
+    bool available = readiness_available;
+    locker.unlock();
+    listener(available);
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,138 @@
+/**
+* @file dolby_decrypt.h
+* @version 1.0
+* Header for retry and readiness of the Dolby library decryption at startup
+*/
+
+#ifndef DOLBY_DECRYPT_H_
+#define DOLBY_DECRYPT_H_
+
+#include <stdint.h>
+#include <gio/gio.h>
+#include <functional>
+#include <string>
+
+namespace lge {
+namespace mm {
+
+#ifndef DOLBY_DECRYPT_TIMEOUT_MS
+#define DOLBY_DECRYPT_TIMEOUT_MS 60000 // RetryWithBackoff gives up after it
+#endif
+
+#define DOLBY_DECRYPT_BACKOFF_MIN_MS 50
+#define DOLBY_DECRYPT_BACKOFF_MAX_MS 2000
+
+#ifndef DOLBY_LIBRARY_WAIT_MS
+#define DOLBY_LIBRARY_WAIT_MS 5000 // longest an engine launch waits for the libraries
+#endif
+
+// well-known name of the key source which FileDecryptor calls, empty - retry by timer only
+#ifndef DOLBY_CRYPTO_SERVICE_NAME
+#define DOLBY_CRYPTO_SERVICE_NAME "com.lge.cryptoservice"
+#endif
+
+// bus of the key source, the other bus is checked once in case it is found there
+#ifndef DOLBY_CRYPTO_SERVICE_BUS
+#define DOLBY_CRYPTO_SERVICE_BUS G_BUS_TYPE_SESSION
+#endif
+
+/**
+* @class lge::mm::CryptoServiceWatch
+* @brief Wakes a retry of decryption when the key source appears on its bus.
+* @details NameOwnerChanged of DOLBY_CRYPTO_SERVICE_NAME is subscribed on a private<BR>
+*          GMainContext which is iterated only by Wait(), so the watch can be used from<BR>
+*          any thread without the main loop. Unique names (":1.x") never wake a retry.<BR>
+*          If the bus is not reachable or no name is set, Wait() just sleeps.
+*/
+class CryptoServiceWatch {
+public:
+    CryptoServiceWatch();
+    ~CryptoServiceWatch();
+
+    CryptoServiceWatch(const CryptoServiceWatch&) = delete;
+    CryptoServiceWatch& operator=(const CryptoServiceWatch&) = delete;
+
+    /**
+    * @fn Wait
+    * @brief Waits until the key source appears or timeout.
+    * @param[in] timeout_ms : timeout
+    * @return bool (true - the key source appeared, false - timeout)
+    */
+    bool Wait(uint32_t timeout_ms);
+
+private:
+    static void onNameOwnerChanged(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                   const gchar* interface, const gchar* signal, GVariant* parameters,
+                                   gpointer user_data);
+    static gboolean onTimeout(gpointer user_data);
+    static bool hasOwner(GDBusConnection* connection, const char* name);
+
+    GMainContext* context_;
+    GDBusConnection* connection_;
+    guint subscription_;
+    bool appeared_;
+};
+
+/**
+* @fn RetryWithBackoff
+* @brief Repeats an attempt until it is done, with exponential backoff between attempts.
+* @section function Function Flow
+* - Calls attempt, which returns false while the key source is not reachable.
+* - Waits DOLBY_DECRYPT_BACKOFF_MIN_MS doubled per failure up to DOLBY_DECRYPT_BACKOFF_MAX_MS.
+* - The wait ends early when the key source appears on the bus, see CryptoServiceWatch.<BR>
+*   The backoff still grows, so a service which appears but keeps failing is not hammered.
+*
+* @param[in] what : name of the attempt for logs
+* @param[in] attempt : returns true when done, false to retry
+* @param[in] timeout_ms : gives up after timeout
+* @return bool (true - attempt is done, false - timeout)
+*/
+bool RetryWithBackoff(const std::string& what, std::function<bool()> attempt,
+                      uint32_t timeout_ms = DOLBY_DECRYPT_TIMEOUT_MS);
+
+/**
+* @class lge::mm::DolbyLibraryReadiness
+* @brief Readiness of the decrypted Dolby libraries which PlayerEngines load at start.
+* @details Settled once by the startup decryption, as available or not. A PlayerEngine<BR>
+*          launched before that runs without the Dolby decoder, so launches which are not<BR>
+*          urgent wait for it, and listeners may recycle engines launched too early.
+*/
+class DolbyLibraryReadiness {
+public:
+    /**
+    * @brief Called once when settled.
+    * @param available : true - decrypted libraries exist
+    */
+    typedef std::function<void(bool available)> Listener;
+
+    /**
+    * @fn Settle
+    * @brief Settles the readiness and notifies waiters and listeners. Only the first call counts.
+    * @param[in] available : true - decrypted libraries exist
+    * @return : None
+    */
+    static void Settle(bool available);
+
+    /**
+    * @fn Wait
+    * @brief Waits until settled.
+    * @param[in] timeout_ms : timeout
+    * @return bool (true - settled, false - timeout)
+    */
+    static bool Wait(uint32_t timeout_ms);
+
+    static bool IsSettled();
+    static bool IsAvailable();
+
+    /**
+    * @fn AddListener
+    * @brief Adds a listener. It is called at once if already settled, otherwise on the thread of Settle().
+    * @return : None
+    */
+    static void AddListener(Listener listener);
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // DOLBY_DECRYPT_H_
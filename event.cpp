@@ -1,7 +1,17 @@
 #include "event_system.h"
 
+#include <stdint.h>
+#include <sys/eventfd.h>
+
+#include "command_pool.h"
+#include "command_recorder.h"
 #include "glib_helper.h"
 #include "player_logger.h"
+#include "timer_wheel.h"
+
+#ifndef MAX_PLAYER_ENGINE_INSTANCE
+#define MAX_PLAYER_ENGINE_INSTANCE 14 // same as playerprovider.h
+#endif
 
 namespace lge {
 namespace mm {
@@ -11,9 +21,12 @@ EventSystem::EventSystem(std::shared_ptr<Queue>& sp_command_queue)
   : thread_sema_(),
     thread_(),
     gmain_context_(nullptr),
-    pipe_{-1, -1},
+    event_fd_(-1),
     command_queue_(sp_command_queue),
-    coro_(nullptr),
+    lanes_(),
+    current_lane_(nullptr),
+    timer_wheel_(g_get_monotonic_time() / 1000),
+    timer_source_(nullptr),
     loop_(nullptr),
     src_id_(nullptr){
   MMLogInfo("");
@@ -25,8 +38,13 @@ EventSystem::~EventSystem(){
     command_queue_->Post(new QuitThreadCommand(nullptr));
     thread_sema_.wait();
 
-    for(int i = 0; i < 2; i++)
-        close(pipe_[i]);
+    if (event_fd_ >= 0)
+        close(event_fd_);
+
+    if (timer_source_) {
+        g_source_destroy(timer_source_);
+        g_source_unref(timer_source_);
+    }
 
     g_main_context_pop_thread_default(gmain_context_);
     g_main_loop_quit(this->loop_);
@@ -34,6 +52,13 @@ EventSystem::~EventSystem(){
     g_main_context_unref(gmain_context_);
 
     thread_.reset();
+
+    for (auto& it : lanes_) {
+        delete it.second->coro;
+        delete it.second;
+    }
+    lanes_.clear();
+    CommandPool::Instance().LogStats();
     MMLogInfo("Coroutine thread is released");
 }
 
@@ -45,16 +70,44 @@ void EventSystem::Init() {
 }
 
 void EventSystem::InitCoro() {
-    coro_ = new Coro::push_type(std::bind(&EventSystem::HandleEvent, this, std::placeholders::_1));
+    // lane for commands without connection name, it runs only when other lanes are idle
+    GetLane("");
+}
+
+EventSystem::Lane* EventSystem::GetLane(const std::string& connection_name) {
+    auto it = lanes_.find(connection_name);
+    if (it != lanes_.end())
+        return it->second;
+
+    // the global lane is not counted
+    if (lanes_.size() > MAX_PLAYER_ENGINE_INSTANCE) {
+        for (auto idle = lanes_.begin(); idle != lanes_.end(); idle++) {
+            if (!idle->first.empty() && idle->second->command == nullptr) {
+                MMLogInfo("release idle lane [%s]", idle->first.c_str());
+                delete idle->second->coro;
+                delete idle->second;
+                lanes_.erase(idle);
+                break;
+            }
+        }
+        if (lanes_.size() > MAX_PLAYER_ENGINE_INSTANCE)
+            return nullptr;
+    }
+
+    Lane* lane = new Lane{connection_name, nullptr, nullptr};
+    lane->coro = new Coro::push_type(std::bind(&EventSystem::HandleEvent, this, lane, std::placeholders::_1));
+    lanes_[connection_name] = lane;
+
     EventAndParam eap;
     eap.first = EventType::None;
     eap.second = nullptr;
 
     try {
-        (*coro_)(eap);
+        Resume(lane, eap);
     } catch (boost::exception &e) {
         MMLogError("%s", boost::diagnostic_information(e).c_str());
     }
+    return lane;
 }
 
 void EventSystem::InitMainLoop() {
@@ -65,21 +118,29 @@ void EventSystem::InitMainLoop() {
 void EventSystem::MainLoop() {
     MMLogInfo("");
 
-	if (pipe(pipe_) == -1)
-		MMLogError("error creating POSIX pipe");
+    // producers write only when the queue re-armed, so several posts share one wakeup
+    event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd_ == -1)
+        MMLogError("error creating eventfd");
 
     command_queue_->RegisterCallback(std::bind(&EventSystem::InformCommandArrived, this));
 
     gmain_context_ = g_main_context_new();
     g_main_context_push_thread_default(gmain_context_);
 
-    this->src_id_ = GlibHelper::ConnectUnixFd(gmain_context_, pipe_[0], G_IO_IN, [this](gint fd, GIOCondition condition) -> gboolean {
-      char data;
-      ssize_t sz __attribute__((unused)) = read(fd, &data, 1);
-      SetEvent(EventType::CommandArrived, nullptr);
+    this->src_id_ = GlibHelper::ConnectUnixFd(gmain_context_, event_fd_, G_IO_IN, [this](gint fd, GIOCondition condition) -> gboolean {
+      eventfd_t count;
+      eventfd_read(fd, &count);
+      Dispatch();
       return TRUE;
     });
 
+    // one source drives every WaitEvent deadline, its ready time follows the timer wheel
+    static GSourceFuncs timer_funcs = { nullptr, nullptr, &EventSystem::onTimer, nullptr, nullptr, nullptr };
+    timer_source_ = g_source_new(&timer_funcs, sizeof(TimerSource));
+    reinterpret_cast<TimerSource*>(timer_source_)->self = this;
+    g_source_attach(timer_source_, gmain_context_);
+
     GlibHelper::CallAsync(gmain_context_, [this]() -> gboolean {
       MMLogInfo("ThreadReady callabck");
       thread_sema_.notify();
@@ -91,73 +152,211 @@ void EventSystem::MainLoop() {
 }
 
 bool EventSystem::WaitEvent(Coro::pull_type& in, uint32_t succeed_event, uint32_t fail_event) {
+    // no deadline, a caller which needs one uses WaitEventFor() and handles TimedOut
+    return (WaitEventFor(in, succeed_event, fail_event, 0) == WaitResult::Succeeded);
+}
+
+WaitResult EventSystem::WaitEventFor(Coro::pull_type& in, uint32_t succeed_event, uint32_t fail_event, uint32_t timeout_ms) {
     EventAndParam eap;
     EventType event;
-
-    MMLogInfo("success:0x%08x, fail:0x%08x", succeed_event, fail_event);
+    TimerWheel::TimerId timer_id = 0;
+    Lane* lane = current_lane_;
+
+    MMLogInfo("success:0x%08x, fail:0x%08x, timeout:%u", succeed_event, fail_event, timeout_ms);
+
+    if (timeout_ms > 0 && lane != nullptr) {
+        timer_id = timer_wheel_.Add(g_get_monotonic_time() / 1000, timeout_ms, [this, lane](TimerWheel::TimerId id) {
+            EventAndParam timeout;
+            timeout.first = EventType::Timeout;
+            timeout.second = reinterpret_cast<void*>(static_cast<uintptr_t>(id));
+            Resume(lane, timeout);
+        });
+        ArmTimer();
+    }
 
     while (1) {
         in();
         eap = in.get();
         event = eap.first;
 
+        if (event == EventType::Timeout) {
+            if (timer_id != 0 && eap.second == reinterpret_cast<void*>(static_cast<uintptr_t>(timer_id))) {
+                MMLogWarn("no event in %u ms, success:0x%08x, fail:0x%08x [%s]", timeout_ms,
+                          succeed_event, fail_event, lane->connection_name.c_str());
+                return WaitResult::TimedOut;
+            }
+            continue;
+        }
+
         if ((uint32_t)event & succeed_event) {
             MMLogInfo("got succeed event: %08x", (uint32_t)event);
-            return true;
+            timer_wheel_.Cancel(timer_id);
+            return WaitResult::Succeeded;
         }
 
         if ((uint32_t)event & fail_event) {
             MMLogInfo("got fail event: %08x", (uint32_t)event);
-            return false;
+            timer_wheel_.Cancel(timer_id);
+            return WaitResult::Failed;
         }
     }
 
-    return true;
+    return WaitResult::Succeeded;
+}
+
+void EventSystem::Resume(Lane* lane, const EventAndParam& eap) {
+    Lane* prev = current_lane_;
+    current_lane_ = lane;
+    (*lane->coro)(eap);
+    current_lane_ = prev;
+}
+
+void EventSystem::ArmTimer() {
+    uint64_t wakeup_ms = 0;
+
+    if (timer_source_ == nullptr)
+        return;
+
+    if (timer_wheel_.NextWakeup(wakeup_ms))
+        g_source_set_ready_time(timer_source_, (gint64)wakeup_ms * 1000);
+    else
+        g_source_set_ready_time(timer_source_, -1);
+}
+
+gboolean EventSystem::onTimer(GSource* source, GSourceFunc callback, gpointer user_data) {
+    EventSystem* self = reinterpret_cast<TimerSource*>(source)->self;
+
+    self->timer_wheel_.Advance(g_get_monotonic_time() / 1000);
+    self->ArmTimer();
+    return G_SOURCE_CONTINUE;
 }
 
 void EventSystem::SetEvent(EventType event, void* param) {
     EventAndParam eap;
     eap.first = event;
     eap.second = param;
-    (*coro_)(eap);
+
+    // a cross-engine command runs alone, so it gets every event
+    Lane* global = lanes_[""];
+    if (global->command) {
+        Resume(global, eap);
+        return;
+    }
+
+    // not of a PlayerEngine, every waiting command checks the event by itself
+    std::vector<Lane*> busy;
+    for (auto& it : lanes_) {
+        if (it.second->command)
+            busy.push_back(it.second);
+    }
+    for (auto lane : busy)
+        Resume(lane, eap);
 }
 
-void EventSystem::HandleEvent(Coro::pull_type& in) {
-    MMLogInfo("Coro is ready to receive event");
+void EventSystem::SetEvent(EventType event, void* param, const std::string& connection_name) {
+    EventAndParam eap;
+    eap.first = event;
+    eap.second = param;
+
+    Lane* global = lanes_[""];
+    if (global->command) {
+        Resume(global, eap);
+        return;
+    }
+
+    // an event of an unknown or idle PlayerEngine must not wake a command of another one
+    auto it = connection_name.empty() ? lanes_.end() : lanes_.find(connection_name);
+    if (it == lanes_.end() || it->second->command == nullptr) {
+        MMLogDebug("event(%u) of [%s] has no waiting command", (uint32_t)event, connection_name.c_str());
+        return;
+    }
+    Resume(it->second, eap);
+}
+
+bool EventSystem::IsRunnable(const BaseCommand* command) {
+    const std::string& name = command->connectionName;
+
+    if (lanes_[""]->command)
+        return false;
+
+    if (name.empty()) {
+        for (auto& it : lanes_) {
+            if (it.second->command)
+                return false;
+        }
+        return true;
+    }
+
+    auto it = lanes_.find(name);
+    if (it != lanes_.end())
+        return (it->second->command == nullptr);
+
+    if (lanes_.size() <= MAX_PLAYER_ENGINE_INSTANCE)
+        return true;
+    for (auto& idle : lanes_) {
+        if (!idle.first.empty() && idle.second->command == nullptr)
+            return true;
+    }
+    return false;
+}
 
+void EventSystem::Dispatch() {
     BaseCommand* command = nullptr;
+
+    while ((command = command_queue_->Pop(std::bind(&EventSystem::IsRunnable, this, std::placeholders::_1)))) {
+        if (command->type == CommandType::QuitThread) {
+            Recorder::Instance().OnDone(command);
+            delete command;
+            GlibHelper::Disconnect(this->src_id_);
+            MMLogInfo("QuitThread command is received");
+            thread_sema_.notify();
+            return;
+        }
+
+        Lane* lane = GetLane(command->connectionName);
+        if (lane == nullptr) { // IsRunnable() checked a lane is available
+            MMLogError("no lane for [%s]", command->connectionName.c_str());
+            Recorder::Instance().OnDone(command);
+            delete command;
+            continue;
+        }
+
+        lane->command = command;
+        EventAndParam eap;
+        eap.first = EventType::CommandArrived;
+        eap.second = nullptr;
+        Resume(lane, eap);
+    }
+
+    command_queue_->Rearm();
+}
+
+void EventSystem::HandleEvent(Lane* lane, Coro::pull_type& in) {
+    MMLogInfo("Coro of lane [%s] is ready to receive event", lane->connection_name.c_str());
+
     EventAndParam eap;
 
     while(1) {
         in();
         eap = in.get();
 
-        if (command == nullptr && eap.first == EventType::CommandArrived) {
-            command = command_queue_->Pop();
-            if (command == nullptr)
-                continue;
-
-            if(command->type == CommandType::QuitThread){
-                delete command;
-                GlibHelper::Disconnect(this->src_id_);
-                MMLogInfo("QuitThread command is received");
-                break;
-            } else {
-                command->Execute(in);
-            }
+        if (lane->command != nullptr && eap.first == EventType::CommandArrived) {
+            Recorder::Instance().OnStart(lane->command);
+            lane->command->Execute(in);
+            Recorder::Instance().OnDone(lane->command);
 
-            delete command;
-            command = nullptr;
+            delete lane->command;
+            lane->command = nullptr;
 
-            if (command_queue_->Size())
-                InformCommandArrived();
+            // resuming other lanes from this coroutine is not allowed, dispatch from main loop
+            GlibHelper::CallAsync(gmain_context_, [this]() -> gboolean {
+                Dispatch();
+                return FALSE;
+            });
         } else {
-            // ignore other commands, if command is not being processed.
+            // ignore other events, if command is not being processed.
         }
     }
-
-    thread_sema_.notify();
-    MMLogInfo("Coro thread is finished");
 }
 
 GMainContext* EventSystem::GetGMainContext() {
@@ -165,8 +364,7 @@ GMainContext* EventSystem::GetGMainContext() {
 }
 
 void EventSystem::InformCommandArrived() {
-    char data = 0;
-    write(pipe_[1], &data, 1);
+    eventfd_write(event_fd_, 1);
 }
 
 } // namespace command
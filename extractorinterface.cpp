@@ -387,6 +387,21 @@ bool ExtractorInterface::requestImages(std::vector<std::string>& urls) {
     return true;
 }
 
+static void
+onSetPlaytimeReply (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data) {
+    GError *error = NULL;
+    GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source_object), res, &error);
+
+    if (error) {
+        MMLogError("SetPlaytime of com.lge.thumbnailextractor fail: %s\n", error->message);
+        g_error_free(error);
+    }
+    if (ret)
+        g_variant_unref(ret);
+}
+
 /**
  * ================================================================================
  * @fn : setPlayTime
@@ -394,36 +409,35 @@ bool ExtractorInterface::requestImages(std::vector<std::string>& urls) {
  * @section : Function flow (Pseudo-code or Decision Table)
  *  - Make DBUS message
  *  - Set arguements to message
- *  - Send message over DBUS
+ *  - Send message over DBUS without waiting, the reply is only logged
  * @param [in] url : file path of video file.
  * @section Global Variables: none
  * @section Dependencies: none
- * @return :  bool (true: success false: fail)
+ * @return :  bool (true: sent false: not connected)
  * ===================================================================================
  */
 bool ExtractorInterface::setPlayTime(std::string path, uint32_t playTime) {
-    GError *error = NULL;
     MMLogInfo("path = %s, playTime = %d", path.c_str(), playTime);
-    g_dbus_connection_call_sync(mConnection,
-                                THUMBNAIL_EXTRACTOR_SERVICE,
-                                THUMBNAIL_EXTRACTOR_OBJECT_PATH,
-                                THUMBNAIL_EXTRACTOR_INTERFACE,
-                                "SetPlaytime",
-                                g_variant_new ("(si)",
-                                    path.c_str(),
-                                    playTime),
-                                NULL,
-                                G_DBUS_CALL_FLAGS_NONE,
-                                MAX_DBUS_TIMEOUT * 1000,
-                                NULL,
-                                &error);
-
-    if (error) {
-        MMLogError("Could not start com.lge.thumbnailextractor: %s\n", error->message);
-        g_error_free(error);
+    if (mConnection == NULL) {
+        MMLogError("com.lge.thumbnailextractor is not connected");
         return false;
     }
 
+    g_dbus_connection_call(mConnection,
+                           THUMBNAIL_EXTRACTOR_SERVICE,
+                           THUMBNAIL_EXTRACTOR_OBJECT_PATH,
+                           THUMBNAIL_EXTRACTOR_INTERFACE,
+                           "SetPlaytime",
+                           g_variant_new ("(si)",
+                               path.c_str(),
+                               playTime),
+                           NULL,
+                           G_DBUS_CALL_FLAGS_NONE,
+                           MAX_DBUS_TIMEOUT * 1000,
+                           NULL,
+                           onSetPlaytimeReply,
+                           NULL);
+
     return true;
 }
 
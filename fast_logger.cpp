@@ -0,0 +1,320 @@
+#include "fast_logger.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+
+static_assert((FAST_LOG_RING_SIZE & (FAST_LOG_RING_SIZE - 1)) == 0, "FAST_LOG_RING_SIZE must be power of 2");
+
+namespace {
+
+// head and tail on their own cache lines, padded since over-aligned new is C++17
+struct FastLogRing {
+    std::atomic<uint32_t> head;                 // written by the owner thread
+    char head_pad[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> tail;                 // written by the drain
+    char tail_pad[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> orphan;                   // owner thread exited
+    uint32_t tid;
+    FastLogRecord records[FAST_LOG_RING_SIZE];
+};
+
+std::mutex registry_mutex;
+std::vector<FastLogRing*> registry;
+std::once_flag drain_once;
+std::timed_mutex drain_mutex;
+std::mutex sink_mutex;
+FastLog::Sink sink;
+std::atomic<uint64_t> total_dropped(0);
+
+thread_local FastLogRing* tls_ring = nullptr;
+
+// marks the ring of an exiting thread, the drain frees it when empty
+struct RingOwner {
+    ~RingOwner() {
+        if (tls_ring)
+            tls_ring->orphan.store(true, std::memory_order_release);
+        tls_ring = nullptr;
+    }
+};
+thread_local RingOwner tls_owner;
+
+uint64_t NowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void EmitToMMLog(uint8_t level, const char* text) {
+    switch (level) {
+    case MM_FASTLOG_LEVEL_DEBUG: MMLogDebug("%s", text); break;
+    case MM_FASTLOG_LEVEL_INFO:  MMLogInfo("%s", text); break;
+    case MM_FASTLOG_LEVEL_WARN:  MMLogWarn("%s", text); break;
+    default:                     MMLogError("%s", text); break;
+    }
+}
+
+// caller holds drain_mutex
+void DrainAll() {
+    struct Span {
+        FastLogRing* ring;
+        uint32_t head;
+    };
+    std::vector<Span> spans;
+    std::vector<const FastLogRecord*> batch;
+    {
+        std::lock_guard<std::mutex> locker(registry_mutex);
+        spans.reserve(registry.size());
+        for (auto ring : registry) {
+            uint32_t head = ring->head.load(std::memory_order_acquire);
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            for (uint32_t i = tail; i != head; i++)
+                batch.push_back(&ring->records[i & (FAST_LOG_RING_SIZE - 1)]);
+            spans.push_back(Span{ring, head});
+        }
+    }
+
+    FastLog::Sink emit;
+    {
+        std::lock_guard<std::mutex> locker(sink_mutex);
+        emit = sink;
+    }
+    if (!emit)
+        emit = EmitToMMLog;
+
+    // each ring is in order already, merged by time over the threads
+    std::stable_sort(batch.begin(), batch.end(), [](const FastLogRecord* a, const FastLogRecord* b) {
+        return a->time_ns < b->time_ns;
+    });
+
+    char text[512];
+    for (auto record : batch) {
+        // DLT stamps the time of the drain, the time of the call goes into the text
+        int n = snprintf(text, sizeof(text), "[%llu.%06llu] %s:%d ",
+                         (unsigned long long)(record->time_ns / 1000000000ull),
+                         (unsigned long long)(record->time_ns % 1000000000ull / 1000),
+                         record->site->function, record->site->line);
+        if (n < 0 || (size_t)n >= sizeof(text))
+            n = 0;
+        FastLog::Format(*record, text + n, sizeof(text) - n);
+        emit(record->site->level, text);
+    }
+
+    std::vector<FastLogRing*> finished;
+    for (auto& span : spans) {
+        span.ring->tail.store(span.head, std::memory_order_release);
+
+        uint64_t dropped = span.ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            snprintf(text, sizeof(text), "fast log dropped %llu records of thread %u",
+                     (unsigned long long)dropped, span.ring->tid);
+            emit(MM_FASTLOG_LEVEL_WARN, text);
+        }
+        if (span.ring->orphan.load(std::memory_order_acquire) &&
+            span.ring->head.load(std::memory_order_acquire) == span.head)
+            finished.push_back(span.ring);
+    }
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> locker(registry_mutex);
+        for (auto ring : finished) {
+            registry.erase(std::remove(registry.begin(), registry.end(), ring), registry.end());
+            delete ring;
+        }
+    }
+}
+
+void DrainLoop() {
+    while (1) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(FAST_LOG_DRAIN_INTERVAL_MS));
+        FastLog::Flush();
+    }
+}
+
+FastLogRing* RegisterRing() {
+    FastLogRing* ring = new FastLogRing();
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->dropped.store(0, std::memory_order_relaxed);
+    ring->orphan.store(false, std::memory_order_relaxed);
+    ring->tid = (uint32_t)syscall(SYS_gettid);
+    (void)&tls_owner; // constructs the owner of this thread, which releases the ring at exit
+
+    {
+        std::lock_guard<std::mutex> locker(registry_mutex);
+        registry.push_back(ring);
+    }
+    std::call_once(drain_once, []() {
+        // lives as long as the process, logging threads may outlive any owner object
+        std::thread(DrainLoop).detach();
+    });
+    return ring;
+}
+
+} // namespace
+
+FastLogRecord* FastLog::Acquire() {
+    FastLogRing* ring = tls_ring;
+    if (ring == nullptr)
+        ring = tls_ring = RegisterRing();
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= FAST_LOG_RING_SIZE) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        total_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    FastLogRecord* record = &ring->records[head & (FAST_LOG_RING_SIZE - 1)];
+    record->time_ns = NowNs();
+    return record;
+}
+
+void FastLog::Commit() {
+    FastLogRing* ring = tls_ring;
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void FastLog::Flush() {
+    std::lock_guard<std::timed_mutex> locker(drain_mutex);
+    DrainAll();
+}
+
+bool FastLog::FlushAtExit() {
+    std::unique_lock<std::timed_mutex> locker(drain_mutex, std::defer_lock);
+    if (!locker.try_lock_for(std::chrono::milliseconds(FAST_LOG_EXIT_FLUSH_MS)))
+        return false;
+    DrainAll();
+    return true;
+}
+
+void FastLog::SetSink(Sink new_sink) {
+    std::lock_guard<std::mutex> locker(sink_mutex);
+    sink = new_sink;
+}
+
+uint64_t FastLog::Dropped() {
+    return total_dropped.load(std::memory_order_relaxed);
+}
+
+size_t FastLog::Format(const FastLogRecord& record, char* buffer, size_t size) {
+    const char* f = record.site->format;
+    size_t out = 0;
+    uint8_t arg = 0;
+
+    if (size == 0)
+        return 0;
+
+    while (*f && out + 1 < size) {
+        if (*f != '%') {
+            buffer[out++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            buffer[out++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion, length is replaced by the stored type
+        const char* start = f++;
+        while (*f && strchr("-+ #0", *f))
+            f++;
+        while (isdigit((unsigned char)*f))
+            f++;
+        if (*f == '.') {
+            f++;
+            while (isdigit((unsigned char)*f))
+                f++;
+        }
+        size_t prefix = std::min<size_t>(f - start, 20);
+        while (*f && strchr("hlqjztL", *f))
+            f++;
+        char conversion = *f;
+        if (conversion == '\0')
+            break;
+        f++;
+
+        char spec[32];
+        memcpy(spec, start, prefix);
+        spec[prefix] = '\0';
+
+        if (arg >= record.argc) {
+            int n = snprintf(buffer + out, size - out, "<?>");
+            out += std::min<size_t>(n > 0 ? n : 0, size - out - 1);
+            continue;
+        }
+
+        uint8_t type = record.types[arg];
+        const FastLogRecord::Arg& value = record.args[arg];
+        arg++;
+
+        int n = 0;
+        switch (conversion) {
+        case 'd': case 'i': {
+            strcat(spec, "ll");
+            strncat(spec, &conversion, 1);
+            long long v = (type == FastLogRecord::Unsigned) ? (long long)value.u :
+                          (type == FastLogRecord::Double) ? (long long)value.d : (long long)value.i;
+            n = snprintf(buffer + out, size - out, spec, v);
+            break;
+        }
+        case 'u': case 'o': case 'x': case 'X': {
+            strcat(spec, "ll");
+            strncat(spec, &conversion, 1);
+            unsigned long long v = (type == FastLogRecord::Signed) ? (unsigned long long)value.i :
+                                   (type == FastLogRecord::Double) ? (unsigned long long)value.d :
+                                   (unsigned long long)value.u;
+            n = snprintf(buffer + out, size - out, spec, v);
+            break;
+        }
+        case 'c': {
+            strncat(spec, &conversion, 1);
+            n = snprintf(buffer + out, size - out, spec, (int)value.i);
+            break;
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            strncat(spec, &conversion, 1);
+            double v = (type == FastLogRecord::Signed) ? (double)value.i :
+                       (type == FastLogRecord::Unsigned) ? (double)value.u : value.d;
+            n = snprintf(buffer + out, size - out, spec, v);
+            break;
+        }
+        case 's': {
+            strncat(spec, &conversion, 1);
+            const char* v = (type == FastLogRecord::String && value.text_offset < FAST_LOG_TEXT_MAX) ?
+                            record.text + value.text_offset : "";
+            n = snprintf(buffer + out, size - out, spec, v);
+            break;
+        }
+        case 'p': {
+            strncat(spec, &conversion, 1);
+            n = snprintf(buffer + out, size - out, spec, value.p);
+            break;
+        }
+        default:
+            n = snprintf(buffer + out, size - out, "%.*s", (int)(f - start), start);
+            break;
+        }
+        out += std::min<size_t>(n > 0 ? n : 0, size - out - 1);
+    }
+
+    buffer[out] = '\0';
+    return out;
+}
+
+} // namespace mm
+} // namespace lge
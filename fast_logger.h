@@ -0,0 +1,242 @@
+/**
+* @file fast_logger.h
+* @version 1.0
+* Header for the asynchronous logger of hot paths, MMFastLogXXX()
+*/
+
+#ifndef FAST_LOGGER_H_
+#define FAST_LOGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+#define MM_FASTLOG_LEVEL_DEBUG 0
+#define MM_FASTLOG_LEVEL_INFO  1
+#define MM_FASTLOG_LEVEL_WARN  2
+#define MM_FASTLOG_LEVEL_ERROR 3
+#define MM_FASTLOG_LEVEL_OFF   4
+
+// calls below the level are removed at compile time, arguments are not evaluated
+#ifndef MM_FASTLOG_MIN_LEVEL
+#define MM_FASTLOG_MIN_LEVEL MM_FASTLOG_LEVEL_INFO
+#endif
+
+#ifndef FAST_LOG_RING_SIZE
+#define FAST_LOG_RING_SIZE 512 // records per thread, power of 2
+#endif
+
+#define FAST_LOG_MAX_ARGS         8
+#define FAST_LOG_TEXT_MAX         160   // bytes of copied strings per record
+#define FAST_LOG_DRAIN_INTERVAL_MS 20
+#define FAST_LOG_EXIT_FLUSH_MS     100  // wait for a busy drain at exit or crash
+
+namespace lge {
+namespace mm {
+
+/**
+* @struct lge::mm::FastLogSite
+* @brief Static data of a call site. Its address is the format id of the records.
+*/
+struct FastLogSite {
+    uint8_t level;
+    const char* format;
+    const char* function;
+    int line;
+};
+
+/**
+* @struct lge::mm::FastLogRecord
+* @brief Binary record of a call, formatted later by the drain thread.
+*/
+struct FastLogRecord {
+    enum ArgType : uint8_t { Signed, Unsigned, Double, String, Pointer };
+
+    const FastLogSite* site;
+    uint64_t time_ns;
+    uint8_t argc;
+    uint8_t types[FAST_LOG_MAX_ARGS];
+    uint16_t text_used;
+    union Arg {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint32_t text_offset;   // String, in text[]
+        const void* p;
+    } args[FAST_LOG_MAX_ARGS];
+    char text[FAST_LOG_TEXT_MAX];
+};
+
+/**
+* @class lge::mm::FastLog
+* @brief Asynchronous logger for hot paths.
+* @details Each logging thread owns a lock-free single producer ring of FastLogRecord.<BR>
+*          A call stores the site and the raw arguments, strings are copied, and returns<BR>
+*          without formatting nor locking. A background thread drains all rings every<BR>
+*          FAST_LOG_DRAIN_INTERVAL_MS, formats the records in time order and passes them to<BR>
+*          the sink, which is MMLogXXX() (DLT) by default.<BR>
+*          When a ring is full the record is dropped and counted, a hot path never waits.
+*          Use it through MMFastLogDebug/Info/Warn/Error().
+*/
+class FastLog {
+public:
+    /**
+    * @brief Receives a formatted record on the drain thread.
+    * @param level : MM_FASTLOG_LEVEL_XXX
+    * @param text : "[sec.usec] function:line message" with the monotonic time of the call, valid only during the call
+    */
+    typedef std::function<void(uint8_t level, const char* text)> Sink;
+
+    /**
+    * @fn Acquire
+    * @brief Gets a free record of the ring of the calling thread.
+    * @return FastLogRecord* (nullptr - ring is full, the call is dropped)
+    */
+    static FastLogRecord* Acquire();
+
+    /**
+    * @fn Commit
+    * @brief Publishes the record got by the last Acquire() of the calling thread to the drain thread.
+    * @return : None
+    */
+    static void Commit();
+
+    /**
+    * @fn Flush
+    * @brief Drains all rings on the calling thread.
+    * @return : None
+    */
+    static void Flush();
+
+    /**
+    * @fn FlushAtExit
+    * @brief Drains all rings unless a drain stays busy for FAST_LOG_EXIT_FLUSH_MS.
+    * @details For exit handlers, where the thread which holds the drain may never run<BR>
+    *          again. It locks and formats, so it must not be called from a signal handler.
+    * @return bool (true - drained, false - gave up)
+    */
+    static bool FlushAtExit();
+
+    /**
+    * @fn SetSink
+    * @brief Replaces the sink. nullptr restores MMLogXXX().
+    * @return : None
+    */
+    static void SetSink(Sink sink);
+
+    /**
+    * @fn Format
+    * @brief Formats a record as printf() would format the site format with the arguments.
+    * @return size_t : length written to buffer, without terminating null
+    */
+    static size_t Format(const FastLogRecord& record, char* buffer, size_t size);
+
+    static uint64_t Dropped();
+};
+
+inline void FastLogPut(FastLogRecord& r, const char* s) {
+    size_t room = FAST_LOG_TEXT_MAX - r.text_used;
+    if (s == nullptr)
+        s = "(null)";
+    size_t length = strnlen(s, room > 0 ? room - 1 : 0);
+    r.types[r.argc] = FastLogRecord::String;
+    r.args[r.argc].text_offset = r.text_used;
+    if (room > 0) {
+        memcpy(r.text + r.text_used, s, length);
+        r.text[r.text_used + length] = '\0';
+        r.text_used += length + 1;
+    }
+    r.argc++;
+}
+
+inline void FastLogPut(FastLogRecord& r, char* s) {
+    FastLogPut(r, static_cast<const char*>(s));
+}
+
+inline void FastLogPut(FastLogRecord& r, double d) {
+    r.types[r.argc] = FastLogRecord::Double;
+    r.args[r.argc++].d = d;
+}
+
+inline void FastLogPut(FastLogRecord& r, const void* p) {
+    r.types[r.argc] = FastLogRecord::Pointer;
+    r.args[r.argc++].p = p;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+FastLogPut(FastLogRecord& r, T v) {
+    if (std::is_signed<T>::value || std::is_enum<T>::value) {
+        r.types[r.argc] = FastLogRecord::Signed;
+        r.args[r.argc++].i = (int64_t)v;
+    } else {
+        r.types[r.argc] = FastLogRecord::Unsigned;
+        r.args[r.argc++].u = (uint64_t)v;
+    }
+}
+
+inline void FastLogPutAll(FastLogRecord&) {
+}
+
+template <typename T, typename... Rest>
+inline void FastLogPutAll(FastLogRecord& r, T v, Rest... rest) {
+    FastLogPut(r, v);
+    FastLogPutAll(r, rest...);
+}
+
+template <typename... Args>
+inline void FastLogWrite(const FastLogSite* site, Args... args) {
+    static_assert(sizeof...(Args) <= FAST_LOG_MAX_ARGS, "too many arguments for MMFastLog");
+    FastLogRecord* r = FastLog::Acquire();
+    if (r == nullptr)
+        return;
+    r->site = site;
+    r->argc = 0;
+    r->text_used = 0;
+    FastLogPutAll(*r, args...);
+    FastLog::Commit();
+}
+
+// never called, lets the compiler check the format against the arguments
+inline void FastLogCheckFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void FastLogCheckFormat(const char*, ...) {
+}
+
+} // namespace mm
+} // namespace lge
+
+#define MM_FASTLOG(lv, fmt, ...) \
+    do { \
+        static const ::lge::mm::FastLogSite mm_fastlog_site = { lv, fmt, __FUNCTION__, __LINE__ }; \
+        if (0) ::lge::mm::FastLogCheckFormat(fmt, ##__VA_ARGS__); \
+        ::lge::mm::FastLogWrite(&mm_fastlog_site, ##__VA_ARGS__); \
+    } while (0)
+
+#if MM_FASTLOG_MIN_LEVEL <= MM_FASTLOG_LEVEL_DEBUG
+#define MMFastLogDebug(fmt, ...) MM_FASTLOG(MM_FASTLOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define MMFastLogDebug(fmt, ...) do {} while (0)
+#endif
+
+#if MM_FASTLOG_MIN_LEVEL <= MM_FASTLOG_LEVEL_INFO
+#define MMFastLogInfo(fmt, ...) MM_FASTLOG(MM_FASTLOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define MMFastLogInfo(fmt, ...) do {} while (0)
+#endif
+
+#if MM_FASTLOG_MIN_LEVEL <= MM_FASTLOG_LEVEL_WARN
+#define MMFastLogWarn(fmt, ...) MM_FASTLOG(MM_FASTLOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define MMFastLogWarn(fmt, ...) do {} while (0)
+#endif
+
+#if MM_FASTLOG_MIN_LEVEL <= MM_FASTLOG_LEVEL_ERROR
+#define MMFastLogError(fmt, ...) MM_FASTLOG(MM_FASTLOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define MMFastLogError(fmt, ...) do {} while (0)
+#endif
+
+#endif  // FAST_LOGGER_H_
@@ -0,0 +1,111 @@
+/**
+* @file fast_logger_benchmark.cpp
+* @version 1.0
+* Per-call cost of MMFastLogInfo() against formatting and writing the log on the caller.
+*
+* Each thread logs in bursts of half a ring, only the calls are timed and the rings are
+* flushed between bursts, so no record is dropped. "sync" formats by vsnprintf and writes
+* to /dev/null under a mutex, as a synchronous logger does on the caller thread. "elided"
+* is MMFastLogDebug() removed by MM_FASTLOG_MIN_LEVEL.
+*
+* build : g++ -O2 -std=c++11 -pthread -I. fast_logger_benchmark.cpp fast_logger.cpp -o fastlog_bench
+* usage : fastlog_bench [threads=1] [calls=1000000]
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fast_logger.h"
+
+using lge::mm::FastLog;
+
+static FILE* null_fp = nullptr;
+static std::mutex sync_mutex;
+
+static void SyncLog(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static void SyncLog(const char* format, ...) {
+    char text[512];
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(text, sizeof(text), format, ap);
+    va_end(ap);
+    std::lock_guard<std::mutex> locker(sync_mutex);
+    fwrite(text, 1, n > 0 ? n : 0, null_fp);
+}
+
+enum class Mode { Fast, Sync, Elided };
+
+static double Run(Mode mode, int threads, uint32_t& calls) {
+    const uint32_t burst = FAST_LOG_RING_SIZE / 2;
+    calls = (calls + burst - 1) / burst * burst;
+    std::vector<std::thread> workers;
+    std::vector<double> busy_ns(threads, 0);
+    std::string connection = ":1.234";
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (uint32_t done = 0; done < calls; done += burst) {
+                auto begin = std::chrono::steady_clock::now();
+                for (uint32_t i = done; i < done + burst; i++) {
+                    switch (mode) {
+                    case Mode::Fast:
+                        MMFastLogInfo("Find a duplicated command(%d) [%s]", (int)i, connection.c_str());
+                        break;
+                    case Mode::Sync:
+                        SyncLog("Find a duplicated command(%d) [%s]", (int)i, connection.c_str());
+                        break;
+                    case Mode::Elided:
+                        MMFastLogDebug("Find a duplicated command(%d) [%s]", (int)i, connection.c_str());
+                        break;
+                    }
+                }
+                busy_ns[t] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+                if (mode == Mode::Fast)
+                    FastLog::Flush();
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    double total = 0;
+    for (auto ns : busy_ns)
+        total += ns;
+    return total / ((double)threads * calls);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = (argc > 1) ? atoi(argv[1]) : 1;
+    uint32_t calls = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    null_fp = fopen("/dev/null", "w");
+    std::atomic<uint64_t> drained(0);
+    FastLog::SetSink([&drained](uint8_t, const char* text) {
+        fputs(text, null_fp);
+        drained++;
+    });
+
+    // registers the ring and starts the drain thread before timing
+    MMFastLogInfo("warm up");
+    FastLog::Flush();
+    drained = 0;
+
+    printf("%-8s %8s %10s %12s\n", "mode", "threads", "calls", "ns/call");
+    double ns = Run(Mode::Fast, threads, calls);
+    FastLog::Flush();
+    printf("%-8s %8d %10u %12.1f\n", "fast", threads, calls, ns);
+    ns = Run(Mode::Sync, threads, calls);
+    printf("%-8s %8d %10u %12.1f\n", "sync", threads, calls, ns);
+    ns = Run(Mode::Elided, threads, calls);
+    printf("%-8s %8d %10u %12.1f\n", "elided", threads, calls, ns);
+    printf("drained=%llu dropped=%llu\n", (unsigned long long)drained.load(),
+           (unsigned long long)FastLog::Dropped());
+    return 0;
+}
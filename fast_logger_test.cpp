@@ -0,0 +1,98 @@
+/**
+* @file fast_logger_test.cpp
+* @version 1.0
+* Test of the records written by MMFastLogXXX().
+*
+* A drained text starts with the monotonic time of the call, not of the drain, and records
+* of different threads come out in the order of their calls. FlushAtExit() drains what is
+* left in the rings.
+*
+* build : g++ -std=c++11 -pthread -I. fast_logger_test.cpp fast_logger.cpp -o fast_logger_test
+* usage : fast_logger_test
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fast_logger.h"
+#include "test_check.h"
+
+using lge::mm::FastLog;
+
+static std::mutex texts_mutex;
+static std::vector<std::string> texts;
+
+static void Collect(uint8_t, const char* text) {
+    std::lock_guard<std::mutex> locker(texts_mutex);
+    texts.push_back(text);
+}
+
+static uint64_t NowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// stamp of the first text which contains the message, 0 if none
+static uint64_t StampOf(const char* message, size_t* order = nullptr) {
+    std::lock_guard<std::mutex> locker(texts_mutex);
+    for (size_t i = 0; i < texts.size(); i++) {
+        if (texts[i].find(message) == std::string::npos)
+            continue;
+        unsigned long long sec = 0, usec = 0;
+        if (sscanf(texts[i].c_str(), "[%llu.%06llu] ", &sec, &usec) != 2)
+            return 0;
+        if (order)
+            *order = i;
+        return sec * 1000000ull + usec;
+    }
+    return 0;
+}
+
+static void TestCallTime() {
+    uint64_t before = NowUs();
+    MMFastLogInfo("call time %d", 1);
+    uint64_t after = NowUs();
+
+    // the drain comes later, the stamp stays the time of the call
+    usleep(60 * 1000);
+    FastLog::Flush();
+
+    uint64_t stamp = StampOf("call time 1");
+    CHECK(stamp >= before && stamp <= after);
+}
+
+static void TestOrderOverThreads() {
+    std::thread other([]() { MMFastLogInfo("order %s", "first"); });
+    other.join();
+    MMFastLogInfo("order %s", "second");
+    FastLog::Flush();
+
+    size_t first = 0, second = 0;
+    CHECK(StampOf("order first", &first) > 0);
+    CHECK(StampOf("order second", &second) > 0);
+    CHECK(first < second);
+}
+
+static void TestFlushAtExit() {
+    MMFastLogWarn("left at exit %u", 7u);
+    CHECK(FastLog::FlushAtExit());
+    CHECK(StampOf("left at exit 7") > 0);
+}
+
+int main() {
+    FastLog::SetSink(Collect);
+
+    TestCallTime();
+    TestOrderOverThreads();
+    TestFlushAtExit();
+
+    FastLog::SetSink(nullptr);
+    return TestResult("fast_logger_test");
+}
@@ -38,6 +38,9 @@
 #include "lightmediascanner_private.h"
 #include "lightmediascanner_db_private.h"
 #include "lightmediascanner_platform_conf.h"
+#if defined(ENABLE_KEYFRAME_INDEX)
+#include "lms_keyframe_index.h"
+#endif
 
 #define SEPARATE_FILES_FROM_DIRECTORIES_PROCESSING
 #define TAB_BUFFER_SIZE		128
@@ -700,6 +703,13 @@ _db_and_parsers_process_file(lms_t *lms, struct db *db, void **parser_match,
         return r;
     }
 
+#if defined(ENABLE_KEYFRAME_INDEX)
+    /* keyframe table for PlayerProvider, read while the file is still in the page cache */
+    if (lms_keyframe_index_supported(finfo.path, finfo.path_len) &&
+        lms_keyframe_index_build(finfo.path) < 0)
+        log_debug("no keyframe index for \"%s\"", finfo.path);
+#endif
+
     return LMS_PROGRESS_STATUS_PROCESSED;
 }
 
@@ -0,0 +1,1026 @@
+/**
+ * @file lms_keyframe_index.c
+ * Keyframe index of video files, extracted at scan time and kept in a sidecar cache.
+ *
+ * Sidecar layout, little endian:
+ *   "KFI1" | u64 media size | i64 media mtime | u32 count | count * (zigzag varint dtime_ms, zigzag varint doffset)
+ * It is named by FNV-1a of the media path, so it survives neither a change of the media
+ * nor a rename, and a stale one is found by size and mtime.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pread, PATH_MAX under -std=c99 */
+#endif
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "lms_keyframe_index.h"
+
+#define KFI_MAGIC       "KFI1"
+#define KFI_HEADER_SIZE (4 + 8 + 8 + 4)
+
+/* ---------------------------------------------------------------- helpers */
+
+static inline uint32_t _le32(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline uint64_t _le64(const uint8_t *p) { return (uint64_t)_le32(p) | ((uint64_t)_le32(p + 4) << 32); }
+static inline uint32_t _be32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+static inline uint64_t _be64(const uint8_t *p) { return ((uint64_t)_be32(p) << 32) | (uint64_t)_be32(p + 4); }
+
+static int
+_read_at(int fd, uint64_t offset, void *buf, size_t len)
+{
+    uint8_t *p = buf;
+
+    while (len > 0) {
+        ssize_t r = pread(fd, p, len, (off_t)offset);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return -1;
+        p += r;
+        offset += (uint64_t)r;
+        len -= (size_t)r;
+    }
+    return 0;
+}
+
+static uint8_t *
+_load_at(int fd, uint64_t offset, uint64_t len)
+{
+    uint8_t *buf;
+
+    if (len == 0 || len > KEYFRAME_INDEX_MAX_HEADER)
+        return NULL;
+
+    buf = malloc((size_t)len);
+    if (!buf)
+        return NULL;
+    if (_read_at(fd, offset, buf, (size_t)len) < 0) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+struct _builder {
+    struct lms_keyframe *entries;
+    uint32_t count;
+    uint32_t alloc;
+};
+
+static int
+_builder_add(struct _builder *b, uint64_t time_ms, uint64_t offset)
+{
+    if (b->count > 0) {
+        const struct lms_keyframe *last = &b->entries[b->count - 1];
+        /* collapse entries a player could not tell apart */
+        if (last->time_ms == time_ms || last->offset == offset)
+            return 0;
+    }
+
+    if (b->count == b->alloc) {
+        uint32_t alloc = b->alloc ? b->alloc * 2 : 256;
+        struct lms_keyframe *tmp = realloc(b->entries, alloc * sizeof(*tmp));
+        if (!tmp)
+            return -1;
+        b->entries = tmp;
+        b->alloc = alloc;
+    }
+
+    b->entries[b->count].time_ms = time_ms;
+    b->entries[b->count].offset = offset;
+    b->count++;
+    return 0;
+}
+
+static int
+_builder_finish(struct _builder *b, struct lms_keyframe_index *index)
+{
+    if (b->count < 2) {
+        /* a single keyframe does not help seeking */
+        free(b->entries);
+        return -1;
+    }
+
+    index->count = b->count;
+    index->entries = b->entries;
+    return 0;
+}
+
+/* ---------------------------------------------------------------- MP4 */
+
+struct _mp4_box {
+    const uint8_t *data;
+    uint64_t size;
+};
+
+/* finds the first child of type in [p, end), data excludes the box header */
+static int
+_mp4_child(const uint8_t *p, const uint8_t *end, const char *type, struct _mp4_box *box)
+{
+    while (end - p >= 8) {
+        uint64_t size = _be32(p);
+        unsigned int header = 8;
+
+        if (size == 1) {
+            if (end - p < 16)
+                return -1;
+            size = _be64(p + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = (uint64_t)(end - p);
+        }
+        if (size < header || size > (uint64_t)(end - p))
+            return -1;
+
+        if (memcmp(p + 4, type, 4) == 0) {
+            box->data = p + header;
+            box->size = size - header;
+            return 0;
+        }
+        p += size;
+    }
+    return -1;
+}
+
+static int
+_mp4_path(const struct _mp4_box *parent, const char *const *types, struct _mp4_box *box)
+{
+    struct _mp4_box cur = *parent;
+
+    for (; *types; types++) {
+        if (_mp4_child(cur.data, cur.data + cur.size, *types, &cur) < 0)
+            return -1;
+    }
+    *box = cur;
+    return 0;
+}
+
+/* timescale of mvhd or mdhd, 0 if broken */
+static uint32_t
+_mp4_timescale(const struct _mp4_box *hd)
+{
+    if (hd->size < 24)
+        return 0;
+    if (hd->data[0] == 1)
+        return hd->size < 32 ? 0 : _be32(hd->data + 20);
+    return _be32(hd->data + 12);
+}
+
+/*
+ * shift from decode time to presentation time by the edit list, in track timescale:
+ * leading empty edits delay the track, the first media edit skips media_time
+ */
+static int64_t
+_mp4_edit_shift(const struct _mp4_box *trak, uint32_t movie_timescale, uint32_t timescale)
+{
+    static const char *const elst_path[] = { "edts", "elst", NULL };
+    struct _mp4_box elst;
+    uint32_t n, i, entry_size;
+    int64_t shift = 0;
+    int v1;
+
+    if (_mp4_path(trak, elst_path, &elst) < 0 || elst.size < 8)
+        return 0;
+    v1 = elst.data[0] == 1;
+    entry_size = v1 ? 20 : 12;
+    n = _be32(elst.data + 4);
+    if (n > (elst.size - 8) / entry_size)
+        return 0;
+
+    for (i = 0; i < n; i++) {
+        const uint8_t *e = elst.data + 8 + (uint64_t)i * entry_size;
+        uint64_t duration = v1 ? _be64(e) : _be32(e);
+        int64_t media_time = v1 ? (int64_t)_be64(e + 8) : (int64_t)(int32_t)_be32(e + 4);
+
+        if (media_time == -1) {
+            if (movie_timescale > 0)
+                shift += (int64_t)(duration * timescale / movie_timescale);
+            continue;
+        }
+        return shift - media_time;
+    }
+    return shift;
+}
+
+static int
+_mp4_track(const struct _mp4_box *trak, uint32_t movie_timescale, struct _builder *b)
+{
+    static const char *const hdlr_path[] = { "mdia", "hdlr", NULL };
+    static const char *const mdhd_path[] = { "mdia", "mdhd", NULL };
+    static const char *const stbl_path[] = { "mdia", "minf", "stbl", NULL };
+    struct _mp4_box hdlr, mdhd, stbl, stts, stss, stsc, stsz, stco, ctts;
+    const uint8_t *stbl_end;
+    uint32_t timescale, stts_n, stss_n, stsc_n, stsz_n, stco_n, ctts_n, fixed_size;
+    uint32_t stts_i = 0, stts_left, stss_i = 0, stsc_i = 0, ctts_i = 0, ctts_left = 0, chunk, sample = 1;
+    int co64;
+    uint64_t time = 0;
+    int64_t shift;
+
+    if (_mp4_path(trak, hdlr_path, &hdlr) < 0 || hdlr.size < 12 ||
+        memcmp(hdlr.data + 8, "vide", 4) != 0)
+        return -1;
+
+    if (_mp4_path(trak, mdhd_path, &mdhd) < 0)
+        return -1;
+    timescale = _mp4_timescale(&mdhd);
+    if (timescale == 0)
+        return -1;
+    shift = _mp4_edit_shift(trak, movie_timescale, timescale);
+
+    if (_mp4_path(trak, stbl_path, &stbl) < 0)
+        return -1;
+    stbl_end = stbl.data + stbl.size;
+
+    /* without stss every sample is a keyframe, nothing to index */
+    if (_mp4_child(stbl.data, stbl_end, "stss", &stss) < 0 ||
+        _mp4_child(stbl.data, stbl_end, "stts", &stts) < 0 ||
+        _mp4_child(stbl.data, stbl_end, "stsc", &stsc) < 0 ||
+        _mp4_child(stbl.data, stbl_end, "stsz", &stsz) < 0)
+        return -1;
+    co64 = 0;
+    if (_mp4_child(stbl.data, stbl_end, "stco", &stco) < 0) {
+        if (_mp4_child(stbl.data, stbl_end, "co64", &stco) < 0)
+            return -1;
+        co64 = 1;
+    }
+
+    if (stss.size < 8 || stts.size < 8 || stsc.size < 8 || stsz.size < 12 || stco.size < 8)
+        return -1;
+    stss_n = _be32(stss.data + 4);
+    stts_n = _be32(stts.data + 4);
+    stsc_n = _be32(stsc.data + 4);
+    fixed_size = _be32(stsz.data + 4);
+    stsz_n = _be32(stsz.data + 8);
+    stco_n = _be32(stco.data + 4);
+    if (stss_n > (stss.size - 8) / 4 || stts_n > (stts.size - 8) / 8 ||
+        stsc_n > (stsc.size - 8) / 12 || stco_n > (stco.size - 8) / (co64 ? 8 : 4) ||
+        (fixed_size == 0 && stsz_n > (stsz.size - 12) / 4))
+        return -1;
+    if (stss_n == 0 || stts_n == 0 || stsc_n == 0 || stco_n == 0)
+        return -1;
+
+    /* composition offsets of B-frame streams, signed even in version 0 as written by most muxers */
+    ctts_n = 0;
+    if (_mp4_child(stbl.data, stbl_end, "ctts", &ctts) == 0 && ctts.size >= 8) {
+        ctts_n = _be32(ctts.data + 4);
+        if (ctts_n > (ctts.size - 8) / 8)
+            ctts_n = 0;
+        if (ctts_n > 0)
+            ctts_left = _be32(ctts.data + 8);
+    }
+
+    stts_left = _be32(stts.data + 8);
+
+    /* walk samples chunk by chunk, stopping on sync samples */
+    for (chunk = 1; chunk <= stco_n && stss_i < stss_n; chunk++) {
+        uint64_t offset;
+        uint32_t per_chunk, j;
+
+        while (stsc_i + 1 < stsc_n && _be32(stsc.data + 8 + (stsc_i + 1) * 12) <= chunk)
+            stsc_i++;
+        per_chunk = _be32(stsc.data + 8 + stsc_i * 12 + 4);
+
+        offset = co64 ? _be64(stco.data + 8 + (uint64_t)(chunk - 1) * 8)
+                      : _be32(stco.data + 8 + (chunk - 1) * 4);
+
+        for (j = 0; j < per_chunk && stss_i < stss_n; j++, sample++) {
+            uint32_t size;
+
+            if (sample > stsz_n)
+                goto done;
+
+            while (ctts_left == 0 && ctts_i + 1 < ctts_n) {
+                ctts_i++;
+                ctts_left = _be32(ctts.data + 8 + ctts_i * 8);
+            }
+
+            while (stss_i < stss_n && _be32(stss.data + 8 + stss_i * 4) < sample)
+                stss_i++;
+            if (stss_i < stss_n && _be32(stss.data + 8 + stss_i * 4) == sample) {
+                int64_t pts = (int64_t)time + shift;
+
+                if (ctts_n > 0)
+                    pts += (int32_t)_be32(ctts.data + 8 + ctts_i * 8 + 4);
+                if (pts < 0)
+                    pts = 0;
+                if (_builder_add(b, (uint64_t)pts * 1000 / timescale, offset) < 0)
+                    return -1;
+                stss_i++;
+            }
+            if (ctts_left > 0)
+                ctts_left--;
+
+            size = fixed_size ? fixed_size : _be32(stsz.data + 12 + (sample - 1) * 4);
+            offset += size;
+
+            while (stts_left == 0 && stts_i + 1 < stts_n) {
+                stts_i++;
+                stts_left = _be32(stts.data + 8 + stts_i * 8);
+            }
+            time += _be32(stts.data + 8 + stts_i * 8 + 4);
+            if (stts_left > 0)
+                stts_left--;
+        }
+    }
+
+done:
+    return b->count > 0 ? 0 : -1;
+}
+
+static int
+_mp4_extract(int fd, uint64_t file_size, struct _builder *b)
+{
+    uint64_t pos = 0;
+    uint8_t header[16];
+
+    while (pos + 8 <= file_size) {
+        uint64_t size;
+        unsigned int header_size = 8;
+
+        if (_read_at(fd, pos, header, 8) < 0)
+            return -1;
+        size = _be32(header);
+        if (size == 1) {
+            if (_read_at(fd, pos + 8, header + 8, 8) < 0)
+                return -1;
+            size = _be64(header + 8);
+            header_size = 16;
+        } else if (size == 0) {
+            size = file_size - pos;
+        }
+        if (size < header_size || size > file_size - pos)
+            return -1;
+
+        if (memcmp(header + 4, "moov", 4) == 0) {
+            struct _mp4_box moov, mvhd, trak;
+            const uint8_t *p, *end;
+            uint8_t *buf = _load_at(fd, pos + header_size, size - header_size);
+            uint32_t movie_timescale = 0;
+            int r = -1;
+
+            if (!buf)
+                return -1;
+            moov.data = buf;
+            moov.size = size - header_size;
+
+            p = moov.data;
+            end = moov.data + moov.size;
+            if (_mp4_child(p, end, "mvhd", &mvhd) == 0)
+                movie_timescale = _mp4_timescale(&mvhd);
+
+            /* first video track with a sync sample table */
+            while (r < 0 && _mp4_child(p, end, "trak", &trak) == 0) {
+                r = _mp4_track(&trak, movie_timescale, b);
+                p = trak.data + trak.size;
+            }
+            free(buf);
+            return r;
+        }
+        pos += size;
+    }
+    return -1;
+}
+
+/* ---------------------------------------------------------------- Matroska */
+
+#define EBML_ID_HEADER          0x1A45DFA3
+#define EBML_ID_SEGMENT         0x18538067
+#define EBML_ID_SEEKHEAD        0x114D9B74
+#define EBML_ID_SEEK            0x4DBB
+#define EBML_ID_SEEKID          0x53AB
+#define EBML_ID_SEEKPOSITION    0x53AC
+#define EBML_ID_INFO            0x1549A966
+#define EBML_ID_TIMECODESCALE   0x2AD7B1
+#define EBML_ID_CLUSTER         0x1F43B675
+#define EBML_ID_CUES            0x1C53BB6B
+#define EBML_ID_CUEPOINT        0xBB
+#define EBML_ID_CUETIME         0xB3
+#define EBML_ID_CUETRACKPOS     0xB7
+#define EBML_ID_CUECLUSTERPOS   0xF1
+#define EBML_SIZE_UNKNOWN       UINT64_MAX
+
+/* reads an element id (keep_marker) or size, returns its length or 0 */
+static unsigned int
+_ebml_vint(const uint8_t *p, const uint8_t *end, int keep_marker, uint64_t *value)
+{
+    unsigned int len = 1, i;
+    uint8_t mask = 0x80;
+    uint64_t v;
+    int all_ones;
+
+    if (p >= end || p[0] == 0)
+        return 0;
+    while (!(p[0] & mask)) {
+        mask >>= 1;
+        len++;
+    }
+    if (len > 8 || (keep_marker && len > 4) || (uint64_t)(end - p) < len)
+        return 0;
+
+    v = keep_marker ? p[0] : (uint64_t)(p[0] & (mask - 1));
+    all_ones = (p[0] & (mask - 1)) == (mask - 1);
+    for (i = 1; i < len; i++) {
+        v = (v << 8) | p[i];
+        all_ones = all_ones && p[i] == 0xFF;
+    }
+    *value = (!keep_marker && all_ones) ? EBML_SIZE_UNKNOWN : v;
+    return len;
+}
+
+static int
+_ebml_element(const uint8_t *p, const uint8_t *end, uint64_t *id, uint64_t *size, unsigned int *header)
+{
+    unsigned int a, c;
+
+    a = _ebml_vint(p, end, 1, id);
+    if (!a)
+        return -1;
+    c = _ebml_vint(p + a, end, 0, size);
+    if (!c)
+        return -1;
+    *header = a + c;
+    return 0;
+}
+
+static uint64_t
+_ebml_uint(const uint8_t *p, uint64_t size)
+{
+    uint64_t v = 0, i;
+
+    for (i = 0; i < size && i < 8; i++)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static int
+_mkv_read_element(int fd, uint64_t pos, uint64_t file_size, uint64_t *id, uint64_t *size, unsigned int *header)
+{
+    uint8_t buf[12];
+    size_t len = (file_size - pos < sizeof(buf)) ? (size_t)(file_size - pos) : sizeof(buf);
+
+    if (len < 2 || _read_at(fd, pos, buf, len) < 0)
+        return -1;
+    return _ebml_element(buf, buf + len, id, size, header);
+}
+
+static void
+_mkv_seekhead(const uint8_t *p, const uint8_t *end, uint64_t *cues_pos, uint64_t *info_pos)
+{
+    uint64_t id, size;
+    unsigned int header;
+
+    while (p < end && _ebml_element(p, end, &id, &size, &header) == 0 && size <= (uint64_t)(end - p - header)) {
+        if (id == EBML_ID_SEEK) {
+            const uint8_t *q = p + header, *qend = q + size;
+            uint64_t seek_id = 0, seek_pos = 0, qid, qsize;
+            unsigned int qheader;
+
+            while (q < qend && _ebml_element(q, qend, &qid, &qsize, &qheader) == 0 &&
+                   qsize <= (uint64_t)(qend - q - qheader)) {
+                if (qid == EBML_ID_SEEKID && qsize <= 4)
+                    seek_id = _ebml_uint(q + qheader, qsize);
+                else if (qid == EBML_ID_SEEKPOSITION)
+                    seek_pos = _ebml_uint(q + qheader, qsize);
+                q += qheader + qsize;
+            }
+            if (seek_id == EBML_ID_CUES)
+                *cues_pos = seek_pos;
+            else if (seek_id == EBML_ID_INFO)
+                *info_pos = seek_pos;
+        }
+        p += header + size;
+    }
+}
+
+static uint64_t
+_mkv_timecode_scale(const uint8_t *p, const uint8_t *end)
+{
+    uint64_t id, size;
+    unsigned int header;
+
+    while (p < end && _ebml_element(p, end, &id, &size, &header) == 0 && size <= (uint64_t)(end - p - header)) {
+        if (id == EBML_ID_TIMECODESCALE) {
+            uint64_t scale = _ebml_uint(p + header, size);
+            return scale ? scale : 1000000;
+        }
+        p += header + size;
+    }
+    return 1000000;
+}
+
+static int
+_mkv_cues(const uint8_t *p, const uint8_t *end, uint64_t segment, uint64_t scale, struct _builder *b)
+{
+    uint64_t id, size;
+    unsigned int header;
+
+    while (p < end && _ebml_element(p, end, &id, &size, &header) == 0 && size <= (uint64_t)(end - p - header)) {
+        if (id == EBML_ID_CUEPOINT) {
+            const uint8_t *q = p + header, *qend = q + size;
+            uint64_t qid, qsize, time = UINT64_MAX, cluster = UINT64_MAX;
+            unsigned int qheader;
+
+            while (q < qend && _ebml_element(q, qend, &qid, &qsize, &qheader) == 0 &&
+                   qsize <= (uint64_t)(qend - q - qheader)) {
+                if (qid == EBML_ID_CUETIME) {
+                    time = _ebml_uint(q + qheader, qsize);
+                } else if (qid == EBML_ID_CUETRACKPOS && cluster == UINT64_MAX) {
+                    /* cues are usually of the video track only, take the first one */
+                    const uint8_t *r = q + qheader, *rend = r + qsize;
+                    uint64_t rid, rsize;
+                    unsigned int rheader;
+
+                    while (r < rend && _ebml_element(r, rend, &rid, &rsize, &rheader) == 0 &&
+                           rsize <= (uint64_t)(rend - r - rheader)) {
+                        if (rid == EBML_ID_CUECLUSTERPOS)
+                            cluster = _ebml_uint(r + rheader, rsize);
+                        r += rheader + rsize;
+                    }
+                }
+                q += qheader + qsize;
+            }
+            if (time != UINT64_MAX && cluster != UINT64_MAX &&
+                _builder_add(b, time * (scale / 1000) / 1000, segment + cluster) < 0)
+                return -1;
+        }
+        p += header + size;
+    }
+    return b->count > 0 ? 0 : -1;
+}
+
+static int
+_mkv_extract(int fd, uint64_t file_size, struct _builder *b)
+{
+    uint64_t id, size, pos = 0, segment, segment_end;
+    uint64_t cues_pos = UINT64_MAX, info_pos = UINT64_MAX, scale = 1000000;
+    unsigned int header;
+    uint8_t *buf;
+    int r;
+
+    if (_mkv_read_element(fd, pos, file_size, &id, &size, &header) < 0 || id != EBML_ID_HEADER ||
+        size == EBML_SIZE_UNKNOWN)
+        return -1;
+    pos += header + size;
+
+    if (_mkv_read_element(fd, pos, file_size, &id, &size, &header) < 0 || id != EBML_ID_SEGMENT)
+        return -1;
+    segment = pos + header;
+    segment_end = (size == EBML_SIZE_UNKNOWN || size > file_size - segment) ? file_size : segment + size;
+
+    /* top level elements up to the first cluster, Cues are found by SeekHead when they are behind it */
+    for (pos = segment; pos < segment_end; pos += header + size) {
+        if (_mkv_read_element(fd, pos, file_size, &id, &size, &header) < 0 ||
+            size == EBML_SIZE_UNKNOWN || size > segment_end - pos - header)
+            break;
+
+        if (id == EBML_ID_SEEKHEAD) {
+            buf = _load_at(fd, pos + header, size);
+            if (buf) {
+                uint64_t cues = UINT64_MAX, info = UINT64_MAX;
+                _mkv_seekhead(buf, buf + size, &cues, &info);
+                if (cues != UINT64_MAX)
+                    cues_pos = segment + cues;
+                if (info != UINT64_MAX)
+                    info_pos = segment + info;
+                free(buf);
+            }
+        } else if (id == EBML_ID_INFO) {
+            info_pos = pos;
+        } else if (id == EBML_ID_CUES) {
+            cues_pos = pos;
+        } else if (id == EBML_ID_CLUSTER && cues_pos != UINT64_MAX) {
+            break;
+        }
+    }
+
+    if (cues_pos == UINT64_MAX || cues_pos >= file_size)
+        return -1;
+
+    if (info_pos != UINT64_MAX && info_pos < file_size &&
+        _mkv_read_element(fd, info_pos, file_size, &id, &size, &header) == 0 && id == EBML_ID_INFO) {
+        buf = _load_at(fd, info_pos + header, size);
+        if (buf) {
+            scale = _mkv_timecode_scale(buf, buf + size);
+            free(buf);
+        }
+    }
+
+    if (_mkv_read_element(fd, cues_pos, file_size, &id, &size, &header) < 0 || id != EBML_ID_CUES ||
+        size == EBML_SIZE_UNKNOWN || size > file_size - cues_pos - header)
+        return -1;
+    buf = _load_at(fd, cues_pos + header, size);
+    if (!buf)
+        return -1;
+    r = _mkv_cues(buf, buf + size, segment, scale, b);
+    free(buf);
+    return r;
+}
+
+/* ---------------------------------------------------------------- ASF */
+
+static const uint8_t _asf_header_guid[16] = {
+    0x30, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11, 0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C };
+static const uint8_t _asf_file_properties_guid[16] = {
+    0xA1, 0xDC, 0xAB, 0x8C, 0x47, 0xA9, 0xCF, 0x11, 0x8E, 0xE4, 0x00, 0xC0, 0x0C, 0x20, 0x53, 0x65 };
+static const uint8_t _asf_data_guid[16] = {
+    0x36, 0x26, 0xB2, 0x75, 0x8E, 0x66, 0xCF, 0x11, 0xA6, 0xD9, 0x00, 0xAA, 0x00, 0x62, 0xCE, 0x6C };
+static const uint8_t _asf_simple_index_guid[16] = {
+    0x90, 0x08, 0x00, 0x33, 0xB1, 0xE5, 0xCF, 0x11, 0x89, 0xF4, 0x00, 0xA0, 0xC9, 0x03, 0x49, 0xCB };
+
+static int
+_asf_extract(int fd, uint64_t file_size, struct _builder *b)
+{
+    uint8_t obj[24];
+    uint8_t *buf;
+    uint64_t header_size, pos, data_start = 0, preroll = 0;
+    uint32_t packet_size = 0, i, n;
+
+    if (_read_at(fd, 0, obj, 24) < 0 || memcmp(obj, _asf_header_guid, 16) != 0)
+        return -1;
+    header_size = _le64(obj + 16);
+    if (header_size < 30 || header_size > file_size)
+        return -1;
+
+    buf = _load_at(fd, 0, header_size);
+    if (!buf)
+        return -1;
+    for (pos = 30; pos + 24 <= header_size;) {
+        uint64_t size = _le64(buf + pos + 16);
+        if (size < 24 || size > header_size - pos)
+            break;
+        if (memcmp(buf + pos, _asf_file_properties_guid, 16) == 0 && size >= 104) {
+            preroll = _le64(buf + pos + 80);
+            packet_size = _le32(buf + pos + 92);
+            /* variable size packets can not be located by number */
+            if (packet_size != _le32(buf + pos + 96))
+                packet_size = 0;
+        }
+        pos += size;
+    }
+    free(buf);
+    if (packet_size == 0)
+        return -1;
+
+    /* the data object follows the header, index objects follow the data */
+    for (pos = header_size; pos + 24 <= file_size;) {
+        uint64_t size;
+
+        if (_read_at(fd, pos, obj, 24) < 0)
+            return -1;
+        size = _le64(obj + 16);
+        if (size < 24 || size > file_size - pos)
+            return -1;
+
+        if (memcmp(obj, _asf_data_guid, 16) == 0) {
+            data_start = pos + 50;
+        } else if (memcmp(obj, _asf_simple_index_guid, 16) == 0 && data_start && size >= 56) {
+            uint64_t interval;
+            int r = 0;
+
+            buf = _load_at(fd, pos, size);
+            if (!buf)
+                return -1;
+            interval = _le64(buf + 40);
+            n = _le32(buf + 52);
+            if (n > (size - 56) / 6)
+                n = (uint32_t)((size - 56) / 6);
+            for (i = 0; i < n && r == 0; i++) {
+                uint64_t time_ms = (uint64_t)i * interval / 10000;
+                uint32_t packet = _le32(buf + 56 + (uint64_t)i * 6);
+                /* index times are send times, the first packets carry the preroll */
+                r = _builder_add(b, time_ms > preroll ? time_ms - preroll : 0,
+                                 data_start + (uint64_t)packet * packet_size);
+            }
+            free(buf);
+            return (r == 0 && b->count > 0) ? 0 : -1;
+        }
+        pos += size;
+    }
+    return -1;
+}
+
+/* ---------------------------------------------------------------- public */
+
+enum _container {
+    _CONTAINER_NONE,
+    _CONTAINER_MP4,
+    _CONTAINER_MKV,
+    _CONTAINER_ASF
+};
+
+static enum _container
+_container_of(const char *path, int path_len)
+{
+    static const struct {
+        const char *ext;
+        enum _container container;
+    } exts[] = {
+        { ".mp4", _CONTAINER_MP4 }, { ".m4v", _CONTAINER_MP4 }, { ".mov", _CONTAINER_MP4 },
+        { ".3gp", _CONTAINER_MP4 }, { ".mkv", _CONTAINER_MKV }, { ".webm", _CONTAINER_MKV },
+        { ".asf", _CONTAINER_ASF }, { ".wmv", _CONTAINER_ASF },
+    };
+    unsigned int i;
+
+    if (path_len < 0)
+        path_len = (int)strlen(path);
+
+    for (i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+        int len = (int)strlen(exts[i].ext);
+        if (path_len > len && strncasecmp(path + path_len - len, exts[i].ext, len) == 0)
+            return exts[i].container;
+    }
+    return _CONTAINER_NONE;
+}
+
+int
+lms_keyframe_index_supported(const char *path, int path_len)
+{
+    return _container_of(path, path_len) != _CONTAINER_NONE;
+}
+
+int
+lms_keyframe_index_extract(const char *path, struct lms_keyframe_index *index)
+{
+    struct _builder b = { NULL, 0, 0 };
+    enum _container container = _container_of(path, -1);
+    struct stat st;
+    int fd, r = -1;
+
+    index->count = 0;
+    index->entries = NULL;
+
+    if (container == _CONTAINER_NONE)
+        return -1;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        switch (container) {
+        case _CONTAINER_MP4:
+            r = _mp4_extract(fd, (uint64_t)st.st_size, &b);
+            break;
+        case _CONTAINER_MKV:
+            r = _mkv_extract(fd, (uint64_t)st.st_size, &b);
+            break;
+        case _CONTAINER_ASF:
+            r = _asf_extract(fd, (uint64_t)st.st_size, &b);
+            break;
+        default:
+            break;
+        }
+    }
+    close(fd);
+
+    if (r < 0) {
+        free(b.entries);
+        return -1;
+    }
+    return _builder_finish(&b, index);
+}
+
+int
+lms_keyframe_index_sidecar(const char *path, char *out, size_t out_len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char *p;
+    int r;
+
+    for (p = (const unsigned char *)path; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
+
+    r = snprintf(out, out_len, "%s/%016llx.kfi", KEYFRAME_INDEX_DIR, (unsigned long long)hash);
+    return (r < 0 || (size_t)r >= out_len) ? -1 : 0;
+}
+
+/* opens the sidecar of path and checks its header against the media, returns the fd */
+static int
+_sidecar_open(const char *path, char *sidecar, size_t sidecar_len, size_t *len)
+{
+    struct stat st, sst;
+    uint8_t header[KFI_HEADER_SIZE];
+    int fd;
+
+    if (stat(path, &st) < 0 || lms_keyframe_index_sidecar(path, sidecar, sidecar_len) < 0)
+        return -1;
+
+    fd = open(sidecar, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &sst) < 0 || sst.st_size < KFI_HEADER_SIZE || sst.st_size > KEYFRAME_INDEX_MAX_HEADER ||
+        _read_at(fd, 0, header, sizeof(header)) < 0 ||
+        memcmp(header, KFI_MAGIC, 4) != 0 ||
+        _le64(header + 4) != (uint64_t)st.st_size ||
+        (int64_t)_le64(header + 12) != (int64_t)st.st_mtime) {
+        close(fd);
+        return -1;
+    }
+
+    *len = (size_t)sst.st_size;
+    return fd;
+}
+
+/* reads the sidecar of path, checks it against the media and returns its body */
+static uint8_t *
+_sidecar_read(const char *path, char *sidecar, size_t sidecar_len, size_t *len)
+{
+    uint8_t *buf;
+    int fd = _sidecar_open(path, sidecar, sidecar_len, len);
+
+    if (fd < 0)
+        return NULL;
+
+    buf = malloc(*len);
+    if (!buf || _read_at(fd, 0, buf, *len) < 0) {
+        free(buf);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+    return buf;
+}
+
+int
+lms_keyframe_index_find(const char *path, char *out, size_t out_len)
+{
+    size_t len;
+    int fd = _sidecar_open(path, out, out_len, &len);
+
+    /* only the header, a valid sidecar is found on every open of the media */
+    if (fd < 0)
+        return -1;
+    close(fd);
+    return 0;
+}
+
+static int
+_varint_get(const uint8_t **p, const uint8_t *end, int64_t *value)
+{
+    uint64_t v = 0;
+    unsigned int shift = 0;
+
+    while (*p < end && shift < 64) {
+        uint8_t c = *(*p)++;
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            *value = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+static size_t
+_varint_put(uint8_t *p, int64_t value)
+{
+    uint64_t v = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+int
+lms_keyframe_index_load(const char *path, struct lms_keyframe_index *index)
+{
+    char sidecar[PATH_MAX];
+    const uint8_t *p, *end;
+    uint64_t time = 0, offset = 0;
+    uint32_t count, i;
+    size_t len;
+    uint8_t *buf;
+
+    index->count = 0;
+    index->entries = NULL;
+
+    buf = _sidecar_read(path, sidecar, sizeof(sidecar), &len);
+    if (!buf)
+        return -1;
+
+    count = _le32(buf + 20);
+    /* every entry takes two bytes at least */
+    if (count == 0 || count > (len - KFI_HEADER_SIZE) / 2) {
+        free(buf);
+        return -1;
+    }
+
+    index->entries = malloc(count * sizeof(*index->entries));
+    if (!index->entries) {
+        free(buf);
+        return -1;
+    }
+
+    p = buf + KFI_HEADER_SIZE;
+    end = buf + len;
+    for (i = 0; i < count; i++) {
+        int64_t dtime, doffset;
+        if (_varint_get(&p, end, &dtime) < 0 || _varint_get(&p, end, &doffset) < 0) {
+            free(index->entries);
+            index->entries = NULL;
+            free(buf);
+            return -1;
+        }
+        time += (uint64_t)dtime;
+        offset += (uint64_t)doffset;
+        index->entries[i].time_ms = time;
+        index->entries[i].offset = offset;
+    }
+    index->count = count;
+    free(buf);
+    return 0;
+}
+
+static void
+_put_le(uint8_t *p, uint64_t v, int bytes)
+{
+    int i;
+    for (i = 0; i < bytes; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+int
+lms_keyframe_index_build(const char *path)
+{
+    struct lms_keyframe_index index;
+    char sidecar[PATH_MAX], tmp[PATH_MAX + 8];
+    struct stat st;
+    uint64_t time = 0, offset = 0;
+    uint8_t *buf;
+    size_t len;
+    uint32_t i;
+    int fd, r;
+
+    if (lms_keyframe_index_find(path, sidecar, sizeof(sidecar)) == 0)
+        return 0;
+    if (stat(path, &st) < 0)
+        return -1;
+    if (lms_keyframe_index_extract(path, &index) < 0)
+        return -1;
+
+    /* two varints of at most 10 bytes per entry */
+    buf = malloc(KFI_HEADER_SIZE + (size_t)index.count * 20);
+    if (!buf) {
+        lms_keyframe_index_free(&index);
+        return -1;
+    }
+    memcpy(buf, KFI_MAGIC, 4);
+    _put_le(buf + 4, (uint64_t)st.st_size, 8);
+    _put_le(buf + 12, (uint64_t)(int64_t)st.st_mtime, 8);
+    _put_le(buf + 20, index.count, 4);
+    len = KFI_HEADER_SIZE;
+    for (i = 0; i < index.count; i++) {
+        len += _varint_put(buf + len, (int64_t)(index.entries[i].time_ms - time));
+        len += _varint_put(buf + len, (int64_t)(index.entries[i].offset - offset));
+        time = index.entries[i].time_ms;
+        offset = index.entries[i].offset;
+    }
+    lms_keyframe_index_free(&index);
+
+    if (mkdir(KEYFRAME_INDEX_DIR, 0755) < 0 && errno != EEXIST) {
+        free(buf);
+        return -1;
+    }
+
+    /* written aside and renamed, a reader never sees a partial index */
+    snprintf(tmp, sizeof(tmp), "%s.%d", sidecar, (int)getpid());
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(buf);
+        return -1;
+    }
+    r = (write(fd, buf, len) == (ssize_t)len) ? 0 : -1;
+    if (close(fd) < 0)
+        r = -1;
+    free(buf);
+
+    if (r == 0 && rename(tmp, sidecar) < 0)
+        r = -1;
+    if (r < 0)
+        unlink(tmp);
+    return r;
+}
+
+void
+lms_keyframe_index_free(struct lms_keyframe_index *index)
+{
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+}
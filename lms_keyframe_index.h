@@ -0,0 +1,89 @@
+/**
+ * @file lms_keyframe_index.h
+ * Keyframe index of video files, extracted at scan time and kept in a sidecar cache.
+ *
+ * An index is a list of (presentation time, byte offset) of keyframes, read from the
+ * container's own tables: stss/stts/ctts/elst/stsc/stsz/stco of MP4, Cues of Matroska and the
+ * Simple Index Object of ASF. PlayerEngine gets the sidecar path on open, so seeks and
+ * trick play can land on keyframes without searching the media.
+ */
+
+#ifndef _LMS_KEYFRAME_INDEX_H_
+#define _LMS_KEYFRAME_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef KEYFRAME_INDEX_DIR
+#define KEYFRAME_INDEX_DIR "/rw_data/mm/keyframe" // sidecars, shared by scanner and media manager
+#endif
+
+/* headers bigger than this are not read, e.g. moov of very long recordings */
+#ifndef KEYFRAME_INDEX_MAX_HEADER
+#define KEYFRAME_INDEX_MAX_HEADER (32 * 1024 * 1024)
+#endif
+
+struct lms_keyframe {
+    uint64_t time_ms;
+    uint64_t offset;
+};
+
+struct lms_keyframe_index {
+    uint32_t count;
+    struct lms_keyframe *entries;
+};
+
+/**
+ * @fn lms_keyframe_index_supported
+ * @brief Checks the extension of path for a container with a keyframe table.
+ * @return int (1 - mp4, m4v, mov, mkv, webm, asf, wmv; 0 - others)
+ */
+int lms_keyframe_index_supported(const char *path, int path_len);
+
+/**
+ * @fn lms_keyframe_index_extract
+ * @brief Reads the keyframe table of the video track of path.
+ * @param[out] index : entries sorted by time, free with lms_keyframe_index_free()
+ * @return int (0 - SUCCESS, <0 - no table or unsupported container)
+ */
+int lms_keyframe_index_extract(const char *path, struct lms_keyframe_index *index);
+
+/**
+ * @fn lms_keyframe_index_build
+ * @brief Extracts the index of path and writes its sidecar, unless a valid one exists.
+ * @return int (0 - SUCCESS, <0 - FAIL)
+ */
+int lms_keyframe_index_build(const char *path);
+
+/**
+ * @fn lms_keyframe_index_sidecar
+ * @brief Gets the sidecar path of path, named by a hash of the media path.
+ * @return int (0 - SUCCESS, <0 - out is too small)
+ */
+int lms_keyframe_index_sidecar(const char *path, char *out, size_t out_len);
+
+/**
+ * @fn lms_keyframe_index_find
+ * @brief Gets the sidecar path of path if it exists and matches size and mtime of the media.
+ * @return int (0 - valid sidecar in out, <0 - none)
+ */
+int lms_keyframe_index_find(const char *path, char *out, size_t out_len);
+
+/**
+ * @fn lms_keyframe_index_load
+ * @brief Reads a valid sidecar of path.
+ * @return int (0 - SUCCESS, <0 - none or stale)
+ */
+int lms_keyframe_index_load(const char *path, struct lms_keyframe_index *index);
+
+void lms_keyframe_index_free(struct lms_keyframe_index *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LMS_KEYFRAME_INDEX_H_ */
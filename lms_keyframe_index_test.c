@@ -0,0 +1,251 @@
+/**
+ * @file lms_keyframe_index_test.c
+ * Test of the keyframe index.
+ *
+ * A small MP4 with B-frame composition offsets and an edit list is written to /tmp. The
+ * keyframe times are presentation times, and a sidecar whose body is broken is still
+ * found by its header but is not loaded.
+ *
+ * build : gcc -std=c99 -DKEYFRAME_INDEX_DIR='"/tmp/lms_keyframe_index_test.d"' -I. lms_keyframe_index_test.c lms_keyframe_index.c -o lms_keyframe_index_test
+ * usage : lms_keyframe_index_test
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* mkstemps, PATH_MAX under -std=c99 */
+#endif
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include "lms_keyframe_index.h"
+#include "test_check.h"
+
+struct writer {
+    uint8_t buf[4096];
+    size_t len;
+};
+
+static void
+_u32(struct writer *w, uint32_t v)
+{
+    w->buf[w->len++] = (uint8_t)(v >> 24);
+    w->buf[w->len++] = (uint8_t)(v >> 16);
+    w->buf[w->len++] = (uint8_t)(v >> 8);
+    w->buf[w->len++] = (uint8_t)v;
+}
+
+/* opens a box, returns the position of its size to close it */
+static size_t
+_open(struct writer *w, const char *type)
+{
+    size_t at = w->len;
+    _u32(w, 0);
+    memcpy(w->buf + w->len, type, 4);
+    w->len += 4;
+    return at;
+}
+
+static void
+_close(struct writer *w, size_t at)
+{
+    size_t len = w->len;
+    w->len = at;
+    _u32(w, (uint32_t)(len - at));
+    w->len = len;
+}
+
+/* full box header of version 0 and timescale, as in mvhd and mdhd */
+static void
+_header_box(struct writer *w, const char *type, uint32_t timescale)
+{
+    size_t box = _open(w, type);
+    _u32(w, 0);         /* version, flags */
+    _u32(w, 0);         /* creation */
+    _u32(w, 0);         /* modification */
+    _u32(w, timescale);
+    _u32(w, 0);         /* duration */
+    _u32(w, 0);
+    _close(w, box);
+}
+
+/*
+ * 6 samples of 100 ms in a track of timescale 1000, keyframes 1 and 4, composition
+ * offsets of 200 for the first 3 samples and 300 for the others
+ */
+static int
+_write_mp4(const char *path, uint32_t empty_edit)
+{
+    struct writer w;
+    size_t moov, trak, edts, elst, mdia, hdlr, minf, stbl, box;
+    FILE *fp;
+    int i;
+
+    w.len = 0;
+    box = _open(&w, "ftyp");
+    _u32(&w, 0x69736f6d); /* isom */
+    _close(&w, box);
+
+    moov = _open(&w, "moov");
+    _header_box(&w, "mvhd", 600);
+    trak = _open(&w, "trak");
+
+    edts = _open(&w, "edts");
+    elst = _open(&w, "elst");
+    _u32(&w, 0);
+    _u32(&w, empty_edit ? 2 : 1);
+    if (empty_edit) {
+        _u32(&w, empty_edit);   /* in movie timescale */
+        _u32(&w, 0xffffffff);   /* empty */
+        _u32(&w, 0x00010000);
+    }
+    _u32(&w, 600);
+    _u32(&w, 200);              /* media_time */
+    _u32(&w, 0x00010000);
+    _close(&w, elst);
+    _close(&w, edts);
+
+    mdia = _open(&w, "mdia");
+    _header_box(&w, "mdhd", 1000);
+    hdlr = _open(&w, "hdlr");
+    _u32(&w, 0);
+    _u32(&w, 0);
+    memcpy(w.buf + w.len, "vide", 4);
+    w.len += 4;
+    _close(&w, hdlr);
+
+    minf = _open(&w, "minf");
+    stbl = _open(&w, "stbl");
+
+    box = _open(&w, "stts");
+    _u32(&w, 0);
+    _u32(&w, 1);
+    _u32(&w, 6);
+    _u32(&w, 100);
+    _close(&w, box);
+
+    box = _open(&w, "ctts");
+    _u32(&w, 0);
+    _u32(&w, 2);
+    _u32(&w, 3);
+    _u32(&w, 200);
+    _u32(&w, 3);
+    _u32(&w, 300);
+    _close(&w, box);
+
+    box = _open(&w, "stss");
+    _u32(&w, 0);
+    _u32(&w, 2);
+    _u32(&w, 1);
+    _u32(&w, 4);
+    _close(&w, box);
+
+    box = _open(&w, "stsc");
+    _u32(&w, 0);
+    _u32(&w, 1);
+    _u32(&w, 1);
+    _u32(&w, 6);
+    _u32(&w, 1);
+    _close(&w, box);
+
+    box = _open(&w, "stsz");
+    _u32(&w, 0);
+    _u32(&w, 0);
+    _u32(&w, 6);
+    for (i = 0; i < 6; i++)
+        _u32(&w, 10);
+    _close(&w, box);
+
+    box = _open(&w, "stco");
+    _u32(&w, 0);
+    _u32(&w, 1);
+    _u32(&w, 1000);
+    _close(&w, box);
+
+    _close(&w, stbl);
+    _close(&w, minf);
+    _close(&w, mdia);
+    _close(&w, trak);
+    _close(&w, moov);
+
+    fp = fopen(path, "wb");
+    if (!fp)
+        return -1;
+    if (fwrite(w.buf, 1, w.len, fp) != w.len) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp);
+}
+
+static void
+test_presentation_time(const char *path)
+{
+    struct lms_keyframe_index index;
+
+    /* the edit skips the delay of the first frame, which shows at 0 */
+    CHECK(_write_mp4(path, 0) == 0);
+    CHECK(lms_keyframe_index_extract(path, &index) == 0);
+    CHECK(index.count == 2);
+    if (index.count == 2) {
+        CHECK(index.entries[0].time_ms == 0 && index.entries[0].offset == 1000);
+        CHECK(index.entries[1].time_ms == 400 && index.entries[1].offset == 1030);
+    }
+    lms_keyframe_index_free(&index);
+
+    /* an empty edit of 300 / 600 s delays the track by 500 ms */
+    CHECK(_write_mp4(path, 300) == 0);
+    CHECK(lms_keyframe_index_extract(path, &index) == 0);
+    CHECK(index.count == 2);
+    if (index.count == 2) {
+        CHECK(index.entries[0].time_ms == 500);
+        CHECK(index.entries[1].time_ms == 900);
+    }
+    lms_keyframe_index_free(&index);
+}
+
+static void
+test_sidecar(const char *path)
+{
+    struct lms_keyframe_index index;
+    char sidecar[PATH_MAX];
+
+    CHECK(_write_mp4(path, 0) == 0);
+    CHECK(lms_keyframe_index_find(path, sidecar, sizeof(sidecar)) < 0);
+    CHECK(lms_keyframe_index_build(path) == 0);
+    CHECK(lms_keyframe_index_find(path, sidecar, sizeof(sidecar)) == 0);
+
+    CHECK(lms_keyframe_index_load(path, &index) == 0);
+    CHECK(index.count == 2);
+    if (index.count == 2)
+        CHECK(index.entries[1].time_ms == 400 && index.entries[1].offset == 1030);
+    lms_keyframe_index_free(&index);
+
+    /* find checks the header only, load reads the body */
+    CHECK(truncate(sidecar, 4 + 8 + 8 + 4 + 1) == 0);
+    CHECK(lms_keyframe_index_find(path, sidecar, sizeof(sidecar)) == 0);
+    CHECK(lms_keyframe_index_load(path, &index) < 0);
+
+    unlink(sidecar);
+    rmdir(KEYFRAME_INDEX_DIR);
+}
+
+int
+main(void)
+{
+    char path[] = "/tmp/lms_keyframe_index_test.XXXXXX.mp4";
+    int fd = mkstemps(path, 4);
+
+    if (fd < 0)
+        return 1;
+    close(fd);
+
+    test_presentation_time(path);
+    test_sidecar(path);
+    unlink(path);
+
+    return TestResult("lms_keyframe_index_test");
+}
@@ -0,0 +1,129 @@
+#include "media_shard_lock.h"
+
+#include <chrono>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+namespace player {
+
+ProfiledMutex::ProfiledMutex(const std::string& name)
+  : mutex_(),
+    name_(name),
+    acquired_(0),
+    contended_(0),
+    wait_total_us_(0),
+    wait_max_us_(0) {}
+
+void ProfiledMutex::lock() {
+    if (mutex_.try_lock()) {
+        acquired_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    mutex_.lock();
+    uint64_t wait_us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    // counters are written by the owner only
+    acquired_.fetch_add(1, std::memory_order_relaxed);
+    contended_.fetch_add(1, std::memory_order_relaxed);
+    wait_total_us_.fetch_add(wait_us, std::memory_order_relaxed);
+    if (wait_us > wait_max_us_.load(std::memory_order_relaxed))
+        wait_max_us_.store(wait_us, std::memory_order_relaxed);
+}
+
+bool ProfiledMutex::try_lock() {
+    if (!mutex_.try_lock())
+        return false;
+    acquired_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+ProfiledMutex::Stats ProfiledMutex::GetStats() const {
+    Stats stats;
+    stats.acquired = acquired_.load(std::memory_order_relaxed);
+    stats.contended = contended_.load(std::memory_order_relaxed);
+    stats.wait_total_us = wait_total_us_.load(std::memory_order_relaxed);
+    stats.wait_max_us = wait_max_us_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ProfiledMutex::LogStats() const {
+    Stats stats = GetStats();
+    if (stats.acquired == 0)
+        return;
+
+    MMLogInfo("lock [%s] acquired=[%llu] contended=[%llu] wait total=[%llu]us avg=[%llu]us max=[%llu]us",
+              name_.c_str(), (unsigned long long)stats.acquired, (unsigned long long)stats.contended,
+              (unsigned long long)stats.wait_total_us,
+              (unsigned long long)(stats.contended ? stats.wait_total_us / stats.contended : 0),
+              (unsigned long long)stats.wait_max_us);
+}
+
+MediaShardLocks::MediaShardLocks(size_t shards)
+  : shards_() {
+    if (shards == 0)
+        shards = 1;
+    shards_.reserve(shards);
+    for (size_t i = 0; i < shards; i++)
+        shards_.emplace_back(new ProfiledMutex("media-shard-" + std::to_string(i)));
+}
+
+void MediaShardLocks::LogStats() const {
+    for (const auto& shard : shards_)
+        shard->LogStats();
+}
+
+MediaFlags::MediaFlags(MediaShardLocks& locks)
+  : locks_(locks),
+    shards_(locks.Size()) {}
+
+void MediaFlags::Set(uint32_t media_id, uint8_t flags, bool on) {
+    std::lock_guard<ProfiledMutex> shard_lock(locks_.For(media_id));
+    auto& shard = shards_[locks_.Index(media_id)];
+
+    if (on) {
+        shard[media_id] |= flags;
+        return;
+    }
+
+    auto it = shard.find(media_id);
+    if (it == shard.end())
+        return;
+    it->second &= ~flags;
+    if (it->second == 0)
+        shard.erase(it);
+}
+
+bool MediaFlags::Test(uint32_t media_id, uint8_t flag) {
+    std::lock_guard<ProfiledMutex> shard_lock(locks_.For(media_id));
+    auto& shard = shards_[locks_.Index(media_id)];
+
+    auto it = shard.find(media_id);
+    return (it != shard.end() && (it->second & flag));
+}
+
+bool MediaFlags::Take(uint32_t media_id, uint8_t flag) {
+    std::lock_guard<ProfiledMutex> shard_lock(locks_.For(media_id));
+    auto& shard = shards_[locks_.Index(media_id)];
+
+    auto it = shard.find(media_id);
+    if (it == shard.end() || !(it->second & flag))
+        return false;
+    it->second &= ~flag;
+    if (it->second == 0)
+        shard.erase(it);
+    return true;
+}
+
+void MediaFlags::Erase(uint32_t media_id) {
+    std::lock_guard<ProfiledMutex> shard_lock(locks_.For(media_id));
+    shards_[locks_.Index(media_id)].erase(media_id);
+}
+
+} // namespace player
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,153 @@
+/**
+* @file media_shard_lock.h
+* @version 1.0
+* Header for locks of PlayerProvider sharded by media id, with wait time profiling
+*/
+
+#ifndef MEDIA_SHARD_LOCK_H_
+#define MEDIA_SHARD_LOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lge {
+namespace mm {
+namespace player {
+
+#ifndef MEDIA_SHARD_COUNT
+#define MEDIA_SHARD_COUNT 8 // media id modulo count picks the shard
+#endif
+
+/**
+* @class lge::mm::player::ProfiledMutex
+* @brief std::mutex which counts acquisitions and measures the time waited for it.
+* @details An uncontended lock is one try_lock, the clock is read only when it has to wait.<BR>
+*          Satisfies Lockable, so std::lock_guard and std::unique_lock work with it.
+*/
+class ProfiledMutex {
+public:
+    struct Stats {
+        uint64_t acquired;
+        uint64_t contended;     // acquisitions which had to wait
+        uint64_t wait_total_us;
+        uint64_t wait_max_us;
+    };
+
+    explicit ProfiledMutex(const std::string& name = std::string());
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock() { mutex_.unlock(); }
+
+    void SetName(const std::string& name) { name_ = name; }
+    const std::string& Name() const { return name_; }
+
+    /**
+    * @fn GetStats
+    * @brief Gets the counters, they may be a little behind while the lock is in use.
+    * @return Stats
+    */
+    Stats GetStats() const;
+
+    /**
+    * @fn LogStats
+    * @brief Logs the counters if the lock was ever taken.
+    * @return : None
+    */
+    void LogStats() const;
+
+private:
+    std::mutex mutex_;
+    std::string name_;
+    std::atomic<uint64_t> acquired_;
+    std::atomic<uint64_t> contended_;
+    std::atomic<uint64_t> wait_total_us_;
+    std::atomic<uint64_t> wait_max_us_;
+};
+
+/**
+* @class lge::mm::player::MediaShardLocks
+* @brief Fixed set of ProfiledMutex, a media id always maps to the same one.
+* @details State of different PlayerEngines is guarded by different shards, so handling a
+*          signal of one engine does not wait for a command of another one. State shared by
+*          all engines keeps its own lock.
+*/
+class MediaShardLocks {
+public:
+    explicit MediaShardLocks(size_t shards = MEDIA_SHARD_COUNT);
+
+    MediaShardLocks(const MediaShardLocks&) = delete;
+    MediaShardLocks& operator=(const MediaShardLocks&) = delete;
+
+    /**
+    * @fn For
+    * @brief Gets the shard lock of media id.
+    * @param[in] media_id : media id
+    * @return ProfiledMutex&
+    */
+    ProfiledMutex& For(uint32_t media_id) { return *shards_[Index(media_id)]; }
+
+    size_t Index(uint32_t media_id) const { return media_id % shards_.size(); }
+    size_t Size() const { return shards_.size(); }
+
+    /**
+    * @fn LogStats
+    * @brief Logs wait time of every shard which was taken.
+    * @return : None
+    */
+    void LogStats() const;
+
+private:
+    std::vector<std::unique_ptr<ProfiledMutex>> shards_;
+};
+
+/**
+* @class lge::mm::player::MediaFlags
+* @brief Flags of each media id, guarded by the shard lock of the media.
+* @details Flags which used to be one member of PlayerProvider for all engines, so a pause
+*          request of one media is not consumed by EOS of another one. Each call takes the
+*          shard lock by itself, do not call while holding it.
+*/
+class MediaFlags {
+public:
+    enum Flag : uint8_t {
+        Playing   = 0x01,
+        NeedPause = 0x02,   // pause requested while EOS or error is handled (BAVN-6023,6776)
+    };
+
+    explicit MediaFlags(MediaShardLocks& locks);
+
+    MediaFlags(const MediaFlags&) = delete;
+    MediaFlags& operator=(const MediaFlags&) = delete;
+
+    void Set(uint32_t media_id, uint8_t flags, bool on);
+    bool Test(uint32_t media_id, uint8_t flag);
+
+    /**
+    * @fn Take
+    * @brief Clears flag of media id and tells whether it was set.
+    * @return bool (true - flag was set)
+    */
+    bool Take(uint32_t media_id, uint8_t flag);
+
+    void Erase(uint32_t media_id);
+
+private:
+    MediaShardLocks& locks_;
+    std::vector<std::unordered_map<uint32_t, uint8_t>> shards_;
+};
+
+} // namespace player
+} // namespace mm
+} // namespace lge
+
+#endif  // MEDIA_SHARD_LOCK_H_
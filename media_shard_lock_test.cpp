@@ -0,0 +1,104 @@
+/**
+* @file media_shard_lock_test.cpp
+* @version 1.0
+* Test of MediaShardLocks and MediaFlags.
+*
+* Flags of media ids in the same and in different shards are kept apart, Take() clears
+* only what it returns, and a pause request set by a client thread while the command
+* thread consumes it is taken exactly once.
+*
+* build : g++ -std=c++11 -pthread -I. media_shard_lock_test.cpp media_shard_lock.cpp -o media_shard_lock_test
+* usage : media_shard_lock_test
+*/
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+#include "media_shard_lock.h"
+#include "test_check.h"
+
+using lge::mm::player::MediaFlags;
+using lge::mm::player::MediaShardLocks;
+
+static void TestPerMedia() {
+    MediaShardLocks locks(4);
+    MediaFlags flags(locks);
+
+    // 1 and 5 share a shard, 2 does not
+    CHECK(&locks.For(1) == &locks.For(5));
+    CHECK(&locks.For(1) != &locks.For(2));
+
+    flags.Set(1, MediaFlags::NeedPause, true);
+    CHECK(flags.Test(1, MediaFlags::NeedPause));
+    CHECK(!flags.Test(5, MediaFlags::NeedPause));
+    CHECK(!flags.Test(2, MediaFlags::NeedPause));
+
+    // EOS of another media does not consume the pause request
+    CHECK(!flags.Take(5, MediaFlags::NeedPause));
+    CHECK(!flags.Take(2, MediaFlags::NeedPause));
+    CHECK(flags.Test(1, MediaFlags::NeedPause));
+}
+
+static void TestTake() {
+    MediaShardLocks locks(4);
+    MediaFlags flags(locks);
+
+    flags.Set(3, MediaFlags::Playing | MediaFlags::NeedPause, true);
+    CHECK(flags.Take(3, MediaFlags::NeedPause));
+    CHECK(!flags.Take(3, MediaFlags::NeedPause));
+    CHECK(flags.Test(3, MediaFlags::Playing));
+
+    flags.Set(3, MediaFlags::Playing, false);
+    CHECK(!flags.Test(3, MediaFlags::Playing));
+
+    flags.Set(3, MediaFlags::Playing, true);
+    flags.Erase(3);
+    CHECK(!flags.Test(3, MediaFlags::Playing));
+
+    // clearing a media which has no flag is harmless
+    flags.Set(7, MediaFlags::NeedPause, false);
+    CHECK(!flags.Test(7, MediaFlags::NeedPause));
+}
+
+static void TestConcurrentPause() {
+    const int requests = 10000;
+    MediaShardLocks locks(4);
+    MediaFlags flags(locks);
+    std::atomic<int> set(0);
+    std::atomic<bool> done(false);
+    int taken = 0;
+
+    // client thread requests pause only after the previous request was consumed
+    std::thread client([&]() {
+        for (int i = 0; i < requests; i++) {
+            while (flags.Test(1, MediaFlags::NeedPause))
+                std::this_thread::yield();
+            flags.Set(1, MediaFlags::NeedPause, true);
+            set++;
+            // another media of the same shard is busy at the same time
+            flags.Set(5, MediaFlags::Playing, (i & 1) != 0);
+        }
+        done = true;
+    });
+
+    while (!done || flags.Test(1, MediaFlags::NeedPause)) {
+        if (flags.Take(1, MediaFlags::NeedPause))
+            taken++;
+        else
+            std::this_thread::yield();
+    }
+    client.join();
+
+    CHECK(set == requests);
+    CHECK(taken == requests);
+    CHECK(!flags.Test(1, MediaFlags::Playing));
+}
+
+int main() {
+    TestPerMedia();
+    TestTake();
+    TestConcurrentPause();
+
+    return TestResult("media_shard_lock_test");
+}
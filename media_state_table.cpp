@@ -0,0 +1,275 @@
+#include "media_state_table.h"
+
+#include <math.h>
+
+#include "player_logger.h"
+
+namespace MM = ::v1::org::genivi::mediamanager;
+
+namespace lge {
+namespace mm {
+namespace player {
+
+const uint32_t MediaStateTable::kNoMedia;
+
+MediaStateTable::MediaStateTable()
+  : states_(),
+    free_slots_(),
+    slots_(),
+    media_ids_() {}
+
+MediaStateTable::State* MediaStateTable::Find(uint32_t media_id, uint8_t field) {
+    auto it = slots_.find(media_id);
+    if (it == slots_.end())
+        return nullptr;
+
+    State* state = &states_[it->second];
+    if (field != 0 && (state->fields & field) == 0)
+        return nullptr;
+    return state;
+}
+
+MediaStateTable::State& MediaStateTable::Get(uint32_t media_id) {
+    auto it = slots_.find(media_id);
+    if (it != slots_.end())
+        return states_[it->second];
+
+    State state;
+    state.media_id = media_id;
+    state.fields = 0;
+    state.active = 0;
+    state.position_us = 0;
+    state.position_time_us = 0;
+    state.rate = 1.0;
+    state.playing = false;
+    state.published_us = 0;
+    state.jitter_count = 0;
+    state.jitter_max_us = 0;
+    state.jitter_abs_sum_us = 0;
+    state.jitter_square_sum = 0;
+    state.duration_us = 0;
+    state.eos_time_us = 0;
+    state.gap_start_us = 0;
+    state.resumable = false;
+    state.resume_us = 0;
+    state.buffering = 100;
+    state.status = MM::PlayerTypes::PlaybackStatus::UNINIT;
+    state.media_type = MM::PlayerTypes::MediaType::AUDIO;
+
+    // push_back of a deque keeps the other slots in place
+    size_t slot = states_.size();
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        states_[slot] = state;
+    } else {
+        states_.push_back(state);
+    }
+    slots_[media_id] = slot;
+    return states_[slot];
+}
+
+bool MediaStateTable::Clear(uint32_t media_id, uint8_t fields) {
+    auto it = slots_.find(media_id);
+    if (it == slots_.end())
+        return false;
+
+    size_t slot = it->second;
+    State& state = states_[slot];
+    if ((state.fields & fields) == 0)
+        return false;
+
+    state.fields &= ~fields;
+    state.active &= ~fields;
+    if (state.fields == 0) {
+        // no other state moves, the slot is reused by the next media id
+        state.media_id = kNoMedia;
+        state.active = 0;
+        state.playing = false;
+        free_slots_.push_back(slot);
+        slots_.erase(it);
+    }
+    return true;
+}
+
+void MediaStateTable::Activate(Field field, uint32_t media_id) {
+    for (auto& state : states_) {
+        if (state.media_id == media_id)
+            state.active |= field;
+        else
+            state.active &= ~field;
+    }
+}
+
+uint64_t MediaStateTable::PositionAt(const State& state, int64_t now_us) {
+    if (!state.playing || now_us <= state.position_time_us)
+        return state.position_us;
+
+    double pos_us = (double)state.position_us + (double)(now_us - state.position_time_us) * state.rate;
+    if (pos_us < 0)
+        return 0;
+    if ((state.fields & Duration) && state.duration_us > 0 && pos_us > (double)state.duration_us)
+        return state.duration_us;
+    return (uint64_t)pos_us;
+}
+
+void MediaStateTable::Anchor(State& state, uint64_t pos_us, int64_t now_us) {
+    state.position_us = pos_us;
+    state.position_time_us = now_us;
+}
+
+void MediaStateTable::Observe(State& state, uint64_t pos_us, int64_t now_us) {
+    if (state.playing && state.position_time_us > 0) {
+        int64_t error_us = (int64_t)pos_us - (int64_t)PositionAt(state, now_us);
+        int64_t abs_us = (error_us < 0) ? -error_us : error_us;
+
+        state.jitter_count++;
+        state.jitter_abs_sum_us += abs_us;
+        state.jitter_square_sum += (double)error_us * error_us;
+        if (abs_us > state.jitter_max_us)
+            state.jitter_max_us = abs_us;
+    }
+    Anchor(state, pos_us, now_us);
+}
+
+void MediaStateTable::SetMotion(State& state, double rate, bool playing, int64_t now_us) {
+    Anchor(state, PositionAt(state, now_us), now_us);
+    state.rate = rate;
+    state.playing = playing;
+}
+
+void MediaStateTable::EndOfStream(State& state, int64_t now_us) {
+    state.eos_time_us = now_us;
+    state.gap_start_us = 0;
+}
+
+void MediaStateTable::Reopened(State& state) {
+    state.gap_start_us = state.eos_time_us;
+    state.eos_time_us = 0;
+}
+
+bool MediaStateTable::TrackGap(State& state, MM::PlayerTypes::PlaybackStatus status, int64_t now_us, int64_t& gap_us) {
+    // an open goes through other statuses before it plays
+    if (status != MM::PlayerTypes::PlaybackStatus::PLAYING && status != MM::PlayerTypes::PlaybackStatus::STOPPED)
+        return false;
+
+    int64_t start_us = state.gap_start_us;
+    state.eos_time_us = 0;
+    state.gap_start_us = 0;
+    if (start_us <= 0 || status != MM::PlayerTypes::PlaybackStatus::PLAYING || now_us < start_us)
+        return false;
+    gap_us = now_us - start_us;
+    return true;
+}
+
+void MediaStateTable::LogJitter(const State& state) {
+    if (state.jitter_count == 0)
+        return;
+
+    MMLogInfo("media[%u] position model vs engine: n=[%u], mean=[%llu]us, rms=[%.0f]us, max=[%lld]us",
+              state.media_id, state.jitter_count,
+              (unsigned long long)(state.jitter_abs_sum_us / state.jitter_count),
+              sqrt(state.jitter_square_sum / state.jitter_count), (long long)state.jitter_max_us);
+}
+
+bool MediaStateTable::AnyPlaying() const {
+    for (auto& state : states_) {
+        if (state.playing && (state.fields & Position))
+            return true;
+    }
+    return false;
+}
+
+void MediaStateTable::PositionsPublished(int64_t now_us) {
+    for (auto& state : states_) {
+        if (state.fields & Position)
+            state.published_us = PositionAt(state, now_us);
+    }
+}
+
+int64_t MediaStateTable::UntilPositionDrift(int64_t now_us, uint64_t drift_us) const {
+    int64_t until_us = -1;
+    for (auto& state : states_) {
+        if (!(state.fields & Position))
+            continue;
+
+        uint64_t pos_us = PositionAt(state, now_us);
+        uint64_t moved_us = (pos_us > state.published_us) ? pos_us - state.published_us : state.published_us - pos_us;
+        // a report, seek or limit moved it already
+        if (moved_us >= drift_us)
+            return 0;
+
+        bool at_end = (state.fields & Duration) && state.duration_us > 0 && pos_us >= state.duration_us;
+        if (!state.playing || state.rate == 0 || at_end)
+            continue;
+
+        int64_t wait_us = (int64_t)ceil((double)(drift_us - moved_us) / fabs(state.rate));
+        if (until_us < 0 || wait_us < until_us)
+            until_us = wait_us;
+    }
+    return until_us;
+}
+
+void MediaStateTable::SetConnections(const std::map<int, std::string>& connection_map) {
+    media_ids_.clear();
+    for (auto& it : connection_map)
+        media_ids_[it.second] = (uint32_t)it.first;
+}
+
+void MediaStateTable::AddConnection(uint32_t media_id, const std::string& connection_name) {
+    media_ids_[connection_name] = media_id;
+}
+
+uint32_t MediaStateTable::MediaID(const std::string& connection_name) const {
+    auto it = media_ids_.find(connection_name);
+    return (it != media_ids_.end()) ? it->second : kNoMedia;
+}
+
+std::vector<MM::PlayerTypes::Position> MediaStateTable::Positions(int64_t now_us) const {
+    std::vector<MM::PlayerTypes::Position> list;
+    for (auto& state : states_) {
+        if (state.fields & Position)
+            list.emplace_back(PositionAt(state, now_us), state.media_id, (state.active & Position) != 0);
+    }
+    return list;
+}
+
+std::vector<MM::PlayerTypes::Duration> MediaStateTable::Durations() const {
+    std::vector<MM::PlayerTypes::Duration> list;
+    for (auto& state : states_) {
+        if (state.fields & Duration)
+            list.emplace_back(state.duration_us, state.media_id, (state.active & Duration) != 0);
+    }
+    return list;
+}
+
+std::vector<MM::PlayerTypes::Buffering> MediaStateTable::Bufferings() const {
+    std::vector<MM::PlayerTypes::Buffering> list;
+    for (auto& state : states_) {
+        if (state.fields & Buffering)
+            list.emplace_back(state.buffering, state.media_id, (state.active & Buffering) != 0);
+    }
+    return list;
+}
+
+std::vector<MM::PlayerTypes::Playback> MediaStateTable::Playbacks() const {
+    std::vector<MM::PlayerTypes::Playback> list;
+    for (auto& state : states_) {
+        if (state.fields & Playback)
+            list.emplace_back(state.status, state.media_id, (state.active & Playback) != 0);
+    }
+    return list;
+}
+
+std::vector<MM::PlayerTypes::Track> MediaStateTable::Tracks() const {
+    std::vector<MM::PlayerTypes::Track> list;
+    for (auto& state : states_) {
+        if (state.fields & CurrentTrack)
+            list.push_back(state.track);
+    }
+    return list;
+}
+
+} // namespace player
+} // namespace mm
+} // namespace lge
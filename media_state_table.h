@@ -0,0 +1,248 @@
+/**
+* @file media_state_table.h
+* @version 1.0
+* Header for playback state of every PlayerEngine kept by PlayerProvider
+*/
+
+#ifndef MEDIA_STATE_TABLE_H_
+#define MEDIA_STATE_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "v1/org/genivi/mediamanager/PlayerTypes.hpp"
+
+namespace lge {
+namespace mm {
+namespace player {
+
+/**
+* @class lge::mm::player::MediaStateTable
+* @brief Position, duration, buffering, playback status and current track per media id.
+* @details States are kept in slots found by media id in O(1), and connection names
+*          of PlayerEngines are indexed to media id the same way.<BR>
+*          A slot never moves: a State& or State* stays valid over Get() of other media ids and<BR>
+*          over Clear() of them, until the last field of its own media id is cleared. A freed<BR>
+*          slot is taken by the next media id, the others keep their order in the attributes.<BR>
+*          The Position, Duration, Buffering, Playback and CurrentTrack attributes of the stub
+*          are built from this table, so they are never read back from the stub.<BR>
+*          Position is a model anchored by CurrentTime, seek, rate and status changes, and is
+*          extrapolated in between, so PlayerEngine may report time rarely.<BR>
+*          Not thread safe, used in command handling thread only.
+*/
+class MediaStateTable {
+public:
+    enum Field : uint8_t {
+        Position     = 0x01,
+        Duration     = 0x02,
+        Buffering    = 0x04,
+        Playback     = 0x08,
+        CurrentTrack = 0x10,
+        AllFields    = 0x1f,
+    };
+
+    static const uint32_t kNoMedia = (uint32_t)-1;
+
+    struct State {
+        uint32_t media_id;
+        uint8_t fields;   // fields which have a value
+        uint8_t active;   // fields published as active
+        // position model, position_us at position_time_us advances by rate while playing
+        uint64_t position_us;
+        int64_t position_time_us;   // monotonic
+        double rate;
+        bool playing;
+        uint64_t published_us;      // position in the last published attribute
+        // error of the model against CurrentTime reported by PlayerEngine
+        uint32_t jitter_count;
+        int64_t jitter_max_us;
+        uint64_t jitter_abs_sum_us;
+        double jitter_square_sum;
+        uint64_t duration_us;
+        int64_t eos_time_us;        // monotonic time of EndOfStream until the next open
+        int64_t gap_start_us;       // EndOfStream time carried by the next open until it plays
+        bool resumable;             // position of the track is kept in ResumeStore
+        uint64_t resume_us;         // position to set when the duration is known, 0 for none
+        int32_t buffering;
+        ::v1::org::genivi::mediamanager::PlayerTypes::PlaybackStatus status;
+        ::v1::org::genivi::mediamanager::PlayerTypes::Track track;
+        ::v1::org::genivi::mediamanager::PlayerTypes::MediaType media_type;   // of the opened track
+    };
+
+    MediaStateTable();
+
+    /**
+    * @fn Find
+    * @brief Gets the state of media id.
+    * @param[in] media_id : media id
+    * @param[in] field : field which should have a value, 0 for any state
+    * @return State* (nullptr - no state or field has no value)
+    */
+    State* Find(uint32_t media_id, uint8_t field = 0);
+
+    /**
+    * @fn Get
+    * @brief Gets the state of media id, adds an empty one if it does not exist.
+    * @param[in] media_id : media id
+    * @return State&
+    */
+    State& Get(uint32_t media_id);
+
+    /**
+    * @fn Clear
+    * @brief Drops fields of media id. The slot is freed when no field is left, a State of
+    *        this media id must be found again after that.
+    * @param[in] media_id : media id
+    * @param[in] fields : Field bits to drop
+    * @return bool (true - some field was dropped)
+    */
+    bool Clear(uint32_t media_id, uint8_t fields);
+
+    /**
+    * @fn Activate
+    * @brief Marks field of media id as active, and the same field of others as inactive.
+    * @param[in] field : Field
+    * @param[in] media_id : media id, kNoMedia marks all inactive
+    * @return : None
+    */
+    void Activate(Field field, uint32_t media_id);
+
+    /**
+    * @fn PositionAt
+    * @brief Extrapolates position of state to now, limited to the duration.
+    * @param[in] state : state having Position
+    * @param[in] now_us : monotonic time
+    * @return uint64_t : position in us
+    */
+    static uint64_t PositionAt(const State& state, int64_t now_us);
+
+    /**
+    * @fn Anchor
+    * @brief Re-anchors the position model, e.g. on seek.
+    * @param[in] state : state
+    * @param[in] pos_us : position at now_us
+    * @param[in] now_us : monotonic time
+    * @return : None
+    */
+    static void Anchor(State& state, uint64_t pos_us, int64_t now_us);
+
+    /**
+    * @fn Observe
+    * @brief Records error of the model against position reported by PlayerEngine and re-anchors.
+    * @param[in] state : state
+    * @param[in] pos_us : reported position
+    * @param[in] now_us : monotonic time
+    * @return : None
+    */
+    static void Observe(State& state, uint64_t pos_us, int64_t now_us);
+
+    /**
+    * @fn SetMotion
+    * @brief Changes rate or playing of the model from the current extrapolated position.
+    * @param[in] state : state
+    * @param[in] rate : playback rate, 1.0 for normal play
+    * @param[in] playing : false freezes position
+    * @param[in] now_us : monotonic time
+    * @return : None
+    */
+    static void SetMotion(State& state, double rate, bool playing, int64_t now_us);
+
+    /**
+    * @fn EndOfStream
+    * @brief Starts a track transition gap at EndOfStream of the playing track.
+    * @param[in] state : state
+    * @param[in] now_us : monotonic time
+    * @return : None
+    */
+    static void EndOfStream(State& state, int64_t now_us);
+
+    /**
+    * @fn Reopened
+    * @brief Hands the gap over to the track opened after EndOfStream, or clears a stale one.
+    * @param[in] state : state
+    * @return : None
+    */
+    static void Reopened(State& state);
+
+    /**
+    * @fn TrackGap
+    * @brief Ends the gap at PLAYING of the track opened after EndOfStream.
+    * @details PLAYING without an open in between (repeat) and STOPPED end the gap without<BR>
+    *          a value, other statuses keep it.
+    * @param[in] state : state
+    * @param[in] status : new playback status
+    * @param[in] now_us : monotonic time
+    * @param[out] gap_us : time from EndOfStream to PLAYING
+    * @return bool (true - gap_us is a transition gap)
+    */
+    static bool TrackGap(State& state, ::v1::org::genivi::mediamanager::PlayerTypes::PlaybackStatus status,
+                         int64_t now_us, int64_t& gap_us);
+
+    /**
+    * @fn LogJitter
+    * @brief Logs error statistics of the position model, e.g. before the state is cleared.
+    * @param[in] state : state
+    * @return : None
+    */
+    static void LogJitter(const State& state);
+
+    bool AnyPlaying() const;
+
+    /**
+    * @fn PositionsPublished
+    * @brief Records positions extrapolated to now_us as the ones in the published attribute.
+    * @param[in] now_us : monotonic time of the publication
+    * @return : None
+    */
+    void PositionsPublished(int64_t now_us);
+
+    /**
+    * @fn UntilPositionDrift
+    * @brief Gets the time until an extrapolated position moves drift_us away from the published one.
+    * @param[in] now_us : monotonic time
+    * @param[in] drift_us : distance which is worth publishing
+    * @return int64_t : time in us, 0 when drifted already, -1 when no position moves
+    */
+    int64_t UntilPositionDrift(int64_t now_us, uint64_t drift_us) const;
+
+    /**
+    * @fn SetConnections
+    * @brief Rebuilds connection name index from the map of PlayerEngineManager.
+    * @param[in] connection_map : media id to connection name
+    * @return : None
+    */
+    void SetConnections(const std::map<int, std::string>& connection_map);
+
+    void AddConnection(uint32_t media_id, const std::string& connection_name);
+
+    /**
+    * @fn MediaID
+    * @brief Gets media id of connection name in O(1).
+    * @param[in] connection_name : connection name
+    * @return uint32_t (kNoMedia - not mapped)
+    */
+    uint32_t MediaID(const std::string& connection_name) const;
+
+    std::vector<::v1::org::genivi::mediamanager::PlayerTypes::Position> Positions(int64_t now_us) const;
+    std::vector<::v1::org::genivi::mediamanager::PlayerTypes::Duration> Durations() const;
+    std::vector<::v1::org::genivi::mediamanager::PlayerTypes::Buffering> Bufferings() const;
+    std::vector<::v1::org::genivi::mediamanager::PlayerTypes::Playback> Playbacks() const;
+    std::vector<::v1::org::genivi::mediamanager::PlayerTypes::Track> Tracks() const;
+
+private:
+    std::deque<State> states_;          // free slots have kNoMedia as media id
+    std::vector<size_t> free_slots_;
+    std::unordered_map<uint32_t, size_t> slots_;
+    std::unordered_map<std::string, uint32_t> media_ids_;
+};
+
+} // namespace player
+} // namespace mm
+} // namespace lge
+
+#endif  // MEDIA_STATE_TABLE_H_
@@ -0,0 +1,215 @@
+/**
+* @file media_state_table_test.cpp
+* @version 1.0
+* Test of the position model and the track transition gap of MediaStateTable.
+*
+* Position is extrapolated by rate while playing, limited to the duration and frozen while
+* paused or buffering. The error against reported positions is recorded only while the
+* model was moving. A gap is measured from EndOfStream to PLAYING of the track opened
+* next, and neither a repeat nor a later PLAYING records a bogus one. An extrapolated
+* position is due again only when it moved the drift away from the published one. A state
+* stays at its address until its own media id is cleared.
+*
+* build : g++ -std=c++11 -I. media_state_table_test.cpp media_state_table.cpp -o media_state_table_test
+* usage : media_state_table_test
+*/
+
+#include <stdio.h>
+
+#include "media_state_table.h"
+#include "test_check.h"
+
+using lge::mm::player::MediaStateTable;
+
+static MediaStateTable::State& Opened(MediaStateTable& table, uint32_t media_id) {
+    MediaStateTable::State& state = table.Get(media_id);
+    state.fields |= MediaStateTable::Position | MediaStateTable::Duration | MediaStateTable::Buffering;
+    return state;
+}
+
+static void TestPositionAt() {
+    MediaStateTable table;
+    MediaStateTable::State& state = Opened(table, 1);
+
+    // paused, frozen
+    MediaStateTable::Anchor(state, 5000000, 1000000);
+    CHECK(MediaStateTable::PositionAt(state, 9000000) == 5000000);
+
+    MediaStateTable::SetMotion(state, 1.0, true, 1000000);
+    CHECK(MediaStateTable::PositionAt(state, 1000000) == 5000000);
+    CHECK(MediaStateTable::PositionAt(state, 3000000) == 7000000);
+    // before the anchor
+    CHECK(MediaStateTable::PositionAt(state, 500000) == 5000000);
+
+    // fast forward from the extrapolated position
+    MediaStateTable::SetMotion(state, 2.0, true, 3000000);
+    CHECK(state.position_us == 7000000);
+    CHECK(MediaStateTable::PositionAt(state, 4000000) == 9000000);
+
+    // limited to the duration
+    state.duration_us = 10000000;
+    CHECK(MediaStateTable::PositionAt(state, 9000000) == 10000000);
+
+    // rewind stops at 0
+    MediaStateTable::SetMotion(state, -4.0, true, 4000000);
+    CHECK(MediaStateTable::PositionAt(state, 5000000) == 5000000);
+    CHECK(MediaStateTable::PositionAt(state, 9000000) == 0);
+}
+
+static void TestBufferingFreezes() {
+    MediaStateTable table;
+    MediaStateTable::State& state = Opened(table, 2);
+
+    MediaStateTable::Anchor(state, 0, 1000000);
+    MediaStateTable::SetMotion(state, 1.0, true, 1000000);
+
+    // buffering below 100% stops the model at 1 s until it recovers at 4 s
+    MediaStateTable::SetMotion(state, state.rate, false, 2000000);
+    CHECK(MediaStateTable::PositionAt(state, 4000000) == 1000000);
+    MediaStateTable::SetMotion(state, state.rate, true, 4000000);
+    CHECK(MediaStateTable::PositionAt(state, 5000000) == 2000000);
+}
+
+static void TestJitter() {
+    MediaStateTable table;
+    MediaStateTable::State& state = Opened(table, 3);
+
+    // the first report only anchors the model
+    MediaStateTable::SetMotion(state, 1.0, true, 0);
+    MediaStateTable::Observe(state, 1000000, 1000000);
+    CHECK(state.jitter_count == 0);
+
+    // model says 2 s, engine says 2.1 s, then model 3.1 s, engine 3.0 s
+    MediaStateTable::Observe(state, 2100000, 2000000);
+    MediaStateTable::Observe(state, 3000000, 3000000);
+    CHECK(state.jitter_count == 2);
+    CHECK(state.jitter_abs_sum_us == 200000);
+    CHECK(state.jitter_max_us == 100000);
+    CHECK(state.jitter_square_sum == 2.0 * 100000.0 * 100000.0);
+    CHECK(state.position_us == 3000000 && state.position_time_us == 3000000);
+
+    // a report while paused re-anchors without error
+    MediaStateTable::SetMotion(state, 1.0, false, 3000000);
+    MediaStateTable::Observe(state, 3500000, 8000000);
+    CHECK(state.jitter_count == 2);
+    CHECK(MediaStateTable::PositionAt(state, 9000000) == 3500000);
+
+    MediaStateTable::LogJitter(state);
+}
+
+static void TestPositions() {
+    MediaStateTable table;
+    MediaStateTable::State& first = Opened(table, 4);
+    MediaStateTable::Anchor(first, 1000000, 0);
+    MediaStateTable::SetMotion(first, 1.0, true, 0);
+    table.Activate(MediaStateTable::Position, 4);
+    CHECK(table.AnyPlaying());
+
+    auto positions = table.Positions(2000000);
+    CHECK(positions.size() == 1);
+    CHECK(MediaStateTable::PositionAt(first, 2000000) == 3000000);
+
+    CHECK(table.Clear(4, MediaStateTable::AllFields));
+    CHECK(!table.AnyPlaying());
+    CHECK(table.Positions(2000000).empty());
+}
+
+static void TestStableSlots() {
+    MediaStateTable table;
+    Opened(table, 1);
+    MediaStateTable::State* second = &Opened(table, 2);
+    MediaStateTable::State* third = &Opened(table, 3);
+
+    // neither a new media id nor a cleared one moves the others
+    CHECK(table.Clear(1, MediaStateTable::AllFields));
+    CHECK(table.Find(2) == second && table.Find(3) == third);
+    CHECK(third->media_id == 3);
+    for (uint32_t media_id = 10; media_id < 100; media_id++)
+        Opened(table, media_id);
+    CHECK(table.Find(2) == second && table.Find(3) == third);
+    CHECK(table.Positions(0).size() == 92);
+
+    // a freed slot is taken again, not grown
+    CHECK(table.Clear(2, MediaStateTable::AllFields));
+    CHECK(table.Find(2) == nullptr);
+    CHECK(&table.Get(5) == second);
+    CHECK(table.Find(5) == second && second->media_id == 5 && second->fields == 0);
+}
+
+static void TestPositionDrift() {
+    MediaStateTable table;
+    CHECK(table.UntilPositionDrift(0, 1000000) == -1);
+
+    MediaStateTable::State& state = Opened(table, 5);
+    state.duration_us = 10000000;
+    MediaStateTable::Anchor(state, 1000000, 0);
+    table.PositionsPublished(0);
+    // paused, nothing moves
+    CHECK(table.UntilPositionDrift(5000000, 1000000) == -1);
+
+    MediaStateTable::SetMotion(state, 2.0, true, 0);
+    CHECK(table.UntilPositionDrift(0, 1000000) == 500000);
+    CHECK(table.UntilPositionDrift(200000, 1000000) == 300000);
+    CHECK(table.UntilPositionDrift(500000, 1000000) == 0);
+
+    table.PositionsPublished(500000);
+    CHECK(state.published_us == 2000000);
+    CHECK(table.UntilPositionDrift(500000, 1000000) == 500000);
+
+    // a seek is due at once, whatever the rate
+    MediaStateTable::Anchor(state, 6000000, 600000);
+    CHECK(table.UntilPositionDrift(600000, 1000000) == 0);
+
+    // held at the duration
+    MediaStateTable::Anchor(state, 10000000, 700000);
+    table.PositionsPublished(700000);
+    CHECK(table.UntilPositionDrift(900000, 1000000) == -1);
+}
+
+static void TestTrackGap() {
+    typedef ::v1::org::genivi::mediamanager::PlayerTypes::PlaybackStatus Status;
+    MediaStateTable table;
+    MediaStateTable::State& state = Opened(table, 5);
+    int64_t gap_us = 0;
+
+    // EndOfStream at 10 s, the next track is opened, prerolls and plays at 10.3 s
+    MediaStateTable::EndOfStream(state, 10000000);
+    CHECK(!MediaStateTable::TrackGap(state, Status::PAUSED, 10100000, gap_us));
+    MediaStateTable::Reopened(state);
+    CHECK(!MediaStateTable::TrackGap(state, Status::PAUSED, 10200000, gap_us));
+    CHECK(MediaStateTable::TrackGap(state, Status::PLAYING, 10300000, gap_us));
+    CHECK(gap_us == 300000);
+
+    // counted once, a later PLAYING after pause is not a transition
+    CHECK(!MediaStateTable::TrackGap(state, Status::PAUSED, 20000000, gap_us));
+    CHECK(!MediaStateTable::TrackGap(state, Status::PLAYING, 30000000, gap_us));
+
+    // repeat, the engine plays again without an open
+    MediaStateTable::EndOfStream(state, 40000000);
+    CHECK(!MediaStateTable::TrackGap(state, Status::PLAYING, 40050000, gap_us));
+    MediaStateTable::Reopened(state);
+    CHECK(!MediaStateTable::TrackGap(state, Status::PLAYING, 90000000, gap_us));
+
+    // an open which is not after EndOfStream
+    MediaStateTable::Reopened(state);
+    CHECK(!MediaStateTable::TrackGap(state, Status::PLAYING, 91000000, gap_us));
+
+    // stopped between EndOfStream and the next open
+    MediaStateTable::EndOfStream(state, 100000000);
+    CHECK(!MediaStateTable::TrackGap(state, Status::STOPPED, 100100000, gap_us));
+    MediaStateTable::Reopened(state);
+    CHECK(!MediaStateTable::TrackGap(state, Status::PLAYING, 200000000, gap_us));
+    CHECK(gap_us == 300000);
+}
+
+int main() {
+    TestPositionAt();
+    TestBufferingFreezes();
+    TestJitter();
+    TestPositions();
+    TestStableSlots();
+    TestPositionDrift();
+    TestTrackGap();
+
+    return TestResult("media_state_table_test");
+}
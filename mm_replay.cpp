@@ -0,0 +1,499 @@
+/**
+* @file mm_replay.cpp
+* @version 1.0
+* Replays a command stream recorded with MM_RECORD_FILE into a headless PlayerProvider.
+*
+* A private session bus is started with GTestDBus, and every PlayerEngine connection found
+* in the record gets a fake engine on it. A fake engine answers each com.lge.PlayerEngine
+* method with default out values, and emits the StateChange signals that were recorded while
+* the command was running, at the same offset from the start of the command.
+* Commands are posted at their recorded time, scaled by speed (0 posts them back to back).
+* Latency from Post to Done and from Post to Start is reported per command type.
+*
+* build : -DMM_REPLAY for this file and playerprovider.cpp, link with media manager objects
+*         except main.cpp and playerstub.cpp, plus gio-2.0, boost_coroutine and the generated
+*         dbus_player_interface.c
+* usage : mm_replay <record file> [speed=1.0]
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gio/gio.h>
+
+#include "command_recorder.h"
+#include "commands.h"
+#include "dbus_player_interface.h"
+#include "playerprovider.h"
+
+#ifndef MM_REPLAY
+#error "mm_replay needs PlayerProvider built with -DMM_REPLAY"
+#endif
+
+using lge::mm::command::BaseCommand;
+using lge::mm::command::CommandType;
+using lge::mm::command::Queue;
+using lge::mm::command::Record;
+using lge::mm::command::RecordKind;
+using lge::mm::command::RecordReader;
+using lge::mm::command::Recorder;
+using lge::mm::player::PlayerProvider;
+
+// longer than PLAYERENGINE_CALL_TIMEOUT_MS, so a command whose call gets no reply still finishes
+static const int kIdleTimeoutMs = 16000;
+
+struct FakeEngine {
+    GDBusConnection* connection;
+    guint registration;
+    std::string unique_name;
+    int media_id;
+};
+
+struct ReplayCommand {
+    size_t post;                      // index of Post in records
+    std::vector<size_t> signals;      // Signal records seen while it was running
+    uint64_t start_us;                // recorded Start, 0 when it never started
+};
+
+struct Sample {
+    size_t command;                   // index in commands
+    uint64_t post_us;
+    uint64_t start_us;
+    uint64_t done_us;
+    uint32_t type;
+};
+
+static std::vector<Record> records;
+static std::vector<ReplayCommand> commands;
+static std::vector<size_t> free_signals;          // Signal records outside of any command
+static std::map<std::string, FakeEngine> engines;  // by recorded connection name
+static GMainContext* engine_context = nullptr;
+
+static std::mutex sample_mutex;
+static std::map<uint64_t, size_t> replay_seq;      // seq in this process -> index in samples
+static std::vector<Sample> samples;
+static std::atomic<size_t> done_count(0);
+static std::atomic<uint64_t> last_progress_us(0);
+static thread_local size_t posting = SIZE_MAX;   // command being posted by this thread
+
+static const char* TypeName(uint32_t type) {
+    switch ((CommandType)type) {
+    case CommandType::Play: return "Play";
+    case CommandType::Pause: return "Pause";
+    case CommandType::PlayPause: return "PlayPause";
+    case CommandType::Stop: return "Stop";
+    case CommandType::Seek: return "Seek";
+    case CommandType::SetPosition: return "SetPosition";
+    case CommandType::SetRate: return "SetRate";
+    case CommandType::SetVolume: return "SetVolume";
+    case CommandType::SetMute: return "SetMute";
+    case CommandType::OpenUri: return "OpenUri";
+    default: return nullptr;
+    }
+}
+
+static std::map<std::string, std::string> ParseParams(const std::string& payload) {
+    std::map<std::string, std::string> params;
+    std::istringstream is(payload);
+    std::string item;
+
+    while (std::getline(is, item, ';')) {
+        size_t eq = item.find('=');
+        if (eq != std::string::npos)
+            params[item.substr(0, eq)] = item.substr(eq + 1);
+    }
+    return params;
+}
+
+static GVariant* DefaultValue(const GVariantType* type) {
+    switch (g_variant_type_peek_string(type)[0]) {
+    case 'b': return g_variant_new_boolean(TRUE);   // "succeed" out value of most methods
+    case 'y': return g_variant_new_byte(0);
+    case 'n': return g_variant_new_int16(0);
+    case 'q': return g_variant_new_uint16(0);
+    case 'i': return g_variant_new_int32(0);
+    case 'u': return g_variant_new_uint32(0);
+    case 'x': return g_variant_new_int64(0);
+    case 't': return g_variant_new_uint64(0);
+    case 'h': return g_variant_new_handle(0);
+    case 'd': return g_variant_new_double(0);
+    case 's': return g_variant_new_string("");
+    case 'o': return g_variant_new_object_path("/");
+    case 'g': return g_variant_new_signature("");
+    case 'v': return g_variant_new_variant(g_variant_new_string(""));
+    case 'a': return g_variant_new_array(g_variant_type_element(type), nullptr, 0);
+    case 'm': return g_variant_new_maybe(g_variant_type_element(type), nullptr);
+    case '{':
+        return g_variant_new_dict_entry(DefaultValue(g_variant_type_key(type)),
+                                        DefaultValue(g_variant_type_value(type)));
+    case '(': {
+        std::vector<GVariant*> children;
+        for (const GVariantType* t = g_variant_type_first(type); t; t = g_variant_type_next(t))
+            children.push_back(DefaultValue(t));
+        return g_variant_new_tuple(children.data(), children.size());
+    }
+    default:
+        return g_variant_new_string("");
+    }
+}
+
+static void onMethodCall(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                         const gchar* interface_name, const gchar* method_name, GVariant* parameters,
+                         GDBusMethodInvocation* invocation, gpointer user_data) {
+    const GDBusMethodInfo* info = g_dbus_method_invocation_get_method_info(invocation);
+    std::vector<GVariant*> out;
+
+    for (GDBusArgInfo** arg = info->out_args; arg && *arg; arg++) {
+        GVariantType* type = g_variant_type_new((*arg)->signature);
+        out.push_back(DefaultValue(type));
+        g_variant_type_free(type);
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new_tuple(out.data(), out.size()));
+}
+
+static const GDBusInterfaceVTable engine_vtable = { onMethodCall, nullptr, nullptr, { 0 } };
+
+static bool CreateEngine(const std::string& recorded_name, int media_id) {
+    GError* error = nullptr;
+    gchar* address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SESSION, nullptr, &error);
+    if (address == nullptr) {
+        fprintf(stderr, "no session bus: %s\n", error->message);
+        g_error_free(error);
+        return false;
+    }
+
+    // dedicated connection, so each fake engine has its own unique name like real ones
+    FakeEngine engine;
+    engine.connection = g_dbus_connection_new_for_address_sync(address,
+        (GDBusConnectionFlags)(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+        nullptr, nullptr, &error);
+    g_free(address);
+    if (engine.connection == nullptr) {
+        fprintf(stderr, "failed to connect fake engine: %s\n", error->message);
+        g_error_free(error);
+        return false;
+    }
+
+    engine.registration = g_dbus_connection_register_object(engine.connection, "/com/lge/PlayerEngine",
+        com_lge_player_engine_interface_info(), &engine_vtable, nullptr, nullptr, &error);
+    if (engine.registration == 0) {
+        fprintf(stderr, "failed to register fake engine: %s\n", error->message);
+        g_error_free(error);
+        g_object_unref(engine.connection);
+        return false;
+    }
+
+    engine.unique_name = g_dbus_connection_get_unique_name(engine.connection);
+    engine.media_id = media_id;
+    engines[recorded_name] = engine;
+    return true;
+}
+
+static void EmitSignal(const Record& record) {
+    auto it = engines.find(record.name);
+    if (it == engines.end())
+        return;
+
+    g_dbus_connection_emit_signal(it->second.connection, nullptr, "/com/lge/PlayerEngine",
+        "com.lge.PlayerEngine", "StateChange", g_variant_new("(s)", record.payload.c_str()), nullptr);
+}
+
+static void EmitSignalLater(size_t index, guint delay_ms) {
+    GSource* source = g_timeout_source_new(delay_ms);
+    g_source_set_callback(source, [](gpointer data) -> gboolean {
+        EmitSignal(records[(size_t)(uintptr_t)data]);
+        return FALSE;
+    }, (gpointer)(uintptr_t)index, nullptr);
+    g_source_attach(source, engine_context);
+    g_source_unref(source);
+}
+
+static bool Load(const std::string& path) {
+    RecordReader reader;
+    Record record;
+    std::map<uint64_t, size_t> by_seq;       // recorded seq -> index in commands
+    std::vector<size_t> running;             // commands between Start and Done
+
+    if (!reader.Open(path)) {
+        fprintf(stderr, "failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    while (reader.Next(record)) {
+        size_t index = records.size();
+        records.push_back(record);
+
+        switch (record.kind) {
+        case RecordKind::Post:
+            by_seq[record.seq] = commands.size();
+            commands.push_back(ReplayCommand{ index, {}, 0 });
+            break;
+        case RecordKind::Start: {
+            auto it = by_seq.find(record.seq);
+            if (it != by_seq.end()) {
+                commands[it->second].start_us = record.time_us;
+                running.push_back(it->second);
+            }
+            break;
+        }
+        case RecordKind::Done: {
+            auto it = by_seq.find(record.seq);
+            if (it != by_seq.end())
+                running.erase(std::remove(running.begin(), running.end(), it->second), running.end());
+            break;
+        }
+        case RecordKind::Signal: {
+            // lanes run in parallel, give the signal to the command of the same engine
+            auto owner = std::find_if(running.rbegin(), running.rend(), [&](size_t c) {
+                return records[commands[c].post].name == record.name;
+            });
+            if (owner != running.rend())
+                commands[*owner].signals.push_back(index);
+            else
+                free_signals.push_back(index);
+            break;
+        }
+        }
+    }
+
+    printf("loaded %zu records, %zu commands, %zu signals outside of commands\n",
+           records.size(), commands.size(), free_signals.size());
+    return true;
+}
+
+static void Observe(const Record& record) {
+    std::lock_guard<std::mutex> locker(sample_mutex);
+
+    switch (record.kind) {
+    case RecordKind::Post:
+        // PlayerProvider posts internal commands as well, measure only the replayed ones
+        if (posting == SIZE_MAX)
+            break;
+        replay_seq[record.seq] = samples.size();
+        samples.push_back(Sample{ posting, record.time_us, 0, 0, record.type });
+        break;
+    case RecordKind::Start: {
+        auto it = replay_seq.find(record.seq);
+        if (it == replay_seq.end())
+            break;
+        samples[it->second].start_us = record.time_us;
+
+        const ReplayCommand& command = commands[samples[it->second].command];
+        for (size_t s : command.signals)
+            EmitSignalLater(s, (guint)((records[s].time_us - command.start_us) / 1000));
+        break;
+    }
+    case RecordKind::Done: {
+        auto it = replay_seq.find(record.seq);
+        if (it == replay_seq.end())
+            break;
+        samples[it->second].done_us = record.time_us;
+        replay_seq.erase(it);
+        done_count++;
+        last_progress_us = g_get_monotonic_time();
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static BaseCommand* MakeCommand(PlayerProvider* player, const Record& record) {
+    auto engine = engines.find(record.name);
+    if (engine == engines.end())
+        return nullptr;
+
+    const std::string& name = engine->second.unique_name;
+    auto params = ParseParams(record.payload);
+    BaseCommand* bc = nullptr;
+
+    switch ((CommandType)record.type) {
+    case CommandType::Play:
+        bc = new (std::nothrow) lge::mm::command::PlayCommand(player, name, nullptr);
+        break;
+    case CommandType::Pause:
+        bc = new (std::nothrow) lge::mm::command::PauseCommand(player, name, nullptr);
+        break;
+    case CommandType::PlayPause:
+        bc = new (std::nothrow) lge::mm::command::PlayPauseCommand(player, name, nullptr);
+        break;
+    case CommandType::Stop:
+        bc = new (std::nothrow) lge::mm::command::StopCommand(player, true, name, engine->second.media_id, nullptr);
+        break;
+    case CommandType::Seek:
+        bc = new (std::nothrow) lge::mm::command::SeekCommand(player, std::stoll(params["pos_us"]), name, nullptr);
+        break;
+    case CommandType::SetPosition:
+        bc = new (std::nothrow) lge::mm::command::SetPositionCommand(player, params["is_streaming"] == "1",
+                                                                     std::stoull(params["pos_us"]), name, nullptr);
+        break;
+    case CommandType::SetRate:
+        bc = new (std::nothrow) lge::mm::command::SetRateCommand(player,
+            static_cast<decltype(lge::mm::command::SetRateCommand::rate)>(std::stod(params["rate"])), name);
+        break;
+    case CommandType::SetVolume:
+        bc = new (std::nothrow) lge::mm::command::SetVolumeCommand(player,
+            static_cast<decltype(lge::mm::command::SetVolumeCommand::volume)>(std::stod(params["volume"])), name);
+        break;
+    case CommandType::SetMute:
+        bc = new (std::nothrow) lge::mm::command::SetMuteCommand(player,
+            static_cast<decltype(lge::mm::command::SetMuteCommand::mute)>(std::stoi(params["mute"])), name);
+        break;
+    default:
+        // OpenUri and playlist commands need state of PlayerStubImpl, engines are attached instead
+        return nullptr;
+    }
+
+    if (bc)
+        bc->from_hmi = (record.flags & 0x1) != 0;
+    return bc;
+}
+
+static uint64_t Percentile(std::vector<uint64_t>& v, int p) {
+    size_t rank = (v.size() * p + 99) / 100;
+    return v[rank > 0 ? rank - 1 : 0];
+}
+
+static void Report() {
+    std::map<uint32_t, std::vector<uint64_t>> latency, wait;
+    size_t unfinished = 0;
+
+    std::lock_guard<std::mutex> locker(sample_mutex);
+    for (const Sample& s : samples) {
+        if (s.done_us == 0) {
+            unfinished++;   // coalesced in the queue or never answered
+            continue;
+        }
+        latency[s.type].push_back(s.done_us - s.post_us);
+        wait[s.type].push_back(s.start_us - s.post_us);
+    }
+
+    printf("%-12s %6s %9s %9s %9s %9s %9s\n", "command", "count", "wait p50", "p50", "p90", "p99", "max");
+    for (auto& it : latency) {
+        std::vector<uint64_t>& l = it.second;
+        std::vector<uint64_t>& w = wait[it.first];
+        std::sort(l.begin(), l.end());
+        std::sort(w.begin(), w.end());
+
+        const char* name = TypeName(it.first);
+        std::string label = name ? name : "type " + std::to_string(it.first);
+        printf("%-12s %6zu %9llu %9llu %9llu %9llu %9llu\n", label.c_str(), l.size(),
+               (unsigned long long)Percentile(w, 50), (unsigned long long)Percentile(l, 50),
+               (unsigned long long)Percentile(l, 90), (unsigned long long)Percentile(l, 99),
+               (unsigned long long)l.back());
+    }
+    printf("latency in us, %zu posted, %zu unfinished\n", samples.size(), unfinished);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("usage : %s <record file> [speed=1.0]\n", argv[0]);
+        return 1;
+    }
+    double speed = (argc > 2) ? atof(argv[2]) : 1.0;
+
+    // recording the replay into the same file would be confusing
+    unsetenv(COMMAND_RECORD_FILE_ENV);
+
+    if (!Load(argv[1]))
+        return 1;
+
+    GTestDBus* bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+
+    // method calls of fake engines are dispatched in the context which was default at registration
+    engine_context = g_main_context_new();
+    g_main_context_push_thread_default(engine_context);
+    int next_media_id = 1;
+    for (const ReplayCommand& command : commands) {
+        const Record& post = records[command.post];
+        if (engines.count(post.name))
+            continue;
+        auto params = ParseParams(post.payload);
+        int media_id = params.count("media_id") ? std::stoi(params["media_id"]) : next_media_id;
+        next_media_id = std::max(next_media_id, media_id + 1);
+        if (!CreateEngine(post.name, media_id))
+            return 1;
+    }
+    g_main_context_pop_thread_default(engine_context);
+
+    GMainLoop* engine_loop = g_main_loop_new(engine_context, FALSE);
+    std::thread engine_thread([engine_loop]() { g_main_loop_run(engine_loop); });
+
+    auto queue = std::make_shared<Queue>();
+    std::unique_ptr<PlayerProvider> player(new PlayerProvider(queue));
+    for (auto& it : engines) {
+        if (player->attachReplayEngine(it.second.unique_name, it.second.media_id) <= -1) {
+            fprintf(stderr, "failed to attach %s\n", it.first.c_str());
+            return 1;
+        }
+    }
+    Recorder::Instance().SetObserver(Observe);
+
+    // Posts and signals outside of commands in recorded order, the rest follows Start of commands
+    std::vector<size_t> timeline;
+    for (size_t c = 0; c < commands.size(); c++)
+        timeline.push_back(commands[c].post);
+    timeline.insert(timeline.end(), free_signals.begin(), free_signals.end());
+    std::sort(timeline.begin(), timeline.end());
+
+    size_t skipped = 0, next_command = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t index : timeline) {
+        const Record& record = records[index];
+        if (speed > 0)
+            std::this_thread::sleep_until(begin + std::chrono::microseconds((uint64_t)(record.time_us / speed)));
+
+        if (record.kind == RecordKind::Signal) {
+            EmitSignal(record);
+            continue;
+        }
+
+        BaseCommand* bc = MakeCommand(player.get(), record);
+        if (bc == nullptr) {
+            skipped++;
+        } else {
+            posting = next_command;
+            if (record.flags & 0x2)
+                queue->PostFront(bc);
+            else
+                queue->Post(bc);
+            posting = SIZE_MAX;
+        }
+        next_command++;
+    }
+
+    size_t posted = commands.size() - skipped;
+    last_progress_us = g_get_monotonic_time();
+    while (done_count < posted && (uint64_t)g_get_monotonic_time() - last_progress_us < kIdleTimeoutMs * 1000ULL)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    Recorder::Instance().SetObserver(nullptr);
+    printf("%zu commands skipped, not constructible without PlayerStubImpl\n", skipped);
+    Report();
+
+    player.reset();
+    g_main_loop_quit(engine_loop);
+    engine_thread.join();
+    g_main_loop_unref(engine_loop);
+    for (auto& it : engines) {
+        g_dbus_connection_unregister_object(it.second.connection, it.second.registration);
+        g_object_unref(it.second.connection);
+    }
+    g_main_context_unref(engine_context);
+
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return 0;
+}
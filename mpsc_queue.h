@@ -0,0 +1,109 @@
+/**
+* @file mpsc_queue.h
+* @version 1.0
+* Lock-free ring for multi-producer / single-consumer hand-off
+*/
+
+#ifndef MPSC_QUEUE_H_
+#define MPSC_QUEUE_H_
+
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+
+namespace lge {
+namespace mm {
+
+/**
+* @class lge::mm::BoundedMpscQueue
+* @brief Bounded FIFO. Any thread can push, only one thread can pop.
+* @details Ring buffer with a sequence number per cell (D. Vyukov).<BR>
+*          Push and pop never take a lock and never block. Push fails when the ring is full.
+*/
+template<typename T>
+class BoundedMpscQueue {
+public:
+    explicit BoundedMpscQueue(size_t capacity)
+      : mask_(RoundUp(capacity) - 1),
+        cells_(new Cell[mask_ + 1]),
+        head_(0),
+        tail_(0) {
+        for (size_t i = 0; i <= mask_; i++)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    bool TryPush(const T& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (1) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool TryPop(T& value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell = &cells_[pos & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+            return false; // empty, or producer has not finished writing the cell
+
+        value = cell->value;
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        head_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // approximate, exact only on the consumer thread when producers are idle
+    size_t SizeApprox() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return (tail > head) ? (tail - head) : 0;
+    }
+
+    size_t Capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t RoundUp(size_t v) {
+        size_t n = 2;
+        while (n < v)
+            n <<= 1;
+        return n;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // MPSC_QUEUE_H_
@@ -40,7 +40,8 @@ PlaybackOption::PlaybackOption()
     auto_stop_command_on_last_list(true),
     entertainment_mode(true),
     set_playback_error_and_stop(false),
-    set_potion_on_stop_state(false) {
+    set_potion_on_stop_state(false),
+    resume_position_on_open(false) {
     Print();
 }
 
@@ -57,6 +58,7 @@ void PlaybackOption::Update(MM::PlayerTypes::OptionMap& om) {
     GET_PLAYBACK_OPTION(auto_resume_on_next_or_prev);
     GET_PLAYBACK_OPTION(entertainment_mode);
     GET_PLAYBACK_OPTION(set_playback_error_and_stop);
+    GET_PLAYBACK_OPTION(resume_position_on_open);
 
     Print();
 }
@@ -75,6 +77,7 @@ void PlaybackOption::Get(MM::PlayerTypes::OptionMap& om) {
     SET_PLAYBACK_OPTION(auto_resume_on_next_or_prev);
     SET_PLAYBACK_OPTION(entertainment_mode);
     SET_PLAYBACK_OPTION(set_playback_error_and_stop);
+    SET_PLAYBACK_OPTION(resume_position_on_open);
 }
 
 void PlaybackOption::Print() {
@@ -90,6 +93,7 @@ void PlaybackOption::Print() {
     PRINT_PLAYBACK_OPTION("%d", auto_resume_on_next_or_prev);
     PRINT_PLAYBACK_OPTION("%d", entertainment_mode);
     PRINT_PLAYBACK_OPTION("%d", set_playback_error_and_stop);
+    PRINT_PLAYBACK_OPTION("%d", resume_position_on_open);
 }
 
 } // namespace player
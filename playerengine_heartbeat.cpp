@@ -0,0 +1,330 @@
+#include "playerengine_heartbeat.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "player_logger.h"
+
+#ifndef __NR_memfd_create
+#define __NR_memfd_create 319
+#endif
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+namespace lge {
+namespace mm {
+
+static const size_t kSegmentSize = sizeof(PlayerEngineHeartbeatSlot) * PLAYERENGINE_HEARTBEAT_SLOTS;
+
+static int MemfdCreate(const char* name, unsigned int flags) {
+    return syscall(__NR_memfd_create, name, flags);
+}
+
+static void ResetSlot(PlayerEngineHeartbeatSlot& slot, int pid) {
+    slot.flags.store(0, std::memory_order_relaxed);
+    slot.beat.store(0, std::memory_order_relaxed);
+    slot.beat_time_us.store(0, std::memory_order_relaxed);
+    slot.buffer_time_us.store(0, std::memory_order_relaxed);
+    slot.pts_ns.store(0, std::memory_order_relaxed);
+    slot.stall_time_us.store(0, std::memory_order_relaxed);
+    slot.pid.store(pid, std::memory_order_release);
+}
+
+PlayerEngineHeartbeat::PlayerEngineHeartbeat()
+  : slot_(nullptr),
+    map_(nullptr),
+    map_size_(0),
+    source_(nullptr),
+    stall_(Stall::None),
+    stall_at_us_(0) {}
+
+PlayerEngineHeartbeat::~PlayerEngineHeartbeat() {
+    if (source_) {
+        g_source_destroy(source_);
+        g_source_unref(source_);
+    }
+    if (map_)
+        munmap(map_, map_size_);
+}
+
+bool PlayerEngineHeartbeat::Attach() {
+    const char* fd_env = getenv(PLAYERENGINE_HEARTBEAT_FD_ENV);
+    const char* slot_env = getenv(PLAYERENGINE_HEARTBEAT_SLOT_ENV);
+    if (fd_env == nullptr || slot_env == nullptr || map_)
+        return false;
+
+    int fd = atoi(fd_env);
+    int slot = atoi(slot_env);
+    unsetenv(PLAYERENGINE_HEARTBEAT_FD_ENV);
+    unsetenv(PLAYERENGINE_HEARTBEAT_SLOT_ENV);
+    if (fd <= STDERR_FILENO)
+        return false;
+    if (slot < 0 || slot >= PLAYERENGINE_HEARTBEAT_SLOTS) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, kSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        MMLogError("mmap heartbeat segment fail : %s", strerror(errno));
+        return false;
+    }
+
+    map_ = map;
+    map_size_ = kSegmentSize;
+    slot_ = static_cast<PlayerEngineHeartbeatSlot*>(map) + slot;
+    MMLogInfo("heartbeat is attached to slot[%d]", slot);
+    return true;
+}
+
+void PlayerEngineHeartbeat::Start(GMainContext* context) {
+    if (slot_ == nullptr || source_)
+        return;
+
+    // test mode, e.g. PLAYERENGINE_HEARTBEAT_STALL=loop:5000
+    const char* stall = getenv(PLAYERENGINE_HEARTBEAT_STALL_ENV);
+    if (stall) {
+        const char* colon = strchr(stall, ':');
+        if (colon && strncmp(stall, "loop", colon - stall) == 0)
+            stall_ = Stall::Loop;
+        else if (colon && strncmp(stall, "pipeline", colon - stall) == 0)
+            stall_ = Stall::Pipeline;
+        if (stall_ != Stall::None) {
+            stall_at_us_ = g_get_monotonic_time() + (gint64)atoi(colon + 1) * 1000;
+            MMLogWarn("heartbeat test mode, %s stalls in %d ms", stall, atoi(colon + 1));
+        }
+    }
+
+    slot_->beat_time_us.store(g_get_monotonic_time(), std::memory_order_release);
+    source_ = g_timeout_source_new(PLAYERENGINE_HEARTBEAT_INTERVAL_MS);
+    g_source_set_callback(source_, onBeat, this, nullptr);
+    g_source_attach(source_, context);
+}
+
+gboolean PlayerEngineHeartbeat::onBeat(gpointer user_data) {
+    PlayerEngineHeartbeat* self = static_cast<PlayerEngineHeartbeat*>(user_data);
+    PlayerEngineHeartbeatSlot* slot = self->slot_;
+    gint64 now = g_get_monotonic_time();
+
+    if (self->stall_ == Stall::Loop && now >= self->stall_at_us_) {
+        slot->stall_time_us.store(now, std::memory_order_release);
+        MMLogWarn("heartbeat test mode, main loop is frozen");
+        while (1)
+            pause();
+    }
+
+    slot->beat.fetch_add(1, std::memory_order_relaxed);
+    slot->beat_time_us.store(now, std::memory_order_release);
+    return G_SOURCE_CONTINUE;
+}
+
+void PlayerEngineHeartbeat::SetPlaying(bool playing) {
+    if (slot_ == nullptr)
+        return;
+
+    // buffers are counted from now, prerolling after seek or resume is not a stall
+    if (playing) {
+        slot_->buffer_time_us.store(g_get_monotonic_time(), std::memory_order_relaxed);
+        slot_->flags.fetch_or(PLAYERENGINE_HEARTBEAT_PLAYING, std::memory_order_release);
+    } else {
+        slot_->flags.fetch_and(~PLAYERENGINE_HEARTBEAT_PLAYING, std::memory_order_release);
+    }
+}
+
+void PlayerEngineHeartbeat::OnBuffer(int64_t pts_ns) {
+    if (slot_ == nullptr)
+        return;
+
+    gint64 now = g_get_monotonic_time();
+    if (stall_ == Stall::Pipeline && now >= stall_at_us_) {
+        int64_t none = 0;
+        slot_->stall_time_us.compare_exchange_strong(none, now, std::memory_order_release);
+        return;
+    }
+
+    slot_->pts_ns.store(pts_ns, std::memory_order_relaxed);
+    slot_->buffer_time_us.store(now, std::memory_order_release);
+}
+
+PlayerEngineHeartbeatWatchdog::PlayerEngineHeartbeatWatchdog(GMainContext* context, uint32_t hang_timeout_ms)
+  : context_(context ? context : g_main_context_default()),
+    hang_timeout_ms_(hang_timeout_ms),
+    mutex_(),
+    fd_(-1),
+    slots_(nullptr),
+    watches_(PLAYERENGINE_HEARTBEAT_SLOTS, Watch{0, false}),
+    check_source_(nullptr),
+    hang_callback_(nullptr) {
+    g_main_context_ref(context_);
+
+    fd_ = MemfdCreate("playerengine-heartbeat", MFD_CLOEXEC);
+    if (fd_ < 0) {
+        MMLogError("memfd_create for heartbeat fail : %s", strerror(errno));
+        return;
+    }
+    if (ftruncate(fd_, (off_t)kSegmentSize) < 0) {
+        MMLogError("resize heartbeat segment fail : %s", strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+
+    void* map = mmap(nullptr, kSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        MMLogError("mmap heartbeat segment fail : %s", strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+    slots_ = static_cast<PlayerEngineHeartbeatSlot*>(map);
+}
+
+PlayerEngineHeartbeatWatchdog::~PlayerEngineHeartbeatWatchdog() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (check_source_) {
+        g_source_destroy(check_source_);
+        g_source_unref(check_source_);
+    }
+    if (slots_)
+        munmap(slots_, kSegmentSize);
+    if (fd_ >= 0)
+        close(fd_);
+    g_main_context_unref(context_);
+}
+
+void PlayerEngineHeartbeatWatchdog::SetHangCallback(HangCallback cb) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    hang_callback_ = cb;
+}
+
+int PlayerEngineHeartbeatWatchdog::Reserve(int& fd) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    fd = -1;
+    if (slots_ == nullptr)
+        return -1;
+
+    for (int i = 0; i < PLAYERENGINE_HEARTBEAT_SLOTS; i++) {
+        if (watches_[i].pid != 0)
+            continue;
+        watches_[i] = Watch{-1, false};
+        ResetSlot(slots_[i], 0);
+        fd = fd_;
+        return i;
+    }
+    MMLogWarn("no free heartbeat slot, PlayerEngine is not watched");
+    return -1;
+}
+
+void PlayerEngineHeartbeatWatchdog::Bind(int slot, int pid) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (slot < 0 || slot >= PLAYERENGINE_HEARTBEAT_SLOTS || watches_[slot].pid != -1)
+        return;
+    watches_[slot].pid = pid;
+    slots_[slot].pid.store(pid, std::memory_order_release);
+
+    if (check_source_ == nullptr) {
+        check_source_ = g_timeout_source_new(PLAYERENGINE_HEARTBEAT_CHECK_MS);
+        g_source_set_callback(check_source_, onCheck, this, nullptr);
+        g_source_attach(check_source_, context_);
+    }
+    MMLogInfo("PlayerEngine[%d] is watched by heartbeat slot[%d]", pid, slot);
+}
+
+void PlayerEngineHeartbeatWatchdog::Release(int slot) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (slots_ == nullptr || slot < 0 || slot >= PLAYERENGINE_HEARTBEAT_SLOTS)
+        return;
+    watches_[slot] = Watch{0, false};
+    ResetSlot(slots_[slot], 0);
+}
+
+void PlayerEngineHeartbeatWatchdog::Remove(int pid) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (pid <= 0)
+        return;
+    for (int i = 0; i < PLAYERENGINE_HEARTBEAT_SLOTS; i++) {
+        if (watches_[i].pid == pid) {
+            watches_[i] = Watch{0, false};
+            ResetSlot(slots_[i], 0);
+        }
+    }
+}
+
+gboolean PlayerEngineHeartbeatWatchdog::onCheck(gpointer user_data) {
+    PlayerEngineHeartbeatWatchdog* self = static_cast<PlayerEngineHeartbeatWatchdog*>(user_data);
+    gint64 now = g_get_monotonic_time();
+    gint64 timeout_us = (gint64)self->hang_timeout_ms_ * 1000;
+    std::vector<Hang> hangs;
+    bool watching = false;
+
+    std::unique_lock<std::mutex> locker(self->mutex_);
+    for (int i = 0; i < PLAYERENGINE_HEARTBEAT_SLOTS; i++) {
+        Watch& watch = self->watches_[i];
+        if (watch.pid <= 0)
+            continue;
+        watching = true;
+        if (watch.reported)
+            continue;
+
+        const PlayerEngineHeartbeatSlot& slot = self->slots_[i];
+        gint64 beat_time = slot.beat_time_us.load(std::memory_order_acquire);
+        if (beat_time == 0) // not started yet, or PlayerEngine without heartbeat
+            continue;
+
+        Hang hang{watch.pid, nullptr, 0, 0};
+        if (now - beat_time > timeout_us) {
+            hang.reason = "main loop";
+            hang.silent_us = now - beat_time;
+        } else if (slot.flags.load(std::memory_order_acquire) & PLAYERENGINE_HEARTBEAT_PLAYING) {
+            gint64 buffer_time = slot.buffer_time_us.load(std::memory_order_acquire);
+            if (buffer_time > 0 && now - buffer_time > timeout_us) {
+                hang.reason = "pipeline";
+                hang.silent_us = now - buffer_time;
+            }
+        }
+        if (hang.reason == nullptr)
+            continue;
+
+        gint64 stall_time = slot.stall_time_us.load(std::memory_order_acquire);
+        if (stall_time > 0)
+            hang.latency_us = now - stall_time;
+        watch.reported = true;
+        hangs.push_back(hang);
+    }
+
+    if (!watching) {
+        // nothing to watch, no more wake ups until the next Bind()
+        g_source_unref(self->check_source_);
+        self->check_source_ = nullptr;
+    }
+    HangCallback cb = self->hang_callback_;
+    locker.unlock();
+
+    for (const auto& hang : hangs) {
+        if (hang.latency_us > 0) {
+            MMLogError("PlayerEngine[%d] %s is hung, silent for %lld ms, detected %lld ms after the injected stall",
+                       hang.pid, hang.reason, (long long)(hang.silent_us / 1000), (long long)(hang.latency_us / 1000));
+        } else {
+            MMLogError("PlayerEngine[%d] %s is hung, silent for %lld ms",
+                       hang.pid, hang.reason, (long long)(hang.silent_us / 1000));
+        }
+        if (cb)
+            cb(hang);
+    }
+    return watching ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,185 @@
+/**
+* @file playerengine_heartbeat.h
+* @version 1.0
+* Header for the shared memory heartbeat between PlayerEngineManager and PlayerEngine
+*/
+
+#ifndef PLAYERENGINE_HEARTBEAT_H_
+#define PLAYERENGINE_HEARTBEAT_H_
+
+#include <stdint.h>
+#include <glib.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace lge {
+namespace mm {
+
+#define PLAYERENGINE_HEARTBEAT_FD_ENV       "PLAYERENGINE_HEARTBEAT_FD"
+#define PLAYERENGINE_HEARTBEAT_SLOT_ENV     "PLAYERENGINE_HEARTBEAT_SLOT"
+#define PLAYERENGINE_HEARTBEAT_STALL_ENV    "PLAYERENGINE_HEARTBEAT_STALL" // test mode, "loop:<ms>" or "pipeline:<ms>"
+#define PLAYERENGINE_HEARTBEAT_SLOTS        16
+#define PLAYERENGINE_HEARTBEAT_INTERVAL_MS  100 // PlayerEngine side, built into both processes
+#define PLAYERENGINE_HEARTBEAT_CHECK_MS     250
+#define PLAYERENGINE_HANG_TIMEOUT_MS        3000 // no beat for this long while playing is a hang
+
+#define PLAYERENGINE_HEARTBEAT_PLAYING      0x1
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "heartbeat slots are shared between processes, atomics must be lock free");
+
+/**
+* @struct lge::mm::PlayerEngineHeartbeatSlot
+* @brief One cache line of the shared segment per PlayerEngine.
+* @details pid is written by the manager, the others by the PlayerEngine. Times are
+*          g_get_monotonic_time(), which is the same clock in both processes.
+*/
+struct alignas(64) PlayerEngineHeartbeatSlot {
+    std::atomic<int32_t> pid;
+    std::atomic<uint32_t> flags;            // PLAYERENGINE_HEARTBEAT_PLAYING
+    std::atomic<uint64_t> beat;             // bumped by the main loop of PlayerEngine
+    std::atomic<int64_t> beat_time_us;      // 0 until the first beat
+    std::atomic<int64_t> buffer_time_us;    // last buffer rendered, or start of playing
+    std::atomic<int64_t> pts_ns;            // PTS of the last buffer rendered
+    std::atomic<int64_t> stall_time_us;     // test mode, when the stall was injected
+};
+
+/**
+* @class lge::mm::PlayerEngineHeartbeat
+* @brief Used by PlayerEngine. Beats from its main loop and records rendered buffers.
+* @details The segment is inherited from the launcher, see PLAYERENGINE_HEARTBEAT_FD_ENV.<BR>
+*          A frozen main loop stops the beat, a frozen pipeline stops the buffers while
+*          playing. Both are seen by the manager without any D-Bus call.
+*/
+class PlayerEngineHeartbeat {
+public:
+    PlayerEngineHeartbeat();
+    ~PlayerEngineHeartbeat();
+
+    /**
+    * @fn Attach
+    * @brief Maps the slot given by the launcher and closes the inherited fd.
+    * @return bool (true - attached, false - not launched with heartbeat)
+    */
+    bool Attach();
+
+    /**
+    * @fn Start
+    * @brief Beats every PLAYERENGINE_HEARTBEAT_INTERVAL_MS from context.
+    * @details In test mode, PLAYERENGINE_HEARTBEAT_STALL freezes the main loop or drops the<BR>
+    *          buffers after the given time, to measure how long the manager takes to notice.
+    * @param[in] context : main context of PlayerEngine, nullptr for default
+    * @return : None
+    */
+    void Start(GMainContext* context = nullptr);
+
+    /**
+    * @fn SetPlaying
+    * @brief Tells whether buffers are expected, e.g. on PLAYING and PAUSED state changes.
+    * @return : None
+    */
+    void SetPlaying(bool playing);
+
+    /**
+    * @fn OnBuffer
+    * @brief Records a rendered buffer, e.g. from a pad probe of the sink. Any thread.
+    * @param[in] pts_ns : PTS of the buffer
+    * @return : None
+    */
+    void OnBuffer(int64_t pts_ns);
+
+private:
+    enum class Stall : uint8_t { None, Loop, Pipeline };
+
+    static gboolean onBeat(gpointer user_data);
+
+    PlayerEngineHeartbeatSlot* slot_;
+    void* map_;
+    size_t map_size_;
+    GSource* source_;
+    Stall stall_;
+    gint64 stall_at_us_;
+};
+
+/**
+* @class lge::mm::PlayerEngineHeartbeatWatchdog
+* @brief Owns the heartbeat segment and samples every slot from one timer.
+* @details A PlayerEngine is hung when its beat is older than the hang timeout, or when
+*          it is playing and no buffer was rendered for the hang timeout. It is reported once,
+*          within hang timeout + PLAYERENGINE_HEARTBEAT_CHECK_MS.<BR>
+*          PlayerEngines which never beat, e.g. built without heartbeat, are never reported.
+* @see PlayerEngineManager
+*/
+class PlayerEngineHeartbeatWatchdog {
+public:
+    struct Hang {
+        int pid;
+        const char* reason;     // "main loop" or "pipeline"
+        gint64 silent_us;       // since the last beat or buffer
+        gint64 latency_us;      // since the injected stall in test mode, otherwise 0
+    };
+
+    /**
+    * @brief Called from the GMainContext when a PlayerEngine is hung.
+    */
+    typedef std::function<void(const Hang& hang)> HangCallback;
+
+    explicit PlayerEngineHeartbeatWatchdog(GMainContext* context = nullptr,
+                                           uint32_t hang_timeout_ms = PLAYERENGINE_HANG_TIMEOUT_MS);
+    ~PlayerEngineHeartbeatWatchdog();
+
+    void SetHangCallback(HangCallback cb);
+
+    /**
+    * @fn Reserve
+    * @brief Takes a free slot for a PlayerEngine to be launched. Must be called before launch.
+    * @param[out] fd : segment fd to be inherited by PlayerEngine, close-on-exec
+    * @return int (slot, -1 if there is no segment or free slot)
+    */
+    int Reserve(int& fd);
+
+    /**
+    * @fn Bind
+    * @brief Starts watching the slot for the launched PlayerEngine.
+    * @return : None
+    */
+    void Bind(int slot, int pid);
+
+    /**
+    * @fn Release
+    * @brief Frees a reserved slot, e.g. the launch failed.
+    * @return : None
+    */
+    void Release(int slot);
+
+    /**
+    * @fn Remove
+    * @brief Stops watching the PlayerEngine and frees its slot.
+    * @return : None
+    */
+    void Remove(int pid);
+
+private:
+    struct Watch {
+        int pid;        // 0 - free, -1 - reserved
+        bool reported;
+    };
+
+    static gboolean onCheck(gpointer user_data);
+
+    GMainContext* context_;
+    uint32_t hang_timeout_ms_;
+    std::mutex mutex_;
+    int fd_;
+    PlayerEngineHeartbeatSlot* slots_;
+    std::vector<Watch> watches_;
+    GSource* check_source_;
+    HangCallback hang_callback_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // PLAYERENGINE_HEARTBEAT_H_
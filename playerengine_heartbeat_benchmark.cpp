@@ -0,0 +1,136 @@
+/**
+* @file playerengine_heartbeat_benchmark.cpp
+* @version 1.0
+* Measures how long PlayerEngineHeartbeatWatchdog takes to detect a hung PlayerEngine.
+*
+* The tool launches copies of itself by LaunchPlayerEngineProcess() as fake PlayerEngines.
+* Each one beats from its main loop and feeds buffers from a streaming thread, then freezes
+* its main loop or its pipeline by PLAYERENGINE_HEARTBEAT_STALL test mode. The parent runs the
+* watchdog and prints the latency from the injected stall to the detection.
+*
+* build : g++ -O2 -std=c++11 -pthread -I. playerengine_heartbeat_benchmark.cpp playerengine_heartbeat.cpp
+*         playerengine_launcher.cpp $(pkg-config --cflags --libs glib-2.0) -o pe_heartbeat_bench
+* usage : pe_heartbeat_bench [loop|pipeline|all] [engines=8] [hang_timeout_ms=3000]
+*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "playerengine_heartbeat.h"
+#include "playerengine_launcher.h"
+
+using lge::mm::PlayerEngineHeartbeat;
+using lge::mm::PlayerEngineHeartbeatWatchdog;
+
+// fake PlayerEngine, 30 fps sink until the injected stall
+static int RunEngine() {
+    PlayerEngineHeartbeat heartbeat;
+    if (!heartbeat.Attach())
+        return 1;
+
+    GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+    heartbeat.Start();
+    heartbeat.SetPlaying(true);
+
+    std::thread streaming([&heartbeat]() {
+        int64_t pts_ns = 0;
+        while (1) {
+            heartbeat.OnBuffer(pts_ns);
+            pts_ns += 33333333;
+            usleep(33333);
+        }
+    });
+    streaming.detach();
+
+    g_main_loop_run(loop);
+    return 0;
+}
+
+static bool Measure(const char* mode, int engines, uint32_t hang_timeout_ms) {
+    GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+    PlayerEngineHeartbeatWatchdog watchdog(nullptr, hang_timeout_ms);
+    std::vector<double> latencies;
+    std::vector<int> pids;
+    int pending = 0;
+
+    watchdog.SetHangCallback([&](const PlayerEngineHeartbeatWatchdog::Hang& hang) {
+        latencies.push_back(hang.latency_us / 1000.0);
+        kill(hang.pid, SIGKILL);
+        waitpid(hang.pid, nullptr, 0);
+        watchdog.Remove(hang.pid);
+        if (--pending == 0)
+            g_main_loop_quit(loop);
+    });
+
+    for (int i = 0; i < engines; i++) {
+        // spread the stalls over the check interval
+        std::string stall = std::string(mode) + ":" + std::to_string(1000 + i * 37);
+        setenv(PLAYERENGINE_HEARTBEAT_STALL_ENV, stall.c_str(), 1);
+
+        int fd = -1;
+        int slot = watchdog.Reserve(fd);
+        pid_t pid = lge::mm::LaunchPlayerEngineProcess("/proc/self/exe", -1, fd, slot);
+        if (pid <= 0) {
+            watchdog.Release(slot);
+            continue;
+        }
+        watchdog.Bind(slot, pid);
+        pids.push_back(pid);
+        pending++;
+    }
+    unsetenv(PLAYERENGINE_HEARTBEAT_STALL_ENV);
+
+    // gives up if detection takes far longer than it should
+    guint deadline = g_timeout_add(hang_timeout_ms * 2 + 10000, [](gpointer data) -> gboolean {
+        g_main_loop_quit(static_cast<GMainLoop*>(data));
+        return G_SOURCE_REMOVE;
+    }, loop);
+    if (pending > 0)
+        g_main_loop_run(loop);
+    g_source_remove(deadline);
+
+    for (auto pid : pids) {
+        if (kill(pid, SIGKILL) == 0)
+            waitpid(pid, nullptr, 0);
+    }
+    g_main_loop_unref(loop);
+
+    if (latencies.empty()) {
+        printf("%-9s %8d %8d no detection\n", mode, engines, 0);
+        return false;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-9s %8d %8zu %10.1f %10.1f %10.1f %12u\n", mode, engines, latencies.size(),
+           latencies.front(), latencies[latencies.size() / 2], latencies.back(),
+           hang_timeout_ms + PLAYERENGINE_HEARTBEAT_CHECK_MS);
+    return latencies.size() == (size_t)engines;
+}
+
+int main(int argc, char *argv[]) {
+    if (getenv(PLAYERENGINE_HEARTBEAT_FD_ENV))
+        return RunEngine();
+
+    std::string mode = (argc > 1) ? argv[1] : "all";
+    int engines = (argc > 2) ? atoi(argv[2]) : 8;
+    uint32_t hang_timeout_ms = (argc > 3) ? strtoul(argv[3], NULL, 10) : PLAYERENGINE_HANG_TIMEOUT_MS;
+    if (engines > PLAYERENGINE_HEARTBEAT_SLOTS)
+        engines = PLAYERENGINE_HEARTBEAT_SLOTS;
+
+    printf("%-9s %8s %8s %10s %10s %10s %12s\n", "stall", "engines", "detected",
+           "min(ms)", "median(ms)", "max(ms)", "bound(ms)");
+    bool ok = true;
+    if (mode == "loop" || mode == "all")
+        ok &= Measure("loop", engines, hang_timeout_ms);
+    if (mode == "pipeline" || mode == "all")
+        ok &= Measure("pipeline", engines, hang_timeout_ms);
+    return ok ? 0 : 1;
+}
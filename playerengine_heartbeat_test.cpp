@@ -0,0 +1,131 @@
+/**
+* @file playerengine_heartbeat_test.cpp
+* @version 1.0
+* Test of hang detection by PlayerEngineHeartbeatWatchdog.
+*
+* PlayerEngineHeartbeat and the watchdog run in one process on one main context. An engine
+* which beats and renders is never reported. One whose buffers stop while playing is
+* reported once as a pipeline hang, one whose beat stops as a main loop hang, and one
+* which never beats is not reported.
+*
+* build : g++ -std=c++11 -pthread -I. playerengine_heartbeat_test.cpp playerengine_heartbeat.cpp
+*         $(pkg-config --cflags --libs glib-2.0) -o playerengine_heartbeat_test
+* usage : playerengine_heartbeat_test
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <glib.h>
+
+#include "playerengine_heartbeat.h"
+#include "test_check.h"
+
+using lge::mm::PlayerEngineHeartbeat;
+using lge::mm::PlayerEngineHeartbeatWatchdog;
+
+static const uint32_t kHangTimeoutMs = 300;
+
+struct Report {
+    int count;
+    std::string reason;
+};
+
+static std::map<int, Report> reports;
+
+static void OnHang(const PlayerEngineHeartbeatWatchdog::Hang& hang) {
+    Report& report = reports[hang.pid];
+    report.count++;
+    report.reason = hang.reason;
+}
+
+// dispatches the default context for timeout_ms, calling tick() between iterations
+static void Run(uint32_t timeout_ms, std::function<void()> tick = nullptr) {
+    gint64 end = g_get_monotonic_time() + timeout_ms * 1000LL;
+    while (g_get_monotonic_time() < end) {
+        if (tick)
+            tick();
+        if (!g_main_context_iteration(nullptr, FALSE))
+            usleep(1000);
+    }
+}
+
+// as PlayerEngineManager launches an engine, the slot is inherited by the environment
+static bool Launch(PlayerEngineHeartbeatWatchdog& watchdog, PlayerEngineHeartbeat& heartbeat, int pid) {
+    int fd = -1;
+    int slot = watchdog.Reserve(fd);
+    if (slot < 0)
+        return false;
+
+    setenv(PLAYERENGINE_HEARTBEAT_FD_ENV, std::to_string(dup(fd)).c_str(), 1);
+    setenv(PLAYERENGINE_HEARTBEAT_SLOT_ENV, std::to_string(slot).c_str(), 1);
+    bool attached = heartbeat.Attach();
+    watchdog.Bind(slot, pid);
+    return attached;
+}
+
+static void TestPipelineHang(PlayerEngineHeartbeatWatchdog& watchdog) {
+    const int pid = 1001;
+    PlayerEngineHeartbeat heartbeat;
+    CHECK(Launch(watchdog, heartbeat, pid));
+    heartbeat.Start();
+
+    // beats, and renders while playing
+    Run(600);
+    heartbeat.SetPlaying(true);
+    int64_t pts_ns = 0;
+    Run(600, [&heartbeat, &pts_ns]() { heartbeat.OnBuffer(pts_ns += 1000000); });
+    CHECK(reports.count(pid) == 0);
+
+    // buffers stop while the main loop still beats
+    Run(kHangTimeoutMs + PLAYERENGINE_HEARTBEAT_CHECK_MS + 100);
+    CHECK(reports.count(pid) == 1);
+    CHECK(reports[pid].reason == "pipeline");
+
+    // reported once
+    Run(600);
+    CHECK(reports[pid].count == 1);
+    watchdog.Remove(pid);
+}
+
+static void TestMainLoopHang(PlayerEngineHeartbeatWatchdog& watchdog) {
+    const int pid = 1002;
+    PlayerEngineHeartbeat* heartbeat = new PlayerEngineHeartbeat();
+    CHECK(Launch(watchdog, *heartbeat, pid));
+    heartbeat->Start();
+    Run(400);
+    CHECK(reports.count(pid) == 0);
+
+    // the beat stops, the slot keeps the time of the last one
+    delete heartbeat;
+    Run(kHangTimeoutMs + PLAYERENGINE_HEARTBEAT_CHECK_MS + 100);
+    CHECK(reports.count(pid) == 1);
+    CHECK(reports[pid].reason == "main loop");
+    watchdog.Remove(pid);
+}
+
+static void TestNeverBeats(PlayerEngineHeartbeatWatchdog& watchdog) {
+    const int pid = 1003;
+    PlayerEngineHeartbeat heartbeat;
+
+    // attached but never started, as an engine built without heartbeat
+    CHECK(Launch(watchdog, heartbeat, pid));
+    Run(kHangTimeoutMs * 3);
+    CHECK(reports.count(pid) == 0);
+    watchdog.Remove(pid);
+}
+
+int main() {
+    PlayerEngineHeartbeatWatchdog watchdog(nullptr, kHangTimeoutMs);
+    watchdog.SetHangCallback(OnHang);
+
+    TestPipelineHang(watchdog);
+    TestMainLoopHang(watchdog);
+    TestNeverBeats(watchdog);
+
+    return TestResult("playerengine_heartbeat_test");
+}
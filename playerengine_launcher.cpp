@@ -0,0 +1,117 @@
+#include "playerengine_launcher.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "player_logger.h"
+#include "playerengine_heartbeat.h"
+#include "playerengine_ready.h"
+
+extern char **environ;
+
+namespace lge {
+namespace mm {
+
+// signals which media manager handles or may ignore, PlayerEngine starts with default handlers
+static const int kDefaultSignals[] = { SIGCHLD, SIGTERM, SIGPIPE, SIGABRT, SIGSEGV, SIGBUS, SIGINT, SIGHUP };
+
+// environment set by the launcher only, never inherited from media manager
+static const char* const kLauncherEnvs[] = { PLAYERENGINE_READY_FD_ENV, PLAYERENGINE_HEARTBEAT_FD_ENV, PLAYERENGINE_HEARTBEAT_SLOT_ENV };
+
+static bool IsLauncherEnv(const char* env) {
+    for (auto name : kLauncherEnvs) {
+        size_t len = strlen(name);
+        if (strncmp(env, name, len) == 0 && env[len] == '=')
+            return true;
+    }
+    return false;
+}
+
+// dup2() onto itself keeps close-on-exec flag, and a source on a target fd of the other one
+// would be overwritten, so move such fds above the targets first
+static int MoveAboveChildFds(int fd) {
+    if (fd == PLAYERENGINE_READY_CHILD_FD || fd == PLAYERENGINE_HEARTBEAT_CHILD_FD)
+        return fcntl(fd, F_DUPFD_CLOEXEC, PLAYERENGINE_HEARTBEAT_CHILD_FD + 1);
+    return fd;
+}
+
+pid_t LaunchPlayerEngineProcess(const std::string& path, int ready_fd, int heartbeat_fd, int heartbeat_slot) {
+    size_t pos = path.rfind('/');
+    std::string filename = (pos == std::string::npos) ? path : path.substr(pos+1);
+    MMLogInfo("launch PlayerEngine: %s [%s]", filename.c_str(), path.c_str());
+
+    std::string ready_env = std::string(PLAYERENGINE_READY_FD_ENV) + "=" + std::to_string(PLAYERENGINE_READY_CHILD_FD);
+    std::string heartbeat_fd_env = std::string(PLAYERENGINE_HEARTBEAT_FD_ENV) + "=" + std::to_string(PLAYERENGINE_HEARTBEAT_CHILD_FD);
+    std::string heartbeat_slot_env = std::string(PLAYERENGINE_HEARTBEAT_SLOT_ENV) + "=" + std::to_string(heartbeat_slot);
+    if (heartbeat_slot < 0)
+        heartbeat_fd = -1;
+
+    std::vector<char*> envp;
+    for (char **env = environ; env && *env; env++) {
+        if (!IsLauncherEnv(*env))
+            envp.push_back(*env);
+    }
+    if (ready_fd >= 0)
+        envp.push_back(const_cast<char*>(ready_env.c_str()));
+    if (heartbeat_fd >= 0) {
+        envp.push_back(const_cast<char*>(heartbeat_fd_env.c_str()));
+        envp.push_back(const_cast<char*>(heartbeat_slot_env.c_str()));
+    }
+    envp.push_back(nullptr);
+
+    char *argv[] = { const_cast<char*>(filename.c_str()), nullptr };
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    int src_fd = MoveAboveChildFds(ready_fd);
+    if (src_fd >= 0)
+        posix_spawn_file_actions_adddup2(&actions, src_fd, PLAYERENGINE_READY_CHILD_FD);
+    int heartbeat_src_fd = MoveAboveChildFds(heartbeat_fd);
+    if (heartbeat_src_fd >= 0)
+        posix_spawn_file_actions_adddup2(&actions, heartbeat_src_fd, PLAYERENGINE_HEARTBEAT_CHILD_FD);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+
+    sigset_t def;
+    sigemptyset(&def);
+    for (auto sig : kDefaultSignals)
+        sigaddset(&def, sig);
+    posix_spawnattr_setsigdefault(&attr, &def);
+
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    pid_t pid = -1;
+    int ret = posix_spawn(&pid, path.c_str(), &actions, &attr, argv, envp.data());
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (src_fd >= 0 && src_fd != ready_fd)
+        close(src_fd);
+    if (heartbeat_src_fd >= 0 && heartbeat_src_fd != heartbeat_fd)
+        close(heartbeat_src_fd);
+
+    if (ret != 0) {
+        MMLogError("posix_spawn(%s) failed: %s", path.c_str(), strerror(ret));
+        return -1;
+    }
+
+    MMLogInfo("PlayerEngine process %d created", pid);
+    return pid;
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,44 @@
+/**
+* @file playerengine_launcher.h
+* @version 1.0
+* Launcher of PlayerEngine process
+*/
+
+#ifndef PLAYERENGINE_LAUNCHER_H_
+#define PLAYERENGINE_LAUNCHER_H_
+
+#include <sys/types.h>
+#include <string>
+
+namespace lge {
+namespace mm {
+
+#define PLAYERENGINE_READY_CHILD_FD     3 // fd number of the readiness pipe in PlayerEngine
+#define PLAYERENGINE_HEARTBEAT_CHILD_FD 4 // fd number of the heartbeat segment in PlayerEngine
+
+/**
+* @fn LaunchPlayerEngineProcess
+* @brief Launches PlayerEngine by posix_spawn.
+* @section function Function Flow
+* - Builds environment of the child. If ready_fd is valid, PLAYERENGINE_READY_FD is added.
+*   If heartbeat_fd is valid, PLAYERENGINE_HEARTBEAT_FD and PLAYERENGINE_HEARTBEAT_SLOT are added.
+* - Resets signal mask and handlers of the child to default.
+* - Duplicates ready_fd to PLAYERENGINE_READY_CHILD_FD and heartbeat_fd to
+*   PLAYERENGINE_HEARTBEAT_CHILD_FD in the child.
+* - Spawns the process without copying page tables of the media manager.
+*
+* @param[in] path : full path of PlayerEngine binary
+* @param[in] ready_fd : write end of readiness pipe, -1 if not used
+* @param[in] heartbeat_fd : heartbeat segment, -1 if not used
+* @param[in] heartbeat_slot : slot of the PlayerEngine in the heartbeat segment
+* @section global_variable Global Variables : environ
+* @section dependencies_none Dependencies : None
+* @return pid_t : pid of PlayerEngine, -1 on failure
+*/
+pid_t LaunchPlayerEngineProcess(const std::string& path, int ready_fd = -1,
+                                int heartbeat_fd = -1, int heartbeat_slot = -1);
+
+} // namespace mm
+} // namespace lge
+
+#endif  // PLAYERENGINE_LAUNCHER_H_
@@ -0,0 +1,275 @@
+#include "playerengine_monitor.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib-unix.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "player_logger.h"
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+
+#ifndef __NR_pidfd_send_signal
+#define __NR_pidfd_send_signal 424
+#endif
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+namespace lge {
+namespace mm {
+
+static int PidfdOpen(pid_t pid) {
+    return syscall(__NR_pidfd_open, pid, 0);
+}
+
+static int PidfdSendSignal(int pidfd, int sig) {
+    return syscall(__NR_pidfd_send_signal, pidfd, sig, NULL, 0);
+}
+
+PlayerEngineMonitor::PlayerEngineMonitor(GMainContext* context)
+  : context_(context ? context : g_main_context_default()),
+    mutex_(),
+    children_(),
+    exit_callback_(nullptr) {
+    g_main_context_ref(context_);
+}
+
+PlayerEngineMonitor::~PlayerEngineMonitor() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    for (auto& it : children_)
+        release(it.second);
+    children_.clear();
+    g_main_context_unref(context_);
+}
+
+void PlayerEngineMonitor::SetExitCallback(ExitCallback cb) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    exit_callback_ = cb;
+}
+
+bool PlayerEngineMonitor::Add(int pid) {
+    if (pid <= 0)
+        return false;
+
+    int pidfd = PidfdOpen(pid);
+    if (pidfd < 0) {
+        MMLogWarn("pidfd_open(%d) failed: %s", pid, strerror(errno));
+        return false;
+    }
+
+    Child* child = new Child{pid, pidfd, nullptr, nullptr, false, false, 0, 0};
+    Context* ctx = new Context{this, pid};
+    child->exit_source = g_unix_fd_source_new(pidfd, G_IO_IN);
+    g_source_set_callback(child->exit_source, (GSourceFunc)onExited, ctx,
+                          [](gpointer data) { delete static_cast<Context*>(data); });
+
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        auto it = children_.find(pid);
+        if (it != children_.end()) {
+            release(it->second);
+            children_.erase(it);
+        }
+        children_[pid] = child;
+    }
+    g_source_attach(child->exit_source, context_);
+    MMLogInfo("PlayerEngine[%d] is tracked by pidfd[%d]", pid, pidfd);
+    return true;
+}
+
+bool PlayerEngineMonitor::IsAlive(int pid) {
+    if (pid <= 0)
+        return false;
+
+    std::unique_lock<std::mutex> locker(mutex_);
+    auto it = children_.find(pid);
+    if (it == children_.end()) {
+        locker.unlock();
+        return (kill(pid, 0) == 0); // not launched by PlayerEngineManager
+    }
+
+    // pidfd becomes readable when the process exits, even before onExited() is dispatched
+    struct pollfd pfd = {it->second->pidfd, POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+        return false;
+    return true;
+}
+
+bool PlayerEngineMonitor::Terminate(int pid, uint32_t kill_deadline_ms, uint32_t grace_ms) {
+    if (pid <= 0)
+        return false;
+
+    std::unique_lock<std::mutex> locker(mutex_);
+    auto it = children_.find(pid);
+    if (it == children_.end()) {
+        locker.unlock();
+        MMLogInfo("PlayerEngine[%d] is not tracked, kill directly", pid);
+        if (kill(pid, SIGKILL) != 0)
+            return false;
+        // no exit source reaps it, wait here. SIGKILL is not caught so it ends shortly,
+        // ECHILD when it is not our child or already reaped
+        while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+            ;
+        return true;
+    }
+
+    Child* child = it->second;
+    if (child->terminating) {
+        MMLogInfo("PlayerEngine[%d] is already terminating", pid);
+        return true;
+    }
+
+    child->terminating = true;
+    child->kill_deadline_ms = kill_deadline_ms;
+    if (grace_ms > 0) {
+        armKillSource(child, grace_ms);
+        MMLogInfo("PlayerEngine[%d] gets SIGTERM in %u ms, SIGKILL %u ms later", pid, grace_ms, kill_deadline_ms);
+        return true;
+    }
+
+    if (!sendTerm(child)) {
+        child->terminating = false;
+        return false;
+    }
+    armKillSource(child, kill_deadline_ms);
+    return true;
+}
+
+bool PlayerEngineMonitor::Kill(int pid) {
+    if (pid <= 0)
+        return false;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    auto it = children_.find(pid);
+    if (it == children_.end()) {
+        MMLogWarn("PlayerEngine[%d] is not tracked, not killed", pid);
+        return false;
+    }
+
+    if (sendSignal(it->second, SIGKILL) != 0) {
+        MMLogWarn("Fail to send SIGKILL to PlayerEngine[%d]: %s", pid, strerror(errno));
+        return false;
+    }
+    MMLogWarn("SIGKILL is sent to PlayerEngine[%d]", pid);
+    return true;
+}
+
+gboolean PlayerEngineMonitor::onExited(gint fd, GIOCondition condition, gpointer user_data) {
+    Context* ctx = static_cast<Context*>(user_data);
+    PlayerEngineMonitor* self = ctx->self;
+    siginfo_t info;
+
+    std::unique_lock<std::mutex> locker(self->mutex_);
+    auto it = self->children_.find(ctx->pid);
+    if (it == self->children_.end())
+        return FALSE;
+    Child* child = it->second;
+
+    memset(&info, 0, sizeof(info));
+    if (waitid((idtype_t)P_PIDFD, child->pidfd, &info, WEXITED | WNOHANG) != 0) {
+        if (errno == EINVAL) // kernel without P_PIDFD
+            waitpid(child->pid, NULL, WNOHANG);
+        else if (errno != ECHILD) // ECHILD : already reaped by SIGCHLD handler
+            MMLogWarn("waitid(%d) failed: %s", child->pid, strerror(errno));
+    }
+
+    bool expected = child->terminating;
+    if (expected && child->term_sent) {
+        MMLogInfo("PlayerEngine[%d] exited [code:%d, status:%d] %lld us after SIGTERM", child->pid,
+                  info.si_code, info.si_status, (long long)(g_get_monotonic_time() - child->term_time));
+    } else if (expected) {
+        MMLogInfo("PlayerEngine[%d] exited [code:%d, status:%d] before SIGTERM", child->pid,
+                  info.si_code, info.si_status);
+    } else {
+        MMLogError("PlayerEngine[%d] exited unexpectedly [code:%d, status:%d]", child->pid, info.si_code, info.si_status);
+    }
+
+    int pid = child->pid;
+    g_source_unref(child->exit_source);
+    child->exit_source = nullptr;
+    self->release(child);
+    self->children_.erase(it);
+    ExitCallback cb = self->exit_callback_;
+    locker.unlock();
+
+    if (cb)
+        cb(pid, expected);
+    return FALSE;
+}
+
+gboolean PlayerEngineMonitor::onKillDeadline(gpointer user_data) {
+    Context* ctx = static_cast<Context*>(user_data);
+    PlayerEngineMonitor* self = ctx->self;
+
+    std::lock_guard<std::mutex> locker(self->mutex_);
+    auto it = self->children_.find(ctx->pid);
+    if (it == self->children_.end())
+        return FALSE;
+    Child* child = it->second;
+
+    g_source_unref(child->kill_source);
+    child->kill_source = nullptr;
+
+    // end of the grace period
+    if (!child->term_sent) {
+        if (sendTerm(child))
+            self->armKillSource(child, child->kill_deadline_ms);
+        return FALSE;
+    }
+
+    MMLogWarn("PlayerEngine[%d] did not exit after SIGTERM, send SIGKILL", child->pid);
+    sendSignal(child, SIGKILL);
+    return FALSE;
+}
+
+bool PlayerEngineMonitor::sendTerm(Child* child) {
+    if (sendSignal(child, SIGTERM) != 0) {
+        MMLogWarn("Fail to send SIGTERM to PlayerEngine[%d]: %s", child->pid, strerror(errno));
+        return false;
+    }
+    child->term_sent = true;
+    child->term_time = g_get_monotonic_time();
+    MMLogInfo("SIGTERM is sent to PlayerEngine[%d], SIGKILL in %u ms", child->pid, child->kill_deadline_ms);
+    return true;
+}
+
+void PlayerEngineMonitor::armKillSource(Child* child, uint32_t timeout_ms) {
+    Context* ctx = new Context{this, child->pid};
+    child->kill_source = g_timeout_source_new(timeout_ms);
+    g_source_set_callback(child->kill_source, onKillDeadline, ctx,
+                          [](gpointer data) { delete static_cast<Context*>(data); });
+    g_source_attach(child->kill_source, context_);
+}
+
+int PlayerEngineMonitor::sendSignal(Child* child, int sig) {
+    if (PidfdSendSignal(child->pidfd, sig) == 0)
+        return 0;
+    if (errno == ENOSYS)
+        return kill(child->pid, sig);
+    return -1;
+}
+
+void PlayerEngineMonitor::release(Child* child) {
+    if (child->exit_source) {
+        g_source_destroy(child->exit_source);
+        g_source_unref(child->exit_source);
+    }
+    if (child->kill_source) {
+        g_source_destroy(child->kill_source);
+        g_source_unref(child->kill_source);
+    }
+    if (child->pidfd >= 0)
+        close(child->pidfd);
+    delete child;
+}
+
+} // namespace mm
+} // namespace lge
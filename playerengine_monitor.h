@@ -0,0 +1,114 @@
+/**
+* @file playerengine_monitor.h
+* @version 1.0
+* Header for the class lge::mm::PlayerEngineMonitor
+*/
+
+#ifndef PLAYERENGINE_MONITOR_H_
+#define PLAYERENGINE_MONITOR_H_
+
+#include <stdint.h>
+#include <glib.h>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace lge {
+namespace mm {
+
+#define PLAYERENGINE_KILL_DEADLINE_MS 300 // SIGTERM -> SIGKILL, covers alsa close of PlayerEngine
+#define PLAYERENGINE_STOP_GRACE_MS    200 // before SIGTERM, StopCommand posted with it closes alsa
+
+/**
+* @class lge::mm::PlayerEngineMonitor
+* @brief Tracks lifecycle of PlayerEngine processes by pidfd.
+* @details A pidfd per PlayerEngine is watched from the given GMainContext.<BR>
+*          Exit is detected as soon as it happens and the child is reaped by the monitor.<BR>
+*          Termination sends SIGTERM and escalates to SIGKILL by a timer, without sleeping.
+* @see PlayerEngineManager
+*/
+class PlayerEngineMonitor {
+public:
+    /**
+    * @brief Called from the GMainContext when a tracked PlayerEngine exited.
+    * @param pid : pid of the PlayerEngine
+    * @param expected : true if the exit was requested by Terminate()
+    */
+    typedef std::function<void(int pid, bool expected)> ExitCallback;
+
+    explicit PlayerEngineMonitor(GMainContext* context = nullptr);
+    ~PlayerEngineMonitor();
+
+    void SetExitCallback(ExitCallback cb);
+
+    /**
+    * @fn Add
+    * @brief Opens pidfd of the PlayerEngine and starts watching it.
+    * @param[in] pid : pid of the PlayerEngine
+    * @return bool (true - SUCCESS, false - pidfd is not supported or process is gone)
+    */
+    bool Add(int pid);
+
+    /**
+    * @fn IsAlive
+    * @brief Checks the PlayerEngine is running. Exited but not reaped process is regarded as dead.
+    * @param[in] pid : pid of the PlayerEngine
+    * @return bool
+    */
+    bool IsAlive(int pid);
+
+    /**
+    * @fn Terminate
+    * @brief Sends SIGTERM after the grace period and SIGKILL on the deadline, by timers. Does not block.
+    *        The exit is reported as expected from this call on.
+    * @param[in] pid : pid of the PlayerEngine
+    * @param[in] kill_deadline_ms : time to wait exit after SIGTERM before SIGKILL
+    * @param[in] grace_ms : time to let the engine stop by itself before SIGTERM
+    * @return bool (true - termination is started, false - FAIL)
+    */
+    bool Terminate(int pid, uint32_t kill_deadline_ms = PLAYERENGINE_KILL_DEADLINE_MS,
+                   uint32_t grace_ms = PLAYERENGINE_STOP_GRACE_MS);
+
+    /**
+    * @fn Kill
+    * @brief Sends SIGKILL at once, for a hung PlayerEngine which would not handle SIGTERM.
+    *        Unless Terminate() was called before, the exit is reported as not expected.
+    * @param[in] pid : pid of the PlayerEngine
+    * @return bool (true - signal is sent, false - FAIL)
+    */
+    bool Kill(int pid);
+
+private:
+    struct Child {
+        int pid;
+        int pidfd;
+        GSource* exit_source;
+        GSource* kill_source;
+        bool terminating;
+        bool term_sent;
+        uint32_t kill_deadline_ms;
+        gint64 term_time;
+    };
+
+    struct Context {
+        PlayerEngineMonitor* self;
+        int pid;
+    };
+
+    static gboolean onExited(gint fd, GIOCondition condition, gpointer user_data);
+    static gboolean onKillDeadline(gpointer user_data);
+    static int sendSignal(Child* child, int sig);
+    static bool sendTerm(Child* child);
+    void armKillSource(Child* child, uint32_t timeout_ms);
+    void release(Child* child);
+
+    GMainContext* context_;
+    std::mutex mutex_;
+    std::map<int, Child*> children_;
+    ExitCallback exit_callback_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // PLAYERENGINE_MONITOR_H_
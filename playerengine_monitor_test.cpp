@@ -0,0 +1,132 @@
+/**
+* @file playerengine_monitor_test.cpp
+* @version 1.0
+* Test of the exits seen by PlayerEngineMonitor.
+*
+* Forked children stand in for PlayerEngines. Terminate() gives a child the stop grace
+* before SIGTERM and SIGKILL after the kill deadline. Each exit is reported once, as
+* expected after Terminate() and as unexpected otherwise. A child which is not tracked is
+* killed and reaped by Terminate() itself.
+*
+* build : g++ -std=c++11 -pthread -I. playerengine_monitor_test.cpp playerengine_monitor.cpp
+*         $(pkg-config --cflags --libs glib-2.0) -o playerengine_monitor_test
+* usage : playerengine_monitor_test
+*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <functional>
+#include <map>
+#include <glib.h>
+
+#include "playerengine_monitor.h"
+#include "test_check.h"
+
+using lge::mm::PlayerEngineMonitor;
+
+struct Exit {
+    int count;
+    bool expected;
+    gint64 time_us;
+};
+
+static std::map<int, Exit> exits;
+
+static void OnExit(int pid, bool expected) {
+    Exit& exit = exits[pid];
+    exit.count++;
+    exit.expected = expected;
+    exit.time_us = g_get_monotonic_time();
+}
+
+// dispatches the default context until done() or timeout
+static bool RunUntil(uint32_t timeout_ms, std::function<bool()> done) {
+    gint64 end = g_get_monotonic_time() + timeout_ms * 1000LL;
+    while (g_get_monotonic_time() < end) {
+        if (done())
+            return true;
+        if (!g_main_context_iteration(nullptr, FALSE))
+            usleep(1000);
+    }
+    return done();
+}
+
+static int Fork(bool ignore_term, int exit_after_ms) {
+    int pid = fork();
+    if (pid != 0)
+        return pid;
+
+    if (ignore_term)
+        signal(SIGTERM, SIG_IGN);
+    if (exit_after_ms >= 0) {
+        usleep(exit_after_ms * 1000);
+        _exit(3);
+    }
+    while (1)
+        pause();
+}
+
+static void TestGraceBeforeTerm(PlayerEngineMonitor& monitor) {
+    int pid = Fork(false, -1);
+    CHECK(monitor.Add(pid));
+
+    gint64 begin = g_get_monotonic_time();
+    CHECK(monitor.Terminate(pid, 300, 200));
+    // still running in the grace period, the StopCommand closes alsa meanwhile
+    RunUntil(100, []() { return false; });
+    CHECK(exits.count(pid) == 0);
+    CHECK(monitor.IsAlive(pid));
+
+    CHECK(RunUntil(2000, [pid]() { return exits.count(pid) > 0; }));
+    CHECK(exits[pid].count == 1 && exits[pid].expected);
+    CHECK(exits[pid].time_us - begin >= 200 * 1000);
+    CHECK(exits[pid].time_us - begin < 500 * 1000);
+}
+
+static void TestKillAfterDeadline(PlayerEngineMonitor& monitor) {
+    int pid = Fork(true, -1);
+    CHECK(monitor.Add(pid));
+
+    gint64 begin = g_get_monotonic_time();
+    CHECK(monitor.Terminate(pid, 300, 100));
+    CHECK(RunUntil(2000, [pid]() { return exits.count(pid) > 0; }));
+    CHECK(exits[pid].count == 1 && exits[pid].expected);
+    CHECK(exits[pid].time_us - begin >= 400 * 1000);
+}
+
+static void TestUnexpectedExit(PlayerEngineMonitor& monitor) {
+    int pid = Fork(false, 50);
+    CHECK(monitor.Add(pid));
+
+    CHECK(RunUntil(2000, [pid]() { return exits.count(pid) > 0; }));
+    CHECK(exits[pid].count == 1 && !exits[pid].expected);
+    CHECK(!monitor.IsAlive(pid));
+
+    // reaped by the monitor, the exit is not reported again
+    RunUntil(100, []() { return false; });
+    CHECK(exits[pid].count == 1);
+    CHECK(waitpid(pid, NULL, WNOHANG) < 0);
+}
+
+static void TestTerminateUntracked(PlayerEngineMonitor& monitor) {
+    int pid = Fork(true, -1);
+
+    CHECK(monitor.Terminate(pid));
+    // no zombie left behind
+    CHECK(waitpid(pid, NULL, WNOHANG) < 0);
+    CHECK(exits.count(pid) == 0);
+}
+
+int main() {
+    PlayerEngineMonitor monitor;
+    monitor.SetExitCallback(OnExit);
+
+    TestGraceBeforeTerm(monitor);
+    TestKillAfterDeadline(monitor);
+    TestUnexpectedExit(monitor);
+    TestTerminateUntracked(monitor);
+
+    return TestResult("playerengine_monitor_test");
+}
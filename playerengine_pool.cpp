@@ -0,0 +1,173 @@
+#include "playerengine_pool.h"
+
+#include <chrono>
+
+#include "player_logger.h"
+
+#define POOL_RETRY_DELAY_MS 1000
+
+namespace lge {
+namespace mm {
+
+PlayerEnginePool::PlayerEnginePool(Launcher launcher, Destroyer destroyer, Prober alive, uint32_t size)
+  : launcher_(launcher),
+    destroyer_(destroyer),
+    alive_(alive),
+    size_(size),
+    ready_(),
+    generation_(0),
+    stale_(),
+    mutex_(),
+    cv_(),
+    thread_(),
+    quit_(false) {
+    MMLogInfo("pool size=[%u]", size_);
+}
+
+PlayerEnginePool::~PlayerEnginePool() {
+    MMLogInfo("");
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        quit_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+
+    for (auto& engine : ready_)
+        destroyer_(engine.pid);
+    ready_.clear();
+}
+
+void PlayerEnginePool::Start() {
+    if (size_ == 0) {
+        MMLogInfo("PlayerEngine pool is disabled");
+        return;
+    }
+    if (thread_.joinable())
+        return;
+    thread_ = std::thread(std::bind(&PlayerEnginePool::Refill, this));
+}
+
+bool PlayerEnginePool::Take(Engine& engine) {
+    std::unique_lock<std::mutex> locker(mutex_);
+
+    while (!ready_.empty()) {
+        engine = ready_.front();
+        ready_.pop_front();
+
+        if (!alive_(engine.pid)) { // died while waiting in the pool
+            MMLogWarn("pooled PlayerEngine[%d] is not alive, discard", engine.pid);
+            continue;
+        }
+
+        MMLogInfo("hand out pooled PlayerEngine[%d / %s], remain=[%zu]",
+                  engine.pid, engine.connection_name.c_str(), ready_.size());
+        locker.unlock();
+        cv_.notify_all();
+        return true;
+    }
+
+    locker.unlock();
+    cv_.notify_all();
+    MMLogInfo("PlayerEngine pool is empty");
+    return false;
+}
+
+bool PlayerEnginePool::Contains(const std::string& connection_name) {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    for (auto& engine : ready_) {
+        if (engine.connection_name.compare(connection_name) == 0)
+            return true;
+    }
+    return false;
+}
+
+void PlayerEnginePool::Resize(uint32_t size) {
+    std::deque<Engine> surplus;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        MMLogInfo("pool size [%u] -> [%u]", size_, size);
+        size_ = size;
+        while (ready_.size() > size_) {
+            surplus.push_back(ready_.back());
+            ready_.pop_back();
+        }
+    }
+    for (auto& engine : surplus)
+        destroyer_(engine.pid);
+
+    if (size_ > 0)
+        Start();
+    cv_.notify_all();
+}
+
+void PlayerEnginePool::Recycle(Filter stale_filter) {
+    std::deque<Engine> stale;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        // engines launching now are of the old generation and checked when done
+        generation_++;
+        stale_ = stale_filter;
+        for (auto it = ready_.begin(); it != ready_.end();) {
+            if (stale_(*it)) {
+                stale.push_back(*it);
+                it = ready_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    MMLogInfo("recycle [%zu] pooled PlayerEngines", stale.size());
+    for (auto& engine : stale)
+        destroyer_(engine.pid);
+    cv_.notify_all();
+}
+
+uint32_t PlayerEnginePool::Size() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return ready_.size();
+}
+
+void PlayerEnginePool::Refill() {
+    MMLogInfo("PlayerEngine pool refill thread is started");
+
+    std::unique_lock<std::mutex> locker(mutex_);
+    while (!quit_) {
+        cv_.wait(locker, [this]() { return quit_ || ready_.size() < size_; });
+        if (quit_)
+            break;
+
+        Engine engine{0, "", true, generation_};
+        locker.unlock();
+        bool launched = launcher_(engine);
+        locker.lock();
+
+        if (!launched) {
+            MMLogWarn("Fail to prepare PlayerEngine for pool, retry later");
+            cv_.wait_for(locker, std::chrono::milliseconds(POOL_RETRY_DELAY_MS), [this]() { return quit_; });
+            continue;
+        }
+
+        bool stale = engine.generation != generation_ && stale_ && stale_(engine);
+        if (stale)
+            MMLogInfo("PlayerEngine[%d] was recycled while launching, relaunch", engine.pid);
+
+        if (quit_ || stale || ready_.size() >= size_) {
+            locker.unlock();
+            destroyer_(engine.pid);
+            locker.lock();
+            continue;
+        }
+
+        ready_.push_back(engine);
+        MMLogInfo("PlayerEngine[%d / %s] is ready in pool, count=[%zu]",
+                  engine.pid, engine.connection_name.c_str(), ready_.size());
+    }
+
+    MMLogInfo("PlayerEngine pool refill thread is finished");
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,126 @@
+/**
+* @file playerengine_pool.h
+* @version 1.0
+* Header for the class lge::mm::PlayerEnginePool
+*/
+
+#ifndef PLAYERENGINE_POOL_H_
+#define PLAYERENGINE_POOL_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace lge {
+namespace mm {
+
+#define DEFAULT_PLAYER_ENGINE_POOL_SIZE 1 // playerengine_pool_size of mediamanager.cfg when not set
+
+/**
+* @class lge::mm::PlayerEnginePool
+* @brief Keeps PlayerEngine processes which are already launched and own their bus name.
+* @details openUri takes an engine from the pool instead of launching one and waiting<BR>
+*          for its connection name. The pool is refilled by a background thread.
+* @see PlayerEngineManager
+*/
+class PlayerEnginePool {
+public:
+    struct Engine {
+        int pid;
+        std::string connection_name;
+        bool libraries_settled;  // set by the launcher, libraries loaded at start were settled at launch
+        uint32_t generation;     // set by the pool at launch, see Recycle()
+    };
+
+    typedef std::function<bool(Engine&)> Launcher;
+    typedef std::function<void(int)> Destroyer;
+    typedef std::function<bool(int)> Prober;
+    typedef std::function<bool(const Engine&)> Filter;
+
+    /**
+    * @fn PlayerEnginePool
+    * @brief Constructor.
+    * @param[in] launcher : launches a PlayerEngine and resolves its connection name.
+    * @param[in] destroyer : destroys a PlayerEngine which is not handed out.
+    * @param[in] alive : checks a pooled PlayerEngine is still running before it is handed out.
+    * @param[in] size : number of engines to keep ready. 0 disables the pool.
+    * @return : None
+    */
+    PlayerEnginePool(Launcher launcher, Destroyer destroyer, Prober alive,
+                     uint32_t size = DEFAULT_PLAYER_ENGINE_POOL_SIZE);
+
+    /**
+    * @fn ~PlayerEnginePool
+    * @brief Destructor. Stops refill thread and destroys engines not handed out.
+    * @return : None
+    */
+    ~PlayerEnginePool();
+
+    /**
+    * @fn Start
+    * @brief Starts refill thread.
+    * @return : None
+    */
+    void Start();
+
+    /**
+    * @fn Take
+    * @brief Hands out a ready PlayerEngine and requests refill.
+    * @param[out] engine : pid and connection name of the engine.
+    * @return bool (true - engine is handed out, false - pool is empty)
+    */
+    bool Take(Engine& engine);
+
+    /**
+    * @fn Contains
+    * @brief Checks the connection name belongs to an engine waiting in the pool.
+    * @param[in] connection_name : connection name to check
+    * @return bool
+    */
+    bool Contains(const std::string& connection_name);
+
+    /**
+    * @fn Resize
+    * @brief Changes number of engines to keep ready.
+    * @param[in] size : new pool size
+    * @return : None
+    */
+    void Resize(uint32_t size);
+
+    /**
+    * @fn Recycle
+    * @brief Destroys stale engines waiting in the pool, the refill thread launches new ones.
+    * @details Used when engines launched earlier miss something loaded at their start.<BR>
+    *          An engine which is still launching is checked by the same filter when it is<BR>
+    *          done, so an engine launched before the call never gets into the pool stale.
+    * @param[in] stale : true for an engine to destroy, decided by what was recorded at its launch
+    * @return : None
+    */
+    void Recycle(Filter stale);
+
+    uint32_t Size();
+
+private:
+    void Refill();
+
+    Launcher launcher_;
+    Destroyer destroyer_;
+    Prober alive_;
+    uint32_t size_;
+    std::deque<Engine> ready_;
+    uint32_t generation_;
+    Filter stale_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool quit_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // PLAYERENGINE_POOL_H_
@@ -0,0 +1,152 @@
+/**
+* @file playerengine_pool_test.cpp
+* @version 1.0
+* Test of PlayerEnginePool::Recycle and Take.
+*
+* The launcher records whether the libraries were settled at launch, as PlayerEngineManager
+* does for the Dolby libraries. Only engines recorded as stale are recycled, also one which
+* was still launching when Recycle() was called. An engine which died in the pool is not
+* handed out.
+*
+* build : g++ -std=c++11 -pthread -I. playerengine_pool_test.cpp playerengine_pool.cpp -o playerengine_pool_test
+* usage : playerengine_pool_test
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "playerengine_pool.h"
+#include "test_check.h"
+
+using lge::mm::PlayerEnginePool;
+
+// a fake PlayerEngine launcher, a launch can be held until released
+class FakeLauncher {
+public:
+    bool Launch(PlayerEnginePool::Engine& engine) {
+        std::unique_lock<std::mutex> locker(mutex_);
+        engine.pid = getpid();
+        engine.connection_name = ":1." + std::to_string(++launched_);
+        engine.libraries_settled = settled_;
+        launching_ = true;
+        cv_.notify_all();
+        cv_.wait(locker, [this]() { return !hold_; });
+        launching_ = false;
+        return true;
+    }
+
+    void Destroy(int) { destroyed_++; }
+    bool Alive(int) { return !dead_; }
+
+    void Settle() { std::lock_guard<std::mutex> locker(mutex_); settled_ = true; }
+    void Hold(bool hold) {
+        {
+            std::lock_guard<std::mutex> locker(mutex_);
+            hold_ = hold;
+        }
+        cv_.notify_all();
+    }
+    void WaitLaunching() {
+        std::unique_lock<std::mutex> locker(mutex_);
+        cv_.wait(locker, [this]() { return launching_; });
+    }
+
+    std::atomic<int> destroyed_{0};
+    std::atomic<bool> dead_{false};
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int launched_ = 0;
+    bool settled_ = false;
+    bool hold_ = false;
+    bool launching_ = false;
+};
+
+static bool WaitSize(PlayerEnginePool& pool, uint32_t size) {
+    for (int i = 0; i < 200; i++) {
+        if (pool.Size() == size)
+            return true;
+        usleep(10 * 1000);
+    }
+    return false;
+}
+
+static bool IsStale(const PlayerEnginePool::Engine& engine) {
+    return !engine.libraries_settled;
+}
+
+static void TestRecycleStale() {
+    FakeLauncher launcher;
+    PlayerEnginePool pool([&launcher](PlayerEnginePool::Engine& e) { return launcher.Launch(e); },
+                          [&launcher](int pid) { launcher.Destroy(pid); },
+                          [&launcher](int pid) { return launcher.Alive(pid); }, 1);
+    pool.Start();
+    CHECK(WaitSize(pool, 1));
+    CHECK(pool.Contains(":1.1"));
+
+    // launched before settled, relaunched
+    launcher.Settle();
+    pool.Recycle(IsStale);
+    CHECK(launcher.destroyed_ == 1);
+    CHECK(WaitSize(pool, 1));
+    CHECK(pool.Contains(":1.2"));
+
+    // launched after settled, kept
+    pool.Recycle(IsStale);
+    CHECK(launcher.destroyed_ == 1);
+    CHECK(pool.Contains(":1.2"));
+}
+
+static void TestRecycleWhileLaunching() {
+    FakeLauncher launcher;
+    PlayerEnginePool pool([&launcher](PlayerEnginePool::Engine& e) { return launcher.Launch(e); },
+                          [&launcher](int pid) { launcher.Destroy(pid); },
+                          [&launcher](int pid) { return launcher.Alive(pid); }, 1);
+    launcher.Hold(true);
+    pool.Start();
+    launcher.WaitLaunching();
+
+    // the pool is empty at Recycle(), the engine launching now joins it later
+    launcher.Settle();
+    pool.Recycle(IsStale);
+    CHECK(launcher.destroyed_ == 0);
+    launcher.Hold(false);
+
+    CHECK(WaitSize(pool, 1));
+    CHECK(!pool.Contains(":1.1"));
+    CHECK(pool.Contains(":1.2"));
+    CHECK(launcher.destroyed_ == 1);
+}
+
+static void TestTakeDiscardsDead() {
+    FakeLauncher launcher;
+    PlayerEnginePool pool([&launcher](PlayerEnginePool::Engine& e) { return launcher.Launch(e); },
+                          [&launcher](int pid) { launcher.Destroy(pid); },
+                          [&launcher](int pid) { return launcher.Alive(pid); }, 1);
+    pool.Start();
+    CHECK(WaitSize(pool, 1));
+
+    // the monitor already saw the exit, the pool launches instead
+    launcher.dead_ = true;
+    PlayerEnginePool::Engine engine{0, "", true, 0};
+    CHECK(!pool.Take(engine));
+
+    launcher.dead_ = false;
+    CHECK(WaitSize(pool, 1));
+    CHECK(pool.Take(engine));
+    CHECK(engine.connection_name == ":1.2");
+}
+
+int main() {
+    TestRecycleStale();
+    TestRecycleWhileLaunching();
+    TestTakeDiscardsDead();
+
+    return TestResult("playerengine_pool_test");
+}
@@ -0,0 +1,369 @@
+#include "playerengine_ready.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib-unix.h>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+
+bool NotifyPlayerEngineReady(const char* unique_name) {
+    const char* env = getenv(PLAYERENGINE_READY_FD_ENV);
+    if (env == nullptr || unique_name == nullptr)
+        return false;
+
+    int fd = atoi(env);
+    unsetenv(PLAYERENGINE_READY_FD_ENV);
+    if (fd <= STDERR_FILENO)
+        return false;
+
+    std::string msg(unique_name);
+    msg.push_back('\n');
+    ssize_t sz = TEMP_FAILURE_RETRY(write(fd, msg.c_str(), msg.size()));
+    close(fd);
+
+    return (sz == (ssize_t)msg.size());
+}
+
+PlayerEngineReadyWatcher::PlayerEngineReadyWatcher(GMainContext* context, const char* bus_name)
+  : context_(context ? context : g_main_context_default()),
+    bus_name_(bus_name ? bus_name : ""),
+    bus_(nullptr),
+    subscription_(0),
+    cancellable_(g_cancellable_new()),
+    bus_source_(nullptr),
+    mutex_(),
+    pending_(),
+    reported_() {
+    g_main_context_ref(context_);
+}
+
+PlayerEngineReadyWatcher::~PlayerEngineReadyWatcher() {
+    std::map<int, Completion> completions;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        for (auto& it : pending_) {
+            if (it.second->completion)
+                completions[it.first].swap(it.second->completion);
+            release(it.second);
+        }
+        pending_.clear();
+        if (bus_source_) {
+            g_source_destroy(bus_source_);
+            g_source_unref(bus_source_);
+            bus_source_ = nullptr;
+        }
+    }
+    // a launcher waiting for one of them is not left behind
+    for (auto& it : completions)
+        it.second(it.first, Result::Closed, std::string());
+
+    // replies still in flight see the cancellation and do not touch the watcher
+    g_cancellable_cancel(cancellable_);
+    g_object_unref(cancellable_);
+    if (bus_) {
+        if (subscription_)
+            g_dbus_connection_signal_unsubscribe(bus_, subscription_);
+        g_object_unref(bus_);
+    }
+    g_main_context_unref(context_);
+}
+
+bool PlayerEngineReadyWatcher::Prepare(int fds[2]) {
+    // both ends are close-on-exec, the launcher duplicates the child end to PLAYERENGINE_READY_CHILD_FD
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        MMLogError("error creating POSIX pipe for PlayerEngine handshake: %s", strerror(errno));
+        fds[0] = fds[1] = -1;
+        return false;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+void PlayerEngineReadyWatcher::Watch(int pid, int fds[2], uint32_t timeout_ms, Completion done) {
+    if (fds[1] >= 0)
+        close(fds[1]);
+    fds[1] = -1;
+
+    Pending* pending = new Pending{fds[0], nullptr, nullptr, g_get_monotonic_time(), false, "", done};
+    if (pending->fd >= 0) {
+        pending->source = g_unix_fd_source_new(pending->fd, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR));
+        g_source_set_callback(pending->source, (GSourceFunc)onReadable, new Context{this, pid},
+                              [](gpointer data) { delete static_cast<Context*>(data); });
+    }
+    pending->timeout_source = g_timeout_source_new(timeout_ms);
+    g_source_set_callback(pending->timeout_source, onTimeout, new Context{this, pid},
+                          [](gpointer data) { delete static_cast<Context*>(data); });
+
+    Completion replaced;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        auto it = pending_.find(pid);
+        if (it != pending_.end()) {
+            replaced.swap(it->second->completion);
+            release(it->second);
+            pending_.erase(it);
+        }
+        pending_[pid] = pending;
+        if (pending->source)
+            g_source_attach(pending->source, context_);
+        g_source_attach(pending->timeout_source, context_);
+
+        // the owner of the bus name is asked once for engines which owned it before the subscription
+        if (!bus_name_.empty() && bus_source_ == nullptr) {
+            bus_source_ = g_timeout_source_new(0);
+            g_source_set_callback(bus_source_, onWatchBus, this, nullptr);
+            g_source_attach(bus_source_, context_);
+        }
+    }
+    if (replaced)
+        replaced(pid, Result::Closed, std::string());
+}
+
+gboolean PlayerEngineReadyWatcher::onReadable(gint fd, GIOCondition condition, gpointer user_data) {
+    Context* ctx = static_cast<Context*>(user_data);
+    PlayerEngineReadyWatcher* self = ctx->self;
+    char buf[PLAYERENGINE_READY_NAME_MAX];
+    bool finished = false;
+
+    std::unique_lock<std::mutex> locker(self->mutex_);
+    auto it = self->pending_.find(ctx->pid);
+    if (it == self->pending_.end())
+        return FALSE;
+    Pending* pending = it->second;
+
+    while (1) {
+        ssize_t sz = read(fd, buf, sizeof(buf));
+        if (sz > 0) {
+            pending->name.append(buf, sz);
+            size_t pos = pending->name.find('\n');
+            if (pos != std::string::npos) {
+                pending->name.resize(pos);
+                finished = true;
+                break;
+            }
+            if (pending->name.size() >= PLAYERENGINE_READY_NAME_MAX) {
+                MMLogError("PlayerEngine[%d] reported too long name", ctx->pid);
+                pending->name.clear();
+                finished = true;
+                break;
+            }
+        } else if (sz == -1 && (errno == EAGAIN || errno == EINTR)) {
+            break;
+        } else { // EOF or error before new line, PlayerEngine exited or closed the pipe
+            pending->name.clear();
+            finished = true;
+            break;
+        }
+    }
+
+    if (!finished)
+        return TRUE;
+
+    std::string name = pending->name;
+    bool done = pending->done;
+    close(pending->fd);
+    pending->fd = -1;
+    g_source_unref(pending->source);
+    pending->source = nullptr;
+    if (name.empty()) {
+        MMLogWarn("PlayerEngine[%d] closed handshake without name", ctx->pid);
+        // only the bus can tell the readiness now
+        bool closed = self->bus_name_.empty();
+        locker.unlock();
+        if (!done && closed)
+            self->complete(ctx->pid, Result::Closed, name);
+        return FALSE;
+    }
+
+    // a late report after the bus is still recorded for IsReported()
+    self->reported_[name] = ctx->pid;
+    locker.unlock();
+    self->complete(ctx->pid, Result::Reported, name);
+    return FALSE;
+}
+
+gboolean PlayerEngineReadyWatcher::onTimeout(gpointer user_data) {
+    Context* ctx = static_cast<Context*>(user_data);
+
+    MMLogWarn("PlayerEngine[%d] is not ready in time", ctx->pid);
+    ctx->self->complete(ctx->pid, Result::Timeout, std::string());
+    return FALSE;
+}
+
+gboolean PlayerEngineReadyWatcher::onWatchBus(gpointer user_data) {
+    PlayerEngineReadyWatcher* self = static_cast<PlayerEngineReadyWatcher*>(user_data);
+    {
+        std::lock_guard<std::mutex> locker(self->mutex_);
+        g_source_unref(self->bus_source_);
+        self->bus_source_ = nullptr;
+    }
+
+    if (self->bus_ == nullptr) {
+        GError* error = NULL;
+        self->bus_ = g_bus_get_sync(G_BUS_TYPE_SESSION, self->cancellable_, &error);
+        if (self->bus_ == nullptr) {
+            MMLogError("no session bus to watch %s: %s", self->bus_name_.c_str(), error ? error->message : "");
+            if (error)
+                g_error_free(error);
+            return FALSE;
+        }
+
+        // the signal is dispatched on the thread-default context of the subscriber
+        g_main_context_push_thread_default(self->context_);
+        self->subscription_ = g_dbus_connection_signal_subscribe(self->bus_, "org.freedesktop.DBus",
+                                  "org.freedesktop.DBus", "NameOwnerChanged", "/org/freedesktop/DBus",
+                                  self->bus_name_.c_str(), G_DBUS_SIGNAL_FLAGS_NONE, onNameOwnerChanged, self, nullptr);
+        g_main_context_pop_thread_default(self->context_);
+    }
+
+    g_main_context_push_thread_default(self->context_);
+    g_dbus_connection_call(self->bus_, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                           "GetNameOwner", g_variant_new("(s)", self->bus_name_.c_str()), G_VARIANT_TYPE("(s)"),
+                           G_DBUS_CALL_FLAGS_NONE, -1, self->cancellable_, onNameOwner, self);
+    g_main_context_pop_thread_default(self->context_);
+    return FALSE;
+}
+
+void PlayerEngineReadyWatcher::onNameOwnerChanged(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                                  const gchar* interface, const gchar* signal, GVariant* parameters,
+                                                  gpointer user_data) {
+    PlayerEngineReadyWatcher* self = static_cast<PlayerEngineReadyWatcher*>(user_data);
+    const gchar* name = nullptr;
+    const gchar* old_owner = nullptr;
+    const gchar* new_owner = nullptr;
+
+    g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+    if (new_owner && new_owner[0] != '\0')
+        self->queryOwnerPid(new_owner);
+}
+
+void PlayerEngineReadyWatcher::onNameOwner(GObject* source, GAsyncResult* res, gpointer user_data) {
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+    if (reply == nullptr) {
+        // not owned yet, NameOwnerChanged follows. cancelled when the watcher is gone
+        if (error)
+            g_error_free(error);
+        return;
+    }
+
+    const gchar* owner = nullptr;
+    g_variant_get(reply, "(&s)", &owner);
+    static_cast<PlayerEngineReadyWatcher*>(user_data)->queryOwnerPid(owner);
+    g_variant_unref(reply);
+}
+
+// the owner is matched to a launched engine by pid, not by guessing which name is new
+void PlayerEngineReadyWatcher::queryOwnerPid(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        bool waiting = false;
+        for (auto& it : pending_)
+            waiting = waiting || !it.second->done;
+        if (!waiting)
+            return;
+    }
+
+    g_main_context_push_thread_default(context_);
+    g_dbus_connection_call(bus_, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                           "GetConnectionUnixProcessID", g_variant_new("(s)", name.c_str()), G_VARIANT_TYPE("(u)"),
+                           G_DBUS_CALL_FLAGS_NONE, -1, cancellable_, onOwnerPid, new OwnerQuery{this, name});
+    g_main_context_pop_thread_default(context_);
+}
+
+void PlayerEngineReadyWatcher::onOwnerPid(GObject* source, GAsyncResult* res, gpointer user_data) {
+    OwnerQuery* query = static_cast<OwnerQuery*>(user_data);
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+    if (reply == nullptr) {
+        if (error && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            MMLogWarn("no pid of [%s]: %s", query->name.c_str(), error->message);
+        if (error)
+            g_error_free(error);
+        delete query;
+        return;
+    }
+
+    guint32 pid = 0;
+    g_variant_get(reply, "(u)", &pid);
+    g_variant_unref(reply);
+    query->self->complete((int)pid, Result::Reported, query->name);
+    delete query;
+}
+
+void PlayerEngineReadyWatcher::complete(int pid, Result result, const std::string& name) {
+    std::unique_lock<std::mutex> locker(mutex_);
+    auto it = pending_.find(pid);
+    if (it == pending_.end() || it->second->done)
+        return;
+
+    Pending* pending = it->second;
+    pending->done = true;
+    if (pending->timeout_source) {
+        g_source_destroy(pending->timeout_source);
+        g_source_unref(pending->timeout_source);
+        pending->timeout_source = nullptr;
+    }
+    if (result == Result::Reported) {
+        reported_[name] = pid;
+        MMLogInfo("PlayerEngine[%d] is ready as [%s], spawn-to-ready=[%lld]us",
+                  pid, name.c_str(), (long long)(g_get_monotonic_time() - pending->spawn_time));
+    }
+    Completion completion;
+    completion.swap(pending->completion);
+    locker.unlock();
+
+    if (completion)
+        completion(pid, result, name);
+}
+
+void PlayerEngineReadyWatcher::Cancel(int pid) {
+    Completion completion;
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+
+        auto it = pending_.find(pid);
+        if (it != pending_.end()) {
+            completion.swap(it->second->completion);
+            release(it->second);
+            pending_.erase(it);
+        }
+        for (auto r = reported_.begin(); r != reported_.end(); ) {
+            if (r->second == pid)
+                r = reported_.erase(r);
+            else
+                r++;
+        }
+    }
+    if (completion)
+        completion(pid, Result::Closed, std::string());
+}
+
+bool PlayerEngineReadyWatcher::IsReported(const std::string& connection_name) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    // Cancel() drops the name when the engine is destroyed or its exit is seen
+    return (reported_.find(connection_name) != reported_.end());
+}
+
+void PlayerEngineReadyWatcher::release(Pending* pending) {
+    if (pending->source) {
+        g_source_destroy(pending->source);
+        g_source_unref(pending->source);
+    }
+    if (pending->timeout_source) {
+        g_source_destroy(pending->timeout_source);
+        g_source_unref(pending->timeout_source);
+    }
+    if (pending->fd >= 0)
+        close(pending->fd);
+    delete pending;
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,154 @@
+/**
+* @file playerengine_ready.h
+* @version 1.0
+* Header for the readiness handshake between PlayerEngineManager and PlayerEngine
+*/
+
+#ifndef PLAYERENGINE_READY_H_
+#define PLAYERENGINE_READY_H_
+
+#include <stdint.h>
+#include <gio/gio.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace lge {
+namespace mm {
+
+#define PLAYERENGINE_READY_FD_ENV     "PLAYERENGINE_READY_FD"
+#define PLAYERENGINE_READY_TIMEOUT_MS 4000
+#define PLAYERENGINE_READY_NAME_MAX   256
+#define PLAYERENGINE_BUS_NAME         "com.lge.PlayerEngine"
+
+/**
+* @fn NotifyPlayerEngineReady
+* @brief Used by PlayerEngine. Reports its unique bus name to the launcher.
+* @section function Function Flow
+* - Gets inherited fd from PLAYERENGINE_READY_FD environment variable.
+* - Writes unique name terminated by new line and closes the fd.
+*
+* @param[in] unique_name : unique name of the bus connection which owns com.lge.PlayerEngine
+* @return bool (true - reported, false - not launched with handshake)
+*/
+bool NotifyPlayerEngineReady(const char* unique_name);
+
+/**
+* @class lge::mm::PlayerEngineReadyWatcher
+* @brief Completes the readiness of launched PlayerEngine processes on a GMainContext.
+* @details A PlayerEngine is ready when it reports its unique name over the inherited pipe,<BR>
+*          or when the bus tells that a connection of its pid became the owner of the bus<BR>
+*          name (NameOwnerChanged), for an engine which does not report. Both are watched<BR>
+*          from the given GMainContext, nothing polls.
+* @see PlayerEngineManager
+*/
+class PlayerEngineReadyWatcher {
+public:
+    enum class Result : uint8_t {
+      Reported, /**< unique bus name is reported or owned */
+      Timeout,  /**< not ready within the timeout of Watch() */
+      Closed    /**< cancelled, or the pipe closed without name and the bus is not watched */
+    };
+
+    /**
+    * Called once per Watch(), on the context of the watcher. Cancel() calls it on its caller.
+    */
+    typedef std::function<void(int pid, Result result, const std::string& connection_name)> Completion;
+
+    /**
+    * @fn PlayerEngineReadyWatcher
+    * @brief Constructor.
+    * @param[in] context : context which completes the readiness, nullptr for the default one
+    * @param[in] bus_name : well-known name owned by a ready PlayerEngine, nullptr for the pipe only
+    * @return : None
+    */
+    explicit PlayerEngineReadyWatcher(GMainContext* context = nullptr, const char* bus_name = PLAYERENGINE_BUS_NAME);
+    ~PlayerEngineReadyWatcher();
+
+    /**
+    * @fn Prepare
+    * @brief Creates a pipe for a PlayerEngine to be launched. Must be called before launch.
+    * @param[out] fds : fds[0] is kept by manager, fds[1] is inherited by PlayerEngine.
+    * @return bool (true - SUCCESS, false - FAIL)
+    */
+    bool Prepare(int fds[2]);
+
+    /**
+    * @fn Watch
+    * @brief Closes the child side and watches the readiness of the launched PlayerEngine.
+    * @details The pipe is kept after completion until Cancel(), so a late report of an<BR>
+    *          engine found on the bus first never writes to a closed pipe.
+    * @param[in] pid : pid of the launched PlayerEngine
+    * @param[in] fds : fds returned by Prepare(), {-1, -1} when it failed
+    * @param[in] timeout_ms : time until it completes as Timeout
+    * @param[in] done : completion, may be nullptr
+    * @return : None
+    */
+    void Watch(int pid, int fds[2], uint32_t timeout_ms, Completion done);
+
+    /**
+    * @fn Cancel
+    * @brief Stops watching the PlayerEngine, e.g. when it is destroyed or has exited.
+    *        A watch which is not completed yet completes as Closed.
+    * @param[in] pid : pid of the launched PlayerEngine
+    * @return : None
+    */
+    void Cancel(int pid);
+
+    /**
+    * @fn IsReported
+    * @brief Checks the connection name was reported by a PlayerEngine which is not cancelled.
+    * @param[in] connection_name : connection name to check
+    * @return bool
+    */
+    bool IsReported(const std::string& connection_name);
+
+private:
+    struct Pending {
+        int fd;
+        GSource* source;          // pipe
+        GSource* timeout_source;
+        gint64 spawn_time;
+        bool done;
+        std::string name;
+        Completion completion;
+    };
+
+    struct Context {
+        PlayerEngineReadyWatcher* self;
+        int pid;
+    };
+
+    struct OwnerQuery {
+        PlayerEngineReadyWatcher* self;
+        std::string name;
+    };
+
+    static gboolean onReadable(gint fd, GIOCondition condition, gpointer user_data);
+    static gboolean onTimeout(gpointer user_data);
+    static gboolean onWatchBus(gpointer user_data);
+    static void onNameOwnerChanged(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                   const gchar* interface, const gchar* signal, GVariant* parameters,
+                                   gpointer user_data);
+    static void onNameOwner(GObject* source, GAsyncResult* res, gpointer user_data);
+    static void onOwnerPid(GObject* source, GAsyncResult* res, gpointer user_data);
+    void queryOwnerPid(const std::string& name);
+    void complete(int pid, Result result, const std::string& name);
+    void release(Pending* pending);
+
+    GMainContext* context_;
+    std::string bus_name_;
+    GDBusConnection* bus_;        // used on context_ only
+    guint subscription_;
+    GCancellable* cancellable_;
+    GSource* bus_source_;         // asks the owner of the bus name, guarded by mutex_
+    std::mutex mutex_;
+    std::map<int, Pending*> pending_;
+    std::map<std::string, int> reported_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // PLAYERENGINE_READY_H_
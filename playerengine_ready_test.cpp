@@ -0,0 +1,163 @@
+/**
+* @file playerengine_ready_test.cpp
+* @version 1.0
+* Test of PlayerEngineReadyWatcher.
+*
+* A duplicated write end of the handshake pipe stands for the launched PlayerEngine, the
+* bus is not watched. The readiness completes once on a GMainLoop thread: Reported by the
+* report, Timeout when none comes in time, and Closed when the pipe closes without name or
+* the watch is cancelled. A late report after Timeout is still recorded.
+*
+* build : g++ -std=c++11 -pthread -I. playerengine_ready_test.cpp playerengine_ready.cpp $(pkg-config --cflags --libs gio-2.0) -o playerengine_ready_test
+* usage : playerengine_ready_test
+*/
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "playerengine_ready.h"
+#include "test_check.h"
+
+using lge::mm::PlayerEngineReadyWatcher;
+typedef PlayerEngineReadyWatcher::Result Result;
+
+// what the launcher gets from the completion
+struct Readiness {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int count = 0;
+    Result result = Result::Closed;
+    std::string name;
+    std::thread::id thread;
+
+    PlayerEngineReadyWatcher::Completion Completion() {
+        return [this](int, Result r, const std::string& n) {
+            std::lock_guard<std::mutex> locker(mutex);
+            count++;
+            result = r;
+            name = n;
+            thread = std::this_thread::get_id();
+            cv.notify_all();
+        };
+    }
+
+    bool WaitDone(uint32_t timeout_ms) {
+        std::unique_lock<std::mutex> locker(mutex);
+        return cv.wait_for(locker, std::chrono::milliseconds(timeout_ms), [this]() { return count > 0; });
+    }
+};
+
+// returns the end written by the PlayerEngine
+static int Launch(PlayerEngineReadyWatcher& watcher, int pid, uint32_t timeout_ms, Readiness& readiness) {
+    int fds[2];
+    if (!watcher.Prepare(fds))
+        return -1;
+    int child = dup(fds[1]);
+    watcher.Watch(pid, fds, timeout_ms, readiness.Completion());
+    return child;
+}
+
+// fails with EPIPE once the watch is cancelled, as for a destroyed engine
+static bool Report(int fd, const char* name) {
+    std::string msg = std::string(name) + "\n";
+    bool written = write(fd, msg.c_str(), msg.size()) == (ssize_t)msg.size();
+    close(fd);
+    return written;
+}
+
+static void TestReported(PlayerEngineReadyWatcher& watcher) {
+    int pid = getpid();
+    Readiness readiness;
+    int fd = Launch(watcher, pid, 2000, readiness);
+    CHECK(fd >= 0);
+
+    usleep(20 * 1000);
+    CHECK(readiness.count == 0);
+    CHECK(Report(fd, ":1.42"));
+    CHECK(readiness.WaitDone(2000));
+    CHECK(readiness.result == Result::Reported);
+    CHECK(readiness.name == ":1.42");
+    // finished from the main context, not from the launching thread
+    CHECK(readiness.thread != std::this_thread::get_id());
+    CHECK(watcher.IsReported(":1.42"));
+
+    watcher.Cancel(pid);
+    CHECK(readiness.count == 1);
+    CHECK(!watcher.IsReported(":1.42"));
+}
+
+static void TestTimeoutKeepsPipe(PlayerEngineReadyWatcher& watcher) {
+    int pid = getpid() + 1;
+    Readiness readiness;
+    int fd = Launch(watcher, pid, 30, readiness);
+
+    CHECK(readiness.WaitDone(2000));
+    CHECK(readiness.result == Result::Timeout);
+    CHECK(readiness.name.empty());
+
+    // a late report is recorded, the completion is not called again
+    CHECK(Report(fd, ":1.43"));
+    for (int i = 0; i < 200 && !watcher.IsReported(":1.43"); i++)
+        usleep(10 * 1000);
+    CHECK(watcher.IsReported(":1.43"));
+    CHECK(readiness.count == 1);
+    watcher.Cancel(pid);
+    CHECK(!watcher.IsReported(":1.43"));
+}
+
+static void TestClosed(PlayerEngineReadyWatcher& watcher) {
+    int pid = getpid() + 2;
+    Readiness readiness;
+    int fd = Launch(watcher, pid, 2000, readiness);
+
+    // an engine exits or closes the inherited end, nothing else can tell the readiness
+    close(fd);
+    CHECK(readiness.WaitDone(2000));
+    CHECK(readiness.result == Result::Closed);
+    CHECK(readiness.name.empty());
+    watcher.Cancel(pid);
+    CHECK(readiness.count == 1);
+}
+
+static void TestCancel(PlayerEngineReadyWatcher& watcher) {
+    int pid = getpid() + 3;
+    Readiness readiness;
+    int fd = Launch(watcher, pid, 2000, readiness);
+
+    // destroyed while launching, the launcher is completed at once
+    watcher.Cancel(pid);
+    CHECK(readiness.count == 1);
+    CHECK(readiness.result == Result::Closed);
+    CHECK(readiness.thread == std::this_thread::get_id());
+
+    CHECK(!Report(fd, ":1.45"));
+    usleep(50 * 1000);
+    CHECK(readiness.count == 1);
+    CHECK(!watcher.IsReported(":1.45"));
+}
+
+int main() {
+    // a report after Cancel() writes to a closed pipe
+    signal(SIGPIPE, SIG_IGN);
+    GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+    std::thread loop_thread([loop]() { g_main_loop_run(loop); });
+    {
+        PlayerEngineReadyWatcher watcher(nullptr, nullptr);
+
+        TestReported(watcher);
+        TestTimeoutKeepsPipe(watcher);
+        TestClosed(watcher);
+        TestCancel(watcher);
+    }
+    g_main_loop_quit(loop);
+    loop_thread.join();
+    g_main_loop_unref(loop);
+
+    return TestResult("playerengine_ready_test");
+}
@@ -0,0 +1,253 @@
+#include "playerengine_signal.h"
+
+#include <string.h>
+#include <sstream>
+
+#include <boost/property_tree/json_parser.hpp>
+
+namespace lge {
+namespace mm {
+namespace player {
+
+namespace {
+
+struct SignalName {
+    const char* name;
+    size_t len;
+    PESignal type;
+};
+
+#define SIGNAL_NAME(n) { #n, sizeof(#n) - 1, PESignal::n }
+
+const SignalName kSignalNames[] = {
+    SIGNAL_NAME(CurrentTime),   // most frequent first
+    SIGNAL_NAME(Duration),
+    SIGNAL_NAME(PlaybackStatus),
+    SIGNAL_NAME(AsyncDone),
+    SIGNAL_NAME(StreamingEvent),
+    SIGNAL_NAME(BeginOfStream),
+    SIGNAL_NAME(EndOfStream),
+    SIGNAL_NAME(SourceInfo),
+    SIGNAL_NAME(Subtitle),
+    SIGNAL_NAME(ChannelInfo),
+    SIGNAL_NAME(AddressInfo),
+    SIGNAL_NAME(Warning),
+    SIGNAL_NAME(Error),
+    SIGNAL_NAME(ContentType),
+};
+
+#undef SIGNAL_NAME
+
+const char* SkipSpace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    return p;
+}
+
+// p is at the opening quote, returns the position after the closing one
+const char* SkipString(const char* p, const char* end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\')
+            p++;
+        else if (*p == '"')
+            return p + 1;
+    }
+    return nullptr;
+}
+
+// p is at '{' or '[', returns the position after the matching close
+const char* SkipNested(const char* p, const char* end) {
+    int depth = 0;
+    while (p < end) {
+        if (*p == '"') {
+            p = SkipString(p, end);
+            if (p == nullptr)
+                return nullptr;
+            continue;
+        }
+        if (*p == '{' || *p == '[') {
+            depth++;
+        } else if (*p == '}' || *p == ']') {
+            if (--depth == 0)
+                return p + 1;
+        }
+        p++;
+    }
+    return nullptr;
+}
+
+// integer part of a JSON number, the engine sends times as integers in ms
+bool ParseNumber(const char* p, size_t len, int64_t& out) {
+    const char* end = p + len;
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9')
+        return false;
+
+    int64_t value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+        value = value * 10 + (*p - '0');
+    if (p < end && *p != '.' && *p != 'e' && *p != 'E')
+        return false;
+
+    out = negative ? -value : value;
+    return true;
+}
+
+bool NumberFromVariant(GVariant* value, int64_t& out) {
+    switch (g_variant_classify(value)) {
+    case G_VARIANT_CLASS_INT64:  out = g_variant_get_int64(value); return true;
+    case G_VARIANT_CLASS_UINT64: out = (int64_t)g_variant_get_uint64(value); return true;
+    case G_VARIANT_CLASS_INT32:  out = g_variant_get_int32(value); return true;
+    case G_VARIANT_CLASS_UINT32: out = g_variant_get_uint32(value); return true;
+    case G_VARIANT_CLASS_DOUBLE: out = (int64_t)g_variant_get_double(value); return true;
+    default: return false;
+    }
+}
+
+} // namespace
+
+bool PESignalData::ParseBody(boost::property_tree::ptree& pt) const {
+    if (body == nullptr || body_len == 0)
+        return true;    // scalar or empty value, handlers find no child
+
+    try {
+        std::stringstream ss(std::string(body, body_len));
+        boost::property_tree::json_parser::read_json(ss, pt);
+    } catch (const boost::property_tree::ptree_error&) {
+        return false;
+    }
+    return true;
+}
+
+PESignal PESignalFromName(const char* name, size_t len) {
+    for (auto& entry : kSignalNames) {
+        if (entry.len == len && memcmp(entry.name, name, len) == 0)
+            return entry.type;
+    }
+    return PESignal::Unknown;
+}
+
+const char* PESignalName(PESignal type) {
+    for (auto& entry : kSignalNames) {
+        if (entry.type == type)
+            return entry.name;
+    }
+    return "";
+}
+
+std::string EncodePESignalJson(const PESignalData& signal) {
+    std::string json("{\"");
+    json += PESignalName(signal.type);
+    json += "\":";
+    if (signal.body != nullptr) {
+        json.append(signal.body, signal.body_len);
+    } else if (signal.has_number || signal.text == nullptr) {
+        json += std::to_string((long long)signal.number);
+    } else {
+        json += '"';
+        json.append(signal.text, signal.text_len);
+        json += '"';
+    }
+    json += '}';
+    return json;
+}
+
+bool DecodePESignalJson(const char* json, size_t len, PESignalData& out) {
+    if (json == nullptr)
+        return false;
+
+    const char* end = json + len;
+    const char* p = SkipSpace(json, end);
+    if (p == end || *p != '{')
+        return false;
+
+    p = SkipSpace(p + 1, end);
+    if (p == end || *p != '"')
+        return false;
+    const char* name = p + 1;
+    p = SkipString(p, end);
+    if (p == nullptr)
+        return false;
+    out.type = PESignalFromName(name, (size_t)(p - 1 - name));
+
+    p = SkipSpace(p, end);
+    if (p == end || *p != ':')
+        return false;
+    p = SkipSpace(p + 1, end);
+    if (p == end)
+        return false;
+
+    const char* value = p;
+    if (*p == '"') {
+        p = SkipString(p, end);
+        if (p == nullptr)
+            return false;
+        out.text = value + 1;
+        out.text_len = (size_t)(p - 1 - out.text);
+    } else if (*p == '{' || *p == '[') {
+        p = SkipNested(p, end);
+        if (p == nullptr)
+            return false;
+        out.body = value;
+        out.body_len = (size_t)(p - value);
+    } else {
+        while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\n')
+            p++;
+        out.text = value;
+        out.text_len = (size_t)(p - value);
+    }
+
+    // numbers may come quoted as well, read_json kept every value as a string
+    if (out.text != nullptr)
+        out.has_number = ParseNumber(out.text, out.text_len, out.number);
+    return true;
+}
+
+bool DecodePESignal(GVariant* parameters, PESignalData& out) {
+    out = PESignalData();
+    if (parameters == nullptr)
+        return false;
+
+    if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(s)"))) {
+        gsize len = 0;
+        GVariant* inner = g_variant_get_child_value(parameters, 0);
+        const gchar* json = g_variant_get_string(inner, &len);
+        // the string is owned by parameters, which outlives the decoded signal
+        g_variant_unref(inner);
+        return DecodePESignalJson(json, len, out);
+    }
+
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE("(sv)")))
+        return false;
+
+    gsize len = 0;
+    GVariant* name = g_variant_get_child_value(parameters, 0);
+    const gchar* name_str = g_variant_get_string(name, &len);
+    out.type = PESignalFromName(name_str, len);
+    g_variant_unref(name);
+
+    GVariant* boxed = g_variant_get_child_value(parameters, 1);
+    GVariant* value = g_variant_get_variant(boxed);
+    out.has_number = NumberFromVariant(value, out.number);
+    if (!out.has_number && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+        const gchar* text = g_variant_get_string(value, &len);
+        if (len > 0 && text[0] == '{') {
+            out.body = text;
+            out.body_len = len;
+        } else {
+            out.text = text;
+            out.text_len = len;
+        }
+    }
+    g_variant_unref(value);
+    g_variant_unref(boxed);
+    return true;
+}
+
+} // namespace player
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,119 @@
+/**
+* @file playerengine_signal.h
+* @version 1.0
+* Header for decoding StateChange signal of PlayerEngine
+*/
+
+#ifndef PLAYERENGINE_SIGNAL_H_
+#define PLAYERENGINE_SIGNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include <gio/gio.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace lge {
+namespace mm {
+namespace player {
+
+enum class PESignal : uint8_t {
+    Unknown = 0,
+    Duration,
+    CurrentTime,
+    PlaybackStatus,
+    BeginOfStream,
+    EndOfStream,
+    AsyncDone,
+    SourceInfo,
+    Subtitle,
+    ChannelInfo,
+    AddressInfo,
+    StreamingEvent,
+    Warning,
+    Error,
+    ContentType,
+};
+
+/**
+* @class lge::mm::player::PESignalData
+* @brief One decoded StateChange signal.
+* @details Text and body point into the signal parameters, valid until those are unreffed.
+*/
+struct PESignalData {
+    PESignal type;
+    bool has_number;
+    int64_t number;         // Duration, CurrentTime in ms
+    const char* text;       // PlaybackStatus, ContentType
+    size_t text_len;
+    const char* body;       // JSON object of SourceInfo, StreamingEvent, Warning, Error, ...
+    size_t body_len;
+
+    PESignalData() : type(PESignal::Unknown), has_number(false), number(0), text(nullptr), text_len(0), body(nullptr), body_len(0) {}
+
+    std::string Text() const { return std::string(text ? text : "", text_len); }
+
+    /**
+    * @fn ParseBody
+    * @brief Reads the JSON object body into pt, only signals having a structured value need it.
+    * @param[out] pt : boost::property_tree object
+    * @return bool (true - parsed)
+    */
+    bool ParseBody(boost::property_tree::ptree& pt) const;
+};
+
+/**
+* @fn PESignalFromName
+* @brief Gets PESignal of signal name.
+* @param[in] name : name, not null terminated
+* @param[in] len : length of name
+* @return PESignal (Unknown - not handled by PlayerProvider)
+*/
+PESignal PESignalFromName(const char* name, size_t len);
+
+/**
+* @fn PESignalName
+* @brief Gets name of PESignal.
+* @param[in] type : PESignal
+* @return const char* ("" - Unknown)
+*/
+const char* PESignalName(PESignal type);
+
+/**
+* @fn EncodePESignalJson
+* @brief Writes a decoded signal back as legacy {"Name": value} payload, for recording.
+* @param[in] signal : decoded signal
+* @return std::string
+*/
+std::string EncodePESignalJson(const PESignalData& signal);
+
+/**
+* @fn DecodePESignalJson
+* @brief Decodes a legacy {"Name": value} payload in one pass without building a tree.
+* @param[in] json : payload
+* @param[in] len : length of payload
+* @param[out] out : decoded signal
+* @return bool (true - decoded)
+*/
+bool DecodePESignalJson(const char* json, size_t len, PESignalData& out);
+
+/**
+* @fn DecodePESignal
+* @brief Decodes parameters of StateChange signal.
+* @details Two schemas are accepted.<BR>
+*          (sv) : name and typed value - x for Duration and CurrentTime, s for PlaybackStatus and
+*                 ContentType, s with a JSON object for the structured ones, anything for the others.<BR>
+*          (s)  : legacy JSON {"Name": value}, decoded by DecodePESignalJson().
+* @param[in] parameters : signal parameters
+* @param[out] out : decoded signal
+* @return bool (true - decoded)
+*/
+bool DecodePESignal(GVariant* parameters, PESignalData& out);
+
+} // namespace player
+} // namespace mm
+} // namespace lge
+
+#endif  // PLAYERENGINE_SIGNAL_H_
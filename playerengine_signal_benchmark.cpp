@@ -0,0 +1,190 @@
+/**
+* @file playerengine_signal_benchmark.cpp
+* @version 1.0
+* Benchmark of StateChange signal decoding, boost::property_tree against DecodePESignal().
+*
+* Signals are a mix like a playing track produces, mostly CurrentTime. Each is kept in
+* serialized form as it arrives from D-Bus, and decoded down to the value a handler uses.
+*   ptree : read_json into a tree and find the handler by name, as handleStateChange did
+*   json  : DecodePESignal() on the legacy (s) payload
+*   typed : DecodePESignal() on the (sv) payload
+*
+* build : g++ -O2 -std=c++11 -I. playerengine_signal_benchmark.cpp playerengine_signal.cpp
+*         $(pkg-config --cflags --libs gio-2.0) -o pe_signal_bench
+* usage : pe_signal_bench [ptree|json|typed|all] [signals=1000000] [rounds=5]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "playerengine_signal.h"
+
+using boost::property_tree::ptree;
+using lge::mm::player::DecodePESignal;
+using lge::mm::player::PESignal;
+using lge::mm::player::PESignalData;
+
+static std::atomic<unsigned long long> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+struct Sample {
+    const char* name;
+    std::string json;
+    GVariant* typed_value;
+};
+
+static std::vector<Sample> MakeSamples(size_t n) {
+    std::vector<Sample> samples;
+    samples.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        unsigned seed = (unsigned)(i % 100);
+        if (seed < 90) {
+            long long ms = (long long)i * 100;
+            samples.push_back({ "CurrentTime", "{\"CurrentTime\":" + std::to_string(ms) + "}",
+                                g_variant_new_int64(ms) });
+        } else if (seed < 95) {
+            samples.push_back({ "PlaybackStatus", "{\"PlaybackStatus\":\"Playing\"}",
+                                g_variant_new_string("Playing") });
+        } else if (seed < 98) {
+            samples.push_back({ "StreamingEvent", "{\"StreamingEvent\":{\"BUFFERING\":\"40\"}}",
+                                g_variant_new_string("{\"BUFFERING\":\"40\"}") });
+        } else {
+            samples.push_back({ "Duration", "{\"Duration\":245000}", g_variant_new_int64(245000) });
+        }
+    }
+    return samples;
+}
+
+// the wire form, like parameters of a received GDBusMessage
+static GVariant* Serialized(GVariant* value) {
+    GVariant* normal = g_variant_get_normal_form(value);
+    g_variant_unref(value);
+    return normal;
+}
+
+static int64_t DecodePtree(GVariant* parameters) {
+    static std::map<std::string, int> handler = {
+        { "Duration", 1 }, { "CurrentTime", 2 }, { "PlaybackStatus", 3 }, { "StreamingEvent", 4 },
+    };
+
+    GVariant* inner = g_variant_get_child_value(parameters, 0);
+    ptree pt;
+    std::string s(g_variant_get_string(inner, NULL));
+    std::stringstream ss(s);
+    boost::property_tree::json_parser::read_json(ss, pt);
+    g_variant_unref(inner);
+
+    auto iter = pt.begin();
+    auto it = handler.find(iter->first);
+    if (it == handler.end())
+        return 0;
+
+    const ptree& sub_pt = iter->second;
+    switch (it->second) {
+    case 1:
+    case 2:
+        return sub_pt.get_value_optional<int64_t>().value_or(0);
+    case 3:
+        return (int64_t)sub_pt.get_value<std::string>().size();
+    default:
+        return sub_pt.get_optional<int>("BUFFERING").value_or(0);
+    }
+}
+
+static int64_t DecodeFast(GVariant* parameters) {
+    PESignalData signal;
+    if (!DecodePESignal(parameters, signal))
+        return 0;
+
+    switch (signal.type) {
+    case PESignal::Duration:
+    case PESignal::CurrentTime:
+        return signal.number;
+    case PESignal::PlaybackStatus:
+        return (int64_t)signal.text_len;
+    case PESignal::StreamingEvent: {
+        ptree pt;
+        signal.ParseBody(pt);
+        return pt.get_optional<int>("BUFFERING").value_or(0);
+    }
+    default:
+        return 0;
+    }
+}
+
+static void Run(const std::string& mode, const std::vector<GVariant*>& signals, int rounds) {
+    int64_t (*decode)(GVariant*) = (mode == "ptree") ? DecodePtree : DecodeFast;
+
+    for (int r = 0; r < rounds; r++) {
+        int64_t sum = 0;
+        unsigned long long allocations = g_allocations;
+        auto begin = std::chrono::steady_clock::now();
+        for (GVariant* parameters : signals)
+            sum += decode(parameters);
+        auto end = std::chrono::steady_clock::now();
+        allocations = g_allocations - allocations;
+
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        printf("%6s %6d %12.1f %12.1f %14.2f %16lld\n", mode.c_str(), r, ms, ms * 1e6 / signals.size(),
+               (double)allocations / signals.size(), (long long)sum);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string mode = (argc > 1) ? argv[1] : "all";
+    size_t count = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000000;
+    int rounds = (argc > 3) ? atoi(argv[3]) : 5;
+
+    if (mode != "ptree" && mode != "json" && mode != "typed" && mode != "all") {
+        fprintf(stderr, "usage: %s [ptree|json|typed|all] [signals] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Sample> samples = MakeSamples(count);
+    std::vector<GVariant*> legacy;
+    std::vector<GVariant*> typed;
+    legacy.reserve(count);
+    typed.reserve(count);
+    for (auto& sample : samples) {
+        legacy.push_back(Serialized(g_variant_ref_sink(g_variant_new("(s)", sample.json.c_str()))));
+        typed.push_back(Serialized(g_variant_ref_sink(g_variant_new("(sv)", sample.name, sample.typed_value))));
+    }
+
+    printf("signals=%zu\n", count);
+    printf("%6s %6s %12s %12s %14s %16s\n", "mode", "round", "time(ms)", "ns/signal", "allocs/signal", "checksum");
+
+    if (mode == "ptree" || mode == "all")
+        Run("ptree", legacy, rounds);
+    if (mode == "json" || mode == "all")
+        Run("json", legacy, rounds);
+    if (mode == "typed" || mode == "all")
+        Run("typed", typed, rounds);
+
+    for (GVariant* parameters : legacy)
+        g_variant_unref(parameters);
+    for (GVariant* parameters : typed)
+        g_variant_unref(parameters);
+    return 0;
+}
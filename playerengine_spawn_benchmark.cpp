@@ -0,0 +1,134 @@
+/**
+* @file playerengine_spawn_benchmark.cpp
+* @version 1.0
+* Micro-benchmark of PlayerEngine launch cost against RSS of the parent process.
+*
+* Compares fork()+execve() which was used by PlayerEngineManager with posix_spawn()
+* used by LaunchPlayerEngineProcess(). The parent touches memory step by step and
+* keeps worker threads running like media manager does.
+*
+* build : g++ -O2 -std=c++11 -pthread playerengine_spawn_benchmark.cpp -o pe_spawn_bench
+* usage : pe_spawn_bench [binary=/bin/true] [iterations=50] [max_rss_mb=1024]
+*/
+
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern char **environ;
+
+static const size_t kMB = 1024 * 1024;
+
+static pid_t LaunchFork(const char* path, char* const argv[]) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        execve(path, argv, environ);
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t LaunchSpawn(const char* path, char* const argv[]) {
+    pid_t pid = -1;
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    short flags = POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+    if (posix_spawn(&pid, path, NULL, &attr, argv, environ) != 0)
+        pid = -1;
+    posix_spawnattr_destroy(&attr);
+    return pid;
+}
+
+// time until launch call returns in the parent, which is what media manager threads pay
+static double Measure(pid_t (*launch)(const char*, char* const[]), const char* path, int iterations) {
+    char* argv[] = { const_cast<char*>(path), NULL };
+    std::vector<double> samples;
+
+    for (int i = 0; i < iterations; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        pid_t pid = launch(path, argv);
+        auto end = std::chrono::steady_clock::now();
+        if (pid <= 0) {
+            fprintf(stderr, "launch failed: %s\n", strerror(errno));
+            return -1;
+        }
+        waitpid(pid, NULL, 0);
+        samples.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+static long CurrentRssKb() {
+    long rss = 0;
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        long size = 0;
+        if (fscanf(fp, "%ld %ld", &size, &rss) != 2)
+            rss = 0;
+        fclose(fp);
+    }
+    return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(int argc, char *argv[]) {
+    const char* path = (argc > 1) ? argv[1] : "/bin/true";
+    int iterations = (argc > 2) ? atoi(argv[2]) : 50;
+    size_t max_rss_mb = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1024;
+
+    std::atomic<bool> quit(false);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; i++) {
+        workers.emplace_back([&quit]() {
+            while (!quit)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    }
+
+    std::vector<char*> blocks;
+    size_t allocated_mb = 0;
+    printf("%10s %12s %16s %18s %8s\n", "rss(MB)", "target(MB)", "fork+exec(us)", "posix_spawn(us)", "ratio");
+
+    for (size_t target = 0; target <= max_rss_mb; target = (target == 0) ? 64 : target * 2) {
+        while (allocated_mb < target) {
+            char* block = static_cast<char*>(malloc(64 * kMB));
+            if (!block)
+                break;
+            memset(block, 0x5a, 64 * kMB); // touch every page
+            blocks.push_back(block);
+            allocated_mb += 64;
+        }
+
+        double fork_us = Measure(LaunchFork, path, iterations);
+        double spawn_us = Measure(LaunchSpawn, path, iterations);
+        printf("%10ld %12zu %16.1f %18.1f %8.2f\n", CurrentRssKb() / 1024, target,
+               fork_us, spawn_us, (spawn_us > 0) ? fork_us / spawn_us : 0.0);
+        fflush(stdout);
+    }
+
+    quit = true;
+    for (auto& t : workers)
+        t.join();
+    for (auto block : blocks)
+        free(block);
+    return 0;
+}
@@ -1,22 +1,27 @@
 #include "playerprovider.h"
 
+#include <future>
+
+#include "async_call.h"
+#include "command_recorder.h"
+#include "fast_logger.h"
 #include "glib_helper.h"
 #include "lang_convert.h"
+#include "lms_keyframe_index.h"
 #include "option.h"
 #include "player_logger.h"
+#include "playerengine_signal.h"
 #include "player/player_export.h"
 
+#include <limits.h>
 #include <math.h>
 
 #define WAIT_ON_ERROR_SECONDS 6 // ToDo: need to export to configure file
 
-#define CACHE_SERVICE_NAME   "com.lge.stream-caching-service"
-#define CACHE_OBJECT_PATH    "/com/lge/caching"
-#define CACHE_INTERFACE_NAME "com.lge.StreamCaching"
-
-#define CACHE_SETCACHEDMUSIC  "SetCachedMusic"
-#define CACHE_GETCACHEDMOVIE  "GetCachedMovie"
-#define CACHE_SETCACHEDMOVIE  "SetCachedMovie"
+// deadline of a gdbus call to PlayerEngine, other waits of commands have none
+#ifndef PLAYERENGINE_CALL_TIMEOUT_MS
+#define PLAYERENGINE_CALL_TIMEOUT_MS 15000
+#endif
 
 #define GOLF_SUBTITLE_PATH  "/rw_data/app/golf/subtitle/"
 
@@ -38,6 +43,7 @@ PlayerProvider::PlayerProvider(std::shared_ptr<command::Queue>& sp_command_queue
         playerengine_proxy_{nullptr},
         sig_id_state_change_{0},
         gbus_sync_connection_{nullptr},
+        signal_stats_(),
         command_queue_(sp_command_queue),
         event_system_(sp_command_queue),
         sc_notifier_(),
@@ -52,22 +58,35 @@ PlayerProvider::PlayerProvider(std::shared_ptr<command::Queue>& sp_command_queue
         file_location(),
         platform_name(),
         need_to_open_when_play_{false},
-        track_opened_(),
+        media_state_(),
+        caching_client_(),
+        resume_store_(),
+        transcode_service_(Option::transcode_workers()),
+        transcode_mutex_(),
+        transcode_token_(std::make_shared<bool>(true)),
+        transcode_tracks_(),
         media_type_(MM::PlayerTypes::MediaType::AUDIO),
         playback_option_(),
         video_window_backup_{11000, 0, 0, 1280, 720, 0, 7, "", ""},
         state_{State::Stopped},
-        is_playing_(false),
         is_need_new_index_(false),
         is_Error_state(false),
         is_EOS_state_(false),
-        is_need_pause_(false),
-        seeking_position_idx(-1),
+        seeking_media_id_(MediaStateTable::kNoMedia),
+        dirty_state_(0),
+        last_state_publish_us_(0),
+        state_publish_source_(nullptr),
+        position_drift_source_(nullptr),
+        track_gap_stats_(),
+        resume_flush_source_(nullptr),
         last_fail_media_id_(0),
         multi_channel_media_id_(0),
         multi_channel_media_type_(""),
         clean_connection_(""),
         single_connection_name_(""),
+        media_locks_(),
+        media_flags_(media_locks_),
+        _attribute_mutex("attribute"),
         playback_blocked_(false),
         play_direction_(Direction::Forward),
         updated_current_time_since_trickplay_(false),
@@ -79,9 +98,6 @@ PlayerProvider::PlayerProvider(std::shared_ptr<command::Queue>& sp_command_queue
         contrast_2nd_(0xdeadbeef),
         cache_path_buffer_(""),
         pe_audio_slot_map_(),
-        audio_slot_num_(""),
-        audio_slot_num_2ch_(""),
-        audio_slot_num_6ch_(""),
         speed_ignore_buffering_map_() {
     MMLogInfo("");
 
@@ -91,6 +107,24 @@ PlayerProvider::PlayerProvider(std::shared_ptr<command::Queue>& sp_command_queue
         MMLogInfo("Failed to initialize event_system");
     }
 
+    // a callback posted before the destructor finds the token expired and does nothing
+    std::weak_ptr<bool> token = transcode_token_;
+    transcode_service_.SetCallbacks(
+        [this, token](uint32_t id, uint64_t position_us, uint64_t duration_us) {
+            GlibHelper::CallAsync(event_system_.GetGMainContext(), [this, token, id, position_us, duration_us]() -> gboolean {
+                if (!token.expired())
+                    onTranscodeProgress(TRANSCODE_MEDIA_ID_BASE | id, position_us, duration_us);
+                return FALSE;
+            });
+        },
+        [this, token](uint32_t id, TranscodeService::Result result, const std::string& message) {
+            GlibHelper::CallAsync(event_system_.GetGMainContext(), [this, token, id, result, message]() -> gboolean {
+                if (!token.expired())
+                    onTranscodeDone(TRANSCODE_MEDIA_ID_BASE | id, result, message);
+                return FALSE;
+            });
+        });
+
     //playlist::PlaylistOption::set_platform(Option::platform());
     if (!Option::platform().compare("B_AVN")) {
         playback_option_.set_potion_on_stop_state = false;
@@ -99,6 +133,23 @@ PlayerProvider::PlayerProvider(std::shared_ptr<command::Queue>& sp_command_queue
 
 PlayerProvider::~PlayerProvider() {
     MMLogInfo("");
+
+    // jobs still running report to nobody, and callbacks already posted are dropped
+    transcode_service_.SetCallbacks(nullptr, nullptr);
+    transcode_token_.reset();
+
+    if (state_publish_source_) {
+        g_source_destroy(state_publish_source_);
+        g_source_unref(state_publish_source_);
+    }
+    if (position_drift_source_) {
+        g_source_destroy(position_drift_source_);
+        g_source_unref(position_drift_source_);
+    }
+    if (resume_flush_source_) {
+        g_source_destroy(resume_flush_source_);
+        g_source_unref(resume_flush_source_);
+    }
 }
 
 void PlayerProvider::ServiceRegistered() {
@@ -117,153 +168,360 @@ void PlayerProvider::PEDestroyed(int destroy_mid) {
     MMLogInfo("id=[%d]", destroy_mid);
     last_fail_media_id_ = destroy_mid;
 
-    GlibHelper::CallAsync(event_system_.GetGMainContext(), [this]() -> gboolean {
-        MMLogError("PEDestroyed Callback[%d]", last_fail_media_id_);
-        event_system_.SetEvent(command::EventType::ErrorOccured, nullptr);
+    GlibHelper::CallAsync(event_system_.GetGMainContext(), [this, destroy_mid]() -> gboolean {
+        handlePEDestroyed(destroy_mid);
+        return FALSE;
+    });
+}
 
-        ptree pt;
-        pt.put("ErrorCode", ERROR_GST_INTERNAL_ERROR);
-        if (last_fail_media_id_ > 0)
-            onPEDestroyed(pt, last_fail_media_id_);
+void PlayerProvider::PEExited(int pid, std::function<bool(int)> is_bound) {
+    // the monitor calls from its own thread, engine state is checked where commands run
+    GlibHelper::CallAsync(event_system_.GetGMainContext(), [this, pid, is_bound]() -> gboolean {
+        if (!is_bound(pid))
+            return FALSE;
+        MMLogError("PlayerEngine[%d] died, mark it as failed", pid);
+        last_fail_media_id_ = pid;
+        handlePEDestroyed(pid);
         return FALSE;
     });
 }
 
-uint32_t PlayerProvider::getMediaID(std::string connectionName) {
-    std::map<int, std::string>::iterator it;
-    for (it = connection_map_.begin(); it != connection_map_.end(); it++) {
-        if (it->second == connectionName) {
-            return it->first;
-        }
+void PlayerProvider::handlePEDestroyed(int destroy_mid) {
+    // the monitor and checkValidMediaId() both report a crashed engine
+    if (destroy_mid > 0 && !destroyed_media_ids_.insert(destroy_mid).second) {
+        MMLogInfo("PEDestroyed[%d] is already handled", destroy_mid);
+        return;
     }
-    return -1;
+
+    MMLogError("PEDestroyed Callback[%d]", destroy_mid);
+    auto it = connection_map_.find(destroy_mid);
+    event_system_.SetEvent(command::EventType::ErrorOccured, nullptr,
+                           (it != connection_map_.end()) ? it->second : std::string());
+
+    ptree pt;
+    pt.put("ErrorCode", ERROR_GST_INTERNAL_ERROR);
+    if (destroy_mid > 0)
+        onPEDestroyed(pt, destroy_mid);
 }
 
-int32_t PlayerProvider::getPositionAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::Position> pos_t = stub->getPositionAttribute();
-    uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Position>::iterator itr;
+uint32_t PlayerProvider::getMediaID(std::string connectionName) {
+    return media_state_.MediaID(connectionName);
+}
 
-    for(itr = pos_t.begin(); itr != pos_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             return (itr - pos_t.begin());
-        }
-    }
-    return -1;
+MM::PlayerTypes::MediaType PlayerProvider::mediaTypeOf(const std::string& connectionName) {
+    MediaStateTable::State* opened = media_state_.Find(getMediaID(connectionName), MediaStateTable::CurrentTrack);
+    return (opened != nullptr) ? opened->media_type : media_type_;
 }
 
-int32_t PlayerProvider::getDurationAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::Duration> dur_t = stub->getDurationAttribute();
+int32_t PlayerProvider::getMuteAttrIdx(std::string connectionName) {
+    const std::vector<MM::PlayerTypes::MuteOption>& mute_t = stub->getMuteAttribute();
     uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Duration>::iterator itr;
+    std::vector<MM::PlayerTypes::MuteOption>::const_iterator itr;
 
-    for(itr = dur_t.begin(); itr != dur_t.end(); itr++) {
+    for(itr = mute_t.begin(); itr != mute_t.end(); itr++) {
         if(itr->getMedia_id() == media_id) {
-             return (itr - dur_t.begin());
+             return (itr - mute_t.begin());
         }
     }
     return -1;
 }
 
-int32_t PlayerProvider::getBufferingAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::Buffering> buf_t = stub->getBufferingAttribute();
+int32_t PlayerProvider::getRateAttrIdx(std::string connectionName) {
     uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Buffering>::iterator itr;
+    int32_t index = -1;
+    size_t size = 0;
+    {
+        std::lock_guard<ProfiledMutex> lock(_attribute_mutex);
+        const std::vector<MM::PlayerTypes::Rate>& rate_t = stub->getRateAttribute();
+        std::vector<MM::PlayerTypes::Rate>::const_iterator itr;
 
-    for(itr = buf_t.begin(); itr != buf_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             return (itr - buf_t.begin());
+        size = rate_t.size();
+        for(itr = rate_t.begin(); itr != rate_t.end(); itr++) {
+            if(itr->getMedia_id() == media_id) {
+                index = (itr - rate_t.begin());
+                break;
+            }
         }
     }
-    return -1;
+    MMLogError("[getRateAttrIdx] Rate list size[%lu]", size);
+    return index;
 }
 
-int32_t PlayerProvider::getCurrentTrackAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::Track> track_t = stub->getCurrentTrackAttribute();
+int32_t PlayerProvider::getSpeedAttrIdx(std::string connectionName) {
     uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Track>::iterator itr;
-
-    for(itr = track_t.begin(); itr != track_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             return (itr - track_t.begin());
+    int32_t index = -1;
+    size_t size = 0;
+    {
+        std::lock_guard<ProfiledMutex> lock(_attribute_mutex);
+        const std::vector<MM::PlayerTypes::Speed>& speed_t = stub->getSpeedAttribute();
+        std::vector<MM::PlayerTypes::Speed>::const_iterator itr;
+
+        size = speed_t.size();
+        for(itr = speed_t.begin(); itr != speed_t.end(); itr++) {
+            if(itr->getMedia_id() == media_id) {
+                index = (itr - speed_t.begin());
+                break;
+            }
         }
     }
-    return -1;
+    MMLogError("[getSpeedAttrIdx] Speed list size[%lu]", size);
+    return index;
 }
 
-int32_t PlayerProvider::getMuteAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::MuteOption> mute_t = stub->getMuteAttribute();
+int32_t PlayerProvider::getVolumeAttrIdx(std::string connectionName) {
+    const std::vector<MM::PlayerTypes::Volume>& volume_t = stub->getVolumeAttribute();
     uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::MuteOption>::iterator itr;
+    std::vector<MM::PlayerTypes::Volume>::const_iterator itr;
 
-    for(itr = mute_t.begin(); itr != mute_t.end(); itr++) {
+    for(itr = volume_t.begin(); itr != volume_t.end(); itr++) {
         if(itr->getMedia_id() == media_id) {
-             return (itr - mute_t.begin());
+             return (itr - volume_t.begin());
         }
     }
     return -1;
 }
 
-int32_t PlayerProvider::getRateAttrIdx(std::string connectionName) {
+void PlayerProvider::publishState(uint8_t fields) {
+    // pending ones go out together, so attributes never look older than a discrete change
+    fields |= dirty_state_;
+    dirty_state_ = 0;
+    last_state_publish_us_ = g_get_monotonic_time();
+
+    if (fields & MediaStateTable::Position) {
+        stub->setPositionAttribute(media_state_.Positions(last_state_publish_us_));
+        media_state_.PositionsPublished(last_state_publish_us_);
+        schedulePositionDrift();
+    }
+    if (fields & MediaStateTable::Duration)
+        stub->setDurationAttribute(media_state_.Durations());
+    if (fields & MediaStateTable::Buffering)
+        stub->setBufferingAttribute(media_state_.Bufferings());
+    if (fields & MediaStateTable::Playback)
+        stub->setPlaybackAttribute(media_state_.Playbacks());
+    if (fields & MediaStateTable::CurrentTrack)
+        stub->setCurrentTrackAttribute(media_state_.Tracks());
+}
 
-    _attribute_mutex.lock();
-    std::vector<MM::PlayerTypes::Rate> rate_t = stub->getRateAttribute();
-    uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Rate>::iterator itr;
+void PlayerProvider::publishStateLater(uint8_t fields) {
+    dirty_state_ |= fields;
+    if (state_publish_source_ != nullptr)
+        return;
 
-    MMLogError("[getRateAttrIdx] Rate list size[%lu]", rate_t.size());
-    for(itr = rate_t.begin(); itr != rate_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             _attribute_mutex.unlock();
-             return (itr - rate_t.begin());
-        }
+    gint64 wait_us = last_state_publish_us_ + Option::state_publish_interval_ms() * 1000LL - g_get_monotonic_time();
+    if (wait_us <= 0) {
+        publishState(0);
+        return;
     }
-    _attribute_mutex.unlock();
-    return -1;
+
+    state_publish_source_ = g_timeout_source_new((guint)((wait_us + 999) / 1000));
+    g_source_set_callback(state_publish_source_, &PlayerProvider::onPublishState, this, nullptr);
+    g_source_attach(state_publish_source_, event_system_.GetGMainContext());
 }
 
-int32_t PlayerProvider::getSpeedAttrIdx(std::string connectionName) {
+gboolean PlayerProvider::onPublishState(gpointer user_data) {
+    PlayerProvider* self = static_cast<PlayerProvider*>(user_data);
 
-    _attribute_mutex.lock();
-    std::vector<MM::PlayerTypes::Speed> speed_t = stub->getSpeedAttribute();
-    uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Speed>::iterator itr;
+    g_source_unref(self->state_publish_source_);
+    self->state_publish_source_ = nullptr;
+    if (self->dirty_state_)
+        self->publishState(0);
+    return FALSE;
+}
 
-    MMLogError("[getSpeedAttrIdx] Speed list size[%lu]", speed_t.size());
-    for(itr = speed_t.begin(); itr != speed_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             _attribute_mutex.unlock();
-             return (itr - speed_t.begin());
-        }
+void PlayerProvider::schedulePositionDrift() {
+    if (position_drift_source_) {
+        g_source_destroy(position_drift_source_);
+        g_source_unref(position_drift_source_);
+        position_drift_source_ = nullptr;
     }
-    _attribute_mutex.unlock();
-    return -1;
+
+    // extrapolated position goes out again only when it moved far enough from the published one
+    int64_t wait_us = media_state_.UntilPositionDrift(g_get_monotonic_time(),
+                                                      Option::position_publish_drift_ms() * 1000ULL);
+    if (wait_us < 0)
+        return;
+
+    position_drift_source_ = g_timeout_source_new((guint)((wait_us + 999) / 1000));
+    g_source_set_callback(position_drift_source_, &PlayerProvider::onPositionDrift, this, nullptr);
+    g_source_attach(position_drift_source_, event_system_.GetGMainContext());
 }
 
-int32_t PlayerProvider::getPlaybackAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::Playback> playback_t = stub->getPlaybackAttribute();
-    uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Playback>::iterator itr;
+gboolean PlayerProvider::onPositionDrift(gpointer user_data) {
+    PlayerProvider* self = static_cast<PlayerProvider*>(user_data);
 
-    for(itr = playback_t.begin(); itr != playback_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             return (itr - playback_t.begin());
-        }
-    }
-    return -1;
+    g_source_unref(self->position_drift_source_);
+    self->position_drift_source_ = nullptr;
+    if (self->media_state_.UntilPositionDrift(g_get_monotonic_time(),
+                                              Option::position_publish_drift_ms() * 1000ULL) == 0)
+        self->publishStateLater(MediaStateTable::Position);
+    else
+        self->schedulePositionDrift();
+    return FALSE;
 }
 
-int32_t PlayerProvider::getVolumeAttrIdx(std::string connectionName) {
-    std::vector<MM::PlayerTypes::Volume> volume_t = stub->getVolumeAttribute();
-    uint32_t media_id = getMediaID(connectionName);
-    std::vector<MM::PlayerTypes::Volume>::iterator itr;
+void PlayerProvider::saveResumePosition(const MediaStateTable::State& state, bool sync) {
+    if (!state.resumable || !(state.fields & MediaStateTable::CurrentTrack))
+        return;
 
-    for(itr = volume_t.begin(); itr != volume_t.end(); itr++) {
-        if(itr->getMedia_id() == media_id) {
-             return (itr - volume_t.begin());
-        }
+    resume_store_.Put(state.track.getUri(), MediaStateTable::PositionAt(state, g_get_monotonic_time()),
+                      state.duration_us);
+    if (sync) {
+        resume_store_.Flush(true);
+        return;
     }
-    return -1;
+    if (resume_flush_source_ != nullptr)
+        return;
+
+    resume_flush_source_ = g_timeout_source_new(RESUME_STORE_FLUSH_INTERVAL_MS);
+    g_source_set_callback(resume_flush_source_, &PlayerProvider::onFlushResume, this, nullptr);
+    g_source_attach(resume_flush_source_, event_system_.GetGMainContext());
+}
+
+gboolean PlayerProvider::onFlushResume(gpointer user_data) {
+    PlayerProvider* self = static_cast<PlayerProvider*>(user_data);
+
+    g_source_unref(self->resume_flush_source_);
+    self->resume_flush_source_ = nullptr;
+    self->resume_store_.Flush(false);
+    return FALSE;
+}
+
+uint32_t PlayerProvider::startTranscode(const std::string& uri) {
+    // the arranged output is read and consumed at once, arrangeTranscodeOutput() may come in between
+    std::lock_guard<std::mutex> locker(transcode_mutex_);
+    boost::property_tree::ptree pt;
+    addRecorderOption(pt);
+
+    TranscodeJob job;
+    job.input = uri;
+    job.output = pt.get<std::string>("transcode_output", "");
+    job.codec = pt.get<std::string>("transcode_codec", "");
+    job.format = pt.get<std::string>("transcode_fileformat", "");
+    if (job.output.empty()) {
+        MMLogError("transcode output is not arranged");
+        return 0;
+    }
+
+    uint32_t id = transcode_service_.Submit(job);
+    if (id == 0)
+        return 0;
+
+    uint32_t media_id = TRANSCODE_MEDIA_ID_BASE | id;
+    MM::PlayerTypes::Track track;
+    track.setUri(uri);
+    transcode_tracks_[media_id] = track;
+    uri_transcode_output_.clear(); // one job per arrangeTranscodeOutput()
+    return media_id;
+}
+
+bool PlayerProvider::stopTranscode(uint32_t media_id) {
+    return transcode_service_.Cancel(media_id & ~TRANSCODE_MEDIA_ID_BASE);
+}
+
+void PlayerProvider::onTranscodeProgress(uint32_t media_id, uint64_t position_us, uint64_t duration_us) {
+    std::unique_lock<std::mutex> locker(transcode_mutex_);
+    auto it = transcode_tracks_.find(media_id);
+    if (it == transcode_tracks_.end())
+        return;
+    MM::PlayerTypes::Track track = it->second;
+    locker.unlock();
+
+    // not playing, so the position stays where the encoder is
+    MediaStateTable::State& state = media_state_.Get(media_id);
+    state.track = track;
+    state.duration_us = duration_us;
+    MediaStateTable::Anchor(state, position_us, g_get_monotonic_time());
+    state.fields |= MediaStateTable::CurrentTrack | MediaStateTable::Position | MediaStateTable::Duration;
+    publishStateLater(MediaStateTable::Position | MediaStateTable::Duration);
+}
+
+void PlayerProvider::onTranscodeDone(uint32_t media_id, TranscodeService::Result result, const std::string& message) {
+    std::unique_lock<std::mutex> locker(transcode_mutex_);
+    auto it = transcode_tracks_.find(media_id);
+    if (it == transcode_tracks_.end())
+        return;
+    MM::PlayerTypes::Track track = it->second;
+    transcode_tracks_.erase(it);
+    locker.unlock();
+
+    if (result == TranscodeService::Result::Done) {
+        sc_notifier_.NotifyEOS(track, media_id);
+    } else if (result == TranscodeService::Result::Failed) {
+        MMLogError("transcoding [%s] fail : %s", track.getUri().c_str(), message.c_str());
+        stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::PLAYBACK_INTERNAL_ERROR, track, media_id);
+    }
+    if (media_state_.Clear(media_id, MediaStateTable::AllFields))
+        publishState(MediaStateTable::Position | MediaStateTable::Duration | MediaStateTable::CurrentTrack);
+}
+
+bool PlayerProvider::updatePosition(const std::string& connectionName, uint64_t pos_us, bool immediate) {
+    MediaStateTable::State* state = media_state_.Find(getMediaID(connectionName), MediaStateTable::Position);
+    if (state == nullptr)
+        return false;
+
+    if (immediate)
+        MediaStateTable::Anchor(*state, pos_us, g_get_monotonic_time());
+    else
+        MediaStateTable::Observe(*state, pos_us, g_get_monotonic_time());
+    media_state_.Activate(MediaStateTable::Position, state->media_id);
+    if (immediate)
+        publishState(MediaStateTable::Position);
+    else if (media_state_.UntilPositionDrift(g_get_monotonic_time(), Option::position_publish_drift_ms() * 1000ULL) == 0)
+        publishStateLater(MediaStateTable::Position);
+    else
+        schedulePositionDrift(); // the report agrees with the published position, the model is re-anchored
+    return true;
+}
+
+bool PlayerProvider::updateDuration(const std::string& connectionName, uint64_t duration_us) {
+    MediaStateTable::State* state = media_state_.Find(getMediaID(connectionName), MediaStateTable::Duration);
+    if (state == nullptr)
+        return false;
+
+    state->duration_us = duration_us;
+    media_state_.Activate(MediaStateTable::Duration, state->media_id);
+    publishState(MediaStateTable::Duration);
+
+    // the posted command may clear the state, it is not used after Post()
+    uint64_t resume_us = state->resume_us;
+    if (duration_us > 0)
+        state->resume_us = 0;
+    if (resume_us > 0 && resume_us < duration_us)
+        command_queue_->Post(new command::SetPositionCommand(this, false, resume_us, connectionName, nullptr));
+    return true;
+}
+
+bool PlayerProvider::updatePlaybackStatus(const std::string& connectionName, MM::PlayerTypes::PlaybackStatus status) {
+    MediaStateTable::State* state = media_state_.Find(getMediaID(connectionName), MediaStateTable::Playback);
+    if (state == nullptr)
+        return false;
+
+    gint64 now_us = g_get_monotonic_time();
+    state->status = status;
+    MediaStateTable::SetMotion(*state, state->rate,
+                               status == MM::PlayerTypes::PlaybackStatus::PLAYING && state->buffering >= 100, now_us);
+    transcode_service_.SetPlaybackActive(media_state_.AnyPlaying());
+    int64_t gap_us = 0;
+    if (MediaStateTable::TrackGap(*state, status, now_us, gap_us))
+        recordTrackGap(state->media_id, gap_us);
+    media_state_.Activate(MediaStateTable::Playback, state->media_id);
+    publishState(MediaStateTable::Playback);
+    // the model started or stopped moving, the published position is re-anchored
+    if (state->fields & MediaStateTable::Position)
+        publishStateLater(MediaStateTable::Position);
+    return true;
+}
+
+void PlayerProvider::recordTrackGap(uint32_t media_id, gint64 gap_us) {
+    track_gap_stats_.count++;
+    track_gap_stats_.sum_us += gap_us;
+    if (gap_us > track_gap_stats_.max_us)
+        track_gap_stats_.max_us = gap_us;
+
+    MMLogInfo("track transition gap media[%u]=[%lld]ms, n=[%u], mean=[%lld]ms, max=[%lld]ms", media_id,
+              (long long)(gap_us / 1000), track_gap_stats_.count,
+              (long long)(track_gap_stats_.sum_us / track_gap_stats_.count / 1000),
+              (long long)(track_gap_stats_.max_us / 1000));
 }
 
 bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriCommand* command) {
@@ -281,6 +539,8 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
     }
     std::string connectionName = command->connectionName;
     connection_map_ = command->connectionMap;
+    media_state_.SetConnections(connection_map_);
+    destroyed_media_ids_.erase((int)command->media_id); // pid is taken by a new engine
     if (current_media_type == MM::PlayerTypes::MediaType::AUDIO || current_media_type == MM::PlayerTypes::MediaType::VIDEO ||
         current_media_type == MM::PlayerTypes::MediaType::USB_AUDIO1 || current_media_type == MM::PlayerTypes::MediaType::USB_VIDEO1 ||
         current_media_type == MM::PlayerTypes::MediaType::USB_AUDIO2 || current_media_type == MM::PlayerTypes::MediaType::USB_VIDEO2 ||
@@ -333,40 +593,30 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
     }
 #endif
     need_to_open_when_play_[proxyId] = false;
-    int32_t Idx = getCurrentTrackAttrIdx(connectionName);
-    if (Idx < stub->getCurrentTrackAttribute().size() && Idx != -1) {
-        track_opened_.erase(track_opened_.begin()+Idx);
-        track_opened_.insert(track_opened_.begin()+Idx, command->track);
-    } else {
-        track_opened_.push_back(command->track);
-    }
-    stub->setCurrentTrackAttribute(track_opened_);
-
-    Idx = getCurrentTrackAttrIdx(connectionName);
-    if (Idx > -1)
-        sc_notifier_.NotifyCurrentTrack(track_opened_[Idx], getMediaID(connectionName));
-    std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-    Idx = getPositionAttrIdx(connectionName);
-    if (Idx <= -1) {
-        MM::PlayerTypes::Position pos_t(command->pos_us, getMediaID(connectionName), true);
-        pos_list.push_back(pos_t);
-        /* Now the index will be the last element */
-        Idx = pos_list.size() - 1;
-    } else {
-        pos_list[Idx].setMedia_id(getMediaID(connectionName));
-        pos_list[Idx].setPosition(command->pos_us);
-    }
-    for (auto itr = pos_list.begin(); itr != pos_list.end(); itr++) {
-        if ((itr - pos_list.begin()) != Idx) {
-            itr->setActive(false);
-        } else {
-            if (Idx != (pos_list.size() - 1)) // For ignoring sending 0 position
-                itr->setActive(true);
-            else
-                itr->setActive(false);
-        }
-    }
-    stub->setPositionAttribute(pos_list);
+    uint32_t opened_media_id = getMediaID(connectionName);
+    MediaStateTable::State& opened = media_state_.Get(opened_media_id);
+    bool is_new_position = !(opened.fields & MediaStateTable::Position);
+    opened.track = command->track;
+    opened.media_type = current_media_type;
+    opened.resumable = (current_media_type == MM::PlayerTypes::MediaType::VIDEO ||
+                        current_media_type == MM::PlayerTypes::MediaType::USB_VIDEO1 ||
+                        current_media_type == MM::PlayerTypes::MediaType::USB_VIDEO2);
+    // resumes only if the client asked for it, set when the duration of the track is known
+    opened.resume_us = 0;
+    uint64_t resume_us = 0;
+    if (opened.resumable && playback_option_.resume_position_on_open && command->pos_us == 0 &&
+        resume_store_.Get(uri, resume_us) && resume_us > 0) {
+        MMLogInfo("[OpenUriCommand] " "resume from %llu ms", (unsigned long long)TimeConvert::UsToMs(resume_us));
+        opened.resume_us = resume_us;
+    }
+    opened.position_us = command->pos_us;
+    opened.fields |= MediaStateTable::CurrentTrack | MediaStateTable::Position;
+    publishState(MediaStateTable::CurrentTrack);
+    sc_notifier_.NotifyCurrentTrack(command->track, opened_media_id);
+
+    // For ignoring sending 0 position
+    media_state_.Activate(MediaStateTable::Position, is_new_position ? MediaStateTable::kNoMedia : opened_media_id);
+    publishState(MediaStateTable::Position);
 
     // set_uri option : json string
     boost::property_tree::ptree tree;
@@ -392,8 +642,10 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
         if (fabs(contrast_2nd_ - 0xdeadbeef) > DBL_EPSILON)
             sub_tree.put("contrast", contrast_2nd_);
     }
-    if (current_media_type == MM::PlayerTypes::MediaType::STREAM)
+    if (current_media_type == MM::PlayerTypes::MediaType::STREAM) {
+        std::lock_guard<std::mutex> locker(transcode_mutex_);
         addRecorderOption(sub_tree);
+    }
 
     sub_tree.put("cache", cache);
     sub_tree.put("show-preroll-frame", command->show_preroll_frame);
@@ -407,26 +659,28 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
     sub_tree.put("channel", command->channel_num);
 
     getSubtitlePath(uri, current_media_type, sub_tree);
+    getKeyframeIndex(uri, current_media_type, sub_tree);
     if (current_media_type == MM::PlayerTypes::MediaType::GOLF_VIDEO) {
         MMLogInfo("get cached golf video path..");
-        sendDbusCaching(Caching::GetCachedMovie, uri);
+        sendDbusCaching(in, Caching::GetCachedMovie, uri, connectionName);
     }
 
-    audio_slot_num_6ch_ = "_";
-    audio_slot_num_2ch_ = "_";
-    audio_slot_num_ = "_";
+    // audio slots are per command, other lanes open tracks while this one waits
+    std::string audio_slot_num_6ch = "_";
+    std::string audio_slot_num_2ch = "_";
+    std::string audio_slot_num = "_";
     if (uri.length() > 2 && uri[0] == '<' && uri[2] == '>') { // ccRC project needs this logic
       MMLogInfo("6ch_slot=[%c]", uri[1]);
       sub_tree.put("6ch_slot", uri[1]);
-      audio_slot_num_6ch_ = "6ch_";
-      audio_slot_num_6ch_.push_back(uri[1]);
+      audio_slot_num_6ch = "6ch_";
+      audio_slot_num_6ch.push_back(uri[1]);
       uri.erase(0, 3);
     }
     if (uri.length() > 2 && uri[0] == '[' && uri[2] == ']') {
       MMLogInfo("2ch_slot=[%c]", uri[1]);
       sub_tree.put("2ch_slot", uri[1]);
-      audio_slot_num_2ch_ = "2ch_";
-      audio_slot_num_2ch_.push_back(uri[1]);
+      audio_slot_num_2ch = "2ch_";
+      audio_slot_num_2ch.push_back(uri[1]);
       uri.erase(0, 3);
     }
 
@@ -437,7 +691,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
     GError *error = NULL;
 #ifdef PLATFORM_CCIC 
 //ccIC의 경우 6ch은 무조건 0번 슬롯을 사용하기때문에 2ch slot 정보만 보내고 있음.
-    audio_slot_num_6ch_ = "6ch_0";
+    audio_slot_num_6ch = "6ch_0";
     gint result_channel = 0;
     MMLogInfo("call getChannelInfo in sync");
     com_lge_player_engine_call_get_channel_info_sync(
@@ -458,12 +712,12 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
         return false;
     }
 
-    audio_slot_num_ = result_channel > 5 ? audio_slot_num_6ch_ : result_channel > 0 ? audio_slot_num_2ch_ : "_";
-    if(audio_slot_num_[0] == '_') {
+    audio_slot_num = result_channel > 5 ? audio_slot_num_6ch : result_channel > 0 ? audio_slot_num_2ch : "_";
+    if(audio_slot_num[0] == '_') {
         MMLogError("Failed to get slot");
     } else if (result_channel > 5){
         MMLogInfo("if 6ch slot is being used, it will be downmixed");
-        auto pe_audio_slot_iter = pe_audio_slot_map_.find(audio_slot_num_);
+        auto pe_audio_slot_iter = pe_audio_slot_map_.find(audio_slot_num);
         if(pe_audio_slot_iter != pe_audio_slot_map_.end()) {
             if(pe_audio_slot_iter->second != connectionName) {
                 MMLogInfo("Force downmix 6ch to 2ch");
@@ -472,12 +726,12 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
             }
         }
     } else {
-        auto pe_audio_slot_iter = pe_audio_slot_map_.find(audio_slot_num_);
+        auto pe_audio_slot_iter = pe_audio_slot_map_.find(audio_slot_num);
         if(pe_audio_slot_iter != pe_audio_slot_map_.end()) {
             if(pe_audio_slot_iter->second != connectionName) {
                 int slot_proxyId = preparePEProxy(pe_audio_slot_iter->second, false);
                 if (slot_proxyId <= -1) {
-                    MMLogInfo("there is no pe proxy Id for audio slot %s", audio_slot_num_.c_str());
+                    MMLogInfo("there is no pe proxy Id for audio slot %s", audio_slot_num.c_str());
                 } else {
                     command::StopCommand sc(this, false, pe_audio_slot_iter->second, getMediaID(pe_audio_slot_iter->second), nullptr);
                     sc.Execute(in);
@@ -487,27 +741,37 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
     }
 #endif
     // async call
+    std::shared_ptr<AsyncCall> call = newAsyncCall(connectionName);
     com_lge_player_engine_call_set_uri(
         playerengine_proxy_[proxyId],
         uri.c_str(),
         ss.str().c_str(),
-        NULL,
-        (GAsyncReadyCallback)PlayerProvider::callAsyncCallback,
-        (gpointer*)new std::pair<PlayerProvider*, command::BaseCommand*>(this, command)
+        call->Cancellable(),
+        (GAsyncReadyCallback)AsyncCall::Callback,
+        call->UserData()
     );
 
-    //if (!skip_wait)
-        event_system_.WaitEvent(in, (uint32_t)command::EventType::CallAsync, 0);
     // async call result
     dbus_error = NULL;
     gboolean succeed = FALSE;
+    command::WaitResult waited = waitAsyncCall(in, call);
+    if (waited == command::WaitResult::TimedOut) {
+        // the call is cancelled, a late reply is dropped
+        command->e = MM::PlayerTypes::PlayerError::BACKEND_UNREACHABLE;
+        MMLogError("setUri of [%s] timed out in %u ms", connectionName.c_str(), PLAYERENGINE_CALL_TIMEOUT_MS);
+        goto EXIT_ERROR;
+    }
+    if (waited != command::WaitResult::Succeeded) {
+        command->e = MM::PlayerTypes::PlayerError::BACKEND_UNREACHABLE;
+        MMLogError("no reply of setUri from [%s]", connectionName.c_str());
+        goto EXIT_ERROR;
+    }
     com_lge_player_engine_call_set_uri_finish(
         playerengine_proxy_[proxyId],
         &succeed,
-        command->async_result,
+        call->Result(),
         &dbus_error
     );
-    g_object_unref(command->async_result);
 
     if (dbus_error) {
         command->e = MM::PlayerTypes::PlayerError::BACKEND_UNREACHABLE;
@@ -521,52 +785,23 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
     } else {
 #ifdef PLATFORM_CCIC
         /* mapping audio slot with pe connection */
-        if(audio_slot_num_[0] != '_') {
-            pe_audio_slot_map_.insert({audio_slot_num_, connectionName});
+        if(audio_slot_num[0] != '_') {
+            pe_audio_slot_map_.insert({audio_slot_num, connectionName});
             if(result_channel > 5)
-                pe_audio_slot_map_.insert({audio_slot_num_2ch_, connectionName});
+                pe_audio_slot_map_.insert({audio_slot_num_2ch, connectionName});
         }
 #endif
-        /* Create vector index for duration attribute */
-        std::vector<MM::PlayerTypes::Duration> dur_list = stub->getDurationAttribute();
-        Idx = getDurationAttrIdx(connectionName);
-        if (Idx == -1 || dur_list.size() == 0) {
-            MM::PlayerTypes::Duration dur_t(0, getMediaID(connectionName), true);
-            dur_list.push_back(dur_t);
-            /* Now the index will be the last element */
-            Idx = dur_list.size() - 1;
-        } else {
-            dur_list[Idx].setMedia_id(getMediaID(connectionName));
-            dur_list[Idx].setDuration(0);
-        }
-
-        for (auto itr = dur_list.begin(); itr != dur_list.end(); itr++) {
-            if ((itr - dur_list.begin()) != Idx) {
-                itr->setActive(false);
-            } else {
-                itr->setActive(true);
-            }
-        }
-        stub->setDurationAttribute(dur_list);
-
-        /* Create vector index for buffering attribute */
-        std::vector<MM::PlayerTypes::Buffering> buf_list = stub->getBufferingAttribute();
-        Idx = getBufferingAttrIdx(connectionName);
-        if (Idx == -1 || buf_list.size() == 0) {
-            MM::PlayerTypes::Buffering buf_t(100/*progress*/, getMediaID(connectionName), false);
-            buf_list.push_back(buf_t);
-            /* Now the index will be the last element */
-            //Idx = buf_list.size() - 1;
-        } else {
-            buf_list[Idx].setMedia_id(getMediaID(connectionName));
-            buf_list[Idx].setProgress(100);
-        }
-
-        for (auto itr = buf_list.begin(); itr != buf_list.end(); itr++) {
-            itr->setActive(false); // We don't need to notify this here
-        }
-        stub->setBufferingAttribute(buf_list);
+        /* Create state of duration and buffering attribute */
+        MediaStateTable::State& created = media_state_.Get(opened_media_id);
+        MediaStateTable::Reopened(created);
+        created.duration_us = 0;
+        created.buffering = 100;
+        created.fields |= MediaStateTable::Duration | MediaStateTable::Buffering;
+        media_state_.Activate(MediaStateTable::Duration, opened_media_id);
+        media_state_.Activate(MediaStateTable::Buffering, MediaStateTable::kNoMedia); // We don't need to notify this here
+        publishState(MediaStateTable::Duration | MediaStateTable::Buffering);
 
+        int32_t Idx = -1;
         /* Create vector index for Mute attribute */
         std::vector<MM::PlayerTypes::MuteOption> mute_list = stub->getMuteAttribute();
         Idx = getMuteAttrIdx(connectionName);
@@ -637,27 +872,12 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenUriComma
         }
         stub->setVolumeAttribute(volume_list);
 
-        /* Create vector index for Playback attribute */
-        std::vector<MM::PlayerTypes::Playback> playback_list = stub->getPlaybackAttribute();
-        Idx = getPlaybackAttrIdx(connectionName);
-        if (Idx == -1 || playback_list.size() == 0) {
-            MM::PlayerTypes::Playback playback_t(MM::PlayerTypes::PlaybackStatus::UNINIT, getMediaID(connectionName), true);
-            playback_list.push_back(playback_t);
-            /* Now the index will be the last element */
-            Idx = playback_list.size() - 1;
-        } else {
-            playback_list[Idx].setMedia_id(getMediaID(connectionName));
-            playback_list[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::UNINIT);
-        }
-        MMLogInfo("getPlaybackAttribute Idx = [%d]", Idx);
-        for (auto itr = playback_list.begin(); itr != playback_list.end(); itr++) {
-            if ((itr - playback_list.begin()) != Idx) {
-                itr->setActive(false);
-            } else {
-                itr->setActive(true);
-            }
-        }
-        stub->setPlaybackAttribute(playback_list);
+        /* Create state of Playback attribute */
+        MediaStateTable::State& playback = media_state_.Get(opened_media_id);
+        playback.status = MM::PlayerTypes::PlaybackStatus::UNINIT;
+        playback.fields |= MediaStateTable::Playback;
+        media_state_.Activate(MediaStateTable::Playback, opened_media_id);
+        publishState(MediaStateTable::Playback);
 
         /*
         if (command->channel_num > 2 && multi_channel_media_id_ == 0) {
@@ -751,12 +971,10 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenTrackCom
 bool PlayerProvider::process(command::Coro::pull_type& in, command::PauseCommand* command) {
     MMLogInfo("[PauseCommand] " "");
 
-    _mutex.lock();
     std::string connectionName = command->connectionName;
     int proxyId = preparePEProxy(connectionName);
     if (proxyId <= -1) {
         MMLogInfo("Invalid Proxy Id");
-        _mutex.unlock();
         return false;
     }
 
@@ -765,14 +983,14 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::PauseCommand
     int32_t rate_index = getRateAttrIdx(connectionName);
     if (rate_index < 0) {
         MMLogInfo("Invalid rate_index");
-        _mutex.unlock();
         return false;
     }
     double prev_rate = stub->getRateAttribute()[rate_index].getRate();
-    is_need_pause_ = (is_EOS_state_ || is_Error_state) ? true : false;
+    // takes the shard lock only for the flag, stopTrickPlay() and the calls below yield to other lanes
+    media_flags_.Set(getMediaID(connectionName), MediaFlags::NeedPause, is_EOS_state_ || is_Error_state);
 
     if ((fabs(prev_rate - 0.0) > DBL_EPSILON) && (fabs(prev_rate - 1.0) > DBL_EPSILON)) {
-        stopTrickPlay(in, IsVideoType(media_type_), connectionName);
+        stopTrickPlay(in, IsVideoType(mediaTypeOf(connectionName)), connectionName);
     }
 
     GError *dbus_error = NULL;
@@ -794,50 +1012,22 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::PauseCommand
         // check need to set PlaybackStatus attribute
         if ((fabs(prev_rate - 1.0) > DBL_EPSILON) || prev_state == State::Paused) {
             MMLogInfo("[PauseCommand] " "PlaybackStatus is Paused");
-            std::vector<MM::PlayerTypes::Playback> pb_t = stub->getPlaybackAttribute();
-            std::vector<MM::PlayerTypes::Playback>::iterator itr;
-            int32_t Idx = getPlaybackAttrIdx(connectionName);
-
-            if (Idx > -1 && pb_t.size() > 0) {
-                pb_t[Idx].setMedia_id(getMediaID(connectionName));
-                pb_t[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::PAUSED);
-                for(itr = pb_t.begin(); itr != pb_t.end(); itr++) {
-                    if((itr - pb_t.begin()) == Idx) {
-                        itr->setActive(true);
-                    } else {
-                        itr->setActive(false);
-                    }
-                }
-                stub->setPlaybackAttribute(pb_t);
-            }
+            updatePlaybackStatus(connectionName, MM::PlayerTypes::PlaybackStatus::PAUSED);
         }
 
         state_[proxyId] = State::Paused;
+        MediaStateTable::State* paused = media_state_.Find(getMediaID(connectionName), MediaStateTable::CurrentTrack);
+        if (paused != nullptr)
+            saveResumePosition(*paused, false);
     } else if (prev_state == State::Stopped) {
         // may be already released or error handling case -> app needs status changed event
-        std::vector<MM::PlayerTypes::Playback> pb_t = stub->getPlaybackAttribute();
-        std::vector<MM::PlayerTypes::Playback>::iterator itr;
-        int32_t Idx = getPlaybackAttrIdx(connectionName);
-
-        if (Idx > -1 && pb_t.size() > 0) {
-            pb_t[Idx].setMedia_id(getMediaID(connectionName));
-            pb_t[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::PAUSED);
-            for(itr = pb_t.begin(); itr != pb_t.end(); itr++) {
-                if((itr - pb_t.begin()) == Idx) {
-                    itr->setActive(true);
-                } else {
-                    itr->setActive(false);
-                }
-            }
-            stub->setPlaybackAttribute(pb_t);
-        }
+        updatePlaybackStatus(connectionName, MM::PlayerTypes::PlaybackStatus::PAUSED);
     } else {
         // may be null pipeline.
         state_[proxyId] = State::Stopped;
     }
 
-    is_playing_ = false;
-    _mutex.unlock();
+    media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, false);
 
     return succeed;
 }
@@ -871,7 +1061,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::PlayCommand*
         uint32_t index = (*track).index();
         std::string uri = (*track).GetInfo(playlist::Track::InfoType::Uri);
 
-        is_playing_ = true;
+        media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, true);
         command::OpenUriCommand ouc(this, index, uri, true, connection_map_, getMediaID(connectionName), 0, connectionName, nullptr);
         if (ouc.Execute(in) == false) {
             command->e = ouc.e;
@@ -907,7 +1097,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::PlayCommand*
     }
 
     if (succeed == TRUE) {
-        is_playing_ = true;
+        media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, true);
         state_[proxyId] = State::Playing;
     }
     return succeed;
@@ -918,7 +1108,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::PlayPauseCom
     std::string connectionName = command->connectionName;
     MMLogInfo("[PlayPauseCommand] " "");
 
-    if (is_playing_ == true) {
+    if (media_flags_.Test(getMediaID(connectionName), MediaFlags::Playing)) {
         command::PauseCommand pc(this, connectionName, nullptr);
         succeed = pc.Execute(in);
     } else {
@@ -939,18 +1129,11 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::NextCommand*
     }
 
     bool pause_after_next = false; // For EOS pause case (BAVN-6023)
-    std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-    int32_t Idx = getPositionAttrIdx(connectionName);
-    if (Idx > -1 && pos_list.size() > 0) {
-        uint64_t last_position = pos_list[Idx].getPosition();
+    MediaStateTable::State* last = media_state_.Find(getMediaID(connectionName), MediaStateTable::Position);
+    if (last != nullptr) {
+        uint64_t last_position = last->position_us;
         MMLogInfo("Last position = %d", last_position);
-        pos_list[Idx].setPosition(0);
-        pos_list[Idx].setMedia_id(getMediaID(connectionName));
-        for(auto itr : pos_list) {
-            itr.setActive(false);
-        }
-        pos_list[Idx].setActive(true);
-        stub->setPositionAttribute(pos_list);
+        updatePosition(connectionName, 0);
 
         if (playback_option_.set_position_on_prev) {
             bool goto_begin_of_track =
@@ -977,7 +1160,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::NextCommand*
 
     if (command->pos == 2 || command->pos == -2) { // Need pause after next command (BAVN-6023,6776)
         pause_after_next = true;
-        is_playing_ = false; // For safety
+        media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, false); // For safety
         if (command->pos == 2) command->pos = 1;
         if (command->pos == -2) command->pos = -1;
     }
@@ -1028,10 +1211,10 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::NextCommand*
     MMLogInfo("[NextCommand] " "Next Track-> index: %d, uri: %s", index, uri.c_str());
 
     if (playback_option_.auto_resume_on_next_or_prev && !pause_after_next) {
-        is_playing_ = true;
+        media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, true);
     }
 
-    if (is_playing_ == false) {
+    if (!media_flags_.Test(getMediaID(connectionName), MediaFlags::Playing)) {
         MMLogInfo("[NextCommand] " "paused, Current Track-> index: %d, uri: %s", index, uri.c_str());
 
         command::OpenUriCommand ouc(this, index, uri, true, connection_map_, getMediaID(connectionName), 0, connectionName, nullptr);
@@ -1059,7 +1242,8 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::NextCommand*
 
 bool PlayerProvider::process(command::Coro::pull_type& in, command::NextAndTrickCommand* command) {
     MMLogInfo("[NextAndTrickCommand] " "pos: %d, rate: %f", command->pos, command->rate);
-    int proxyId = preparePEProxy(sender_name_);
+    std::string connectionName = command->connectionName;
+    int proxyId = preparePEProxy(connectionName);
     if (proxyId <= -1) {
         MMLogInfo("Invalid Proxy Id");
         return false;
@@ -1083,27 +1267,27 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::NextAndTrick
         play_direction_ = Direction::Backward;
 
     // open uri
-    command::OpenUriCommand ouc(this, index, uri, true, connection_map_, getMediaID(sender_name_), 0, sender_name_,  nullptr);
+    command::OpenUriCommand ouc(this, index, uri, true, connection_map_, getMediaID(connectionName), 0, connectionName,  nullptr);
     if (ouc.Execute(in) == false) {
         return false;
     }
 
-    int32_t Idx = getDurationAttrIdx(sender_name_);
-    if (command->pos < 0 && Idx > -1) {
+    MediaStateTable::State* opened = media_state_.Find(getMediaID(connectionName), MediaStateTable::Duration);
+    if (command->pos < 0 && opened != nullptr) {
         // seek to the end of stream
-        uint64_t new_position = stub->getDurationAttribute()[Idx].getDuration();
+        uint64_t new_position = opened->duration_us;
         if (new_position < TimeConvert::SecToUs(3)) {
             MMLogWarn("[NextAndTrickCommand] " "duration is smaller than 3 seconds");
             return false;
         }
         new_position -= TimeConvert::SecToUs(3);
-        command::SetPositionCommand spc(this, false, new_position, sender_name_, nullptr);
+        command::SetPositionCommand spc(this, false, new_position, connectionName, nullptr);
         if (spc.Execute(in) == false)
             return false;
     }
 
     // play with trick mode
-    command::SetRateCommand src(this, command->rate, sender_name_);
+    command::SetRateCommand src(this, command->rate, connectionName);
     if (src.Execute(in) == false)
         return false;
 
@@ -1135,19 +1319,18 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SeekCommand*
         return false;
     }
 
-    int32_t Idx = getPositionAttrIdx(connectionName);
-    if (Idx < 0) {
+    MediaStateTable::State* media_state = media_state_.Find(getMediaID(connectionName));
+    if (media_state == nullptr || !(media_state->fields & MediaStateTable::Position)) {
         MMLogInfo("Invalid position index");
         return false;
     }
-    uint64_t new_pos_us = stub->getPositionAttribute()[Idx].getPosition();
+    uint64_t new_pos_us = MediaStateTable::PositionAt(*media_state, g_get_monotonic_time());
 
-    Idx = getDurationAttrIdx(connectionName);
-    if (Idx < 0) {
+    if (!(media_state->fields & MediaStateTable::Duration)) {
         MMLogInfo("Invalid duration index");
         return false;
     }
-    uint64_t duration = stub->getDurationAttribute()[Idx].getDuration();
+    uint64_t duration = media_state->duration_us;
 
     if (command->pos_us < 0 && (uint64_t)abs(command->pos_us) > new_pos_us) {
         MMLogWarn("[SeekCommand] " "out of range ( pos_us : %lld is bigger than position %llu )", command->pos_us, new_pos_us);
@@ -1161,18 +1344,8 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SeekCommand*
         return false;
     }
 
-    std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-    Idx = getPositionAttrIdx(connectionName);
-
-    if (Idx > -1 && pos_list.size() > 0) {
-        pos_list[Idx].setPosition(new_pos_us);
-        pos_list[Idx].setMedia_id(getMediaID(connectionName));
-        for(auto itr : pos_list) {
-            itr.setActive(false);
-        }
-        pos_list[Idx].setActive(true);
-        stub->setPositionAttribute(pos_list);
-    }
+    updatePosition(connectionName, new_pos_us);
+    saveResumePosition(*media_state, false);
 
     GError *dbus_error = NULL;
     gboolean succeed = FALSE;
@@ -1206,17 +1379,17 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetPositionC
     static std::vector<command::CommandType> cv = { command::CommandType::Seek, command::CommandType::SetPosition };
     static std::vector<command::CommandType> cv_rate = { command::CommandType::SetRate };
     std::string connectionName = command->connectionName;
+    if (command_queue_->Exist(cv, connectionName)) {
+        MMLogInfo("[SetPositionCommand] " "skip command");
+        return true;
+    }
+
     int proxyId = preparePEProxy(connectionName);
     if (proxyId <= -1) {
         MMLogInfo("Invalid Proxy Id");
         return false;
     }
 
-    if (command_queue_->Exist(cv, connectionName)) {
-        MMLogInfo("[SetPositionCommand] " "skip command");
-        return true;
-    }
-
     MMLogInfo("[SetPositionCommand] " "pos_us : %llu, skip_wait=[%d]", command->pos_us, command->is_streaming);
 
     int32_t rate_index = getRateAttrIdx(connectionName);
@@ -1231,12 +1404,12 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetPositionC
         return false;
     }
 
-    int32_t Idx = getDurationAttrIdx(connectionName);
-    if (Idx < 0) {
+    MediaStateTable::State* media_state = media_state_.Find(getMediaID(connectionName), MediaStateTable::Duration);
+    if (media_state == nullptr) {
         MMLogInfo("Invalid duration index");
         return false;
     }
-    uint64_t duration = stub->getDurationAttribute()[Idx].getDuration();
+    uint64_t duration = media_state->duration_us;
 
     if ((uint64_t)command->pos_us > duration) {
         MMLogError("[SetPositionCommand] " "out of range ( pos_us : %llu is bigger than duration %llu )", command->pos_us, duration);
@@ -1245,20 +1418,12 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetPositionC
         command->pos_us -= 1000LL;
     }
 
-    std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-    Idx = getPositionAttrIdx(connectionName);
-
-    if (Idx > -1 && pos_list.size() > 0) {
-        MMLogInfo("[SetPositionCommand] " "The position[%llu] of Index[%d][%s] changed to [%llu], pos_list size[%ld]",
-            stub->getPositionAttribute()[Idx].getPosition(), Idx, connectionName.c_str(), command->pos_us, pos_list.size());
-        seeking_position_idx = Idx;
-        pos_list[Idx].setPosition(command->pos_us);
-        pos_list[Idx].setMedia_id(getMediaID(connectionName));
-        for(auto itr : pos_list) {
-            itr.setActive(false);
-        }
-        pos_list[Idx].setActive(true);
-        stub->setPositionAttribute(pos_list);
+    if (media_state->fields & MediaStateTable::Position) {
+        MMLogInfo("[SetPositionCommand] " "The position[%llu] of media[%u][%s] changed to [%llu]",
+            media_state->position_us, media_state->media_id, connectionName.c_str(), command->pos_us);
+        seeking_media_id_ = media_state->media_id;
+        updatePosition(connectionName, command->pos_us);
+        saveResumePosition(*media_state, false);
     }
 
     GError *dbus_error = NULL;
@@ -1281,7 +1446,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetPositionC
         event_system_.WaitEvent(in, (uint32_t)command::EventType::AsyncDone, (uint32_t)command::EventType::ErrorOccured);
     }
     MMLogError("[SetPositionCommand] " "return value :%d", succeed);
-    seeking_position_idx = -1;
+    seeking_media_id_ = MediaStateTable::kNoMedia;
 
     return succeed;
 }
@@ -1310,22 +1475,32 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::StopCommand*
 
     GError *dbus_error = NULL;
     gboolean succeed = FALSE;
+    std::shared_ptr<AsyncCall> call = newAsyncCall(connectionName);
     com_lge_player_engine_call_stop(
         playerengine_proxy_[proxyId],
-        NULL,
-        (GAsyncReadyCallback)PlayerProvider::callAsyncCallback,
-        (gpointer*)new std::pair<PlayerProvider*, command::BaseCommand*>(this, command)
+        call->Cancellable(),
+        (GAsyncReadyCallback)AsyncCall::Callback,
+        call->UserData()
     );
 
-    event_system_.WaitEvent(in, (uint32_t)command::EventType::CallAsync, 0);
-
-    com_lge_player_engine_call_stop_finish(
-        playerengine_proxy_[proxyId],
-        &succeed,
-        command->async_result,
-        &dbus_error
-    );
-    g_object_unref(command->async_result);
+    // the engine is released below even if it does not answer
+    command::WaitResult waited = waitAsyncCall(in, call);
+    if (waited == command::WaitResult::TimedOut) {
+        command->e = MM::PlayerTypes::PlayerError::BACKEND_UNREACHABLE;
+        last_fail_media_id_ = getMediaID(connectionName);
+        MMLogError("StopCommand timed out in %u ms - [%d]", PLAYERENGINE_CALL_TIMEOUT_MS, last_fail_media_id_);
+    } else if (waited != command::WaitResult::Succeeded) {
+        command->e = MM::PlayerTypes::PlayerError::BACKEND_UNREACHABLE;
+        last_fail_media_id_ = getMediaID(connectionName);
+        MMLogError("StopCommand no reply - [%d]", last_fail_media_id_);
+    } else {
+        com_lge_player_engine_call_stop_finish(
+            playerengine_proxy_[proxyId],
+            &succeed,
+            call->Result(),
+            &dbus_error
+        );
+    }
 
     if (dbus_error) {
         command->e = MM::PlayerTypes::PlayerError::BACKEND_UNREACHABLE;
@@ -1334,27 +1509,18 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::StopCommand*
         g_error_free(dbus_error);
     }
 
-    /* Erase respective attribute index from the vector */
-    int32_t Idx = getDurationAttrIdx(connectionName);
-    if(Idx < stub->getDurationAttribute().size() && Idx > -1) {
-        MMLogInfo("Erasing attribute from vector wit media-id : %d", stub->getDurationAttribute()[Idx].getMedia_id());
-        std::vector<MM::PlayerTypes::Duration> dur_list = stub->getDurationAttribute();
-        dur_list.erase(dur_list.begin()+Idx);
-        stub->setDurationAttribute(dur_list);
+    /* Erase respective state and attribute index from the vector */
+    uint32_t stopped_media_id = getMediaID(connectionName);
+    MediaStateTable::State* stopped = media_state_.Find(stopped_media_id);
+    uint8_t stopped_fields = (stopped != nullptr) ? stopped->fields : 0;
+    if (stopped_fields != 0) {
+        MMLogInfo("Erasing state of media-id : %u", stopped_media_id);
+        MediaStateTable::LogJitter(*stopped);
+        saveResumePosition(*stopped, true);
+        media_state_.Clear(stopped_media_id, MediaStateTable::AllFields);
+        publishState(stopped_fields & (MediaStateTable::Duration | MediaStateTable::Position | MediaStateTable::Buffering));
     }
-    Idx = getPositionAttrIdx(connectionName);
-    if(Idx < stub->getPositionAttribute().size() && Idx > -1) {
-        std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-        pos_list.erase(pos_list.begin()+Idx);
-        stub->setPositionAttribute(pos_list);
-    }
-    Idx = getBufferingAttrIdx(connectionName);
-    if(Idx < stub->getBufferingAttribute().size() && Idx > -1) {
-        std::vector<MM::PlayerTypes::Buffering> buf_list = stub->getBufferingAttribute();
-        buf_list.erase(buf_list.begin()+Idx);
-        stub->setBufferingAttribute(buf_list);
-    }
-    Idx = getMuteAttrIdx(connectionName);
+    int32_t Idx = getMuteAttrIdx(connectionName);
     if(Idx < stub->getMuteAttribute().size() && Idx > -1) {
         std::vector<MM::PlayerTypes::MuteOption> mute_list = stub->getMuteAttribute();
         mute_list.erase(mute_list.begin()+Idx);
@@ -1375,17 +1541,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::StopCommand*
         volume_list.erase(volume_list.begin()+Idx);
         stub->setVolumeAttribute(volume_list);
     }
-    Idx = getCurrentTrackAttrIdx(connectionName);
-    if(Idx < stub->getCurrentTrackAttribute().size() && Idx > -1) {
-        track_opened_.erase(track_opened_.begin()+Idx);
-        stub->setCurrentTrackAttribute(track_opened_);
-    }
-    Idx = getPlaybackAttrIdx(connectionName);
-    if(Idx < stub->getPlaybackAttribute().size() && Idx > -1) {
-        std::vector<MM::PlayerTypes::Playback> playback_list = stub->getPlaybackAttribute();
-        playback_list.erase(playback_list.begin()+Idx);
-        stub->setPlaybackAttribute(playback_list);
-    }
+    publishState(stopped_fields & (MediaStateTable::CurrentTrack | MediaStateTable::Playback));
     Idx = getSpeedAttrIdx(connectionName);
     if(Idx < stub->getSpeedAttribute().size() && Idx > -1) {
         MMLogInfo("Mutex lock() in speed_list before removing it");
@@ -1408,7 +1564,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::StopCommand*
         }
     }
 #endif
-    is_playing_ = false;
+    media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, false);
     state_[proxyId] = State::Stopped;
     need_to_open_when_play_[proxyId] = true;
     /*
@@ -1420,7 +1576,9 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::StopCommand*
 
     //reset proxy map
     resetPEProxy(connectionName);
-    sender_name_ = "";
+    // signal handlers of other engines may have set it while this command waited
+    if (sender_name_ == connectionName)
+        sender_name_ = "";
     return succeed;
 }
 
@@ -1454,7 +1612,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::PlayExComman
     sc.Execute(in);
 
     if (fabs(command->rate - 0) > DBL_EPSILON) {
-        is_playing_ = true;
+        media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, true);
     }
 
     // open track
@@ -1525,10 +1683,9 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::OpenPlaylist
     }
 
     if (state_[proxyId] == State::Playing || state_[proxyId] == State::Paused) {
-        int32_t Idx = -1;
-        Idx = getCurrentTrackAttrIdx(connectionName);
-        if (Idx > -1) {
-            playlist::Track t(playlist::Track::INVALID_INDEX, track_opened_[Idx].getUri(), "");
+        MediaStateTable::State* opened = media_state_.Find(getMediaID(connectionName), MediaStateTable::CurrentTrack);
+        if (opened != nullptr) {
+            playlist::Track t(playlist::Track::INVALID_INDEX, opened->track.getUri(), "");
             boost::optional<playlist::Track> track = playlist_mgr_->SelectTrack(t);
 
             if (!track) {
@@ -1930,12 +2087,12 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetRepeatCom
     }
 
     if (command->repeat == MM::PlayerTypes::RepeatStatus::REPEAT_DIRECTORY) {
-        int32_t Idx = getCurrentTrackAttrIdx(connectionName);
-        if (Idx < 0) {
+        MediaStateTable::State* opened = media_state_.Find(getMediaID(connectionName), MediaStateTable::CurrentTrack);
+        if (opened == nullptr) {
             MMLogInfo("Invalid Track index");
             return false;
         }
-        std::string uri = track_opened_[Idx].getUri();
+        std::string uri = opened->track.getUri();
         std::string filename;
         std::string directory;
         if (uri.empty() == false) {
@@ -1996,6 +2153,11 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetRateComma
     MMLogInfo("[SetRateCommand] " "rate : %f", command->rate);
     std::string connectionName = command->connectionName;
 
+    if (command_queue_->Superseded(command)) {
+        MMLogInfo("[SetRateCommand] " "skip command, newer rate is queued");
+        return true;
+    }
+
     if (fabs(command->rate - 0.0) <= DBL_EPSILON) {
         MMLogInfo("[SetRateCommand] ignore zero rate");
         return true;
@@ -2003,11 +2165,11 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetRateComma
 
     if (fabs(command->rate - 1.0) <= DBL_EPSILON) {
         bool need_to_seek = false;
-        if (IsVideoType(media_type_) && updated_current_time_since_trickplay_)
+        if (IsVideoType(mediaTypeOf(connectionName)) && updated_current_time_since_trickplay_)
             need_to_seek = true;
         stopTrickPlay(in, need_to_seek, connectionName);
 
-        if (is_playing_ == true) {
+        if (media_flags_.Test(getMediaID(connectionName), MediaFlags::Playing)) {
             command::PlayCommand pc(this, connectionName, nullptr);
             pc.Execute(in);
         }
@@ -2042,9 +2204,16 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetRateComma
 
     if (succeed == TRUE) {
         controlMuteForTrickPlay(in, command->rate, connectionName);
-        is_playing_ = true;
+        media_flags_.Set(getMediaID(connectionName), MediaFlags::Playing, true);
         state_[proxyId] = State::Playing;
 
+        MediaStateTable::State* media_state = media_state_.Find(getMediaID(connectionName));
+        if (media_state != nullptr) {
+            MediaStateTable::SetMotion(*media_state, command->rate, media_state->buffering >= 100, g_get_monotonic_time());
+            if (media_state->fields & MediaStateTable::Position)
+                publishStateLater(MediaStateTable::Position);
+        }
+
         updated_current_time_since_trickplay_ = false;
     } else if (dbus_error) {
         g_error_free(dbus_error);
@@ -2098,6 +2267,11 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetSpeedComm
 bool PlayerProvider::process(command::Coro::pull_type& in, command::SetVolumeCommand* command) {
     MMLogInfo("[SetVolumeCommand] " "volume : %f", command->volume);
     std::string connectionName = command->connectionName;
+    if (command_queue_->Superseded(command)) {
+        MMLogInfo("[SetVolumeCommand] " "skip command, newer volume is queued");
+        return true;
+    }
+
     GError *dbus_error = NULL;
     gboolean succeed = FALSE;
     int proxyId = preparePEProxy(connectionName);
@@ -2137,7 +2311,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetVideoCont
                         (command->contrast < 1.0f) ? 0.9f : command->contrast;
 
 
-    if (media_type_ == MM::PlayerTypes::MediaType::USB_VIDEO2) {
+    if (mediaTypeOf(connectionName) == MM::PlayerTypes::MediaType::USB_VIDEO2) {
         contrast_2nd_ = command->contrast;
     } else {
         contrast_ = command->contrast;
@@ -2172,7 +2346,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetVideoBrig
                           (command->brightness < -0.3f) ? -0.3f :
                           (command->brightness < -0.2f) ? -0.25f: command->brightness;
 
-    if (media_type_ == MM::PlayerTypes::MediaType::USB_VIDEO2) {
+    if (mediaTypeOf(connectionName) == MM::PlayerTypes::MediaType::USB_VIDEO2) {
         brightness_2nd_ = command->brightness;
     } else {
         brightness_ = command->brightness;
@@ -2226,7 +2400,7 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetVideoSatu
         return false;
     }
 
-    if (media_type_ == MM::PlayerTypes::MediaType::USB_VIDEO2) {
+    if (mediaTypeOf(connectionName) == MM::PlayerTypes::MediaType::USB_VIDEO2) {
         saturation_2nd_ = command->saturation;
     } else {
         saturation_ = command->saturation;
@@ -2345,16 +2519,27 @@ bool PlayerProvider::process(command::Coro::pull_type& in, command::SetPlaylistT
 }
 #endif
 
-void PlayerProvider::callAsyncCallback(GObject *source_object, GAsyncResult *res, gpointer user_data) {
-    auto ppair = (std::pair<PlayerProvider*, command::BaseCommand*>*)user_data;
-    PlayerProvider* that = ppair->first;
-    command::BaseCommand* command = ppair->second;
-    delete ppair;
-
-    command->async_result = res;
-    g_object_ref(command->async_result);
+std::shared_ptr<AsyncCall> PlayerProvider::newAsyncCall(const std::string& connectionName) {
+    // the reply comes on the EventSystem thread, the waker runs only while the command waits
+    return AsyncCall::Create([this, connectionName]() {
+        event_system_.SetEvent(command::EventType::CallAsync, nullptr, connectionName);
+    });
+}
 
-    that->onCallAsync(ptree());
+command::WaitResult PlayerProvider::waitAsyncCall(command::Coro::pull_type& in, std::shared_ptr<AsyncCall>& call) {
+    gint64 deadline = g_get_monotonic_time() + (gint64)PLAYERENGINE_CALL_TIMEOUT_MS * 1000;
+
+    // a CallAsync of another call does not end this wait, nor move its deadline
+    while (call->Waiting()) {
+        gint64 left_ms = (deadline - g_get_monotonic_time()) / 1000;
+        if (left_ms <= 0 ||
+            event_system_.WaitEventFor(in, (uint32_t)command::EventType::CallAsync, 0, (uint32_t)left_ms)
+                == command::WaitResult::TimedOut) {
+            call->Abandon();
+            return command::WaitResult::TimedOut;
+        }
+    }
+    return (call->Result() != nullptr) ? command::WaitResult::Succeeded : command::WaitResult::Failed;
 }
 
 void PlayerProvider::handleStateChange(GDBusConnection *connection,
@@ -2365,66 +2550,119 @@ void PlayerProvider::handleStateChange(GDBusConnection *connection,
                                                                              GVariant *parameters,
                                                                              gpointer user_data) {
 
+    PlayerProvider* that = (PlayerProvider*)user_data;
+    that->signal_stats_.received++;
+
     sender_name_ = sender_name ? sender_name : "";
-    static std::map<std::string, void (PlayerProvider::*)(const ptree&)> handler = {
-        { "Duration",             &PlayerProvider::onDuration },
-        { "CurrentTime",       &PlayerProvider::onCurrentTime },
-        { "PlaybackStatus", &PlayerProvider::onPlaybackStatus },
-        { "BeginOfStream",   &PlayerProvider::onBeginOfStream },
-        { "EndOfStream",       &PlayerProvider::onEndOfStream },
-        { "AsyncDone",           &PlayerProvider::onAsyncDone },
-        { "SourceInfo",         &PlayerProvider::onSourceInfo },
-        { "Subtitle",             &PlayerProvider::onSubtitle },
-        { "ChannelInfo",      &PlayerProvider::onChannelEvent },
-        { "AddressInfo",      &PlayerProvider::onAddressEvent },
-        { "StreamingEvent", &PlayerProvider::onStreamingEvent },
-        { "Warning",               &PlayerProvider::onWarning },
-        { "Error",                   &PlayerProvider::onError },
-        { "ContentType",       &PlayerProvider::onContentType },
-    };
+    if (that->pe_proxy_map_.find(sender_name_) == that->pe_proxy_map_.end()) {
+        // already dispatched when its engine was reset
+        that->signal_stats_.stale++;
+        return;
+    }
 
-    GVariant *inner = g_variant_get_child_value(parameters, 0);
-    if (!g_variant_is_of_type(inner, G_VARIANT_TYPE_STRING)) {
+    PESignalData signal;
+    if (!DecodePESignal(parameters, signal)) {
         MMLogError("Invalid type");
-        if (inner)
-            g_variant_unref(inner);
         return;
     }
 
-    ptree pt;
-    const char *jsonCStr = g_variant_get_string(inner, NULL);
-    std::string s(jsonCStr ? jsonCStr : "");
-    std::stringstream ss(s);
-    boost::property_tree::json_parser::read_json(ss, pt);
-    auto iter = pt.begin();
-    std::string state = iter->first ;
-    ptree sub_pt = iter->second;
-
-    auto it = handler.find(state);
-    if (it == handler.end()) {
-        if (inner)
+    command::Recorder& recorder = command::Recorder::Instance();
+    if (recorder.Enabled()) {
+        if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(s)"))) {
+            GVariant *inner = g_variant_get_child_value(parameters, 0);
+            recorder.OnSignal(sender_name, g_variant_get_string(inner, NULL));
             g_variant_unref(inner);
-        return;
+        } else {
+            recorder.OnSignal(sender_name, EncodePESignalJson(signal).c_str());
+        }
     }
 
-    PlayerProvider* that = (PlayerProvider*)user_data;
-    (that->*(handler[state]))(sub_pt);
-
-    if (inner)
-        g_variant_unref(inner);
+    ptree pt;
+    if (signal.type == PESignal::Unknown)
+        that->signal_stats_.unknown++;
+    else
+        that->signal_stats_.handled++;
+
+    switch (signal.type) {
+    case PESignal::CurrentTime:
+        if (signal.has_number)
+            that->onCurrentTime(signal.number);
+        break;
+    case PESignal::Duration:
+        if (signal.has_number)
+            that->onDuration(signal.number);
+        break;
+    case PESignal::PlaybackStatus:
+        if (signal.text != nullptr)
+            that->onPlaybackStatus(signal.Text());
+        break;
+    case PESignal::BeginOfStream:
+        that->onBeginOfStream();
+        break;
+    case PESignal::EndOfStream:
+        that->onEndOfStream();
+        break;
+    case PESignal::AsyncDone:
+        that->onAsyncDone();
+        break;
+    case PESignal::Subtitle:
+        that->onSubtitle();
+        break;
+    case PESignal::ContentType:
+        if (signal.text != nullptr)
+            that->onContentType(signal.Text());
+        else
+            MMLogError("Invalid content type event~!!");
+        break;
+    case PESignal::SourceInfo:
+    case PESignal::ChannelInfo:
+    case PESignal::AddressInfo:
+    case PESignal::StreamingEvent:
+    case PESignal::Warning:
+    case PESignal::Error:
+        // structured signals are rare, only they pay for a tree
+        if (!signal.ParseBody(pt)) {
+            MMLogError("Invalid body of %s", PESignalName(signal.type));
+            break;
+        }
+        if (signal.type == PESignal::SourceInfo)
+            that->onSourceInfo(pt);
+        else if (signal.type == PESignal::ChannelInfo)
+            that->onChannelEvent(pt);
+        else if (signal.type == PESignal::AddressInfo)
+            that->onAddressEvent(pt);
+        else if (signal.type == PESignal::StreamingEvent)
+            that->onStreamingEvent(pt);
+        else if (signal.type == PESignal::Warning)
+            that->onWarning(pt);
+        else
+            that->onError(pt);
+        break;
+    default:
+        break;
+    }
 }
 
-void PlayerProvider::onContentType(const ptree& pt) {
-    auto content = pt.get_value_optional<std::string>();
-    if(!content) {
-        MMLogError("Invalid content type event~!!");
-        return;
-    }
-    std::string name = *content;
+void PlayerProvider::onContentType(const std::string& name) {
     MMLogInfo("Send Content Type=[%s]", name.c_str());
     sc_notifier_.NotifyContentType(name, getMediaID(sender_name_));
 }
 
+#ifdef MM_REPLAY
+int PlayerProvider::attachReplayEngine(const std::string& connectionName, int mediaId) {
+    MMLogInfo("id=[%d], name=[%s]", mediaId, connectionName.c_str());
+
+    std::promise<int> attached;
+    GlibHelper::CallAsync(event_system_.GetGMainContext(), [this, connectionName, mediaId, &attached]() -> gboolean {
+        connection_map_[mediaId] = connectionName;
+        media_state_.AddConnection(mediaId, connectionName);
+        attached.set_value(preparePEProxy(connectionName, true));
+        return FALSE;
+    });
+    return attached.get_future().get();
+}
+#endif
+
 void PlayerProvider::onPEDestroyed(const ptree& pt, int mediaId) {
     if (mediaId > 0) {
         MMLogInfo("id=[%d], sender_name=[%s]", mediaId, sender_name_.c_str());
@@ -2443,76 +2681,30 @@ void PlayerProvider::onPEDestroyed(const ptree& pt, int mediaId) {
 }
 
 void PlayerProvider::onCallAsync(const ptree& pt) {
-    event_system_.SetEvent(command::EventType::CallAsync, nullptr);
+    event_system_.SetEvent(command::EventType::CallAsync, nullptr, sender_name_);
 }
 #if 0
 void PlayerProvider::onVMSourceNotification(const ptree& pt) {
     event_system_.SetEvent(command::EventType::VMSourceNotification, nullptr);
 }
 #endif
-void PlayerProvider::onDuration(const ptree& pt) {
-    auto vduration_ms = pt.get_value_optional<gint64>();
-    if (!vduration_ms)
-        return;
-
-    gint64 duration_ms = *vduration_ms;
-    int32_t Idx = getDurationAttrIdx(sender_name_);
-
-    std::vector<MM::PlayerTypes::Duration> dur_list = stub->getDurationAttribute();
-    std::vector<MM::PlayerTypes::Duration>::iterator itr;
-
-    MMLogInfo("Duration [%lld], list size=[%lu], index=[%d]", duration_ms, dur_list.size(), Idx);
-    if (Idx > -1 && dur_list.size() > 0) {
-        dur_list[Idx].setDuration(TimeConvert::MsToUs((uint64_t)duration_ms));
-        dur_list[Idx].setMedia_id(getMediaID(sender_name_));
-        for (itr = dur_list.begin(); itr != dur_list.end(); itr++) {
-            if ((itr - dur_list.begin()) != Idx) {
-                itr->setActive(false);
-            } else {
-                itr->setActive(true);
-            }
-        }
-        stub->setDurationAttribute(dur_list);
-        MMLogInfo("Duration aft set %lld", dur_list[Idx].getDuration());
-    }
+void PlayerProvider::onDuration(gint64 duration_ms) {
+    MMLogInfo("Duration [%lld], media id=[%u]", duration_ms, getMediaID(sender_name_));
+    updateDuration(sender_name_, TimeConvert::MsToUs((uint64_t)duration_ms));
 }
 
-void PlayerProvider::onCurrentTime(const ptree& pt) {
-    auto vcurrent_time_ms = pt.get_value_optional<gint64>();
-    if (!vcurrent_time_ms)
-        return;
-
-    gint64 current_time_ms = *vcurrent_time_ms;
-    int32_t Idx = getPositionAttrIdx(sender_name_);
-    if (seeking_position_idx > -1 && Idx == seeking_position_idx) {
-        MMLogWarn("CurrentTime[%lld] event is skipped (Seek in progress)", current_time_ms);
+void PlayerProvider::onCurrentTime(gint64 current_time_ms) {
+    if (seeking_media_id_ != MediaStateTable::kNoMedia && getMediaID(sender_name_) == seeking_media_id_) {
+        MMFastLogWarn("CurrentTime[%lld] event is skipped (Seek in progress)", (long long)current_time_ms);
         return;
     }
-    std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-    std::vector<MM::PlayerTypes::Position>::iterator itr;
 
-    if (Idx > -1 && pos_list.size() > 0) {
-        pos_list[Idx].setPosition(TimeConvert::MsToUs((uint64_t)current_time_ms));
-        pos_list[Idx].setMedia_id(getMediaID(sender_name_));
-        for (itr=pos_list.begin(); itr != pos_list.end(); itr++) {
-            if ((itr - pos_list.begin()) != Idx) {
-                itr->setActive(false);
-            } else {
-                itr->setActive(true);
-            }
-        }
-        stub->setPositionAttribute(pos_list);
-        MMLogInfo("get position = %lld", stub->getPositionAttribute()[Idx].getPosition());
-    }
+    if (updatePosition(sender_name_, TimeConvert::MsToUs((uint64_t)current_time_ms), false))
+        saveResumePosition(*media_state_.Find(getMediaID(sender_name_)), false);
     updated_current_time_since_trickplay_ = true;
 }
 
-void PlayerProvider::onPlaybackStatus(const ptree& pt) {
-    auto vstatus = pt.get_value_optional<std::string>();
-    if (!vstatus)
-        return;
-
-    std::string status = *vstatus;
+void PlayerProvider::onPlaybackStatus(const std::string& status) {
     int proxyId = preparePEProxy(sender_name_);
     if (proxyId <= -1) {
         MMLogInfo("Invalid Proxy Id");
@@ -2521,61 +2713,16 @@ void PlayerProvider::onPlaybackStatus(const ptree& pt) {
 
     if (status.compare("Playing") == 0) {
         MMLogInfo("Playing");
-        std::vector<MM::PlayerTypes::Playback> pb_t = stub->getPlaybackAttribute();
-        std::vector<MM::PlayerTypes::Playback>::iterator itr;
-        int32_t Idx = getPlaybackAttrIdx(sender_name_);
-
-        if (Idx > -1 && pb_t.size() > 0) {
-            pb_t[Idx].setMedia_id(getMediaID(sender_name_));
-            pb_t[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::PLAYING);
-            for (itr = pb_t.begin(); itr != pb_t.end(); itr++) {
-                if ((itr - pb_t.begin()) == Idx) {
-                    itr->setActive(true);
-                } else {
-                    itr->setActive(false);
-                }
-            }
-            stub->setPlaybackAttribute(pb_t);
-        }
+        updatePlaybackStatus(sender_name_, MM::PlayerTypes::PlaybackStatus::PLAYING);
         //if (need_to_open_when_play_[proxyId] == true) {
         //    command_queue_->Post(new command::PlayCommand(this, sender_name_, nullptr));
         //}
     } else if (status.compare("Paused") == 0) {
         MMLogInfo("Paused");
-        std::vector<MM::PlayerTypes::Playback> pb_t = stub->getPlaybackAttribute();
-        std::vector<MM::PlayerTypes::Playback>::iterator itr;
-        int32_t Idx = getPlaybackAttrIdx(sender_name_);
-
-        if (Idx > -1 && pb_t.size() > 0) {
-            pb_t[Idx].setMedia_id(getMediaID(sender_name_));
-            pb_t[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::PAUSED);
-            for (itr = pb_t.begin(); itr != pb_t.end(); itr++) {
-                if ((itr - pb_t.begin()) == Idx) {
-                    itr->setActive(true);
-                } else {
-                    itr->setActive(false);
-                }
-            }
-            stub->setPlaybackAttribute(pb_t);
-        }
+        updatePlaybackStatus(sender_name_, MM::PlayerTypes::PlaybackStatus::PAUSED);
     } else if (status.compare("Ready") == 0) {
         MMLogInfo("Ready");
-        std::vector<MM::PlayerTypes::Playback> pb_t = stub->getPlaybackAttribute();
-        std::vector<MM::PlayerTypes::Playback>::iterator itr;
-        int32_t Idx = getPlaybackAttrIdx(sender_name_);
-
-        if (Idx > -1 && pb_t.size() > 0) {
-            pb_t[Idx].setMedia_id(getMediaID(sender_name_));
-            pb_t[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::READY);
-            for (itr = pb_t.begin(); itr != pb_t.end(); itr++) {
-                if ((itr - pb_t.begin()) == Idx) {
-                    itr->setActive(true);
-                } else {
-                    itr->setActive(false);
-                }
-            }
-            stub->setPlaybackAttribute(pb_t);
-        }
+        updatePlaybackStatus(sender_name_, MM::PlayerTypes::PlaybackStatus::READY);
     } else if (status.compare("Stopped") == 0) {
         MMLogInfo("Stopped");
         onPlaybackStopped();
@@ -2611,7 +2758,9 @@ void PlayerProvider::onTrickAndBOS(double rate) {
             MMLogInfo("NextAndTrick");
 
             uint32_t pos = (rate > 0) ? 1 : -1;
-            command_queue_->Post(new command::NextAndTrickCommand(this, pos, rate));
+            command::BaseCommand* next = new command::NextAndTrickCommand(this, pos, rate);
+            next->connectionName = sender_name_; // runs in the lane of the engine which reached BOS/EOS
+            command_queue_->Post(next);
         }
     }
     */
@@ -2637,7 +2786,9 @@ void PlayerProvider::onTrickAndEOS(double rate) {
                 stub->getRepeatOptionAttribute().getStatus() == MM::PlayerTypes::RepeatStatus::REPEAT_SINGLE) {
             MMLogInfo("set_position_on_trick_and_repeat_single");
 
-            uint64_t new_position = stub->getDurationAttribute()[getDurationAttrIdx(sender_name_)].getDuration();
+            // no Duration signal yet, handled as a short track
+            MediaStateTable::State* media_state = media_state_.Find(getMediaID(sender_name_), MediaStateTable::Duration);
+            uint64_t new_position = (media_state != nullptr) ? media_state->duration_us : 0;
             if (new_position < TimeConvert::SecToUs(3)) {
                 MMLogWarn("duration is smaller than 3 seconds");
                 onPlaybackStopped();
@@ -2651,32 +2802,24 @@ void PlayerProvider::onTrickAndEOS(double rate) {
             MMLogInfo("NextAndTrick");
 
             uint32_t pos = (rate > 0) ? 1 : -1;
-            command_queue_->Post(new command::NextAndTrickCommand(this, pos, rate));
+            command::BaseCommand* next = new command::NextAndTrickCommand(this, pos, rate);
+            next->connectionName = sender_name_; // runs in the lane of the engine which reached BOS/EOS
+            command_queue_->Post(next);
         }
     }
     */
 }
 
-void PlayerProvider::onBeginOfStream(const ptree& pt) {
+void PlayerProvider::onBeginOfStream() {
     MMLogInfo("");
 
-    int32_t Idx_t = getCurrentTrackAttrIdx(sender_name_);
-    if (Idx_t < 0) {
+    MediaStateTable::State* opened = media_state_.Find(getMediaID(sender_name_), MediaStateTable::CurrentTrack);
+    if (opened == nullptr) {
         MMLogInfo("Invalid Track index");
         return;
     }
-    std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-    int32_t Idx = getPositionAttrIdx(sender_name_);
-
-    if (Idx > -1 && pos_list.size() > 0) {
-        pos_list[Idx].setPosition(0);
-        pos_list[Idx].setMedia_id(getMediaID(sender_name_));
-        for(auto itr : pos_list) {
-            itr.setActive(false);
-        }
-        pos_list[Idx].setActive(true);
-        stub->setPositionAttribute(pos_list);
-    }
+    MM::PlayerTypes::Track track = opened->track;
+    updatePosition(sender_name_, 0);
 
     int32_t rate_index = getRateAttrIdx(sender_name_);
     if (rate_index < 0) {
@@ -2691,18 +2834,27 @@ void PlayerProvider::onBeginOfStream(const ptree& pt) {
  * When receiving BOS, it requests mute to gstreamer. As a result, gstreamer is muted.
  * So, We send NotifyBOS to application after performing onTrickAndBOS();
  */
-    sc_notifier_.NotifyBOS(track_opened_[Idx_t], getMediaID(sender_name_));
+    sc_notifier_.NotifyBOS(track, getMediaID(sender_name_));
 }
 
-void PlayerProvider::onEndOfStream(const ptree& pt) {
+void PlayerProvider::onEndOfStream() {
     MMLogInfo("");
 
-    int32_t Idx = getCurrentTrackAttrIdx(sender_name_);
-    if (Idx < 0) {
+    uint32_t media_id = getMediaID(sender_name_);
+    MediaStateTable::State* opened = media_state_.Find(media_id, MediaStateTable::CurrentTrack);
+    if (opened == nullptr) {
         MMLogInfo("Invalid Track index");
         return;
     }
-    sc_notifier_.NotifyEOS(track_opened_[Idx], getMediaID(sender_name_));
+    // the gap lasts until the track opened by the client plays
+    MediaStateTable::EndOfStream(*opened, g_get_monotonic_time());
+    if (opened->resumable) {
+        // played to the end, the next open starts from the beginning
+        resume_store_.Erase(opened->track.getUri());
+        opened->resumable = false;
+        resume_store_.Flush(false);
+    }
+    sc_notifier_.NotifyEOS(opened->track, media_id);
 /*
     int proxyId = preparePEProxy(sender_name_);
     if (proxyId == -1) {
@@ -2725,20 +2877,17 @@ void PlayerProvider::onEndOfStream(const ptree& pt) {
     MMLogInfo("repeat_status: %d", static_cast<int32_t>(repeat_status));
 
     //if (repeat_status != MM::PlayerTypes::RepeatStatus::REPEAT_SINGLE) {
-        /* Erase respective attribute index from the vector */
-        Idx = getDurationAttrIdx(sender_name_);
-        if(Idx < stub->getDurationAttribute().size() && Idx != -1) {
-            MMLogInfo("Erasing duration attribute from vector wit media-id : %d", stub->getDurationAttribute()[Idx].getMedia_id());
-            std::vector<MM::PlayerTypes::Duration> dur_list = stub->getDurationAttribute();
-            dur_list.erase(dur_list.begin()+Idx);
-            stub->setDurationAttribute(dur_list);
-        }
-        Idx = getPositionAttrIdx(sender_name_);
-        if(Idx < stub->getPositionAttribute().size() && Idx != -1) {
-            MMLogInfo("Erasing position attribute from vector wit media-id : %d", stub->getPositionAttribute()[Idx].getMedia_id());
-            std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-            pos_list.erase(pos_list.begin()+Idx);
-            stub->setPositionAttribute(pos_list);
+        /* Erase respective state from the table */
+        MediaStateTable::State* eos_state = media_state_.Find(media_id, MediaStateTable::Position);
+        if (eos_state != nullptr)
+            MediaStateTable::LogJitter(*eos_state);
+        if (media_state_.Clear(media_id, MediaStateTable::Duration)) {
+            MMLogInfo("Erasing duration attribute from vector wit media-id : %u", media_id);
+            publishState(MediaStateTable::Duration);
+        }
+        if (media_state_.Clear(media_id, MediaStateTable::Position)) {
+            MMLogInfo("Erasing position attribute from vector wit media-id : %u", media_id);
+            publishState(MediaStateTable::Position);
         }
     //}
 #if 0
@@ -2748,16 +2897,13 @@ void PlayerProvider::onEndOfStream(const ptree& pt) {
         case MM::PlayerTypes::RepeatStatus::REPEAT_DIRECTORY: {
             usleep(TimeConvert::SecToUs(1));
 
-            _mutex.lock();
-            if (is_need_pause_) {
+            if (media_flags_.Take(getMediaID(sender_name_), MediaFlags::NeedPause)) {
                 MMLogInfo("need pause after EOS process");
-                is_need_pause_ = false;
                 command_queue_->Post(new command::NextCommand(this, 2, sender_name_, nullptr));
             } else {
                 MMLogInfo("don't need pause after EOS process");
                 command_queue_->Post(new command::NextCommand(this, 1, sender_name_, nullptr));
             }
-            _mutex.unlock();
             break;
         }
         case MM::PlayerTypes::RepeatStatus::REPEAT_SINGLE: {
@@ -2775,16 +2921,13 @@ void PlayerProvider::onEndOfStream(const ptree& pt) {
             }
             usleep(TimeConvert::SecToUs(1));
 
-            _mutex.lock();
-            if (is_need_pause_) {
+            if (media_flags_.Take(getMediaID(sender_name_), MediaFlags::NeedPause)) {
                 MMLogInfo("need pause after EOS process");
-                is_need_pause_ = false;
                 command_queue_->Post(new command::NextCommand(this, 2, sender_name_, nullptr));
             } else {
                 MMLogInfo("don't need pause after EOS process");
                 command_queue_->Post(new command::NextCommand(this, 1, sender_name_, nullptr));
             }
-            _mutex.unlock();
             break;
         }
         case MM::PlayerTypes::RepeatStatus::NO_REPEAT_AND_SINGLE: {
@@ -2798,8 +2941,8 @@ void PlayerProvider::onEndOfStream(const ptree& pt) {
 #endif
 }
 
-void PlayerProvider::onAsyncDone(const ptree& pt) {
-    event_system_.SetEvent(command::EventType::AsyncDone, nullptr);
+void PlayerProvider::onAsyncDone() {
+    event_system_.SetEvent(command::EventType::AsyncDone, nullptr, sender_name_);
 }
 
 void PlayerProvider::onSourceInfo(const ptree& pt) {
@@ -2816,7 +2959,7 @@ void PlayerProvider::onSourceInfo(const ptree& pt) {
 
     fillSubtitleList(pt);
 
-    if (IsVideoType(media_type_) == true) {
+    if (IsVideoType(mediaTypeOf(sender_name_)) == true) {
         sc_notifier_.NotifyAudioLanguageList(audio_tracks_, getMediaID(sender_name_));
 
         sc_notifier_.NotifySubtitleList(subtitle_tracks_, getMediaID(sender_name_));
@@ -2826,10 +2969,10 @@ void PlayerProvider::onSourceInfo(const ptree& pt) {
             sc_notifier_.NotifyVideoResolution(width, height, getMediaID(sender_name_));
     }
 
-    event_system_.SetEvent(command::EventType::SourceInfo, nullptr);
+    event_system_.SetEvent(command::EventType::SourceInfo, nullptr, sender_name_);
 }
 
-void PlayerProvider::onSubtitle(const ptree& pt) {
+void PlayerProvider::onSubtitle() {
     sc_notifier_.NotifySubtitleData(getMediaID(sender_name_));
 }
 
@@ -2873,33 +3016,29 @@ void PlayerProvider::onStreamingEvent(const ptree& pt) {
     auto speed_ignore_buffering_iter = speed_ignore_buffering_map_.find(sender_name_);
     if (buff_value) {
         //check for speed change request for poddbang
-        if (media_type_ == MM::PlayerTypes::MediaType::PODBBANG) {
+        if (mediaTypeOf(sender_name_) == MM::PlayerTypes::MediaType::PODBBANG) {
             if (speed_ignore_buffering_iter != speed_ignore_buffering_map_.end() && speed_ignore_buffering_iter->second) {
                 MMLogInfo("Ignore buffering events during speed change");
                 return;
             }
         }
         MMLogInfo("Streaming buffering=[%d]", *buff_value);
-        int32_t buf_Idx = getBufferingAttrIdx(sender_name_);
-        if (buf_Idx < 0) {
+        MediaStateTable::State* buffering = media_state_.Find(getMediaID(sender_name_), MediaStateTable::Buffering);
+        if (buffering == nullptr) {
             MMLogError("Invalid Buffering Track index");
             return;
         }
 
-        std::vector<MM::PlayerTypes::Buffering> buf_list = stub->getBufferingAttribute();
-        std::vector<MM::PlayerTypes::Buffering>::iterator itr;
-        if (buf_Idx > -1 && buf_list.size() > 0) {
-            buf_list[buf_Idx].setProgress(*buff_value);
-            buf_list[buf_Idx].setMedia_id(getMediaID(sender_name_));
-            for (itr = buf_list.begin(); itr != buf_list.end(); itr++) {
-                if ((itr - buf_list.begin()) != buf_Idx) {
-                    itr->setActive(false);
-                } else {
-                    itr->setActive(true);
-                }
-            }
-            stub->setBufferingAttribute(buf_list);
-        }
+        buffering->buffering = *buff_value;
+        // position does not advance while the pipeline is starved, it resumes when refilled
+        bool playing = buffering->status == MM::PlayerTypes::PlaybackStatus::PLAYING && *buff_value >= 100;
+        if (playing != buffering->playing)
+            MediaStateTable::SetMotion(*buffering, buffering->rate, playing, g_get_monotonic_time());
+        media_state_.Activate(MediaStateTable::Buffering, buffering->media_id);
+        if (*buff_value >= 100)
+            publishState(MediaStateTable::Buffering);
+        else
+            publishStateLater(MediaStateTable::Buffering);
         return;
     }
 
@@ -2961,11 +3100,12 @@ void PlayerProvider::onError(const ptree& pt) {
     if (!verror_code)
         return;
 
-    int32_t Idx = getCurrentTrackAttrIdx(sender_name_);
-    if (Idx < 0) {
+    MediaStateTable::State* opened = media_state_.Find(getMediaID(sender_name_), MediaStateTable::CurrentTrack);
+    if (opened == nullptr) {
         MMLogInfo("Invalid Track index");
         return;
     }
+    MM::PlayerTypes::Track track = opened->track;
 
     int error_code = *verror_code;
     switch (error_code) {
@@ -2976,29 +3116,29 @@ void PlayerProvider::onError(const ptree& pt) {
         }
         case ERROR_FILE_NOT_SUPPORTED:{
             MMLogError("[%d] notify FILE_NOT_SUPPORTED", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::FILE_NOT_SUPPORTED, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::FILE_NOT_SUPPORTED, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_FILE_NOT_FOUND: {
             MMLogError("[%d] notify BAD_URI", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::BAD_URI, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::BAD_URI, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_VIDEO_RESOLUTION_NOT_SUPPORTED: {
             MMLogError("[%d] notify VIDEO_RESOLUTION_NOT_SUPPORTED", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::VIDEO_RESOLUTION_NOT_SUPPORTED, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::VIDEO_RESOLUTION_NOT_SUPPORTED, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_STREAM_AUDIO_SHORT: {
             MMLogError("[%d] ERROR_STREAM_AUDIO_SHORT - Try using non provide clock option", error_code);
-            command_queue_->PostFront(new command::OpenUriCommand(this, track_opened_[Idx].getIndex(),
-                                                                  track_opened_[Idx].getUri(), media_type_, false,
+            command_queue_->PostFront(new command::OpenUriCommand(this, track.getIndex(),
+                                                                  track.getUri(), mediaTypeOf(sender_name_), false,
                                                                   connection_map_, getMediaID(sender_name_), 0, sender_name_,  nullptr));
             break;
         }
         case ERROR_GST_NO_RESPONSE: {
             MMLogError("[%d] ERROR_GST_NO_RESPONSE - Try forced stop for restore", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::NO_RESPONSE_ERROR, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::NO_RESPONSE_ERROR, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_AUDIO_CODEC_NOT_SUPPORTED:    // FALL-THROUGH
@@ -3007,12 +3147,12 @@ void PlayerProvider::onError(const ptree& pt) {
         case ERROR_RESOURCE_VIDEO_NOT_AVAILABLE: // FALL-THROUGH
         case ERROR_GST_INTERNAL_ERROR: {
             MMLogError("[%d] notify PLAYBACK_INTERNAL_ERROR", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::PLAYBACK_INTERNAL_ERROR, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::PLAYBACK_INTERNAL_ERROR, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_GST_RESOURCE_ERROR_READ: {
             MMLogError("[%d] notify RESOURCE_READ_ERROR", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::RESOURCE_READ_ERROR, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::RESOURCE_READ_ERROR, track, getMediaID(sender_name_));
             command_queue_->Post(new command::StopCommand(this, true, sender_name_, getMediaID(sender_name_), nullptr)); // pipeline could be playing.
             onPlaybackStopped();    // should not play next track.
             break;
@@ -3026,7 +3166,7 @@ void PlayerProvider::onError(const ptree& pt) {
              }
              if (err_msg.compare("Forbidden") == 0) {
                  MMLogInfo("403 Resource forbidden Server Error (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_403, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_403, track, getMediaID(sender_name_));
              }
              break;
         }
@@ -3040,31 +3180,31 @@ void PlayerProvider::onError(const ptree& pt) {
              }
              if (err_msg.compare("Internal Server Error") == 0) {
                  MMLogInfo("500 Internal Server Error (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_500, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_500, track, getMediaID(sender_name_));
              } else if (err_msg.compare("Not Implemented") == 0) {
                  MMLogInfo("501 Not Implemented (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_501, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_501, track, getMediaID(sender_name_));
              } else if (err_msg.compare("Bad Gateway") == 0) {
                  MMLogInfo("502 Bad Gateway (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_502, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_502, track, getMediaID(sender_name_));
              } else if (err_msg.compare("Service Unavailable") == 0) {
                  MMLogInfo("503 Service Unavailable (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_503, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_503, track, getMediaID(sender_name_));
              } else if (err_msg.compare("Gateway Timeout") == 0) {
                  MMLogInfo("504 Gateway Timeout (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_504, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_504, track, getMediaID(sender_name_));
              } else if (err_msg.compare("HTTP Version Not Supported") == 0) {
                  MMLogInfo("505 HTTP Version Not Supported (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_505, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_505, track, getMediaID(sender_name_));
              } else if (err_msg.compare("Internal Server Configuration Error") == 0) {
                  MMLogInfo("506 Internal Server Configuration Error (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_506, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_506, track, getMediaID(sender_name_));
              } else if (err_msg.compare("Insufficient Storage") == 0) {
                  MMLogInfo("507 Insufficient Storage (HTTP)");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_507, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::HTTP_ERROR_RESPONSE_507, track, getMediaID(sender_name_));
              } else {
                  MMLogInfo("RESOURCE_OPEN_READ_ERROR");
-                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::RESOURCE_READ_ERROR, track_opened_[Idx], getMediaID(sender_name_));
+                 stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::RESOURCE_READ_ERROR, track, getMediaID(sender_name_));
              }
 
             break;
@@ -3072,17 +3212,17 @@ void PlayerProvider::onError(const ptree& pt) {
         case ERROR_DIVX_AUDIO_CODEC_NOT_SUPPORTED:    // FALL-THROUGH
         case ERROR_DIVX_VIDEO_CODEC_NOT_SUPPORTED:{
             MMLogError("[%d] notify DIVX_CODEC_NOT_SUPPORTED", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::DIVX_CODEC_NOT_SUPPORTED, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::DIVX_CODEC_NOT_SUPPORTED, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_DIVX_VIDEO_RESOLUTION_NOT_SUPPORTED: {
             MMLogError("[%d] notify DIVX_RESOLUTION_NOT_SUPPORTED", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::DIVX_RESOLUTION_NOT_SUPPORTED, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::DIVX_RESOLUTION_NOT_SUPPORTED, track, getMediaID(sender_name_));
             break;
         }
         case ERROR_DIVX_UNAUTHORIZED: {
             MMLogError("[%d] notify DIVX_UNAUTHORIZED", error_code);
-            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::DIVX_UNAUTHORIZED, track_opened_[Idx], getMediaID(sender_name_));
+            stub->fireErrorOccuredEvent(MM::PlayerTypes::PlaybackError::DIVX_UNAUTHORIZED, track, getMediaID(sender_name_));
             break;
         }
         default: {
@@ -3102,28 +3242,17 @@ void PlayerProvider::onPlaybackError(const ptree& pt) {
         return;
     }
 
-    event_system_.SetEvent(command::EventType::ErrorOccured, nullptr);
-    std::vector<MM::PlayerTypes::Duration> dur_t = stub->getDurationAttribute();
-    int32_t Idx = getDurationAttrIdx(sender_name_);
-
-    if (Idx > -1 && dur_t.size() > 0) {
-        dur_t[Idx].setDuration(0);
-        dur_t[Idx].setMedia_id(getMediaID(sender_name_));
-        for(auto itr : dur_t) {
-            itr.setActive(false);
-        }
-        dur_t[Idx].setActive(true);
-        stub->setDurationAttribute(dur_t);
-    }
+    event_system_.SetEvent(command::EventType::ErrorOccured, nullptr, sender_name_);
+    updateDuration(sender_name_, 0);
 
     bool exist_play_command = false;
     static std::vector<command::CommandType> cv = { command::CommandType::Play };
     if (command_queue_->Exist(cv, sender_name_))
         exist_play_command = true;
 
-    if (is_playing_ == false &&
+    if (!media_flags_.Test(getMediaID(sender_name_), MediaFlags::Playing) &&
             exist_play_command == false) {
-        MMLogInfo("is_playing_ is false, so no need_post_command");
+        MMLogInfo("not playing, so no need_post_command");
         return;
     }
 
@@ -3165,7 +3294,9 @@ void PlayerProvider::onPlaybackError(const ptree& pt) {
         MMLogInfo("rate != 1.0");
         usleep(TimeConvert::SecToUs(1));
         if (need_post_command()) {
-            command_queue_->Post(new command::NextAndTrickCommand(this, pos, rate));
+            command::BaseCommand* next = new command::NextAndTrickCommand(this, pos, rate);
+            next->connectionName = sender_name_; // runs in the lane of the engine which reached BOS/EOS
+            command_queue_->Post(next);
         }
         return;
     }
@@ -3194,18 +3325,15 @@ void PlayerProvider::onPlaybackError(const ptree& pt) {
                     break;
                 }
 
-                _mutex.lock();
-                if (is_need_pause_) {
+                if (media_flags_.Take(getMediaID(sender_name_), MediaFlags::NeedPause)) {
                     MMLogInfo("need pause after error handling");
-                    is_need_pause_ = false;
                     pos = (play_direction_ == Direction::Forward) ? 2 : -2;
                 } else {
                     MMLogInfo("don't need pause after error handling");
                 }
                 command_queue_->Post(new command::NextCommand(this, pos, sender_name_, nullptr));
-                _mutex.unlock();
 
-                if (is_playing_ == false && exist_play_command == true) {
+                if (!media_flags_.Test(getMediaID(sender_name_), MediaFlags::Playing) && exist_play_command == true) {
                     MMLogInfo("add play command");
                     command_queue_->Post(new command::PlayCommand(this, sender_name_, nullptr));
                 }
@@ -3238,18 +3366,15 @@ void PlayerProvider::onPlaybackError(const ptree& pt) {
                 while (optionLoop-- > 0 && need_post_command())
                     usleep(TimeConvert::SecToUs(1));
                 if (need_post_command()) {
-                    _mutex.lock();
-                    if (is_need_pause_) {
+                    if (media_flags_.Take(getMediaID(sender_name_), MediaFlags::NeedPause)) {
                         MMLogInfo("need pause after error handling");
-                        is_need_pause_ = false;
                         pos = (play_direction_ == Direction::Forward) ? 2 : -2;
                     } else {
                         MMLogInfo("don't need pause after error handling");
                     }
                     command_queue_->Post(new command::NextCommand(this, pos, sender_name_, nullptr));
-                    _mutex.unlock();
 
-                    if (is_playing_ == false && exist_play_command == true) {
+                    if (!media_flags_.Test(getMediaID(sender_name_), MediaFlags::Playing) && exist_play_command == true) {
                         MMLogInfo("add play command");
                         command_queue_->Post(new command::PlayCommand(this, sender_name_, nullptr));
                     }
@@ -3269,7 +3394,7 @@ void PlayerProvider::onPlaybackError(const ptree& pt) {
 }
 
 void PlayerProvider::onPlaybackStopped() {
-    is_playing_ = false;
+    media_flags_.Set(getMediaID(sender_name_), MediaFlags::Playing, false);
     int proxyId = preparePEProxy(sender_name_);
     if (proxyId <= -1) {
         MMLogInfo("Invalid Proxy Id");
@@ -3277,43 +3402,13 @@ void PlayerProvider::onPlaybackStopped() {
     }
 
     need_to_open_when_play_[proxyId] = true;
-    std::vector<MM::PlayerTypes::Playback> pb_t = stub->getPlaybackAttribute();
-    std::vector<MM::PlayerTypes::Playback>::iterator itr;
-    int32_t Idx = getPlaybackAttrIdx(sender_name_);
-
-    if (Idx > -1 && pb_t.size() > 0) {
-        pb_t[Idx].setMedia_id(getMediaID(sender_name_));
-        pb_t[Idx].setStatus(MM::PlayerTypes::PlaybackStatus::STOPPED);
-        for(itr = pb_t.begin(); itr != pb_t.end(); itr++) {
-            if((itr - pb_t.begin()) == Idx) {
-                itr->setActive(true);
-            } else {
-                itr->setActive(false);
-            }
-        }
-        stub->setPlaybackAttribute(pb_t);
-    }
+    updatePlaybackStatus(sender_name_, MM::PlayerTypes::PlaybackStatus::STOPPED);
     if (playback_option_.set_potion_on_stop_state) {
-        std::vector<MM::PlayerTypes::Position> pos_list = stub->getPositionAttribute();
-        std::vector<MM::PlayerTypes::Position>::iterator itr;
-        int32_t Idx = getPositionAttrIdx(sender_name_);
-
-        if (Idx > -1 && pos_list.size() > 0 ) {
-            pos_list[Idx].setPosition(0);
-            pos_list[Idx].setMedia_id(getMediaID(sender_name_));
-            for(itr = pos_list.begin(); itr != pos_list.end(); itr++) {
-                if((itr - pos_list.begin()) == Idx) {
-                    itr->setActive(true);
-                } else {
-                    itr->setActive(false);
-                }
-            }
-            stub->setPositionAttribute(pos_list);
-        }
+        updatePosition(sender_name_, 0);
     }
     std::vector<MM::PlayerTypes::Rate> rate_t = stub->getRateAttribute();
     std::vector<MM::PlayerTypes::Rate>::iterator itr_rate;
-    Idx = getRateAttrIdx(sender_name_);
+    int32_t Idx = getRateAttrIdx(sender_name_);
 
     if (Idx > -1 && rate_t.size() > 0) {
         rate_t[Idx].setMedia_id(getMediaID(sender_name_));
@@ -3355,15 +3450,58 @@ void PlayerProvider::resetPEProxy(std::string connectionName) {
         proxyId = it->second;
 
         if ( (proxyId > -1) && (proxyId < MAX_PLAYER_ENGINE_INSTANCE) ) {
-            g_dbus_connection_signal_unsubscribe(gbus_sync_connection_[proxyId], sig_id_state_change_[proxyId]);
-            g_object_unref(gbus_sync_connection_[proxyId]);
+            unsubscribeStateChange(proxyId);
             pe_proxy_map_.erase(connectionName);
-            sig_id_state_change_[proxyId] = 0;
             g_object_unref(playerengine_proxy_[proxyId]);
             playerengine_proxy_[proxyId] = nullptr;
             MMLogInfo("Connection Name %s is erased", connectionName.c_str());
         }
     }
+    MMLogInfo("StateChange signals received=[%llu], handled=[%llu], stale=[%llu], unknown=[%llu]",
+              (unsigned long long)signal_stats_.received, (unsigned long long)signal_stats_.handled,
+              (unsigned long long)signal_stats_.stale, (unsigned long long)signal_stats_.unknown);
+    media_locks_.LogStats();
+    _attribute_mutex.LogStats();
+}
+
+bool PlayerProvider::subscribeStateChange(int proxyId, const std::string& connectionName) {
+    if (sig_id_state_change_[proxyId])
+        return true;
+
+    GError *error = NULL;
+    gbus_sync_connection_[proxyId] = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, &error);
+    if (error) {
+        MMLogError("Failed to set up connection for signal listener : %s", error->message);
+        g_error_free(error);
+        gbus_sync_connection_[proxyId] = nullptr;
+        return false;
+    }
+
+    // sender, path and member go into the match rule, the bus drops signals of anyone else
+    MMLogInfo("proxyId = %d::connectionName = %s", proxyId, connectionName.c_str());
+    sig_id_state_change_[proxyId] = g_dbus_connection_signal_subscribe(
+      gbus_sync_connection_[proxyId],
+      connectionName.c_str(),
+      "com.lge.PlayerEngine",
+      "StateChange",
+      "/com/lge/PlayerEngine",
+      NULL,
+      G_DBUS_SIGNAL_FLAGS_NONE,
+      PlayerProvider::handleStateChange,
+      this,
+      NULL
+    );
+    return true;
+}
+
+void PlayerProvider::unsubscribeStateChange(int proxyId) {
+    if (sig_id_state_change_[proxyId])
+        g_dbus_connection_signal_unsubscribe(gbus_sync_connection_[proxyId], sig_id_state_change_[proxyId]);
+    sig_id_state_change_[proxyId] = 0;
+
+    if (gbus_sync_connection_[proxyId])
+        g_object_unref(gbus_sync_connection_[proxyId]);
+    gbus_sync_connection_[proxyId] = nullptr;
 }
 
 int PlayerProvider::preparePEProxy(std::string connectionName, bool addMode) {
@@ -3391,7 +3529,8 @@ int PlayerProvider::preparePEProxy(std::string connectionName, bool addMode) {
                 (it1->second < MAX_PLAYER_ENGINE_INSTANCE)){
                 state_[it1->second] = State::Stopped;
                 need_to_open_when_play_[it1->second] = true;
-                sig_id_state_change_[it1->second] = 0;
+                // the match rule of the cleaned engine would keep waking us up
+                unsubscribeStateChange(it1->second);
                 pe_proxy_map_.erase(clean_connection_);
             }
             clean_connection_ = "";
@@ -3437,28 +3576,8 @@ int PlayerProvider::preparePEProxy(std::string connectionName, bool addMode) {
         return -1;
     }
     MMLogInfo("playerengine_proxy_[%d] is created", proxyId);
-    gbus_sync_connection_[proxyId] = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, &error);
-    if (error) {
-        MMLogError("Failed to set up connection for signal listener : %s", error->message);
-        g_error_free(error);
+    if (!subscribeStateChange(proxyId, connectionName))
         return -1;
-    }
-
-    if (!sig_id_state_change_[proxyId]) {
-        MMLogInfo("proxyId = %d::connectionName = %s", proxyId, connectionName.c_str());
-        sig_id_state_change_[proxyId] = g_dbus_connection_signal_subscribe(
-          gbus_sync_connection_[proxyId],
-          connectionName.c_str(),
-          "com.lge.PlayerEngine",
-          "StateChange",
-          NULL,
-          NULL,
-          G_DBUS_SIGNAL_FLAGS_NONE,
-          PlayerProvider::handleStateChange,
-          this,
-          NULL
-        );
-    }
 
     return proxyId;
 }
@@ -3488,14 +3607,16 @@ bool PlayerProvider::stopTrickPlay(command::Coro::pull_type& in, bool include_se
         g_error_free(dbus_error);
     }
 
-    int32_t Idx = getPositionAttrIdx(sender_name_);
-    if (include_seek == true && Idx > -1) {
-        command::SetPositionCommand spc(this, false, stub->getPositionAttribute()[Idx].getPosition(), sender_name_, nullptr);
+    MediaStateTable::State* media_state = media_state_.Find(getMediaID(sender_name_), MediaStateTable::Position);
+    if (media_state != nullptr)
+        MediaStateTable::SetMotion(*media_state, 1.0, media_state->playing, g_get_monotonic_time());
+    if (include_seek == true && media_state != nullptr) {
+        command::SetPositionCommand spc(this, false, media_state->position_us, sender_name_, nullptr);
         spc.Execute(in);
     }
     std::vector<MM::PlayerTypes::Rate> rate_t = stub->getRateAttribute();
     std::vector<MM::PlayerTypes::Rate>::iterator itr;
-    Idx = getRateAttrIdx(sender_name_);
+    int32_t Idx = getRateAttrIdx(sender_name_);
 
     if (Idx > -1 && rate_t.size() > 0) {
         rate_t[Idx].setMedia_id(getMediaID(sender_name_));
@@ -3611,6 +3732,25 @@ void PlayerProvider::getSubtitlePath(const std::string& url, MM::PlayerTypes::Me
     }
 }
 
+void PlayerProvider::getKeyframeIndex(const std::string& url, MM::PlayerTypes::MediaType media_type, boost::property_tree::ptree& pt) {
+    if (media_type != MM::PlayerTypes::MediaType::VIDEO &&
+        media_type != MM::PlayerTypes::MediaType::USB_VIDEO1 &&
+        media_type != MM::PlayerTypes::MediaType::USB_VIDEO2)
+        return;
+
+    std::size_t found = url.find(kFilePrefix);
+    if (found == std::string::npos)
+        return;
+
+    std::string path = url.substr(found + kFilePrefix.size());
+    char index_path[PATH_MAX];
+    // a stale index would send seeks to wrong offsets, it is checked against size and mtime of the file
+    if (lms_keyframe_index_find(path.c_str(), index_path, sizeof(index_path)) == 0) {
+        MMLogInfo("keyframe index=[%s]", index_path);
+        pt.put("keyframe-index", std::string(index_path));
+    }
+}
+
 bool PlayerProvider::getVideoResolution(const ptree& pt, int32_t& out_width, int32_t& out_height) {
     out_width = 0;
     out_height = 0;
@@ -3705,41 +3845,27 @@ void PlayerProvider::addRecorderOption(boost::property_tree::ptree& pt) {
     }
 }
 
-void PlayerProvider::sendDbusCaching(Caching mode, std::string& cache_url) {
-    GError *error = NULL;
-    GVariant *ret = NULL;
-    GVariant *params = NULL;
+bool PlayerProvider::makeCachingCall(Caching mode, const std::string& cache_url, const gchar** method_name, GVariant** params) {
     const gchar* check_utf8 = NULL;
-    const gchar* method_name = NULL;
     const gchar* subtitle_path = NULL;
     if (cache_url.size() == 0) {
         MMLogError("Invalid cache url");
-        return;
-    }
-
-    GDBusConnection *conn = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
-    if (conn == NULL || error) {
-        MMLogError("get dbus connection fail");
-        if (error)
-            g_error_free(error);
-        return;
+        return false;
     }
 
     if (mode == Caching::SetCachedMusic || mode == Caching::SetCachedMovie) {
         std::string cdn_url = "";
         std::string golf_full_path(GOLF_SUBTITLE_PATH);
-        int32_t Idx = getCurrentTrackAttrIdx(sender_name_);
-        if (Idx < 0) {
+        MediaStateTable::State* opened = media_state_.Find(getMediaID(sender_name_), MediaStateTable::CurrentTrack);
+        if (opened == nullptr) {
             MMLogError("Invalid Track index");
-            g_object_unref(conn);
-            return;
+            return false;
         }
 
-        cdn_url = track_opened_[Idx].getUri();
+        cdn_url = opened->track.getUri();
         if (cdn_url.size() < 3) {
             MMLogError("Invalid cdn url[%s]", cdn_url.c_str());
-            g_object_unref(conn);
-            return;
+            return false;
         }
 
         if (cdn_url.at(0) == '[' && cdn_url.at(2) == ']')
@@ -3770,68 +3896,95 @@ void PlayerProvider::sendDbusCaching(Caching mode, std::string& cache_url) {
         }
 
         if (mode == Caching::SetCachedMusic) {
-            method_name = CACHE_SETCACHEDMUSIC;
-            params = g_variant_new ("(ss)", check_utf8, cache_url.c_str());
-        } else if (mode == Caching::SetCachedMovie) {
-            method_name = CACHE_SETCACHEDMOVIE;
-            params = g_variant_new ("(sss)", check_utf8, cache_url.c_str(), subtitle_path);
+            *method_name = CACHE_SETCACHEDMUSIC;
+            *params = g_variant_new ("(ss)", check_utf8, cache_url.c_str());
+        } else {
+            *method_name = CACHE_SETCACHEDMOVIE;
+            *params = g_variant_new ("(sss)", check_utf8, cache_url.c_str(), subtitle_path);
         }
     } else if (mode == Caching::GetCachedMovie) {
         std::string cdn_url = cache_url;
         if (cdn_url.at(0) == '[' && cdn_url.at(2) == ']')
             cdn_url.erase(0, 3);
-        method_name = CACHE_GETCACHEDMOVIE;
-        params = g_variant_new ("(s)", cdn_url.c_str());
+        *method_name = CACHE_GETCACHEDMOVIE;
+        *params = g_variant_new ("(s)", cdn_url.c_str());
     } else {
         // SHOULD NOT BE HERE
         MMLogError("Invalid argument");
-        g_object_unref(conn);
-        return;
+        return false;
     }
+    return true;
+}
 
-    ret = g_dbus_connection_call_sync(conn, CACHE_SERVICE_NAME, CACHE_OBJECT_PATH, CACHE_INTERFACE_NAME, method_name,
-                                      params, /* No need to unref*/
-                                      NULL,
-                                      G_DBUS_CALL_FLAGS_NONE,
-                                      -1,
-                                      NULL,
-                                      &error);
-    if (error) {
-        MMLogError("caching gdbus call fail");
-        g_error_free(error);
-        g_object_unref(conn);
+void PlayerProvider::handleCachingReply(Caching mode, GVariant* ret, std::string& cache_url) {
+    gchar* ret_1 = NULL;
+    gchar* ret_2 = NULL;
+    gchar* ret_3 = NULL;
+    if (mode == Caching::SetCachedMusic)
+        g_variant_get(ret, "(ss)", &ret_1, &ret_2); // "OK" / "NOT_FOUND" / "FAIL"
+    else
+        g_variant_get(ret, "(sss)", &ret_1, &ret_2, &ret_3); // "OK" / "NOT_FOUND" / "FAIL"
+    MMLogInfo("gdbus return OK, [%s], [%s], [%s]", ret_1, ret_2, ret_3);
+
+    if (mode == Caching::GetCachedMovie && g_strcmp0(ret_1, "OK") == 0) {
+        std::string saved_path(ret_2 ? ret_2 : "");
+        saved_path.insert(0, "file://");
+        if (cache_url.at(0) == '[' && cache_url.at(2) == ']')
+            saved_path.insert(0, cache_url, 0, 3);
+        cache_url = saved_path;
+        MMLogInfo("updated url=[%s]", cache_url.c_str());
+    }
+    g_free(ret_1);
+    g_free(ret_2);
+    if (ret_3)
+        g_free(ret_3);
+}
+
+void PlayerProvider::sendDbusCaching(Caching mode, std::string& cache_url) {
+    const gchar* method_name = NULL;
+    GVariant* params = NULL;
+    if (!makeCachingCall(mode, cache_url, &method_name, &params))
         return;
+
+    caching_client_.Call(method_name, params, [this, mode, cache_url](GVariant* ret) {
+        std::string url(cache_url);
+        if (ret)
+            handleCachingReply(mode, ret, url);
+    });
+}
+
+bool PlayerProvider::sendDbusCaching(command::Coro::pull_type& in, Caching mode, std::string& cache_url,
+                                     const std::string& connectionName) {
+    const gchar* method_name = NULL;
+    GVariant* params = NULL;
+    if (!makeCachingCall(mode, cache_url, &method_name, &params))
+        return false;
+
+    // other lanes keep running while the caching service answers
+    std::shared_ptr<AsyncCall> call = newAsyncCall(connectionName);
+    caching_client_.Call(method_name, params, call->Cancellable(),
+                         (GAsyncReadyCallback)AsyncCall::Callback, call->UserData());
+
+    command::WaitResult waited = waitAsyncCall(in, call);
+    if (waited == command::WaitResult::TimedOut) {
+        // the call is cancelled, a late reply is dropped
+        MMLogError("[%s] of caching service timed out in %u ms", method_name, PLAYERENGINE_CALL_TIMEOUT_MS);
+        return false;
     }
+    if (waited != command::WaitResult::Succeeded)
+        return false;
 
-    if (ret) {
-        gchar* ret_1 = NULL;
-        gchar* ret_2 = NULL;
-        gchar* ret_3 = NULL;
-        if (mode == Caching::SetCachedMusic)
-            g_variant_get(ret, "(ss)", &ret_1, &ret_2); // "OK" / "NOT_FOUND" / "FAIL"
-        else
-            g_variant_get(ret, "(sss)", &ret_1, &ret_2, &ret_3); // "OK" / "NOT_FOUND" / "FAIL"
-        MMLogInfo("gdbus return OK, [%s], [%s], [%s]", ret_1, ret_2, ret_3);
-
-        if (mode == Caching::GetCachedMovie && g_strcmp0(ret_1, "OK") == 0) {
-            std::string saved_path(ret_2 ? ret_2 : "");
-            saved_path.insert(0, "file://");
-            if (cache_url.at(0) == '[' && cache_url.at(2) == ']')
-                saved_path.insert(0, cache_url, 0, 3);
-            cache_url = saved_path;
-            MMLogInfo("updated url=[%s]", cache_url.c_str());
-        }
-        g_free(ret_1);
-        g_free(ret_2);
-        if (ret_3)
-            g_free(ret_3);
-        g_variant_unref(ret);
-        ret = NULL;
-    }
-    if (conn) {
-        g_object_unref(conn);
-        conn = NULL;
+    GError* error = NULL;
+    GVariant* reply = CachingClient::Finish(call->Result(), &error);
+    if (error) {
+        MMLogError("caching gdbus call [%s] fail : %s", method_name, error->message);
+        g_error_free(error);
     }
+    if (reply == nullptr)
+        return false;
+    handleCachingReply(mode, reply, cache_url);
+    g_variant_unref(reply);
+    return true;
 }
 
 std::string PlayerProvider::MediaTypeToString(MM::PlayerTypes::MediaType media_type) {
@@ -17,22 +17,30 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/coroutine/all.hpp>
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <map>
+#include <set>
 #include <iterator>
 
 #include <CommonAPI/CommonAPI.hpp>
 #include "v1/org/genivi/mediamanager/PlayerStubDefault.hpp"
 #include "dbus_player_interface.h"
 
+#include "async_call.h"
+#include "caching_client.h"
 #include "common.h"
 #include "command_queue.h"
 #include "commands.h"
 #include "event_system.h"
+#include "media_shard_lock.h"
+#include "media_state_table.h"
 #include "playback_option.h"
 #include "player_receiver_interface.h"
+#include "resume_store.h"
 #include "serviceprovider.h"
 #include "state_change_notifier.h"
+#include "transcode_service.h"
 #include "playlist/playlist.h"
 
 namespace lge {
@@ -40,6 +48,9 @@ namespace mm {
 namespace player {
 
 #define MAX_PLAYER_ENGINE_INSTANCE 14 
+#define TRANSCODE_MEDIA_ID_BASE 0x40000000 // above pid_max, media ids of PlayerEngines are pids
+#define DEFAULT_STATE_PUBLISH_INTERVAL_MS 200  // state_publish_interval_ms of mediamanager.cfg when not set (5 Hz)
+#define DEFAULT_POSITION_PUBLISH_DRIFT_MS 1000 // position_publish_drift_ms of mediamanager.cfg when not set
 
 /**
 * @class lge::mm::player::PlayerProvider
@@ -120,6 +131,18 @@ public:
     */
     void ServiceRegistered();
 
+    /**
+    * @fn GetResumePosition
+    * @brief Gets the position kept for a track, for a client which opens it with this position.
+    * @section function_none Function Flow : None
+    * @param[in] uri : track uri
+    * @param[out] pos_us : position
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return bool (true - found)
+    */
+    bool GetResumePosition(const std::string& uri, uint64_t& pos_us) { return resume_store_.Get(uri, pos_us); }
+
     /**
     * @fn PEDestroyed
     * @brief Informs that PlayerEngine is recovered from exit.
@@ -133,11 +156,42 @@ public:
     */
     void PEDestroyed(int mediaId = 0);
 
+    /**
+    * @fn PEExited
+    * @brief Informs that PlayerEngine process exited unexpectedly, called by the process monitor.
+    * @section function Function Flow
+    * - Checks the engine was bound and invokes error handler in command handling thread.
+    *
+    * @param[in] pid : pid of PlayerEngine, same as media id
+    * @param[in] is_bound : tells whether pid is bound to a media, called in command handling thread
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : None
+    */
+    void PEExited(int pid, std::function<bool(int)> is_bound);
+
+#ifdef MM_REPLAY
+    /**
+    * @fn attachReplayEngine
+    * @brief Used by mm_replay, built with MM_REPLAY only. Registers a fake PlayerEngine without launching it.
+    * @section function Function Flow
+    * - Maps media id to the connection name and prepares proxy and StateChange subscription
+    *   in command handling thread, and waits for it. Must not be called in that thread.
+    *
+    * @param[in] connectionName : unique bus name of the fake PlayerEngine
+    * @param[in] mediaId : media id used by the recorded commands
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return int : proxy id (-1 - FAIL)
+    */
+    int attachReplayEngine(const std::string& connectionName, int mediaId);
+#endif
+
     /**
     * @fn getMediaID
     * @brief gets the media id mapped to connection name.
     * @section function Function Flow
-    * - Searches the media id mapped to connection name in the map.
+    * - Looks up the connection name index of media_state_.
     *
     * @param[in] connectionName : connection name
     * @section global_variable_none Global Variables : None
@@ -146,13 +200,18 @@ public:
     */
     uint32_t getMediaID(std::string connectionName);
 
-    int32_t getDurationAttrIdx(std::string connectionName);
-
-    int32_t getPositionAttrIdx(std::string connectionName);
-
-    int32_t getBufferingAttrIdx(std::string connectionName);
-
-    int32_t getCurrentTrackAttrIdx(std::string connectionName);
+    /**
+    * @fn mediaTypeOf
+    * @brief gets the media type of the track opened on the connection.
+    * @section function Function Flow
+    * - Falls back to the last requested media type if nothing is opened on the connection.
+    *
+    * @param[in] connectionName : connection name
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : media type
+    */
+    MM::PlayerTypes::MediaType mediaTypeOf(const std::string& connectionName);
 
     int32_t getMuteAttrIdx(std::string connectionName);
 
@@ -160,10 +219,154 @@ public:
 
     int32_t getSpeedAttrIdx(std::string connectionName);
 
-    int32_t getPlaybackAttrIdx(std::string connectionName);
-
     int32_t getVolumeAttrIdx(std::string connectionName);
 
+    /**
+    * @fn publishState
+    * @brief Sets stub attributes built from media_state_ right away.
+    * @section function Function Flow
+    * - Sets each attribute of fields and of pending dirty fields with the list of MediaStateTable.
+    *
+    * @param[in] fields : MediaStateTable::Field bits
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : None
+    */
+    void publishState(uint8_t fields);
+
+    /**
+    * @fn publishStateLater
+    * @brief Marks fields dirty and publishes them at most once per Option::state_publish_interval_ms().
+    * @section function Function Flow
+    * - Publishes right away when the interval has passed since the last publication.
+    * - Otherwise arms one timeout on the command handling context, later calls are coalesced.
+    *
+    * @param[in] fields : MediaStateTable::Field bits
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : None
+    */
+    void publishStateLater(uint8_t fields);
+
+    static gboolean onPublishState(gpointer user_data);
+
+    /**
+    * @fn schedulePositionDrift
+    * @brief Arms a timeout for when an extrapolated position has moved Option::position_publish_drift_ms()
+    *        away from the published one, so Position is not published while nothing changed.
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : None
+    */
+    void schedulePositionDrift();
+
+    static gboolean onPositionDrift(gpointer user_data);
+
+    struct TrackGapStats {
+        uint32_t count = 0;
+        gint64 sum_us = 0;
+        gint64 max_us = 0;
+    };
+
+    /**
+    * @fn recordTrackGap
+    * @brief Records time from EndOfStream to playing of the next track, and logs the statistics.
+    * @param[in] media_id : media id
+    * @param[in] gap_us : transition gap
+    * @return : None
+    */
+    void recordTrackGap(uint32_t media_id, gint64 gap_us);
+
+    /**
+    * @fn saveResumePosition
+    * @brief Keeps the position of a resumable track in resume_store_.
+    * @section function Function Flow
+    * - Puts the position, which costs no file access.
+    * - Arms one timeout of RESUME_STORE_FLUSH_INTERVAL_MS to flush, later calls are coalesced.
+    * - sync flushes right away and has the disk written by the sync thread of ResumeStore, for stop.
+    *
+    * @param[in] state : state having CurrentTrack
+    * @param[in] sync : true - flush now
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : None
+    */
+    void saveResumePosition(const MediaStateTable::State& state, bool sync);
+
+    static gboolean onFlushResume(gpointer user_data);
+
+    /**
+    * @fn startTranscode
+    * @brief Queues transcoding of uri to the output given by arrangeTranscodeOutput().
+    * @section function Function Flow
+    * - Runs in transcode_service_, no PlayerEngine nor command is taken.
+    * - Progress is published as Position and Duration of the returned media id.
+    * - The end is notified as EOS, a failure as PLAYBACK_INTERNAL_ERROR.
+    *
+    * @param[in] uri : input uri
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return uint32_t (media id of the job, 0 - FAIL)
+    */
+    uint32_t startTranscode(const std::string& uri);
+
+    /**
+    * @fn stopTranscode
+    * @brief Cancels the transcoding job and removes its partial output.
+    * @param[in] media_id : media id returned by startTranscode()
+    * @return bool (true - cancelled, false - no such job)
+    */
+    bool stopTranscode(uint32_t media_id);
+
+    static bool IsTranscodeMediaId(uint32_t media_id) { return (media_id & TRANSCODE_MEDIA_ID_BASE) != 0; }
+
+    void onTranscodeProgress(uint32_t media_id, uint64_t position_us, uint64_t duration_us);
+    void onTranscodeDone(uint32_t media_id, TranscodeService::Result result, const std::string& message);
+
+    /**
+    * @fn updatePosition
+    * @brief Updates position of the connection and publishes it as active.
+    * @section function Function Flow
+    * - Does nothing if the connection has no position yet.
+    *
+    * @param[in] connectionName : connection name
+    * @param[in] pos_us : new position
+    * @param[in] immediate : false for periodic CurrentTime, publication is rate limited and
+    *                        the error of the position model is recorded before re-anchoring
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return bool (true - updated)
+    */
+    bool updatePosition(const std::string& connectionName, uint64_t pos_us, bool immediate = true);
+
+    /**
+    * @fn updateDuration
+    * @brief Updates duration of the connection and publishes it as active.
+    * @section function Function Flow
+    * - Does nothing if the connection has no duration yet.
+    *
+    * @param[in] connectionName : connection name
+    * @param[in] duration_us : new duration
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return bool (true - updated)
+    */
+    bool updateDuration(const std::string& connectionName, uint64_t duration_us);
+
+    /**
+    * @fn updatePlaybackStatus
+    * @brief Updates playback status of the connection and publishes it as active.
+    * @section function Function Flow
+    * - Does nothing if the connection has no playback status yet.
+    *
+    * @param[in] connectionName : connection name
+    * @param[in] status : new status
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return bool (true - updated)
+    */
+    bool updatePlaybackStatus(const std::string& connectionName, ::v1::org::genivi::mediamanager::PlayerTypes::PlaybackStatus status);
+
     /**
     * @fn bool process(command::Coro::pull_type&, command::OpenUriCommand*);
     * @brief Handles OpenUriCommand.
@@ -863,34 +1066,69 @@ private:
     */
     void resetPEProxy(std::string connectionName);
 
+    /**
+    * @fn subscribeStateChange
+    * @brief Subscribes StateChange signal of one PlayerEngine.
+    * @section function Function Flow
+    * - Installs a match rule with sender, object path and member of the engine,
+    *   so signals of other engines and services never reach this process.
+    *
+    * @param[in] proxyId : proxy id of the engine
+    * @param[in] connectionName : unique bus name of the engine
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return bool (true - SUCCESS, false - FAIL)
+    */
+    bool subscribeStateChange(int proxyId, const std::string& connectionName);
+
+    /**
+    * @fn unsubscribeStateChange
+    * @brief Removes the subscription and match rule of subscribeStateChange().
+    * @param[in] proxyId : proxy id of the engine
+    * @return : None
+    */
+    void unsubscribeStateChange(int proxyId);
+
+    struct SignalStats {
+        uint64_t received = 0;  // dispatched to handleStateChange()
+        uint64_t handled = 0;   // passed to a handler
+        uint64_t stale = 0;     // sender has no proxy anymore
+        uint64_t unknown = 0;   // signal without handler
+    };
+
     ComLgePlayerEngine* playerengine_proxy_[MAX_PLAYER_ENGINE_INSTANCE];
     guint sig_id_state_change_[MAX_PLAYER_ENGINE_INSTANCE];
     GDBusConnection *gbus_sync_connection_[MAX_PLAYER_ENGINE_INSTANCE];
+    SignalStats signal_stats_;
     // proxy ->>
 
     // <<- event handling
     /**
-    * @fn callAsyncCallback
-    * @brief Handles completion of asynchronous gdbus call to PlayerEngine.
-    * @section function Function Flow
-    * - Invokes handler for event that indicates completion of the asynchronous gdbus call.
-    *
-    * @param[in] source_object : PlayerEngine proxy.
-    * @param[in] res : result of the gdbus call.
-    * @param[in] user_data : context of the gdbus call.
-    * @section global_variable_none Global Variables : None
-    * @section dependencies_none Dependencies : None
-    * @return bool (true - SUCCESS, false - FAIL)
+    * @fn newAsyncCall
+    * @brief Creates the state of an asynchronous gdbus call to PlayerEngine.
+    * @param[in] connectionName : PlayerEngine, its lane gets CallAsync when the reply comes
+    * @return std::shared_ptr<AsyncCall>
+    */
+    std::shared_ptr<AsyncCall> newAsyncCall(const std::string& connectionName);
+
+    /**
+    * @fn waitAsyncCall
+    * @brief Waits for the reply of the call, cancels the call if the wait times out.
+    * @param[in] in : coroutine of the command
+    * @param[in] call : state created by newAsyncCall()
+    * @return command::WaitResult (Succeeded - got the reply, Failed - no result,
+    *         TimedOut - no reply in PLAYERENGINE_CALL_TIMEOUT_MS)
     */
-    static void callAsyncCallback(GObject *source_object, GAsyncResult *res, gpointer user_data);
+    command::WaitResult waitAsyncCall(command::Coro::pull_type& in, std::shared_ptr<AsyncCall>& call);
 
     /**
     * @fn handleStateChange
     * @brief Callback function for handling StateChanged event from PlayerEngine
     * @section function Function Flow
     * @section function Function Flow
-    * - Parses parameters from PlayerEngine.
-    * - Looks for event handler.
+    * - Drops signals of engines already reset, counts them in signal_stats_.
+    * - Decodes parameters from PlayerEngine with DecodePESignal(), without building a tree.
+    * - Switches on PESignal, only structured signals parse their JSON body.
     * - Executes the event handler.
     *
     * @param[in] connection : gdbus connection
@@ -916,7 +1154,7 @@ private:
     /**
     * @fn onContentType
     */
-    void onContentType(const boost::property_tree::ptree& pt);
+    void onContentType(const std::string& name);
 
     /**
     * @fn onPEDestroyed
@@ -933,6 +1171,14 @@ private:
 
     void onPEDestroyed(const boost::property_tree::ptree& pt, int mediaId);
 
+    /**
+    * @fn handlePEDestroyed
+    * @brief Handles a destroyed PlayerEngine once per media id, in command handling thread.
+    * @param[in] destroy_mid : media id of PlayerEngine, 0 if unknown
+    * @return : None
+    */
+    void handlePEDestroyed(int destroy_mid);
+
     /**
     * @fn onCallAsync
     * @brief Handles event that asynchronous gdbus call is finished.
@@ -963,44 +1209,41 @@ private:
     * @fn onDuration
     * @brief Sub function for handleStateChange(). This handles Duration event.
     * @section function Function Flow
-    * - Extracts duration from boost::property_tree object.
     * - Updates Duration attribute.
     *
-    * @param[in] pt : parameter about event.
+    * @param[in] duration_ms : duration
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onDuration(const boost::property_tree::ptree& pt);
+    void onDuration(gint64 duration_ms);
 
     /**
     * @fn onCurrentTime
     * @brief Sub function for handleStateChange(). This handles CurrentTime event.
     * @section function Function Flow
-    * - Extracts current time from boost::property_tree object.
     * - Updates current time attribute.
     *
-    * @param[in] pt : parameter about event.
+    * @param[in] current_time_ms : position reported by PlayerEngine
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onCurrentTime(const boost::property_tree::ptree& pt);
+    void onCurrentTime(gint64 current_time_ms);
 
     /**
     * @fn onPlaybackStatus
     * @brief Sub function for handleStateChange(). This handles PlaybackStatus event.
     * @section function Function Flow
-    * - Extracts playback status from boost::property_tree object.
     * - Updates playback status.
     * - If current track is changed, plays new track.
     *
-    * @param[in] pt : parameter about event.
+    * @param[in] status : Playing, Paused, Ready or Stopped
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onPlaybackStatus(const boost::property_tree::ptree& pt);
+    void onPlaybackStatus(const std::string& status);
 
     /**
     * @fn onTrickAndBOS
@@ -1039,12 +1282,11 @@ private:
     * - Notifies Begin-Of-Stream event occured.
     * - If it was trick playback mode, invokes onTrickAndBOS().
     *
-    * @param[in] pt : parameter about event.
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onBeginOfStream(const boost::property_tree::ptree& pt);
+    void onBeginOfStream();
 
     /**
     * @fn onEndOfStream
@@ -1056,12 +1298,11 @@ private:
     * - If it needed to repeat current track, jumps to the begin of the current track.
     * - If it needed to stop, stops playback.
     *
-    * @param[in] pt : parameter about event.
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onEndOfStream(const boost::property_tree::ptree& pt);
+    void onEndOfStream();
 
     /**
     * @fn onAsyncDone
@@ -1069,12 +1310,11 @@ private:
     * @section function Function Flow
     * - Informs AsyncDone event to EventSystem.
     *
-    * @param[in] pt : parameter about event.
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onAsyncDone(const boost::property_tree::ptree& pt);
+    void onAsyncDone();
 
     /**
     * @fn onSourceInfo
@@ -1100,12 +1340,11 @@ private:
     * @section function Function Flow
     * - Notifies subtitle updated.
     *
-    * @param[in] pt : parameter about event.
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
     * @return : None
     */
-    void onSubtitle(const boost::property_tree::ptree& pt);
+    void onSubtitle();
 
     /**
     * @fn onChannelEvent
@@ -1283,6 +1522,23 @@ private:
     */
     void getSubtitlePath(const std::string& url, ::v1::org::genivi::mediamanager::PlayerTypes::MediaType type, boost::property_tree::ptree& pt);
 
+    /**
+    * @fn getKeyframeIndex
+    * @brief Gets keyframe index built by the media scanner for local video.
+    * @section function Function Flow
+    * - add index file of the media scanner to the open option.
+    *
+    * @param[in] url : video Url to open.
+    * @param[in] type : media type.<BR>
+    *                   refer /git/src/interfaces/fidl/mm/PlayerTypes.fidl
+    * @param[inout] pt : boost::property_tree object, "keyframe-index" is set to the index file
+    *                    when it is valid for the current file.
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return : None
+    */
+    void getKeyframeIndex(const std::string& url, ::v1::org::genivi::mediamanager::PlayerTypes::MediaType type, boost::property_tree::ptree& pt);
+
     /**
     * @fn getVideoResolution
     * @brief Gets video resolution from the given boost::property_tree.
@@ -1330,6 +1586,8 @@ private:
     * @section function Function Flow
     * - Add recorder option into ptree.
     *
+    * - The caller holds transcode_mutex_, the options are set by the stub thread.
+    *
     * @param[in] pt : base ptree of openUri
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
@@ -1339,11 +1597,11 @@ private:
 
     /**
     * @fn sendDbusCaching
-    * @brief Send dbus call to caching service.
+    * @brief Send dbus call to caching service without waiting for the reply.
     * @section function Function Flow
-    * - Get/Set cached/caching url information.
+    * - Set cached/caching url information, the reply is only logged.
     *
-    * @param[in] is_set : get / set request
+    * @param[in] mode : SetCachedMusic / SetCachedMovie
     * @param[in] cache_url : url path of cached/caching file
     * @section global_variable_none Global Variables : None
     * @section dependencies_none Dependencies : None
@@ -1351,6 +1609,28 @@ private:
     */
     void sendDbusCaching(Caching mode, std::string& cache_url);
 
+    /**
+    * @fn sendDbusCaching
+    * @brief Send dbus call to caching service and wait for the reply in the coroutine.
+    * @section function Function Flow
+    * - Calls with caching_client_ and waits in waitAsyncCall(), as a call to PlayerEngine does.
+    * - Commands of other PlayerEngines keep running meanwhile.
+    *
+    * @param[in] in : coroutine of the command
+    * @param[in] mode : GetCachedMovie
+    * @param[inout] cache_url : url, replaced with the cached file when found
+    * @param[in] connectionName : connection name of the command
+    * @section global_variable_none Global Variables : None
+    * @section dependencies_none Dependencies : None
+    * @return bool (true - replied, false - failed or timed out)
+    */
+    bool sendDbusCaching(command::Coro::pull_type& in, Caching mode, std::string& cache_url,
+                         const std::string& connectionName);
+
+    bool makeCachingCall(Caching mode, const std::string& cache_url, const gchar** method_name, GVariant** params);
+
+    void handleCachingReply(Caching mode, GVariant* ret, std::string& cache_url);
+
     /**
     * @fn MediaTypeToString
     * @brief Returns the mediatype as string.
@@ -1462,31 +1742,43 @@ private:
     ::v1::org::genivi::mediamanager::PlayerTypes::FileFormatType file_type_;
 
     bool need_to_open_when_play_[MAX_PLAYER_ENGINE_INSTANCE];
-    std::vector<::v1::org::genivi::mediamanager::PlayerTypes::Track> track_opened_;
+    MediaStateTable media_state_;
+    CachingClient caching_client_;
+    ResumeStore resume_store_;
+    TranscodeService transcode_service_;
+    std::mutex transcode_mutex_;      // transcode_tracks_ and the arranged output, set by stub and read in command thread
+    std::shared_ptr<bool> transcode_token_;   // reset by the destructor, see the transcode callbacks
+    std::map<uint32_t, ::v1::org::genivi::mediamanager::PlayerTypes::Track> transcode_tracks_;
     ::v1::org::genivi::mediamanager::PlayerTypes::MediaType media_type_;
     PlaybackOption playback_option_;
     command::SetVideoWindowCommand::Info video_window_backup_;
 
     State state_[MAX_PLAYER_ENGINE_INSTANCE];
-    bool is_playing_;
     bool is_need_new_index_;
     std::atomic<bool> is_Error_state; // For Eroor handling pause case (BAVN-6776)
     std::atomic<bool> is_EOS_state_; // For EOS pause case (BAVN-6023)
-    std::atomic<bool> is_need_pause_; // For EOS pause case (BAVN-6023)
-    int32_t seeking_position_idx;
+    uint32_t seeking_media_id_;
+    uint8_t dirty_state_;             // MediaStateTable::Field bits waiting for publishStateLater()
+    gint64 last_state_publish_us_;
+    GSource* state_publish_source_;
+    GSource* position_drift_source_;  // see schedulePositionDrift()
+    TrackGapStats track_gap_stats_;
+    GSource* resume_flush_source_;
     int last_fail_media_id_;
     int multi_channel_media_id_;
     std::string multi_channel_media_type_;
     std::string clean_connection_;
     std::string single_connection_name_;
 
-    std::mutex _mutex;
-    std::mutex _attribute_mutex;
+    MediaShardLocks media_locks_;     // state of one media, e.g. pause against error handling
+    MediaFlags media_flags_;          // playing and pause request of each media, under media_locks_
+    ProfiledMutex _attribute_mutex;   // attribute vectors of the stub, shared by all media
     bool playback_blocked_;
     Direction play_direction_;
     bool updated_current_time_since_trickplay_;
     static std::string sender_name_;
     std::map<int, std::string> connection_map_;
+    std::set<int> destroyed_media_ids_;   // handled by handlePEDestroyed(), until opened again
     double saturation_;
     double brightness_;
     double contrast_;
@@ -1496,9 +1788,6 @@ private:
     std::string cache_path_buffer_;
 
     std::map<std::string, std::string> pe_audio_slot_map_;
-    std::string audio_slot_num_;
-    std::string audio_slot_num_2ch_;
-    std::string audio_slot_num_6ch_;
     std::map<std::string, bool> speed_ignore_buffering_map_;
 };
 
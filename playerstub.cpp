@@ -9,6 +9,18 @@ namespace lge {
 namespace mm {
 namespace player {
 int PlayerStubImpl::default_media_id = 0;
+std::mutex PlayerStubImpl::default_media_id_mutex_;
+
+// written by the CommonAPI thread and the restore of main, read by the exit callback of the monitor
+void PlayerStubImpl::SetDefaultMediaId(int id) {
+    std::lock_guard<std::mutex> locker(default_media_id_mutex_);
+    default_media_id = id;
+}
+
+int PlayerStubImpl::DefaultMediaId() {
+    std::lock_guard<std::mutex> locker(default_media_id_mutex_);
+    return default_media_id;
+}
 
 PlayerStubImpl::PlayerStubImpl(PlayerProvider *player, std::shared_ptr<command::Queue>& sp_command_queue)
   : attr_mutex_(),
@@ -22,8 +34,18 @@ PlayerStubImpl::PlayerStubImpl(PlayerProvider *player, std::shared_ptr<command::
     map_media_id_.clear();
 
     playerenginemanager_ = new (std::nothrow) PlayerEngineManager();
-    if (playerenginemanager_ == nullptr)
+    if (playerenginemanager_ == nullptr) {
         MMLogDebug("Bad allocation while creating playerengine manager");
+    } else {
+        playerenginemanager_->setExitCallback([this](int pid, bool expected) {
+            if (expected)
+                return;
+            player_->PEExited(pid, [this](int pid) {
+                // connectionMap is guarded in PlayerEngineManager
+                return (pid == DefaultMediaId() || playerenginemanager_->getConnectionName(pid).size() > 0);
+            });
+        });
+    }
 
     try {
         initializeDefaultValues();
@@ -113,17 +135,33 @@ void PlayerStubImpl::initializeDefaultValues() {
 void PlayerStubImpl::arrangeTranscodeOutput(const std::shared_ptr<CommonAPI::ClientId> _client, std::string _out_uri, MM::PlayerTypes::ACodecType _c_type,
         MM::PlayerTypes::FileFormatType _f_type, std::string _location, std::string _platform, arrangeTranscodeOutputReply_t _reply) {
     MMLogInfo("url=[%s]", _out_uri.c_str());
-    player_->uri_transcode_output_ = _out_uri;
-    player_->codec_type_ = _c_type;
-    player_->file_type_ = _f_type;
-    player_->file_location = _location;
-    player_->platform_name = _platform;
+    {
+        std::lock_guard<std::mutex> locker(player_->transcode_mutex_);
+        player_->uri_transcode_output_ = _out_uri;
+        player_->codec_type_ = _c_type;
+        player_->file_type_ = _f_type;
+        player_->file_location = _location;
+        player_->platform_name = _platform;
+    }
     _reply(MM::PlayerTypes::PlayerError::NO_ERROR);
 }
 
 void PlayerStubImpl::openUri(const std::shared_ptr<CommonAPI::ClientId> _client,
                              std::string _uri, uint32_t _channels, MM::PlayerTypes::MediaType _type, openUriReply_t _reply) {
     MMLogInfo("load contents.. channels=[%u]", _channels);
+    bool transcode = false;
+    if (_type == MM::PlayerTypes::MediaType::STREAM) {
+        std::lock_guard<std::mutex> locker(player_->transcode_mutex_);
+        transcode = !player_->uri_transcode_output_.empty();
+    }
+    if (transcode) {
+        // transcoding runs in media manager, a PlayerEngine is not needed
+        uint32_t transcodeId = player_->startTranscode(_uri);
+        MMLogInfo("transcode job=[%u]", transcodeId);
+        _reply(transcodeId > 0 ? MM::PlayerTypes::PlayerError::NO_ERROR : MM::PlayerTypes::PlayerError::MEDIA_MANAGER_INTERNAL_ERROR,
+               transcodeId);
+        return;
+    }
     int mediaId = 0;
     int retCnt = 10;
     std::string connectionName;
@@ -139,15 +177,10 @@ void PlayerStubImpl::openUri(const std::shared_ptr<CommonAPI::ClientId> _client,
         } else {
             MMLogInfo("Invalid connection name(null) received for default - restoring connection[%d]", default_media_id);
             if (default_media_id <= 0) {
-                playerenginemanager_->createPlayerEngine();
-                default_media_id = playerenginemanager_->getPID();
-                connectionName = playerenginemanager_->getConnectionName();
-                while (retCnt > 0 && !playerenginemanager_->checkValidConnectionName(default_media_id, connectionName)) {
-                    MMLogInfo("Duplicated connection name is detected.. retry getConnection");
-                    retCnt--;
-                    usleep(100 * 1000);
-                    connectionName = playerenginemanager_->getConnectionName();
-                }
+                int acquired_id = 0;
+                if (!playerenginemanager_->acquirePlayerEngine(acquired_id, connectionName))
+                    acquired_id = 0;
+                SetDefaultMediaId(acquired_id);
 
                 if (default_media_id <= 0 || connectionName.empty()) {
                     MMLogError("Fail to restore");
@@ -202,25 +235,14 @@ void PlayerStubImpl::openUri(const std::shared_ptr<CommonAPI::ClientId> _client,
             }
         } else {
             if (max_pe_instance_ <= MAX_PLAYER_ENGINE_INSTANCE) {
-                max_pe_instance_++;
-                playerenginemanager_->createPlayerEngine();
-                mediaId = playerenginemanager_->getPID();
-                map_media_id_[currentType] = mediaId;
-
-                connectionName = playerenginemanager_->getConnectionName();
-                retCnt = 20; // Timeout 2s -> 4s
-                while (retCnt > 0 && !playerenginemanager_->checkValidConnectionName(mediaId, connectionName)) {
-                    MMLogInfo("Duplicated connection name is detected.. retry getConnection");
-                    retCnt--;
-                    usleep(100 * 1000);
-                    connectionName = playerenginemanager_->getConnectionName();
-                }
-
-                if (retCnt == 0 && !playerenginemanager_->checkValidConnectionName(mediaId, connectionName)) {
+                if (!playerenginemanager_->acquirePlayerEngine(mediaId, connectionName)) {
                     MMLogWarn("Fail to get ConnectionName.. player-engine is not started yet.");
                     _reply(MM::PlayerTypes::PlayerError::MEDIA_MANAGER_INTERNAL_ERROR, 0);
                     return;
                 }
+                max_pe_instance_++;
+                map_media_id_[currentType] = mediaId;
+
                 if (mediaId <= 0 || connectionName.empty()) {
                     MMLogInfo("Invalid values received for map: connection name = %s media ID = %d", connectionName.c_str(), mediaId);
                     _reply(MM::PlayerTypes::PlayerError::MEDIA_MANAGER_INTERNAL_ERROR, 0);
@@ -284,11 +306,13 @@ void PlayerStubImpl::openTrack(const std::shared_ptr<CommonAPI::ClientId> _clien
 
 void PlayerStubImpl::pause(const std::shared_ptr<CommonAPI::ClientId> _client,  uint32_t _mediaId, pauseReply_t _reply) {
     MMLogInfo("media id = %d", _mediaId);
+    if (PlayerProvider::IsTranscodeMediaId(_mediaId)) { // runs until done or stop
+        _reply(MM::PlayerTypes::PlayerError::NO_ERROR);
+        return;
+    }
     std::string connectionName = playerenginemanager_->getConnectionName(_mediaId);
     MMLogInfo("connectionName = %s", connectionName.c_str());
-    player_->_mutex.lock();
-    player_->is_need_pause_ = true;
-    player_->_mutex.unlock();
+    player_->media_flags_.Set(_mediaId, MediaFlags::NeedPause, true);
     command::BaseCommand* command = new (std::nothrow) command::PauseCommand(player_, connectionName, _reply);
     if (!command)
         MMLogError("failed to allocate for PauseCommand");
@@ -298,6 +322,10 @@ void PlayerStubImpl::pause(const std::shared_ptr<CommonAPI::ClientId> _client,
 
 void PlayerStubImpl::play(const std::shared_ptr<CommonAPI::ClientId> _client, uint32_t _mediaId, playReply_t _reply) {
     MMLogInfo("media id = %d", _mediaId);
+    if (PlayerProvider::IsTranscodeMediaId(_mediaId)) { // started by openUri
+        _reply(MM::PlayerTypes::PlayerError::NO_ERROR);
+        return;
+    }
     std::string connectionName = playerenginemanager_->getConnectionName(_mediaId);
     MMLogInfo("connectionName = %s", connectionName.c_str());
     command::BaseCommand* command = new (std::nothrow) command::PlayCommand(player_, connectionName, _reply);
@@ -371,6 +399,11 @@ void PlayerStubImpl::setPosition(const std::shared_ptr<CommonAPI::ClientId> _cli
 
 void PlayerStubImpl::stop(const std::shared_ptr<CommonAPI::ClientId> _client, uint32_t _mediaId, bool _force_kill, stopReply_t _reply) {
     MMLogInfo("mid=[%u], ins_num=[%d], aid=[%d], f=[%d]", _mediaId, max_pe_instance_, default_media_id, _force_kill);
+    if (PlayerProvider::IsTranscodeMediaId(_mediaId)) {
+        player_->stopTranscode(_mediaId);
+        _reply(MM::PlayerTypes::PlayerError::NO_ERROR);
+        return;
+    }
     std::string connectionName = playerenginemanager_->getConnectionName(_mediaId);
     if (connectionName.empty() || _mediaId == 0) {
         if (player_->last_fail_media_id_ == _mediaId) {
@@ -405,14 +438,14 @@ void PlayerStubImpl::stop(const std::shared_ptr<CommonAPI::ClientId> _client, ui
             else {
                 command_queue_->Post(command);
             }
-            usleep(200000); // 200ms for stoppping player-engine (for alsa close)
+            // SIGTERM follows after PLAYERENGINE_STOP_GRACE_MS, time for the StopCommand to close alsa
         }
         // Reset proxy
         player_->resetPEProxy(connectionName);
         std::string connectionRemoved = playerenginemanager_->removeMediaId(_mediaId);
         MMLogInfo("Connection Name %s is removed from connectionMap, reuse=[%d]", connectionRemoved.c_str(), is_pe_reuse);
         if (_mediaId == default_media_id) {
-            default_media_id = 0;
+            SetDefaultMediaId(0);
         } else {
             auto iter = map_media_id_.begin();
             for (; iter != map_media_id_.end(); iter++) {
@@ -717,17 +750,17 @@ void PlayerStubImpl::checkValidMediaId() { // For checking player-engine crash
         int last_id = 0;
         int last_fail_id = player_->last_fail_media_id_;
         std::string connectionName = "";
-        if ((default_media_id > 0 && kill(default_media_id, 0) != 0) || // Check Process valid or not
+        if ((default_media_id > 0 && !playerenginemanager_->isAlive(default_media_id)) || // Check Process valid or not
             (last_fail_id > 0 && default_media_id == last_fail_id)) { // Check last fail id (for case of not exited process)
             last_id = default_media_id;
-            default_media_id = -1; // For preventing main.cpp restore logic
+            SetDefaultMediaId(-1); // For preventing main.cpp restore logic
             max_pe_instance_++; // For compensation
         } else {
             uint32_t stored_id = 0;
             auto iter = map_media_id_.begin();
             for (; iter != map_media_id_.end(); iter++) {
                 stored_id = iter->second;
-                if ((stored_id > 0 && kill(stored_id, 0) != 0) || (last_fail_id > 0 && stored_id == last_fail_id)) {
+                if ((stored_id > 0 && !playerenginemanager_->isAlive(stored_id)) || (last_fail_id > 0 && stored_id == last_fail_id)) {
                     last_id = stored_id;
                     iter->second = 0;
                 }
@@ -738,7 +771,6 @@ void PlayerStubImpl::checkValidMediaId() { // For checking player-engine crash
             MMLogInfo("checkMediaId[%d] died", last_id);
             max_pe_instance_--;
             player_->PEDestroyed(last_id);
-            usleep(10*1000); // 10ms for releasing pended command queue
             std::string connectionName = playerenginemanager_->getConnectionName(last_id);
 
             if (last_id == player_->last_fail_media_id_)
@@ -754,11 +786,10 @@ void PlayerStubImpl::checkValidMediaId() { // For checking player-engine crash
             } else {
                 command_queue_->Post(command);
             }
-            usleep(200*1000); // 200ms for stoppping player-engine (for alsa close)
-            playerenginemanager_->removeMediaId(last_id);
+            playerenginemanager_->removeMediaId(last_id); // SIGTERM after the stop grace, then SIGKILL on deadline
         } else if (default_media_id == 0 && player_->last_fail_media_id_ > 0) {
             MMLogInfo("USB_Audio exception case, PE already destroyed but not launched..");
-            default_media_id = -1;
+            SetDefaultMediaId(-1);
             max_pe_instance_++;
         }
     } else {
@@ -0,0 +1,268 @@
+#include "resume_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+namespace player {
+
+namespace {
+
+const char kMagic[4] = { 'M', 'M', 'R', 'S' };
+const uint32_t kVersion = 1;
+const uint32_t kProbes = 16;
+
+} // namespace
+
+ResumeStore::ResumeStore(const std::string& path, uint32_t slots)
+  : path_(path),
+    slots_(slots > kProbes ? slots : kProbes),
+    open_tried_(false),
+    header_(nullptr),
+    records_(nullptr),
+    map_size_(0),
+    pending_(),
+    mutex_(),
+    cv_(),
+    sync_thread_(nullptr),
+    sync_requested_(false),
+    quit_(false) {}
+
+ResumeStore::~ResumeStore() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        quit_ = true;
+    }
+    cv_.notify_one();
+    if (sync_thread_)
+        sync_thread_->join();
+
+    // nothing else runs at exit, the last records are written here
+    copyPending();
+    if (header_) {
+        msync(header_, map_size_, MS_SYNC);
+        munmap(header_, map_size_);
+    }
+}
+
+bool ResumeStore::Get(const std::string& uri, uint64_t& pos_us) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    uint64_t key = Key(uri);
+    uint32_t check = Check(uri);
+
+    auto it = pending_.find(key);
+    if (it != pending_.end() && it->second.check == check) {
+        if (it->second.erase)
+            return false;
+        pos_us = (uint64_t)it->second.position_ms * 1000;
+        return true;
+    }
+
+    if (!open())
+        return false;
+    Record* record = find(key, check, false);
+    if (record == nullptr)
+        return false;
+    pos_us = (uint64_t)record->position_ms * 1000;
+    return true;
+}
+
+void ResumeStore::Put(const std::string& uri, uint64_t pos_us, uint64_t duration_us) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    Pending& pending = pending_[Key(uri)];
+    pending.check = Check(uri);
+    pending.position_ms = (uint32_t)(pos_us / 1000);
+    pending.duration_ms = (uint32_t)(duration_us / 1000);
+    pending.erase = false;
+}
+
+void ResumeStore::Erase(const std::string& uri) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    Pending& pending = pending_[Key(uri)];
+    pending.check = Check(uri);
+    pending.position_ms = 0;
+    pending.duration_ms = 0;
+    pending.erase = true;
+}
+
+bool ResumeStore::Dirty() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return !pending_.empty();
+}
+
+void ResumeStore::Flush(bool sync) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    copyPending();
+    if (header_ == nullptr)
+        return;
+
+    if (!sync) {
+        // only schedules the write back, does not wait for the disk
+        if (msync(header_, map_size_, MS_ASYNC) < 0)
+            MMLogWarn("msync of resume store fail : %s", strerror(errno));
+        return;
+    }
+
+    sync_requested_ = true;
+    if (!sync_thread_)
+        sync_thread_.reset(new std::thread(&ResumeStore::syncLoop, this));
+    cv_.notify_one();
+}
+
+// called with mutex_ locked, or by the destructor after the sync thread quit
+void ResumeStore::copyPending() {
+    if (pending_.empty() || !open()) {
+        pending_.clear();
+        return;
+    }
+
+    for (const auto& kv : pending_) {
+        const Pending& pending = kv.second;
+        Record* record = find(kv.first, pending.check, !pending.erase);
+        if (record == nullptr)
+            continue;
+
+        // crc is the last field written, a torn record fails it and reads as empty
+        record->crc = 0;
+        if (pending.erase) {
+            record->key = 0;
+            continue;
+        }
+        record->key = kv.first;
+        record->check = pending.check;
+        record->position_ms = pending.position_ms;
+        record->duration_ms = pending.duration_ms;
+        record->stamp = ++header_->stamp;
+        record->reserved = 0;
+        std::atomic_signal_fence(std::memory_order_release);
+        record->crc = Crc(*record);
+    }
+    pending_.clear();
+}
+
+void ResumeStore::syncLoop() {
+    std::unique_lock<std::mutex> locker(mutex_);
+
+    while (1) {
+        cv_.wait(locker, [this]() { return sync_requested_ || quit_; });
+        if (quit_)
+            break;
+        sync_requested_ = false;
+
+        // records are only written under mutex_, Put() and Get() go on while the disk is written
+        locker.unlock();
+        if (msync(header_, map_size_, MS_SYNC) < 0)
+            MMLogWarn("msync of resume store fail : %s", strerror(errno));
+        locker.lock();
+    }
+}
+
+bool ResumeStore::open() {
+    static_assert(sizeof(Header) == 32 && sizeof(Record) == 32, "resume store layout");
+
+    if (open_tried_)
+        return header_ != nullptr;
+    open_tried_ = true;
+
+    int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        MMLogError("open resume store [%s] fail : %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+
+    size_t size = sizeof(Header) + sizeof(Record) * (size_t)slots_;
+    struct stat st;
+    bool fresh = (fstat(fd, &st) < 0 || (size_t)st.st_size != size);
+    if (fresh && ftruncate(fd, 0) == 0 && ftruncate(fd, (off_t)size) < 0) {
+        MMLogError("resize resume store fail : %s", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        MMLogError("mmap resume store fail : %s", strerror(errno));
+        return false;
+    }
+
+    header_ = static_cast<Header*>(map);
+    records_ = reinterpret_cast<Record*>(header_ + 1);
+    map_size_ = size;
+
+    if (fresh || memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 ||
+        header_->version != kVersion || header_->slots != slots_) {
+        MMLogInfo("new resume store [%s], %u slots", path_.c_str(), slots_);
+        memset(map, 0, size);
+        memcpy(header_->magic, kMagic, sizeof(kMagic));
+        header_->version = kVersion;
+        header_->slots = slots_;
+        msync(map, size, MS_SYNC);
+    }
+    return true;
+}
+
+ResumeStore::Record* ResumeStore::find(uint64_t key, uint32_t check, bool for_write) {
+    Record* free_record = nullptr;
+    Record* oldest = nullptr;
+
+    for (uint32_t i = 0; i < kProbes; i++) {
+        Record* record = &records_[(key + i) % slots_];
+        if (!Valid(*record)) {
+            if (free_record == nullptr)
+                free_record = record;
+            continue;
+        }
+        if (record->key == key && record->check == check)
+            return record;
+        if (oldest == nullptr || (int32_t)(record->stamp - oldest->stamp) < 0)
+            oldest = record;
+    }
+
+    if (!for_write)
+        return nullptr;
+    return free_record ? free_record : oldest;
+}
+
+uint64_t ResumeStore::Key(const std::string& uri) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : uri) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash ? hash : 1;
+}
+
+uint32_t ResumeStore::Check(const std::string& uri) {
+    uint32_t hash = 5381;
+    for (unsigned char c : uri)
+        hash = hash * 33 + c;
+    return hash ^ (uint32_t)uri.size();
+}
+
+uint32_t ResumeStore::Crc(const Record& record) {
+    // FNV-1a over the fields before crc
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(Record, crc); i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+bool ResumeStore::Valid(const Record& record) {
+    return record.key != 0 && record.crc == Crc(record);
+}
+
+} // namespace player
+} // namespace mm
+} // namespace lge
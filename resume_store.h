@@ -0,0 +1,149 @@
+/**
+* @file resume_store.h
+* @version 1.0
+* Header for resume positions of tracks kept by PlayerProvider in a memory mapped file
+*/
+
+#ifndef RESUME_STORE_H_
+#define RESUME_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace lge {
+namespace mm {
+namespace player {
+
+#ifndef RESUME_STORE_PATH
+#define RESUME_STORE_PATH "/rw_data/mm/resume_position.db"
+#endif
+
+#ifndef RESUME_STORE_SLOTS
+#define RESUME_STORE_SLOTS 1024 // changing it invalidates an existing store
+#endif
+
+#ifndef RESUME_STORE_FLUSH_INTERVAL_MS
+#define RESUME_STORE_FLUSH_INTERVAL_MS 5000 // positions lost on power cut are at most this old
+#endif
+
+/**
+* @class lge::mm::player::ResumeStore
+* @brief Last position of a track by uri, kept across restarts of the process and the system.
+* @details Records are 32 bytes in a fixed open addressed table of a memory mapped file, so a
+*          read is a hash and a few probes without any file access.<BR>
+*          Put() and Erase() only change a pending map, Flush() copies pending records into the
+*          mapping. Every record carries a checksum, a record torn by a crash reads as empty and
+*          the others are kept. Flush(true) also asks a sync thread to write the mapping to the
+*          disk, for stop and suspend, so the caller never waits for the disk.<BR>
+*          When the probe window of a uri is full, the least recently written record is replaced.<BR>
+*          Thread safe, Get() may be called by a client thread.
+*/
+class ResumeStore {
+public:
+    explicit ResumeStore(const std::string& path = RESUME_STORE_PATH, uint32_t slots = RESUME_STORE_SLOTS);
+    ~ResumeStore();
+
+    ResumeStore(const ResumeStore&) = delete;
+    ResumeStore& operator=(const ResumeStore&) = delete;
+
+    /**
+    * @fn Get
+    * @brief Gets the resume position of uri.
+    * @param[in] uri : track uri
+    * @param[out] pos_us : position
+    * @return bool (true - found)
+    */
+    bool Get(const std::string& uri, uint64_t& pos_us);
+
+    /**
+    * @fn Put
+    * @brief Sets the resume position of uri, written by the next Flush().
+    * @param[in] uri : track uri
+    * @param[in] pos_us : position
+    * @param[in] duration_us : duration, 0 if unknown
+    * @return : None
+    */
+    void Put(const std::string& uri, uint64_t pos_us, uint64_t duration_us);
+
+    /**
+    * @fn Erase
+    * @brief Drops the resume position of uri, e.g. played to the end, at the next Flush().
+    * @param[in] uri : track uri
+    * @return : None
+    */
+    void Erase(const std::string& uri);
+
+    /**
+    * @fn Dirty
+    * @return bool (true - there are records not flushed)
+    */
+    bool Dirty();
+
+    /**
+    * @fn Flush
+    * @brief Writes pending records into the mapped file.
+    * @param[in] sync : true - the sync thread writes the file to the disk, false - leaves it to the kernel
+    * @return : None
+    */
+    void Flush(bool sync);
+
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t slots;
+        uint32_t stamp;     // last stamp given to a record
+        uint8_t reserved[16];
+    };
+
+    struct Record {
+        uint64_t key;       // FNV-1a of uri, 0 for an empty record
+        uint32_t check;     // another hash of uri, tells apart uris of the same key
+        uint32_t position_ms;
+        uint32_t duration_ms;
+        uint32_t stamp;     // order of writes, the smallest is replaced first
+        uint32_t reserved;
+        uint32_t crc;       // of the fields above
+    };
+
+    struct Pending {
+        uint32_t check;
+        uint32_t position_ms;
+        uint32_t duration_ms;
+        bool erase;
+    };
+
+    bool open();
+    void copyPending();
+    void syncLoop();
+    Record* find(uint64_t key, uint32_t check, bool for_write);
+    static uint64_t Key(const std::string& uri);
+    static uint32_t Check(const std::string& uri);
+    static uint32_t Crc(const Record& record);
+    static bool Valid(const Record& record);
+
+    std::string path_;
+    uint32_t slots_;
+    bool open_tried_;
+    Header* header_;
+    Record* records_;
+    size_t map_size_;
+    std::unordered_map<uint64_t, Pending> pending_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unique_ptr<std::thread> sync_thread_;
+    bool sync_requested_;
+    bool quit_;
+};
+
+} // namespace player
+} // namespace mm
+} // namespace lge
+
+#endif  // RESUME_STORE_H_
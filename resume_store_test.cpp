@@ -0,0 +1,131 @@
+/**
+* @file resume_store_test.cpp
+* @version 1.0
+* Test of ResumeStore.
+*
+* Positions are read back before and after a flush and by a store opened later on the same
+* file, erased tracks read as empty, a torn record drops only itself, and a client thread
+* reads while the command thread puts and flushes with sync.
+*
+* build : g++ -std=c++11 -pthread -I. resume_store_test.cpp resume_store.cpp -o resume_store_test
+* usage : resume_store_test
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "resume_store.h"
+#include "test_check.h"
+
+using lge::mm::player::ResumeStore;
+
+static std::string TempPath() {
+    char path[] = "/tmp/resume_store_test.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0)
+        close(fd);
+    return path;
+}
+
+static void TestPutFlushReopen(const std::string& path) {
+    uint64_t pos_us = 0;
+    {
+        ResumeStore store(path, 64);
+        CHECK(!store.Get("file:///a.mp4", pos_us));
+
+        store.Put("file:///a.mp4", 12345000, 60000000);
+        CHECK(store.Dirty());
+        CHECK(store.Get("file:///a.mp4", pos_us) && pos_us == 12345000);
+
+        store.Flush(true);
+        CHECK(!store.Dirty());
+        CHECK(store.Get("file:///a.mp4", pos_us) && pos_us == 12345000);
+
+        // not flushed, written by the destructor
+        store.Put("file:///b.mp4", 7000000, 0);
+    }
+
+    ResumeStore reopened(path, 64);
+    CHECK(reopened.Get("file:///a.mp4", pos_us) && pos_us == 12345000);
+    CHECK(reopened.Get("file:///b.mp4", pos_us) && pos_us == 7000000);
+
+    reopened.Erase("file:///a.mp4");
+    CHECK(!reopened.Get("file:///a.mp4", pos_us));
+    reopened.Flush(false);
+    CHECK(!reopened.Get("file:///a.mp4", pos_us));
+    CHECK(reopened.Get("file:///b.mp4", pos_us) && pos_us == 7000000);
+}
+
+static void TestTornRecord(const std::string& path) {
+    {
+        ResumeStore store(path, 64);
+        store.Put("file:///c.mp4", 1000000, 0);
+        store.Put("file:///d.mp4", 2000000, 0);
+        store.Flush(true);
+    }
+
+    // flip a byte of the position of every record which holds 1000 ms
+    FILE* fp = fopen(path.c_str(), "r+b");
+    CHECK(fp != nullptr);
+    if (fp == nullptr)
+        return;
+    unsigned char record[32];
+    for (long offset = 32; fseek(fp, offset, SEEK_SET) == 0 && fread(record, 1, 32, fp) == 32; offset += 32) {
+        uint32_t position_ms;
+        memcpy(&position_ms, record + 12, sizeof(position_ms));
+        if (position_ms != 1000)
+            continue;
+        record[12] ^= 0xff;
+        fseek(fp, offset, SEEK_SET);
+        fwrite(record, 1, 32, fp);
+    }
+    fclose(fp);
+
+    uint64_t pos_us = 0;
+    ResumeStore store(path, 64);
+    CHECK(!store.Get("file:///c.mp4", pos_us));
+    CHECK(store.Get("file:///d.mp4", pos_us) && pos_us == 2000000);
+}
+
+static void TestClientRead(const std::string& path) {
+    const int updates = 2000;
+    ResumeStore store(path, 64);
+    std::atomic<bool> done(false);
+    int bad = 0;
+
+    // a client asks for the position while the command thread keeps updating it
+    std::thread client([&]() {
+        while (!done) {
+            uint64_t pos_us = 0;
+            if (store.Get("file:///e.mp4", pos_us) && (pos_us % 1000 != 0 || pos_us > (uint64_t)updates * 1000))
+                bad++;
+        }
+    });
+
+    for (int i = 1; i <= updates; i++) {
+        store.Put("file:///e.mp4", (uint64_t)i * 1000, 0);
+        store.Flush((i % 100) == 0);
+    }
+    done = true;
+    client.join();
+
+    uint64_t pos_us = 0;
+    CHECK(bad == 0);
+    CHECK(store.Get("file:///e.mp4", pos_us) && pos_us == (uint64_t)updates * 1000);
+}
+
+int main() {
+    std::string path = TempPath();
+
+    TestPutFlushReopen(path);
+    TestTornRecord(path);
+    TestClientRead(path);
+    unlink(path.c_str());
+
+    return TestResult("resume_store_test");
+}
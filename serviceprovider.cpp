@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include "player_logger.h"
+#include "startup_timeline.h"
 
 namespace lge {
 namespace mm {
@@ -19,6 +20,7 @@ static void onNameAppeared(GDBusConnection *connection,
                            const gchar     *name_owner,
                            void            *user_data) {
   MMLogInfo("Found %s on D-Bus", ((ServiceProvider*)user_data)->ifacePath.c_str());
+  StartupTimeline::Get().Mark(((ServiceProvider*)user_data)->ifacePath + " appeared");
 
   ServiceProvider* this_ = ((ServiceProvider*) user_data);
   ((ServiceProvider*) user_data)->connection = connection;
@@ -34,34 +36,49 @@ static void onNameVanished(GDBusConnection *connection,
   (*(this_->onConnectedCallback))(new MmError("Failed to connect, is " + this_->ifacePath + " running?"));
 }
 
-bool ServiceProvider::connect(std::function<void(MmError* e)> cb) {
-  onConnectedCallback = new std::function<void(MmError* e)>(cb);
+struct ActivationRequest {
+  std::string name;
+  gint64 begin_us;
+};
 
+static void onDummyProxyReady(GObject      *source,
+                              GAsyncResult *res,
+                              gpointer      user_data) {
+  ActivationRequest* request = (ActivationRequest*) user_data;
   GError *error = NULL;
 
-  /* Create a dummy proxy, so that we can poke the service to life if it
-     is activatable, but not yet started. Then use the g_bus_watcher for
-     further interaction. DBus activation is not supported using the
-     watcher. */
-  GDBusConnection *conn = g_bus_get_sync(G_BUS_TYPE_SESSION,
-                                         NULL,
-                                         &error);
-
+  GDBusProxy *proxy = g_dbus_proxy_new_for_bus_finish(res, &error);
   if (error) {
-    MMLogError("Failed to get bus: %s", error->message);
-    return false;
+    MMLogWarn("Failed to poke %s: %s", request->name.c_str(), error->message);
+    g_error_free(error);
+  } else {
+    MMLogInfo("%s is poked in %lld ms", request->name.c_str(),
+              (long long)((g_get_monotonic_time() - request->begin_us) / 1000));
   }
+  if (proxy)
+    g_object_unref(proxy);
+  delete request;
+}
+
+bool ServiceProvider::connect(std::function<void(MmError* e)> cb) {
+  onConnectedCallback = new std::function<void(MmError* e)>(cb);
 
-  GDBusProxy *proxy = g_dbus_proxy_new_sync(conn,
-                                            G_DBUS_PROXY_FLAGS_NONE,
-                                            NULL,
-                                            ifacePath.c_str(),
-                                            "/",
-                                            "org.freedesktop.DBus.Peer",
-                                            NULL,
-                                            &error);
-  g_object_unref(proxy);
-  g_object_unref(conn);
+  /* Create a dummy proxy, so that we can poke the service to life if it
+     is activatable, but not yet started. Then use the g_bus_watcher for
+     further interaction. DBus activation is not supported using the
+     watcher. Both are asynchronous, so the services which are connected
+     at startup are activated concurrently and main() does not block on
+     the bus. */
+  g_dbus_proxy_new_for_bus(G_BUS_TYPE_SESSION,
+                           (GDBusProxyFlags)(G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                                             G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS),
+                           NULL,
+                           ifacePath.c_str(),
+                           "/",
+                           "org.freedesktop.DBus.Peer",
+                           NULL,
+                           onDummyProxyReady,
+                           new ActivationRequest{ifacePath, g_get_monotonic_time()});
 
   m_watcherId = g_bus_watch_name(G_BUS_TYPE_SESSION,
                    ifacePath.c_str(),
@@ -0,0 +1,81 @@
+#include "startup_timeline.h"
+
+#include <time.h>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+
+static int64_t ClockUs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+StartupTimeline& StartupTimeline::Get() {
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+StartupTimeline::StartupTimeline()
+  : mutex_(),
+    start_us_(ClockUs(CLOCK_MONOTONIC)),
+    boot_us_(ClockUs(CLOCK_BOOTTIME)),
+    entries_(),
+    running_(-1),
+    finished_(false) {
+}
+
+void StartupTimeline::Phase(const std::string& name) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    int64_t now_us = ClockUs(CLOCK_MONOTONIC) - start_us_;
+    closePhase(now_us);
+
+    entries_.push_back(Entry{name, now_us, 0});
+    running_ = entries_.size() - 1;
+}
+
+void StartupTimeline::Mark(const std::string& name) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    int64_t now_us = ClockUs(CLOCK_MONOTONIC) - start_us_;
+
+    MMLogInfo("[startup] %s at %lld ms (boot +%lld ms)", name.c_str(),
+              (long long)(now_us / 1000), (long long)((boot_us_ + now_us) / 1000));
+    // late events are logged only, the summary is already out
+    if (!finished_)
+        entries_.push_back(Entry{name, now_us, -1});
+}
+
+void StartupTimeline::Finish() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    int64_t now_us = ClockUs(CLOCK_MONOTONIC) - start_us_;
+    closePhase(now_us);
+    finished_ = true;
+
+    MMLogInfo("[startup] main() started at boot +%lld ms, %zu entries, total %lld ms",
+              (long long)(boot_us_ / 1000), entries_.size(), (long long)(now_us / 1000));
+    for (auto& entry : entries_) {
+        if (entry.wall_us < 0) {
+            MMLogInfo("[startup]   %-28s %8s ms  at %8lld ms", entry.name.c_str(), "-",
+                      (long long)(entry.begin_us / 1000));
+        } else {
+            MMLogInfo("[startup]   %-28s %8lld ms  at %8lld ms", entry.name.c_str(),
+                      (long long)(entry.wall_us / 1000), (long long)(entry.begin_us / 1000));
+        }
+    }
+}
+
+void StartupTimeline::closePhase(int64_t now_us) {
+    if (running_ < 0)
+        return;
+
+    Entry& entry = entries_[running_];
+    entry.wall_us = now_us - entry.begin_us;
+    MMLogInfo("[startup] %s took %lld ms (boot +%lld ms)", entry.name.c_str(),
+              (long long)(entry.wall_us / 1000), (long long)((boot_us_ + now_us) / 1000));
+    running_ = -1;
+}
+
+} // namespace mm
+} // namespace lge
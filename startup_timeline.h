@@ -0,0 +1,75 @@
+/**
+* @file startup_timeline.h
+* @version 1.0
+* Header for the class lge::mm::StartupTimeline
+*/
+
+#ifndef STARTUP_TIMELINE_H_
+#define STARTUP_TIMELINE_H_
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lge {
+namespace mm {
+
+/**
+* @class lge::mm::StartupTimeline
+* @brief Records the wall time of each startup phase of media manager.
+* @details main() runs the phases one after another, Phase() closes the running one and<BR>
+*          opens the next. Mark() records things which finish in the background, e.g. a<BR>
+*          service which appeared on the bus, and can be called from any thread.<BR>
+*          Every entry is logged with its offset from boot (CLOCK_BOOTTIME), so boot time<BR>
+*          regressions are visible per phase. Finish() logs the summary.
+*/
+class StartupTimeline {
+public:
+    static StartupTimeline& Get();
+
+    /**
+    * @fn Phase
+    * @brief Closes the running phase and opens the next one.
+    * @param[in] name : name of the next phase
+    * @return : None
+    */
+    void Phase(const std::string& name);
+
+    /**
+    * @fn Mark
+    * @brief Records an event with its offset from the start of main().
+    * @param[in] name : name of the event
+    * @return : None
+    */
+    void Mark(const std::string& name);
+
+    /**
+    * @fn Finish
+    * @brief Closes the running phase and logs all phases and events so far.
+    * @return : None
+    */
+    void Finish();
+
+private:
+    struct Entry {
+        std::string name;
+        int64_t begin_us;   // from the start of main()
+        int64_t wall_us;    // -1 for a mark
+    };
+
+    StartupTimeline();
+    void closePhase(int64_t now_us);
+
+    std::mutex mutex_;
+    int64_t start_us_;      // CLOCK_MONOTONIC at construction
+    int64_t boot_us_;       // CLOCK_BOOTTIME at construction
+    std::vector<Entry> entries_;
+    int running_;           // index of the running phase, -1 if none
+    bool finished_;
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // STARTUP_TIMELINE_H_
@@ -0,0 +1,40 @@
+/**
+* @file test_check.h
+* @version 1.0
+* CHECK() and the result of the unit tests, shared by the *_test.cpp and *_test.c files
+*/
+
+#ifndef TEST_CHECK_H_
+#define TEST_CHECK_H_
+
+#include <stdio.h>
+
+static int failures = 0;
+
+/**
+* Counts a failure and goes on, so one run reports every failed check.
+*/
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/**
+* @fn TestResult
+* @brief Prints the result of the test, returned by main().
+* @param[in] name : name of the test
+* @return int (0 - passed, 1 - some check failed)
+*/
+static inline int TestResult(const char* name) {
+    if (failures) {
+        fprintf(stderr, "%s: %d failure(s)\n", name, failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif  // TEST_CHECK_H_
@@ -0,0 +1,86 @@
+# Unit tests of media manager, *_test.cpp and *_test.c
+#
+# usage : make -f tests.mk check MM_TEST_CPPFLAGS="-I<platform include dirs>"
+#         make -f tests.mk check TESTS="lms_keyframe_index_test fast_logger_test"
+#
+# player_logger.h, commands.h, command_queue.h and the generated PlayerTypes.hpp come from
+# the platform and are not in this tree, MM_TEST_CPPFLAGS gives their directories.
+# lms_keyframe_index_test needs nothing else. Each test is built from its module only,
+# glib, gio and gstreamer are taken from pkg-config.
+
+CC         ?= gcc
+CXX        ?= g++
+PKG_CONFIG ?= pkg-config
+CFLAGS     ?= -O2 -Wall
+CXXFLAGS   ?= -O2 -Wall
+OUT        ?= _test_build
+
+MM_TEST_CPPFLAGS ?=
+MM_TEST_LDLIBS   ?=
+
+TESTS ?= \
+	async_call_test \
+	command_queue_test \
+	fast_logger_test \
+	lms_keyframe_index_test \
+	media_shard_lock_test \
+	media_state_table_test \
+	playerengine_heartbeat_test \
+	playerengine_monitor_test \
+	playerengine_pool_test \
+	playerengine_ready_test \
+	resume_store_test \
+	transcode_service_test
+
+async_call_test_SRCS             = async_call_test.cpp async_call.cpp
+async_call_test_PKGS             = gio-2.0
+command_queue_test_SRCS          = command_queue_test.cpp command_queue.cpp command_recorder.cpp fast_logger.cpp
+fast_logger_test_SRCS            = fast_logger_test.cpp fast_logger.cpp
+lms_keyframe_index_test_SRCS     = lms_keyframe_index_test.c lms_keyframe_index.c
+lms_keyframe_index_test_CPPFLAGS = -DKEYFRAME_INDEX_DIR='"/tmp/lms_keyframe_index_test.d"'
+media_shard_lock_test_SRCS       = media_shard_lock_test.cpp media_shard_lock.cpp
+media_state_table_test_SRCS      = media_state_table_test.cpp media_state_table.cpp
+playerengine_heartbeat_test_SRCS = playerengine_heartbeat_test.cpp playerengine_heartbeat.cpp
+playerengine_heartbeat_test_PKGS = glib-2.0
+playerengine_monitor_test_SRCS   = playerengine_monitor_test.cpp playerengine_monitor.cpp
+playerengine_monitor_test_PKGS   = glib-2.0
+playerengine_pool_test_SRCS      = playerengine_pool_test.cpp playerengine_pool.cpp
+playerengine_ready_test_SRCS     = playerengine_ready_test.cpp playerengine_ready.cpp
+playerengine_ready_test_PKGS     = gio-2.0
+resume_store_test_SRCS           = resume_store_test.cpp resume_store.cpp
+transcode_service_test_SRCS      = transcode_service_test.cpp transcode_service.cpp
+transcode_service_test_PKGS      = gstreamer-1.0
+
+pkg = $(if $($(1)_PKGS),$(shell $(PKG_CONFIG) --cflags --libs $($(1)_PKGS)))
+
+define c_test
+$(OUT)/$(1): $$($(1)_SRCS) test_check.h | $(OUT)
+	$$(CC) -std=c99 $$(CFLAGS) -I. $$($(1)_CPPFLAGS) $$(MM_TEST_CPPFLAGS) $$($(1)_SRCS) \
+		$$(call pkg,$(1)) $$(MM_TEST_LDLIBS) -o $$@
+endef
+
+define cxx_test
+$(OUT)/$(1): $$($(1)_SRCS) test_check.h | $(OUT)
+	$$(CXX) -std=c++11 -pthread $$(CXXFLAGS) -I. $$($(1)_CPPFLAGS) $$(MM_TEST_CPPFLAGS) $$($(1)_SRCS) \
+		$$(call pkg,$(1)) $$(MM_TEST_LDLIBS) -o $$@
+endef
+
+$(foreach t,$(TESTS),$(eval $(call $(if $(filter %.c,$($(t)_SRCS)),c_test,cxx_test),$(t))))
+
+.PHONY: all check clean
+
+all: $(addprefix $(OUT)/,$(TESTS))
+
+# runs every test, fails when any of them failed
+check: all
+	@failed=0; \
+	for t in $(abspath $(addprefix $(OUT)/,$(TESTS))); do \
+		$$t || failed=1; \
+	done; \
+	exit $$failed
+
+$(OUT):
+	mkdir -p $@
+
+clean:
+	rm -rf $(OUT)
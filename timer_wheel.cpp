@@ -0,0 +1,135 @@
+#include "timer_wheel.h"
+
+#include <vector>
+
+namespace lge {
+namespace mm {
+
+TimerWheel::TimerWheel(uint64_t now_ms)
+  : current_(now_ms / TIMER_WHEEL_TICK_MS),
+    next_id_(0),
+    timers_(),
+    expiring_() {}
+
+TimerWheel::TimerId TimerWheel::Add(uint64_t now_ms, uint32_t timeout_ms, Callback cb) {
+    Timer timer;
+    timer.id = ++next_id_;
+    // round up, a timer never fires before its timeout
+    timer.expire = (now_ms + timeout_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+    timer.cb = cb;
+    Place(std::move(timer));
+
+    return next_id_;
+}
+
+void TimerWheel::Place(Timer&& timer) {
+    uint64_t max = kL0Size * kLnSize * kLnSize - 1;
+    if (timer.expire <= current_)
+        timer.expire = current_ + 1;
+    if (timer.expire - current_ > max)
+        timer.expire = current_ + max;
+
+    uint64_t delta = timer.expire - current_;
+    Slot* slot;
+    if (delta < kL0Size)
+        slot = &l0_[timer.expire & (kL0Size - 1)];
+    else if (delta < kL0Size * kLnSize)
+        slot = &l1_[(timer.expire >> kL0Bits) & (kLnSize - 1)];
+    else
+        slot = &l2_[(timer.expire >> (kL0Bits + kLnBits)) & (kLnSize - 1)];
+
+    TimerId id = timer.id;
+    slot->push_back(std::move(timer));
+    timers_[id] = std::make_pair(slot, std::prev(slot->end()));
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    // due in this tick, but a callback before it cancels it
+    if (expiring_.erase(id))
+        return true;
+
+    auto it = timers_.find(id);
+    if (it == timers_.end())
+        return false;
+
+    it->second.first->erase(it->second.second);
+    timers_.erase(it);
+    return true;
+}
+
+void TimerWheel::Cascade(int level) {
+    Slot* slot = (level == 1) ? &l1_[(current_ >> kL0Bits) & (kLnSize - 1)]
+                              : &l2_[(current_ >> (kL0Bits + kLnBits)) & (kLnSize - 1)];
+    Slot moving;
+    moving.swap(*slot);
+    for (auto& timer : moving) {
+        timers_.erase(timer.id);
+        Place(std::move(timer));
+    }
+}
+
+size_t TimerWheel::Advance(uint64_t now_ms) {
+    uint64_t now = now_ms / TIMER_WHEEL_TICK_MS;
+    size_t fired = 0;
+
+    while (current_ < now) {
+        current_++;
+
+        // move timers of upper levels down when lower level wraps
+        if ((current_ & (kL0Size - 1)) == 0) {
+            if (((current_ >> kL0Bits) & (kLnSize - 1)) == 0)
+                Cascade(2);
+            Cascade(1);
+        }
+
+        Slot& slot = l0_[current_ & (kL0Size - 1)];
+        if (slot.empty())
+            continue;
+
+        // callbacks may add or cancel timers, so take them out first
+        std::vector<Timer> expired;
+        for (auto it = slot.begin(); it != slot.end(); ) {
+            if (it->expire <= current_) {
+                timers_.erase(it->id);
+                expiring_.insert(it->id);
+                expired.push_back(std::move(*it));
+                it = slot.erase(it);
+            } else {
+                it++;
+            }
+        }
+        for (auto& timer : expired) {
+            if (!expiring_.erase(timer.id))
+                continue;
+            fired++;
+            timer.cb(timer.id);
+        }
+
+        if (timers_.empty()) {
+            current_ = now;
+            break;
+        }
+    }
+
+    return fired;
+}
+
+bool TimerWheel::NextWakeup(uint64_t& wakeup_ms) const {
+    if (timers_.empty())
+        return false;
+
+    // earliest timer of level 0 before it wraps, otherwise the next cascade point
+    uint64_t wrap = (current_ | (kL0Size - 1)) + 1;
+    for (uint64_t tick = current_ + 1; tick <= wrap; tick++) {
+        if (!l0_[tick & (kL0Size - 1)].empty()) {
+            wakeup_ms = tick * TIMER_WHEEL_TICK_MS;
+            return true;
+        }
+    }
+
+    wakeup_ms = wrap * TIMER_WHEEL_TICK_MS;
+    return true;
+}
+
+} // namespace mm
+} // namespace lge
@@ -0,0 +1,103 @@
+/**
+* @file timer_wheel.h
+* @version 1.0
+* Header for hierarchical timer wheel used by EventSystem
+*/
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace lge {
+namespace mm {
+
+#define TIMER_WHEEL_TICK_MS 10 // resolution of WaitEvent deadlines
+
+/**
+* @class lge::mm::TimerWheel
+* @brief Three level timer wheel. Add, cancel and expiry of one timer are O(1).
+* @details Level 0 has 256 slots of one tick, level 1 and 2 have 64 slots of 256 and 16384 ticks.<BR>
+*          Timers longer than the wheel (about 46 minutes with 10 ms tick) are clamped.<BR>
+*          Not thread safe, owner drives it from one thread with Advance().
+*/
+class TimerWheel {
+public:
+    typedef uint64_t TimerId;
+    typedef std::function<void(TimerId)> Callback;
+
+    explicit TimerWheel(uint64_t now_ms);
+
+    /**
+    * @fn Add
+    * @brief Registers a timer.
+    * @param[in] now_ms : current monotonic time
+    * @param[in] timeout_ms : relative timeout
+    * @param[in] cb : called from Advance() when expired
+    * @return TimerId (never 0)
+    */
+    TimerId Add(uint64_t now_ms, uint32_t timeout_ms, Callback cb);
+
+    /**
+    * @fn Cancel
+    * @brief Removes a timer which is not fired yet.
+    *        A callback may cancel another timer due in the same Advance(), which then does not fire.
+    * @param[in] id : id returned by Add()
+    * @return bool (true - removed, false - already fired or unknown)
+    */
+    bool Cancel(TimerId id);
+
+    /**
+    * @fn Advance
+    * @brief Fires every timer expired until now_ms.
+    * @param[in] now_ms : current monotonic time
+    * @return size_t : number of fired timers
+    */
+    size_t Advance(uint64_t now_ms);
+
+    /**
+    * @fn NextWakeup
+    * @brief Gets the time Advance() has to be called next.
+    * @param[out] wakeup_ms : monotonic time of the earliest expiry or cascade
+    * @return bool (false - no timer)
+    */
+    bool NextWakeup(uint64_t& wakeup_ms) const;
+
+    size_t Size() const {
+        return timers_.size();
+    }
+
+private:
+    struct Timer {
+        TimerId id;
+        uint64_t expire;  // tick
+        Callback cb;
+    };
+    typedef std::list<Timer> Slot;
+
+    static const int kL0Bits = 8;
+    static const int kLnBits = 6;
+    static const uint64_t kL0Size = 1 << kL0Bits;
+    static const uint64_t kLnSize = 1 << kLnBits;
+
+    void Place(Timer&& timer);
+    void Cascade(int level);
+
+    Slot l0_[kL0Size];
+    Slot l1_[kLnSize];
+    Slot l2_[kLnSize];
+    uint64_t current_;  // last processed tick
+    TimerId next_id_;
+    std::unordered_map<TimerId, std::pair<Slot*, Slot::iterator>> timers_;
+    std::unordered_set<TimerId> expiring_;  // taken out by Advance(), not fired yet
+};
+
+} // namespace mm
+} // namespace lge
+
+#endif  // TIMER_WHEEL_H_
@@ -0,0 +1,372 @@
+#include "transcode_service.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <gst/gst.h>
+
+#include "player_logger.h"
+
+namespace lge {
+namespace mm {
+namespace player {
+
+namespace {
+
+const int64_t kCpuSampleIntervalUs = 1000 * 1000;
+const uint32_t kCpuHysteresisPercent = 10;
+
+bool InitGStreamer() {
+    static std::once_flag once;
+    static bool initialized = false;
+
+    std::call_once(once, []() {
+        GError* error = nullptr;
+        initialized = gst_init_check(nullptr, nullptr, &error);
+        if (!initialized) {
+            MMLogError("gst_init for transcoding fail : %s", error ? error->message : "unknown");
+            g_clear_error(&error);
+        }
+    });
+    return initialized;
+}
+
+const char* ResultToString(TranscodeService::Result result) {
+    switch (result) {
+        case TranscodeService::Result::Done:
+            return "done";
+        case TranscodeService::Result::Failed:
+            return "failed";
+        case TranscodeService::Result::Cancelled:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+TranscodeService::TranscodeService(uint32_t workers, uint32_t queue_max)
+  : workers_max_(workers > 0 ? workers : 1),
+    queue_max_(queue_max > 0 ? queue_max : 1),
+    mutex_(),
+    cv_(),
+    queue_(),
+    running_(),
+    workers_(),
+    quit_(false),
+    next_id_(0),
+    playback_active_(false),
+    progress_callback_(nullptr),
+    done_callback_(nullptr),
+    cpu_mutex_(),
+    cpu_sample_time_us_(0),
+    cpu_total_(0),
+    cpu_idle_(0),
+    cpu_busy_percent_(0) {}
+
+TranscodeService::~TranscodeService() {
+    {
+        std::lock_guard<std::mutex> locker(mutex_);
+        quit_ = true;
+        queue_.clear();
+        for (auto& it : running_)
+            it.second->cancel = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+void TranscodeService::SetCallbacks(ProgressCallback progress, DoneCallback done) {
+    std::lock_guard<std::mutex> locker(mutex_);
+    progress_callback_ = progress;
+    done_callback_ = done;
+}
+
+uint32_t TranscodeService::Submit(const TranscodeJob& job) {
+    if (BuildPipeline(job).empty()) {
+        MMLogError("transcoding to [%s/%s] is not supported", job.codec.c_str(), job.format.c_str());
+        return 0;
+    }
+    if (!InitGStreamer())
+        return 0;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+    if (queue_.size() >= queue_max_) {
+        MMLogWarn("transcoding queue is full [%zu], [%s] is rejected", queue_.size(), job.input.c_str());
+        return 0;
+    }
+
+    std::shared_ptr<Entry> entry(new Entry());
+    entry->id = ++next_id_;
+    if (entry->id == 0)
+        entry->id = ++next_id_;
+    entry->job = job;
+    entry->cancel = false;
+    queue_.push_back(entry);
+
+    // workers are started on demand, most systems never transcode
+    if (workers_.size() < workers_max_ && queue_.size() + running_.size() > workers_.size()) {
+        uint32_t index = (uint32_t)workers_.size();
+        workers_.emplace_back(&TranscodeService::workerLoop, this, index);
+    }
+    MMLogInfo("transcoding job[%u] is queued [%s] -> [%s], pending=[%zu]",
+              entry->id, job.input.c_str(), job.output.c_str(), queue_.size() + running_.size());
+    cv_.notify_all();
+    return entry->id;
+}
+
+bool TranscodeService::Cancel(uint32_t id) {
+    std::unique_lock<std::mutex> locker(mutex_);
+
+    auto running = running_.find(id);
+    if (running != running_.end()) {
+        running->second->cancel = true;
+        MMLogInfo("transcoding job[%u] is being cancelled", id);
+        return true;
+    }
+
+    for (auto it = queue_.begin(); it != queue_.end(); it++) {
+        if ((*it)->id != id)
+            continue;
+        queue_.erase(it);
+        DoneCallback cb = done_callback_;
+        locker.unlock();
+        MMLogInfo("transcoding job[%u] is cancelled before start", id);
+        if (cb)
+            cb(id, Result::Cancelled, std::string());
+        return true;
+    }
+    return false;
+}
+
+void TranscodeService::SetPlaybackActive(bool active) {
+    {
+        // changed under the lock, a worker between its check and wait does not miss it
+        std::lock_guard<std::mutex> locker(mutex_);
+        if (playback_active_ == active)
+            return;
+        playback_active_ = active;
+    }
+    MMLogInfo("transcoding is %s", active ? "throttled by playback" : "not throttled");
+    if (!active)
+        cv_.notify_all();
+}
+
+size_t TranscodeService::Pending() {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return queue_.size() + running_.size();
+}
+
+std::string TranscodeService::BuildPipeline(const TranscodeJob& job) {
+    std::string encoder;
+    std::string muxer;
+
+    if (job.codec == "OPUS")
+        encoder = "opusenc bitrate=16000 frame-size=20 audio-type=2048"; // voice memo settings
+    else if (job.codec == "AAC")
+        encoder = "avenc_aac";
+    else if (job.codec != "WAV_PCM")
+        return std::string();
+
+    if (job.format == "OGG")
+        muxer = "oggmux";
+    else if (job.format == "MP4")
+        muxer = "mp4mux";
+    else if (job.format == "WAV")
+        muxer = "wavenc";
+    else
+        return std::string();
+
+    // wavenc takes raw audio only, and raw audio needs wavenc
+    if ((job.format == "WAV") != (job.codec == "WAV_PCM"))
+        return std::string();
+
+    std::string desc("decodebin caps=audio/x-raw ! audioconvert ! audioresample ! ");
+    if (!encoder.empty())
+        desc += encoder + " ! ";
+    return desc + muxer;
+}
+
+void TranscodeService::workerLoop(uint32_t index) {
+    // threads of the pipelines are created by this thread and inherit its nice value
+    if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), TRANSCODE_WORKER_NICE) < 0)
+        MMLogWarn("setpriority of transcoding worker fail : %s", strerror(errno));
+
+    std::unique_lock<std::mutex> locker(mutex_);
+    while (!quit_) {
+        bool allowed = !playback_active_ || index < TRANSCODE_WORKERS_WHILE_PLAYING;
+        if (queue_.empty() || !allowed) {
+            cv_.wait(locker);
+            continue;
+        }
+
+        std::shared_ptr<Entry> entry = queue_.front();
+        queue_.pop_front();
+        running_[entry->id] = entry;
+        locker.unlock();
+
+        std::string message;
+        gint64 begin = g_get_monotonic_time();
+        Result result = run(*entry, message);
+        MMLogInfo("transcoding job[%u] is %s in %lld ms by worker[%u] %s", entry->id, ResultToString(result),
+                  (long long)((g_get_monotonic_time() - begin) / 1000), index, message.c_str());
+
+        locker.lock();
+        running_.erase(entry->id);
+        DoneCallback cb = done_callback_;
+        locker.unlock();
+        if (cb)
+            cb(entry->id, result, message);
+        locker.lock();
+    }
+}
+
+TranscodeService::Result TranscodeService::run(Entry& entry, std::string& message) {
+    const TranscodeJob& job = entry.job;
+    std::string launch = "filesrc name=src ! " + BuildPipeline(job) + " ! filesink name=sink";
+    std::string temp = job.output + ".temp";
+    GError* error = nullptr;
+
+    GstElement* pipeline = gst_parse_launch(launch.c_str(), &error);
+    if (pipeline == nullptr || error != nullptr) {
+        message = error ? error->message : "cannot create pipeline";
+        g_clear_error(&error);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return Result::Failed;
+    }
+
+    std::string input = job.input;
+    if (input.compare(0, 7, "file://") == 0) {
+        gchar* path = g_filename_from_uri(input.c_str(), nullptr, nullptr);
+        if (path) {
+            input = path;
+            g_free(path);
+        }
+    }
+    GstElement* src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    g_object_set(src, "location", input.c_str(), NULL);
+    g_object_set(sink, "location", temp.c_str(), NULL);
+    gst_object_unref(src);
+    gst_object_unref(sink);
+
+    GstBus* bus = gst_element_get_bus(pipeline);
+    Result result = Result::Failed;
+    bool paused = false;
+    gint64 pause_begin = 0;
+    gint64 paused_total = 0;
+    gint64 last_progress = 0;
+    gint64 last_position = -1;
+
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        message = "cannot change status into play";
+    } else {
+        while (1) {
+            GstMessage* msg = gst_bus_timed_pop_filtered(bus, 100 * GST_MSECOND,
+                                                         (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+            if (msg) {
+                if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS) {
+                    result = Result::Done;
+                } else {
+                    GError* err = nullptr;
+                    gst_message_parse_error(msg, &err, nullptr);
+                    message = std::string(GST_OBJECT_NAME(GST_MESSAGE_SRC(msg))) + ": " + (err ? err->message : "error");
+                    g_clear_error(&err);
+                }
+                gst_message_unref(msg);
+                break;
+            }
+            if (entry.cancel) {
+                result = Result::Cancelled;
+                break;
+            }
+
+            // pausing a busy CPU for playback, with hysteresis so it does not flap
+            gint64 now = g_get_monotonic_time();
+            uint32_t limit = TRANSCODE_CPU_BUSY_PERCENT - (paused ? kCpuHysteresisPercent : 0);
+            bool busy = playback_active_ && cpuBusyPercent() >= limit;
+            if (busy != paused) {
+                gst_element_set_state(pipeline, busy ? GST_STATE_PAUSED : GST_STATE_PLAYING);
+                paused = busy;
+                if (busy)
+                    pause_begin = now;
+                else
+                    paused_total += now - pause_begin;
+            }
+
+            if (paused || now - last_progress < TRANSCODE_PROGRESS_INTERVAL_MS * 1000)
+                continue;
+            last_progress = now;
+
+            gint64 position = 0;
+            gint64 duration = 0;
+            if (!gst_element_query_position(pipeline, GST_FORMAT_TIME, &position) || position == last_position)
+                continue;
+            if (!gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration) || duration < 0)
+                duration = 0;
+            last_position = position;
+
+            std::unique_lock<std::mutex> locker(mutex_);
+            ProgressCallback cb = progress_callback_;
+            locker.unlock();
+            if (cb)
+                cb(entry.id, (uint64_t)position / 1000, (uint64_t)duration / 1000);
+        }
+    }
+    if (paused)
+        paused_total += g_get_monotonic_time() - pause_begin;
+    if (paused_total > 0)
+        MMLogInfo("transcoding job[%u] was paused %lld ms for playback", entry.id, (long long)(paused_total / 1000));
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(pipeline);
+
+    if (result == Result::Done && rename(temp.c_str(), job.output.c_str()) < 0) {
+        message = std::string("rename fail : ") + strerror(errno);
+        result = Result::Failed;
+    }
+    if (result != Result::Done)
+        unlink(temp.c_str());
+    return result;
+}
+
+uint32_t TranscodeService::cpuBusyPercent() {
+    std::lock_guard<std::mutex> locker(cpu_mutex_);
+
+    int64_t now = g_get_monotonic_time();
+    if (now - cpu_sample_time_us_ < kCpuSampleIntervalUs)
+        return cpu_busy_percent_;
+    cpu_sample_time_us_ = now;
+
+    FILE* fp = fopen("/proc/stat", "r");
+    if (fp == nullptr)
+        return cpu_busy_percent_;
+    unsigned long long v[8] = {0, };
+    int n = fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+    fclose(fp);
+    if (n < 4)
+        return cpu_busy_percent_;
+
+    // niced time is left out, it is mostly the transcoding itself
+    uint64_t total = 0;
+    for (auto value : v)
+        total += value;
+    uint64_t idle = v[3] + v[4] + v[1];
+
+    if (cpu_total_ > 0 && total > cpu_total_)
+        cpu_busy_percent_ = (uint32_t)(100 - (idle - cpu_idle_) * 100 / (total - cpu_total_));
+    cpu_total_ = total;
+    cpu_idle_ = idle;
+    return cpu_busy_percent_;
+}
+
+} // namespace player
+} // namespace mm
+} // namespace lge
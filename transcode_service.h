@@ -0,0 +1,168 @@
+/**
+* @file transcode_service.h
+* @version 1.0
+* Header for the transcoding job queue which runs in media manager, e.g. voice memo to opus
+*/
+
+#ifndef TRANSCODE_SERVICE_H_
+#define TRANSCODE_SERVICE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lge {
+namespace mm {
+namespace player {
+
+#define DEFAULT_TRANSCODE_WORKERS 2 // transcode_workers of mediamanager.cfg when not set
+
+#ifndef TRANSCODE_WORKERS_WHILE_PLAYING
+#define TRANSCODE_WORKERS_WHILE_PLAYING 1 // workers which take jobs while playback is active
+#endif
+
+#ifndef TRANSCODE_QUEUE_MAX
+#define TRANSCODE_QUEUE_MAX 16 // Submit() fails beyond it
+#endif
+
+#ifndef TRANSCODE_CPU_BUSY_PERCENT
+#define TRANSCODE_CPU_BUSY_PERCENT 80 // jobs pause above it while playback is active
+#endif
+
+#ifndef TRANSCODE_PROGRESS_INTERVAL_MS
+#define TRANSCODE_PROGRESS_INTERVAL_MS 500
+#endif
+
+#define TRANSCODE_WORKER_NICE 10 // below playback threads of media manager
+
+/**
+* @struct lge::mm::player::TranscodeJob
+* @brief Input and output of a transcoding job, same values as arrangeTranscodeOutput().
+*/
+struct TranscodeJob {
+    std::string input;      // file path or file:// uri
+    std::string output;     // file path, written as output.temp and renamed when done
+    std::string codec;      // "OPUS", "AAC" or "WAV_PCM"
+    std::string format;     // "OGG", "MP4" or "WAV"
+};
+
+/**
+* @class lge::mm::player::TranscodeService
+* @brief Bounded queue of transcoding jobs run by GStreamer pipelines on worker threads.
+* @details A job does not take a PlayerEngine nor a slot of the command queue. Only the audio
+*          of the input is decoded, video streams are left unlinked.<BR>
+*          Workers run at TRANSCODE_WORKER_NICE and the pipeline threads inherit it. While
+*          playback is active, only TRANSCODE_WORKERS_WHILE_PLAYING workers take jobs, and a
+*          running job is paused while CPU is busier than TRANSCODE_CPU_BUSY_PERCENT.<BR>
+*          Workers are started by the first Submit(). Callbacks are called on worker threads,<BR>
+*          except Cancelled of a queued job, which is called by Cancel().
+*/
+class TranscodeService {
+public:
+    enum class Result : uint8_t { Done, Failed, Cancelled };
+
+    /**
+    * @brief Called every TRANSCODE_PROGRESS_INTERVAL_MS while the position moves.
+    * @param id : job id
+    * @param position_us : position of the input which is encoded
+    * @param duration_us : duration of the input, 0 if unknown
+    */
+    typedef std::function<void(uint32_t id, uint64_t position_us, uint64_t duration_us)> ProgressCallback;
+
+    /**
+    * @brief Called once per accepted job.
+    * @param id : job id
+    * @param result : Done - output is complete, otherwise no output is left
+    * @param message : error message for Failed
+    */
+    typedef std::function<void(uint32_t id, Result result, const std::string& message)> DoneCallback;
+
+    explicit TranscodeService(uint32_t workers = DEFAULT_TRANSCODE_WORKERS, uint32_t queue_max = TRANSCODE_QUEUE_MAX);
+    ~TranscodeService();
+
+    TranscodeService(const TranscodeService&) = delete;
+    TranscodeService& operator=(const TranscodeService&) = delete;
+
+    void SetCallbacks(ProgressCallback progress, DoneCallback done);
+
+    /**
+    * @fn Submit
+    * @brief Queues a job.
+    * @param[in] job : job
+    * @return uint32_t (job id, 0 - queue is full or GStreamer is not available)
+    */
+    uint32_t Submit(const TranscodeJob& job);
+
+    /**
+    * @fn Cancel
+    * @brief Drops a queued job, or stops a running one and removes its partial output.
+    * @param[in] id : job id
+    * @return bool (true - the job will be reported as Cancelled)
+    */
+    bool Cancel(uint32_t id);
+
+    /**
+    * @fn SetPlaybackActive
+    * @brief Enables throttling while media is playing.
+    * @return : None
+    */
+    void SetPlaybackActive(bool active);
+
+    /**
+    * @fn Pending
+    * @return size_t : number of queued and running jobs
+    */
+    size_t Pending();
+
+    /**
+    * @fn BuildPipeline
+    * @brief Gets gst-launch description between filesrc "src" and filesink "sink".
+    * @return std::string (empty - codec or format is not supported)
+    */
+    static std::string BuildPipeline(const TranscodeJob& job);
+
+private:
+    struct Entry {
+        uint32_t id;
+        TranscodeJob job;
+        std::atomic<bool> cancel;
+    };
+
+    void workerLoop(uint32_t index);
+    Result run(Entry& entry, std::string& message);
+    uint32_t cpuBusyPercent();
+
+    uint32_t workers_max_;
+    uint32_t queue_max_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Entry>> queue_;
+    std::map<uint32_t, std::shared_ptr<Entry>> running_;
+    std::vector<std::thread> workers_;
+    bool quit_;
+    uint32_t next_id_;
+    std::atomic<bool> playback_active_;   // written under mutex_, read by running jobs without it
+    ProgressCallback progress_callback_;
+    DoneCallback done_callback_;
+
+    // /proc/stat sample shared by workers
+    std::mutex cpu_mutex_;
+    int64_t cpu_sample_time_us_;
+    uint64_t cpu_total_;
+    uint64_t cpu_idle_;
+    uint32_t cpu_busy_percent_;
+};
+
+} // namespace player
+} // namespace mm
+} // namespace lge
+
+#endif  // TRANSCODE_SERVICE_H_
@@ -0,0 +1,172 @@
+/**
+* @file transcode_service_benchmark.cpp
+* @version 1.0
+* Throughput of TranscodeService against the number of workers.
+*
+* Every input file of the directory is transcoded once per worker count. If the directory
+* has no input, synthetic voice-like WAV files are written there first. Outputs go to
+* <dir>/out and are removed after each round. "playing" runs with SetPlaybackActive(true),
+* to see what the throttling costs while media plays.
+*
+* build : g++ -O2 -std=c++11 -pthread -I. transcode_service_benchmark.cpp transcode_service.cpp
+*         $(pkg-config --cflags --libs gstreamer-1.0) -o tc_bench
+* usage : tc_bench [dir=/tmp/tc_bench] [max_workers=4] [codec=OPUS] [format=OGG] [playing|idle]
+*         [inputs=16] [seconds=60]
+*/
+
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "transcode_service.h"
+
+using lge::mm::player::TranscodeJob;
+using lge::mm::player::TranscodeService;
+
+static const uint32_t kSampleRate = 16000;
+
+static void PutLe(std::vector<unsigned char>& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+// mono 16 bit, a few harmonics with a syllable-like envelope
+static bool WriteWav(const std::string& path, uint32_t seconds, uint32_t seed) {
+    uint32_t samples = kSampleRate * seconds;
+    std::vector<unsigned char> wav;
+    wav.reserve(44 + samples * 2);
+    wav.insert(wav.end(), {'R', 'I', 'F', 'F'});
+    PutLe(wav, 36 + samples * 2, 4);
+    wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    PutLe(wav, 16, 4);
+    PutLe(wav, 1, 2);
+    PutLe(wav, 1, 2);
+    PutLe(wav, kSampleRate, 4);
+    PutLe(wav, kSampleRate * 2, 4);
+    PutLe(wav, 2, 2);
+    PutLe(wav, 16, 2);
+    wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+    PutLe(wav, samples * 2, 4);
+
+    double pitch = 110.0 + (seed % 7) * 15.0;
+    uint32_t noise = seed * 2654435761u + 1;
+    for (uint32_t i = 0; i < samples; i++) {
+        double t = (double)i / kSampleRate;
+        double envelope = 0.5 + 0.5 * sin(2 * M_PI * 3.0 * t);
+        double value = 0.5 * sin(2 * M_PI * pitch * t) + 0.25 * sin(2 * M_PI * pitch * 2 * t) +
+                       0.12 * sin(2 * M_PI * pitch * 3 * t);
+        noise = noise * 1664525u + 1013904223u;
+        value = value * envelope + ((double)(noise >> 16) / 65536.0 - 0.5) * 0.05;
+        PutLe(wav, (uint32_t)(int16_t)(value * 20000), 2);
+    }
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr)
+        return false;
+    bool ok = fwrite(wav.data(), 1, wav.size(), fp) == wav.size();
+    fclose(fp);
+    return ok;
+}
+
+static std::vector<std::string> ListInputs(const std::string& dir) {
+    static const char* const kExtensions[] = { ".wav", ".mp4", ".m4a", ".aac", ".mp3", ".ogg", ".opus" };
+    std::vector<std::string> inputs;
+
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr)
+        return inputs;
+    while (struct dirent* e = readdir(d)) {
+        const char* dot = strrchr(e->d_name, '.');
+        if (dot == nullptr)
+            continue;
+        for (auto ext : kExtensions) {
+            if (strcasecmp(dot, ext) == 0) {
+                inputs.push_back(dir + "/" + e->d_name);
+                break;
+            }
+        }
+    }
+    closedir(d);
+    return inputs;
+}
+
+int main(int argc, char *argv[]) {
+    std::string dir = (argc > 1) ? argv[1] : "/tmp/tc_bench";
+    uint32_t max_workers = (argc > 2) ? strtoul(argv[2], NULL, 10) : 4;
+    std::string codec = (argc > 3) ? argv[3] : "OPUS";
+    std::string format = (argc > 4) ? argv[4] : "OGG";
+    bool playing = (argc > 5) && strcmp(argv[5], "playing") == 0;
+    uint32_t generate = (argc > 6) ? strtoul(argv[6], NULL, 10) : 16;
+    uint32_t seconds = (argc > 7) ? strtoul(argv[7], NULL, 10) : 60;
+
+    mkdir(dir.c_str(), 0755);
+    std::vector<std::string> inputs = ListInputs(dir);
+    if (inputs.empty()) {
+        printf("writing %u synthetic inputs of %u s to %s\n", generate, seconds, dir.c_str());
+        for (uint32_t i = 0; i < generate; i++) {
+            std::string path = dir + "/voice_" + std::to_string(i) + ".wav";
+            if (!WriteWav(path, seconds, i)) {
+                fprintf(stderr, "cannot write %s\n", path.c_str());
+                return 1;
+            }
+            inputs.push_back(path);
+        }
+    }
+    std::string out_dir = dir + "/out";
+    mkdir(out_dir.c_str(), 0755);
+
+    const char* extension = (format == "OGG") ? ".opus" : (format == "MP4") ? ".m4a" : ".wav";
+    printf("%8s %8s %8s %10s %10s %10s\n", "workers", "jobs", "failed", "wall(s)", "jobs/s", "playing");
+
+    for (uint32_t workers = 1; workers <= max_workers; workers *= 2) {
+        TranscodeService service(workers, (uint32_t)inputs.size());
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t done = 0;
+        size_t failed = 0;
+
+        service.SetCallbacks(nullptr, [&](uint32_t id, TranscodeService::Result result, const std::string& message) {
+            std::lock_guard<std::mutex> locker(mutex);
+            if (result != TranscodeService::Result::Done) {
+                fprintf(stderr, "job %u failed: %s\n", id, message.c_str());
+                failed++;
+            }
+            done++;
+            cv.notify_all();
+        });
+        service.SetPlaybackActive(playing);
+
+        auto begin = std::chrono::steady_clock::now();
+        size_t submitted = 0;
+        for (size_t i = 0; i < inputs.size(); i++) {
+            TranscodeJob job{inputs[i], out_dir + "/" + std::to_string(i) + extension, codec, format};
+            if (service.Submit(job) == 0) {
+                fprintf(stderr, "submit of %s failed\n", inputs[i].c_str());
+                continue;
+            }
+            submitted++;
+        }
+
+        std::unique_lock<std::mutex> locker(mutex);
+        cv.wait(locker, [&]() { return done >= submitted; });
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        locker.unlock();
+
+        printf("%8u %8zu %8zu %10.2f %10.2f %10s\n", workers, submitted, failed, wall,
+               wall > 0 ? submitted / wall : 0.0, playing ? "yes" : "no");
+        fflush(stdout);
+
+        for (size_t i = 0; i < inputs.size(); i++)
+            unlink((out_dir + "/" + std::to_string(i) + extension).c_str());
+    }
+    return 0;
+}
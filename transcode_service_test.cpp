@@ -0,0 +1,136 @@
+/**
+* @file transcode_service_test.cpp
+* @version 1.0
+* Test of throttling in TranscodeService.
+*
+* Job A reads a FIFO which gets no data, so it keeps worker 0 busy. Job B is queued while
+* playback is active and must wait, since only TRANSCODE_WORKERS_WHILE_PLAYING workers take
+* jobs. When playback stops, the waiting worker wakes up and B is done while A still runs.
+* Callbacks cleared by SetCallbacks(nullptr, nullptr) are not called any more.
+*
+* build : g++ -std=c++11 -pthread -I. transcode_service_test.cpp transcode_service.cpp
+*         $(pkg-config --cflags --libs gstreamer-1.0) -o transcode_service_test
+* usage : transcode_service_test
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "transcode_service.h"
+#include "test_check.h"
+
+using lge::mm::player::TranscodeJob;
+using lge::mm::player::TranscodeService;
+
+static std::mutex done_mutex;
+static std::condition_variable done_cv;
+static std::map<uint32_t, TranscodeService::Result> done;
+
+static void OnDone(uint32_t id, TranscodeService::Result result, const std::string&) {
+    std::lock_guard<std::mutex> locker(done_mutex);
+    done[id] = result;
+    done_cv.notify_all();
+}
+
+static bool WaitDone(uint32_t id, uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> locker(done_mutex);
+    return done_cv.wait_for(locker, std::chrono::milliseconds(timeout_ms),
+                            [id]() { return done.count(id) > 0; });
+}
+
+static bool IsDone(uint32_t id) {
+    std::lock_guard<std::mutex> locker(done_mutex);
+    return done.count(id) > 0;
+}
+
+static bool IsDoneWith(uint32_t id, TranscodeService::Result result) {
+    std::lock_guard<std::mutex> locker(done_mutex);
+    return done.count(id) > 0 && done[id] == result;
+}
+
+// 0.5 s of silence, mono 16 bit 8 kHz
+static bool WriteWav(const std::string& path) {
+    const uint32_t rate = 8000;
+    const uint32_t bytes = rate;
+    unsigned char header[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ',
+                                16, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 16, 0,
+                                'd', 'a', 't', 'a', 0, 0, 0, 0};
+    uint32_t values[4][2] = {{4, 36 + bytes}, {24, rate}, {28, rate * 2}, {40, bytes}};
+    for (auto& value : values) {
+        for (int i = 0; i < 4; i++)
+            header[value[0] + i] = (unsigned char)(value[1] >> (8 * i));
+    }
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr)
+        return false;
+    bool ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+    for (uint32_t i = 0; ok && i < bytes; i++)
+        ok = fputc(0, fp) != EOF;
+    return fclose(fp) == 0 && ok;
+}
+
+int main() {
+    char dir_template[] = "/tmp/transcode_service_test.XXXXXX";
+    if (mkdtemp(dir_template) == nullptr)
+        return 1;
+    std::string dir(dir_template);
+    std::string fifo = dir + "/a.fifo";
+    std::string wav = dir + "/b.wav";
+    CHECK(mkfifo(fifo.c_str(), 0600) == 0);
+    CHECK(WriteWav(wav));
+    // held open so the reader of A neither blocks on open nor sees the end
+    int writer = open(fifo.c_str(), O_RDWR);
+    CHECK(writer >= 0);
+
+    {
+        TranscodeService service(2, 4);
+        service.SetCallbacks(nullptr, OnDone);
+        service.SetPlaybackActive(true);
+
+        uint32_t a = service.Submit(TranscodeJob{fifo, dir + "/a.wav", "WAV_PCM", "WAV"});
+        uint32_t b = service.Submit(TranscodeJob{wav, dir + "/b_out.wav", "WAV_PCM", "WAV"});
+        CHECK(a > 0 && b > 0);
+
+        // worker 1 is throttled while worker 0 is busy with A
+        usleep(500 * 1000);
+        CHECK(!IsDone(a));
+        CHECK(!IsDone(b));
+        CHECK(service.Pending() == 2);
+
+        service.SetPlaybackActive(false);
+        CHECK(WaitDone(b, 5000));
+        CHECK(IsDoneWith(b, TranscodeService::Result::Done));
+        CHECK(!IsDone(a));
+        CHECK(service.Pending() == 1);
+
+        // a job which ends after the callbacks are cleared reports to nobody
+        service.SetCallbacks(nullptr, nullptr);
+        CHECK(service.Cancel(a));
+        // the end of the FIFO also unblocks a reader which is inside read()
+        if (writer >= 0)
+            close(writer);
+        writer = -1;
+        for (int i = 0; i < 500 && service.Pending() > 0; i++)
+            usleep(10 * 1000);
+        CHECK(service.Pending() == 0);
+        CHECK(!IsDone(a));
+    }
+
+    if (writer >= 0)
+        close(writer);
+    unlink(fifo.c_str());
+    unlink(wav.c_str());
+    unlink((dir + "/b_out.wav").c_str());
+    rmdir(dir.c_str());
+
+    return TestResult("transcode_service_test");
+}